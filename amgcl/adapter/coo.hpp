@@ -0,0 +1,305 @@
+#ifndef AMGCL_ADAPTER_COO_HPP
+#define AMGCL_ADAPTER_COO_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2018 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+\file    amgcl/adapter/coo.hpp
+\author  Denis Demidov <dennis.demidov@gmail.com>
+\brief   Parallel conversion of COO triplets to the builtin CRS matrix.
+\ingroup adapters
+*/
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+#include <amgcl/util.hpp>
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/value_type/interface.hpp>
+
+namespace amgcl {
+namespace adapter {
+
+namespace detail {
+
+// Stable parallel LSD radix sort of (key, index) pairs by the keys, one byte
+// of the key at a time. Each thread histograms and then scatters its own
+// contiguous chunk of the input, so the relative order of the equal keys is
+// preserved.
+template <class Key, class Idx>
+void radix_sort(std::vector<Key> &key, std::vector<Idx> &idx, Key max_key) {
+    const int    bits    = 8;
+    const size_t buckets = 1 << bits;
+    const size_t mask    = buckets - 1;
+
+    const ptrdiff_t n = key.size();
+
+#ifdef _OPENMP
+    const int nt = omp_get_max_threads();
+#else
+    const int nt = 1;
+#endif
+
+    std::vector<Key> key2(n);
+    std::vector<Idx> idx2(n);
+    std::vector<ptrdiff_t> hist(nt * buckets);
+
+    const int key_bits = 8 * sizeof(Key);
+
+    for(int shift = 0; shift < key_bits && (max_key >> shift) > 0; shift += bits) {
+        std::fill(hist.begin(), hist.end(), 0);
+
+#pragma omp parallel
+        {
+#ifdef _OPENMP
+            const int tid = omp_get_thread_num();
+            const int nth = omp_get_num_threads();
+#else
+            const int tid = 0;
+            const int nth = 1;
+#endif
+            const ptrdiff_t beg = n * tid / nth;
+            const ptrdiff_t end = n * (tid + 1) / nth;
+
+            ptrdiff_t *h = &hist[tid * buckets];
+
+            for(ptrdiff_t i = beg; i < end; ++i)
+                ++h[(key[i] >> shift) & mask];
+
+#pragma omp barrier
+#pragma omp single
+            {
+                ptrdiff_t sum = 0;
+                for(size_t d = 0; d < buckets; ++d) {
+                    for(int t = 0; t < nth; ++t) {
+                        ptrdiff_t c = hist[t * buckets + d];
+                        hist[t * buckets + d] = sum;
+                        sum += c;
+                    }
+                }
+            }
+
+            for(ptrdiff_t i = beg; i < end; ++i) {
+                ptrdiff_t j = h[(key[i] >> shift) & mask]++;
+                key2[j] = key[i];
+                idx2[j] = idx[i];
+            }
+        }
+
+        key.swap(key2);
+        idx.swap(idx2);
+    }
+}
+
+} // namespace detail
+
+/// Converts COO triplets to the CRS format.
+/**
+ * The triplets may come in any order, and duplicate entries are summed.
+ * The triplets are sorted by rows with a parallel radix sort, and by columns
+ * within each row, in parallel over the rows. The duplicates are summed in
+ * the order of their appearance in the input, so the result does not depend
+ * on the number of threads.
+ *
+ * The permutation of the triplets into the matrix is computed once on
+ * construction, and is kept. Each call to operator() only gathers the
+ * values, so the matrix with the same structure and new values is
+ * converted at the cost of a single pass over the values. Example:
+ * \code
+ * amgcl::adapter::coo_to_crs<double> convert(n, n, nnz, row, col);
+ * auto A = convert(val);
+ * Solver solve(*A, prm);
+ *
+ * // New values for the same triplets:
+ * solve.rebuild(*convert(new_val));
+ * \endcode
+ *
+ * \sa amgcl::adapter::coo() for the one-shot conversion.
+ */
+template <class Val, class Col = ptrdiff_t, class Ptr = Col>
+class coo_to_crs {
+    public:
+        typedef Val                         value_type;
+        typedef backend::crs<Val, Col, Ptr> matrix;
+
+        /// Computes the CRS structure of the triplets.
+        /**
+         * \param nrows Number of rows in the matrix.
+         * \param ncols Number of columns in the matrix.
+         * \param nnz   Number of triplets.
+         * \param row   Row indices of the triplets.
+         * \param col   Column indices of the triplets.
+         */
+        template <class RowIdx, class ColIdx>
+        coo_to_crs(size_t nrows, size_t ncols, size_t nnz,
+                const RowIdx *row, const ColIdx *col)
+            : nnz(nnz)
+        {
+            AMGCL_TIC("coo structure");
+            const ptrdiff_t n = nrows;
+            const ptrdiff_t m = ncols;
+            const ptrdiff_t k = nnz;
+
+            // Sort the triplets by rows.
+            std::vector<Col> key(k);
+            order.resize(k);
+
+            bool valid = true;
+#pragma omp parallel for reduction(&&:valid)
+            for(ptrdiff_t i = 0; i < k; ++i) {
+                ptrdiff_t r = row[i];
+                ptrdiff_t c = col[i];
+                valid = valid && r >= 0 && r < n && c >= 0 && c < m;
+
+                key[i]   = r;
+                order[i] = i;
+            }
+
+            precondition(valid, "Triplet index is out of range");
+
+            if (n > 0) detail::radix_sort(key, order, static_cast<Col>(n - 1));
+
+            // Start of each row in the sorted triplets.
+            std::vector<Ptr> tptr(n + 1);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i <= k; ++i) {
+                ptrdiff_t r_beg = (i == 0) ? 0 : key[i-1] + 1;
+                ptrdiff_t r_end = (i == k) ? n : key[i];
+
+                for(ptrdiff_t r = r_beg; r <= r_end; ++r)
+                    tptr[r] = i;
+            }
+
+            std::vector<Col>().swap(key);
+
+            // Sort the triplets by columns within each row, and count the
+            // unique columns. Equal columns keep the input order.
+            A = std::make_shared<matrix>();
+            A->set_size(nrows, ncols, true);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                Ptr *beg = order.data() + tptr[i];
+                Ptr *end = order.data() + tptr[i+1];
+
+                std::sort(beg, end, [col](Ptr a, Ptr b) {
+                        return col[a] < col[b] || (col[a] == col[b] && a < b);
+                        });
+
+                Ptr cnt = 0;
+                for(Ptr *p = beg; p != end; ++p)
+                    if (p == beg || col[*p] != col[*(p-1)]) ++cnt;
+
+                A->ptr[i+1] = cnt;
+            }
+
+            A->scan_row_sizes();
+            A->set_nonzeros();
+
+            // The column of each matrix entry, and the range of the sorted
+            // triplets summed into it.
+            dup.resize(A->nnz + 1);
+            dup[A->nnz] = k;
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                Ptr head = A->ptr[i];
+
+                for(Ptr j = tptr[i]; j < tptr[i+1]; ++j) {
+                    if (j == tptr[i] || col[order[j]] != col[order[j-1]]) {
+                        A->col[head] = col[order[j]];
+                        dup[head++]  = j;
+                    }
+                }
+            }
+            AMGCL_TOC("coo structure");
+        }
+
+        /// Fills the matrix with the values of the triplets.
+        /**
+         * The values are given in the order of the triplets passed on
+         * construction. Any random access container or pointer may be used.
+         * The returned matrix is kept by the converter, and the next call
+         * overwrites its values in place.
+         */
+        template <class Vals>
+        std::shared_ptr<matrix> operator()(const Vals &val) const {
+            AMGCL_TIC("coo values");
+            const ptrdiff_t nz = A->nnz;
+
+#pragma omp parallel for
+            for(ptrdiff_t j = 0; j < nz; ++j) {
+                Val s = math::zero<Val>();
+                for(Ptr k = dup[j], e = dup[j+1]; k < e; ++k)
+                    s += val[order[k]];
+                A->val[j] = s;
+            }
+            AMGCL_TOC("coo values");
+
+            return A;
+        }
+
+        /// Returns the number of triplets.
+        size_t size() const {
+            return nnz;
+        }
+
+    private:
+        size_t nnz;
+
+        std::shared_ptr<matrix> A;
+
+        // Permutation of the triplets sorted by rows and columns.
+        std::vector<Ptr> order;
+
+        // Sorted triplets dup[j] to dup[j+1]-1 are summed into the matrix
+        // entry j.
+        std::vector<Ptr> dup;
+};
+
+/// Converts the COO triplets to the CRS matrix.
+/**
+ * The triplets may be unsorted and may contain duplicates, which are summed.
+ * Use amgcl::adapter::coo_to_crs directly to keep the permutation for
+ * value-only updates.
+ */
+template <class RowIdx, class ColIdx, class Val>
+std::shared_ptr< backend::crs<Val> >
+coo(size_t nrows, size_t ncols, size_t nnz,
+        const RowIdx *row, const ColIdx *col, const Val *val)
+{
+    return coo_to_crs<Val>(nrows, ncols, nnz, row, col)(val);
+}
+
+} // namespace adapter
+} // namespace amgcl
+
+#endif
@@ -0,0 +1,293 @@
+#ifndef AMGCL_ADAPTER_ELEMENT_ASSEMBLER_HPP
+#define AMGCL_ADAPTER_ELEMENT_ASSEMBLER_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2018 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+\file    amgcl/adapter/element_assembler.hpp
+\author  Denis Demidov <dennis.demidov@gmail.com>
+\brief   Parallel finite element assembly into the builtin CRS matrix.
+\ingroup adapters
+*/
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <numeric>
+
+#include <amgcl/util.hpp>
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/value_type/interface.hpp>
+
+namespace amgcl {
+namespace adapter {
+
+/// Assembles the system matrix from dense element matrices.
+/**
+ * The sparsity pattern of the matrix and the positions of the element
+ * matrix entries in it are computed once on construction, from the element
+ * connectivity. Each assembly then only scatters the element values into the
+ * matrix, so that the matrix with new values (but the same mesh) is
+ * assembled at the cost of a single pass over the element matrices.
+ *
+ * Both the pattern construction and the assembly are parallel over the
+ * matrix rows. Each row gathers the contributions from the elements
+ * containing its node (as given by the node-to-element graph), so that no
+ * locks, atomics or element coloring are required, and the result does not
+ * depend on the number of threads.
+ *
+ * Example:
+ * \code
+ * // Linear triangles: three nodes per element.
+ * amgcl::adapter::element_assembler<double> assemble(nnodes, nelems, 3, tri);
+ *
+ * // Ke holds 3x3 row-major element matrices, one after another:
+ * auto A = assemble(Ke);
+ * Solver solve(*A, prm);
+ *
+ * // Same mesh, new coefficients:
+ * solve.rebuild(*assemble(Ke_new));
+ * \endcode
+ */
+template <class Val, class Col = ptrdiff_t, class Ptr = Col>
+class element_assembler {
+    public:
+        typedef Val                         value_type;
+        typedef backend::crs<Val, Col, Ptr> matrix;
+
+        /// Prepares the assembly for a mesh with elements of any size.
+        /**
+         * \param nnodes Number of nodes (rows in the assembled matrix).
+         * \param nelems Number of elements.
+         * \param eptr   Element pointers (nelems + 1 entries). The nodes of
+         *               element e are enodes[eptr[e]], ...,
+         *               enodes[eptr[e+1] - 1].
+         * \param enodes Element nodes.
+         */
+        template <class EPtr, class ENode>
+        element_assembler(size_t nnodes, size_t nelems,
+                const EPtr *eptr, const ENode *enodes)
+        {
+            init(nnodes, nelems, eptr, enodes);
+        }
+
+        /// Prepares the assembly for a mesh with elements of the same size.
+        /**
+         * \param nnodes Number of nodes (rows in the assembled matrix).
+         * \param nelems Number of elements.
+         * \param npe    Number of nodes per element.
+         * \param enodes Element nodes (nelems * npe entries).
+         */
+        template <class ENode>
+        element_assembler(size_t nnodes, size_t nelems, unsigned npe,
+                const ENode *enodes)
+        {
+            std::vector<size_t> eptr(nelems + 1);
+            for(size_t e = 0; e <= nelems; ++e) eptr[e] = e * npe;
+
+            init(nnodes, nelems, eptr.data(), enodes);
+        }
+
+        /// Assembles the matrix from the element matrices.
+        /**
+         * The element matrices are stored one after another in the order of
+         * the elements. The matrix of an element with k nodes is a dense
+         * k-by-k matrix stored row-wise, with the rows and columns ordered as
+         * the element nodes in the connectivity. Any random access container
+         * or pointer may be used.
+         *
+         * The assembler keeps the returned matrix, and the next call
+         * overwrites its values in place.
+         */
+        template <class ElemVals>
+        std::shared_ptr<matrix> operator()(const ElemVals &Ke) const {
+            AMGCL_TIC("assemble");
+            const ptrdiff_t n = A->nrows;
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                for(Ptr j = A->ptr[i], e = A->ptr[i+1]; j < e; ++j)
+                    A->val[j] = math::zero<Val>();
+
+                for(Ptr j = n2e_ptr[i], e = n2e_ptr[i+1]; j < e; ++j) {
+                    const size_t    off = n2e_off[j];
+                    const unsigned  len = n2e_len[j];
+                    const Ptr      *pos = &this->pos[off];
+
+                    for(unsigned k = 0; k < len; ++k)
+                        A->val[pos[k]] += Ke[off + k];
+                }
+            }
+            AMGCL_TOC("assemble");
+
+            return A;
+        }
+
+        /// Returns the number of values expected in the element matrices.
+        size_t size() const {
+            return pos.size();
+        }
+
+    private:
+        std::shared_ptr<matrix> A;
+
+        // Node-to-element graph. Each entry is a row of an element matrix
+        // (given by its offset and length in the element values), that
+        // contributes to the matrix row of the node.
+        std::vector<Ptr>      n2e_ptr;
+        std::vector<size_t>   n2e_off;
+        std::vector<unsigned> n2e_len;
+
+        // Positions of the element matrix entries in the assembled matrix.
+        std::vector<Ptr> pos;
+
+        template <class EPtr, class ENode>
+        void init(size_t nnodes, size_t nelems, const EPtr *eptr, const ENode *enodes)
+        {
+            AMGCL_TIC("assembly pattern");
+            const ptrdiff_t n = nnodes;
+
+            // Offsets of the element matrices in the element values.
+            std::vector<size_t> voff(nelems + 1);
+            voff[0] = 0;
+            for(size_t e = 0; e < nelems; ++e) {
+                size_t k = eptr[e+1] - eptr[e];
+                voff[e+1] = voff[e] + k * k;
+            }
+
+            // Node-to-element graph. The entries of each node are ordered by
+            // element, so the summation order is fixed.
+            const size_t nconn = eptr[nelems] - eptr[0];
+
+            n2e_ptr.assign(nnodes + 1, 0);
+            n2e_off.resize(nconn);
+            n2e_len.resize(nconn);
+
+            std::vector<size_t> n2e_elm(nconn);
+
+            for(size_t e = 0; e < nelems; ++e)
+                for(EPtr j = eptr[e]; j < eptr[e+1]; ++j) {
+                    ptrdiff_t c = enodes[j];
+                    precondition(c >= 0 && c < n,
+                            "Element node is out of range");
+                    ++n2e_ptr[c + 1];
+                }
+
+            std::partial_sum(n2e_ptr.begin(), n2e_ptr.end(), n2e_ptr.begin());
+
+            {
+                std::vector<Ptr> head(n2e_ptr.begin(), n2e_ptr.end() - 1);
+
+                for(size_t e = 0; e < nelems; ++e) {
+                    unsigned k = eptr[e+1] - eptr[e];
+                    for(unsigned a = 0; a < k; ++a) {
+                        Ptr h = head[enodes[eptr[e] + a]]++;
+
+                        n2e_elm[h] = e;
+                        n2e_off[h] = voff[e] + a * k;
+                        n2e_len[h] = k;
+                    }
+                }
+            }
+
+            // Sparsity pattern: the row of a node has the nodes of all the
+            // elements that contain it.
+            A = std::make_shared<matrix>();
+            A->set_size(nnodes, nnodes, true);
+
+#pragma omp parallel
+            {
+                std::vector<ptrdiff_t> marker(nnodes, -1);
+
+#pragma omp for
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    Ptr cnt = 0;
+
+                    for(Ptr j = n2e_ptr[i], je = n2e_ptr[i+1]; j < je; ++j) {
+                        size_t e = n2e_elm[j];
+                        for(EPtr b = eptr[e]; b < eptr[e+1]; ++b) {
+                            ptrdiff_t c = enodes[b];
+                            if (marker[c] != i) {
+                                marker[c] = i;
+                                ++cnt;
+                            }
+                        }
+                    }
+
+                    A->ptr[i+1] = cnt;
+                }
+            }
+
+            A->scan_row_sizes();
+            A->set_nonzeros();
+
+            // Positions of the element matrix entries. Each element matrix
+            // row belongs to a single matrix row, so the rows are filled
+            // independently.
+            pos.resize(voff.back());
+
+#pragma omp parallel
+            {
+                std::vector<ptrdiff_t> marker(nnodes, -1);
+                std::vector<Ptr>       loc(nnodes);
+
+#pragma omp for
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    Ptr row_beg = A->ptr[i];
+                    Ptr row_end = row_beg;
+
+                    for(Ptr j = n2e_ptr[i], je = n2e_ptr[i+1]; j < je; ++j) {
+                        size_t e = n2e_elm[j];
+                        for(EPtr b = eptr[e]; b < eptr[e+1]; ++b) {
+                            ptrdiff_t c = enodes[b];
+                            if (marker[c] != i) {
+                                marker[c] = i;
+                                A->col[row_end++] = c;
+                            }
+                        }
+                    }
+
+                    std::sort(A->col + row_beg, A->col + row_end);
+
+                    for(Ptr j = row_beg; j < row_end; ++j)
+                        loc[A->col[j]] = j;
+
+                    for(Ptr j = n2e_ptr[i], je = n2e_ptr[i+1]; j < je; ++j) {
+                        size_t e   = n2e_elm[j];
+                        Ptr   *p   = &pos[n2e_off[j]];
+
+                        for(EPtr b = eptr[e]; b < eptr[e+1]; ++b)
+                            *p++ = loc[enodes[b]];
+                    }
+                }
+            }
+            AMGCL_TOC("assembly pattern");
+        }
+};
+
+} // namespace adapter
+} // namespace amgcl
+
+#endif
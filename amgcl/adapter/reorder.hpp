@@ -33,6 +33,7 @@ THE SOFTWARE.
 */
 
 #include <type_traits>
+#include <memory>
 #include <boost/range/size.hpp>
 #include <boost/iterator/permutation_iterator.hpp>
 
@@ -40,6 +41,8 @@ THE SOFTWARE.
 #include <amgcl/reorder/cuthill_mckee.hpp>
 #include <amgcl/backend/builtin.hpp>
 #include <amgcl/backend/detail/matrix_ops.hpp>
+#include <amgcl/detail/sort_row.hpp>
+#include <amgcl/util.hpp>
 
 namespace amgcl {
 namespace adapter {
@@ -266,6 +269,48 @@ class reorder {
             return reordered_vector<const Vector>(x, perm.data());
         }
 
+        /// Returns the reordered copy of the matrix.
+        /**
+         * Unlike the lazy reordered_matrix, the rows and the columns are
+         * renumbered once, in parallel, and the columns of each row are
+         * sorted. Further passes over the matrix (both during the setup
+         * and during the solution) see contiguous memory without the
+         * permutation indirections.
+         */
+        template <class Matrix>
+        std::shared_ptr< backend::crs<typename backend::value_type<Matrix>::type> >
+        materialize(const Matrix &A) const {
+            typedef typename backend::value_type<Matrix>::type V;
+            typedef typename backend::row_iterator<Matrix>::type row_iterator;
+
+            AMGCL_TIC("materialize");
+            auto B = std::make_shared< backend::crs<V> >();
+            B->set_size(n, backend::cols(A), true);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                ptrdiff_t w = 0;
+                for(row_iterator a = backend::row_begin(A, perm[i]); a; ++a) ++w;
+                B->ptr[i+1] = w;
+            }
+
+            B->scan_row_sizes();
+            B->set_nonzeros();
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                ptrdiff_t beg = B->ptr[i], head = beg;
+                for(row_iterator a = backend::row_begin(A, perm[i]); a; ++a, ++head) {
+                    B->col[head] = iperm[a.col()];
+                    B->val[head] = a.value();
+                }
+                amgcl::detail::sort_row(B->col + beg, B->val + beg, head - beg);
+            }
+            AMGCL_TOC("materialize");
+
+            return B;
+        }
+
         template <class Vector1, class Vector2>
         void forward(const Vector1 &x, Vector2 &y) const {
 #pragma omp parallel for
@@ -40,22 +40,48 @@ THE SOFTWARE.
 namespace amgcl {
 namespace adapter {
 
+namespace detail {
+
+// Index types that are binary-compatible with ptrdiff_t are reinterpreted as
+// ptrdiff_t, so that the result may be used with the default builtin backend.
+template <typename T>
+struct zero_copy_index {
+    static_assert(std::is_integral<T>::value, "Unsupported index type");
+
+    typedef typename std::conditional<
+        sizeof(T) == sizeof(ptrdiff_t), ptrdiff_t, T
+        >::type type;
+};
+
+} // namespace detail
+
+/// Wraps user-owned CRS arrays without copying.
+/**
+ * When the index types have the same size as ptrdiff_t, the result is
+ * backend::crs<Val> which may be used with amgcl::backend::builtin<Val>.
+ * Otherwise the arrays keep their types, and the result should be used with
+ * the builtin backend having the same index types, e.g.
+ * ``amg<backend::builtin<double, int>, ...>`` for 32-bit indices.
+ */
 template <typename Ptr, typename Col, typename Val>
-std::shared_ptr< backend::crs<Val> >
+std::shared_ptr<
+    backend::crs<
+        Val,
+        typename detail::zero_copy_index<Col>::type,
+        typename detail::zero_copy_index<Ptr>::type
+        >
+    >
 zero_copy(size_t n, const Ptr *ptr, const Col *col, const Val *val) {
-    // Check that Ptr and Col types are binary-compatible with ptrdiff_t:
-    static_assert(std::is_integral<Ptr>::value, "Unsupported Ptr type");
-    static_assert(std::is_integral<Col>::value, "Unsupported Col type");
-    static_assert(sizeof(Ptr) == sizeof(ptrdiff_t), "Unsupported Ptr type");
-    static_assert(sizeof(Col) == sizeof(ptrdiff_t), "Unsupported Col type");
+    typedef typename detail::zero_copy_index<Col>::type col_type;
+    typedef typename detail::zero_copy_index<Ptr>::type ptr_type;
 
-    auto A = std::make_shared< backend::crs<Val> >();
+    auto A = std::make_shared< backend::crs<Val, col_type, ptr_type> >();
     A->nrows = n;
     A->ncols = n;
     A->nnz   = ptr[n];
 
-    A->ptr = (ptrdiff_t*)ptr;
-    A->col = (ptrdiff_t*)col;
+    A->ptr = (ptr_type*)ptr;
+    A->col = (col_type*)col;
     A->val = (Val*)val;
 
     A->own_data = false;
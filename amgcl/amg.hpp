@@ -35,6 +35,7 @@ THE SOFTWARE.
 #include <iomanip>
 #include <list>
 #include <memory>
+#include <exception>
 
 #ifdef AMGCL_ASYNC_SETUP
 #  include <atomic>
@@ -83,7 +84,7 @@ class amg {
         typedef Coarsening<Backend>          coarsening_type;
         typedef Relax<Backend>               relax_type;
 
-        typedef typename backend::builtin<value_type>::matrix build_matrix;
+        typedef typename backend::builtin_matrix<Backend>::type build_matrix;
 
         typedef typename math::scalar_of<value_type>::type scalar_type;
 
@@ -136,6 +137,26 @@ class amg {
             /// Number of cycles to make as part of preconditioning.
             unsigned pre_cycles;
 
+            /// Keep the data required to rebuild the hierarchy.
+            /**
+             * When set, the transfer operators are kept in the build format,
+             * so that rebuild() may update the hierarchy for the new matrix
+             * values.
+             */
+            bool allow_rebuild;
+
+            /// Overlap the independent phases of the setup.
+            /**
+             * When set, the setup is done with OpenMP tasks: the relaxation
+             * on each level is set up concurrently with the coarsening of
+             * the next level, and the coarse level solver is set up
+             * concurrently with the remaining relaxations. The concurrent
+             * phases run their parallel loops in nested teams. Has no effect
+             * without OpenMP, with the asynchronous setup, or when the
+             * profiling is enabled (the profiler is not thread safe).
+             */
+            bool task_setup;
+
 #ifdef AMGCL_ASYNC_SETUP
             /// Asynchronous setup.
             /** Starts cycling as soon as the first level is (partially)
@@ -149,7 +170,8 @@ class amg {
                 coarse_enough( Backend::direct_solver::coarse_enough() ),
                 direct_coarse(true),
                 max_levels( std::numeric_limits<unsigned>::max() ),
-                npre(1), npost(1), ncycle(1), pre_cycles(1)
+                npre(1), npost(1), ncycle(1), pre_cycles(1), allow_rebuild(false),
+                task_setup(false)
 #ifdef AMGCL_ASYNC_SETUP
                 , async_setup(false)
 #endif
@@ -164,12 +186,14 @@ class amg {
                   AMGCL_PARAMS_IMPORT_VALUE(p, npre),
                   AMGCL_PARAMS_IMPORT_VALUE(p, npost),
                   AMGCL_PARAMS_IMPORT_VALUE(p, ncycle),
-                  AMGCL_PARAMS_IMPORT_VALUE(p, pre_cycles)
+                  AMGCL_PARAMS_IMPORT_VALUE(p, pre_cycles),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, allow_rebuild),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, task_setup)
 #ifdef AMGCL_ASYNC_SETUP
                 , AMGCL_PARAMS_IMPORT_VALUE(p, async_setup)
 #endif
             {
-                check_params(p, {"coarsening", "relax", "coarse_enough",  "direct_coarse", "max_levels", "npre", "npost", "ncycle",  "pre_cycles"
+                check_params(p, {"coarsening", "relax", "coarse_enough",  "direct_coarse", "max_levels", "npre", "npost", "ncycle",  "pre_cycles", "allow_rebuild", "task_setup"
 #ifdef AMGCL_ASYNC_SETUP
                         , "async_setup"
 #endif
@@ -192,6 +216,8 @@ class amg {
                 AMGCL_PARAMS_EXPORT_VALUE(p, path, npost);
                 AMGCL_PARAMS_EXPORT_VALUE(p, path, ncycle);
                 AMGCL_PARAMS_EXPORT_VALUE(p, path, pre_cycles);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, allow_rebuild);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, task_setup);
 #ifdef AMGCL_ASYNC_SETUP
                 AMGCL_PARAMS_EXPORT_VALUE(p, path, async_setup);
 #endif
@@ -246,10 +272,55 @@ class amg {
 #ifdef AMGCL_ASYNC_SETUP
         ~amg() {
             done = true;
-            if (prm.async_setup) init_thread.join();
+            if (prm.async_setup && init_thread.joinable()) init_thread.join();
+        }
+#endif
+
+        /// Rebuilds the hierarchy for the new values of the system matrix.
+        /**
+         * The matrix should have the same sparsity pattern as the one used
+         * to construct the preconditioner. The transfer operators are
+         * reused; only the coarse operators, the smoothers and the coarse
+         * direct solver are updated. Requires params::allow_rebuild to be
+         * set. The pattern is compared with the original one by a checksum
+         * of the nonzero positions.
+         */
+        template <class Matrix>
+        void rebuild(
+                const Matrix &M,
+                const backend_params &bprm = backend_params()
+                )
+        {
+            auto A = std::make_shared<build_matrix>(M);
+            sort_rows(*A);
+
+            rebuild(A, bprm);
         }
+
+        void rebuild(
+                std::shared_ptr<build_matrix> A,
+                const backend_params &bprm = backend_params()
+                )
+        {
+            precondition(prm.allow_rebuild, "allow_rebuild is not set!");
+            precondition(
+                    backend::rows(*A)     == levels.front().rows() &&
+                    backend::nonzeros(*A) == levels.front().nonzeros() &&
+                    pattern_checksum(*A) == pattern,
+                    "The matrix structure has changed!");
+
+#ifdef AMGCL_ASYNC_SETUP
+            if (prm.async_setup && init_thread.joinable()) init_thread.join();
 #endif
 
+            coarsening_type C(prm.coarsening);
+
+            for(level &lvl : levels) {
+                A = lvl.rebuild(A, C, prm, bprm, levels.size() == 1);
+                if (!A) break;
+            }
+        }
+
         /// Performs single V-cycle for the given right-hand side and solution.
         /**
          * \param rhs Right-hand side vector.
@@ -303,10 +374,14 @@ class amg {
 
             std::shared_ptr<relax_type> relax;
 
+            // Transfer operators in the build format, kept for rebuild().
+            std::shared_ptr<build_matrix> bP, bR;
+
             level() {}
 
-            level(std::shared_ptr<build_matrix> A,
-                    params &prm, const backend_params &bprm)
+            // Moves the matrix to the backend. The relaxation is set up
+            // separately.
+            level(std::shared_ptr<build_matrix> A, const backend_params &bprm)
                 : m_rows(backend::rows(*A)), m_nonzeros(backend::nonzeros(*A))
             {
                 AMGCL_TIC("move to backend");
@@ -315,15 +390,20 @@ class amg {
                 t = Backend::create_vector(m_rows, bprm);
                 this->A = Backend::copy_matrix(A, bprm);
                 AMGCL_TOC("move to backend");
+            }
 
+            level(std::shared_ptr<build_matrix> A,
+                    params &prm, const backend_params &bprm)
+                : level(A, bprm)
+            {
                 AMGCL_TIC("relaxation");
                 relax = std::make_shared<relax_type>(*A, prm.relax, bprm);
                 AMGCL_TOC("relaxation");
             }
 
             std::shared_ptr<build_matrix> step_down(
-                    std::shared_ptr<build_matrix> A,
-                    coarsening_type &C, const backend_params &bprm)
+                    std::shared_ptr<build_matrix> A, coarsening_type &C,
+                    const params &prm, const backend_params &bprm)
             {
                 AMGCL_TIC("transfer operators");
                 std::shared_ptr<build_matrix> P, R;
@@ -343,6 +423,11 @@ class amg {
                 this->R = Backend::copy_matrix(R, bprm);
                 AMGCL_TOC("move to backend");
 
+                if (prm.allow_rebuild) {
+                    bP = P;
+                    bR = R;
+                }
+
                 AMGCL_TIC("coarse operator");
                 A = C.coarse_operator(*A, *P, *R);
                 sort_rows(*A);
@@ -366,6 +451,40 @@ class amg {
                     this->A = Backend::copy_matrix(A, bprm);
             }
 
+            // Updates the level for the new values of the matrix and returns
+            // the matrix for the next level.
+            std::shared_ptr<build_matrix> rebuild(
+                    std::shared_ptr<build_matrix> A, coarsening_type &C,
+                    const params &prm, const backend_params &bprm,
+                    bool single_level)
+            {
+                if (solve) {
+                    AMGCL_TIC("coarsest level");
+                    solve = Backend::create_solver(A, bprm);
+                    if (single_level)
+                        this->A = Backend::copy_matrix(A, bprm);
+                    AMGCL_TOC("coarsest level");
+                    return std::shared_ptr<build_matrix>();
+                }
+
+                AMGCL_TIC("move to backend");
+                this->A = Backend::copy_matrix(A, bprm);
+                AMGCL_TOC("move to backend");
+
+                AMGCL_TIC("relaxation");
+                relax = std::make_shared<relax_type>(*A, prm.relax, bprm);
+                AMGCL_TOC("relaxation");
+
+                if (!bP) return std::shared_ptr<build_matrix>();
+
+                AMGCL_TIC("coarse operator");
+                A = C.coarse_operator(*A, *bP, *bR);
+                sort_rows(*A);
+                AMGCL_TOC("coarse operator");
+
+                return A;
+            }
+
             size_t rows() const {
                 return m_rows;
             }
@@ -378,6 +497,7 @@ class amg {
         typedef typename std::list<level>::const_iterator level_iterator;
 
         std::list<level> levels;
+        size_t pattern;
 #ifdef AMGCL_ASYNC_SETUP
         std::thread init_thread;
         std::atomic<bool> done;
@@ -413,7 +533,7 @@ class amg {
 #endif
                 if (levels.size() >= prm.max_levels) break;
 
-                A = levels.back().step_down(A, C, bprm);
+                A = levels.back().step_down(A, C, prm, bprm);
                 if (!A) {
                     // Zero-sized coarse level. Probably the system matrix on
                     // this level is diagonal, should be easily solvable with a
@@ -455,11 +575,139 @@ class amg {
             }
         }
 
+#if defined(_OPENMP) && !defined(AMGCL_PROFILING)
+        // Same as init(), but the relaxation on each level and the coarse
+        // level solver are set up in OpenMP tasks, concurrently with the
+        // coarsening. The coarsening runs on a single thread of the outer
+        // team, and the relaxation tasks are picked up by the other one.
+        // Both start nested teams for their parallel loops, and the two
+        // nested teams together use the nt threads available.
+        void init_tasks(
+                std::shared_ptr<build_matrix> A,
+                const backend_params &bprm = backend_params()
+           )
+        {
+            precondition(
+                    backend::rows(*A) == backend::cols(*A),
+                    "Matrix should be square!"
+                    );
+
+            const int nt = omp_get_max_threads();
+
+            // Nothing to overlap with a single thread.
+            if (nt < 2) {
+                init(A, bprm);
+                return;
+            }
+
+            // Enables the nested parallelism for the lifetime of the object.
+            struct scoped_nested {
+                int old;
+
+                scoped_nested() : old(omp_get_max_active_levels()) {
+                    omp_set_max_active_levels(std::max(old, 2));
+                }
+
+                ~scoped_nested() {
+                    omp_set_max_active_levels(old);
+                }
+            } nested;
+
+            std::exception_ptr error;
+
+#pragma omp parallel num_threads(2)
+#pragma omp single
+            {
+                try {
+                    // The relaxation tasks get nt / 2 threads, and the
+                    // coarsening gets the rest.
+                    omp_set_num_threads(nt - nt / 2);
+
+                    bool direct_coarse_solve = true;
+
+                    coarsening_type C(prm.coarsening);
+
+                    while( backend::rows(*A) > prm.coarse_enough) {
+                        levels.push_back( level(A, bprm) );
+                        level *L = &levels.back();
+
+                        // The relaxation only needs the system matrix of the
+                        // level, which is not changed by the coarsening.
+                        // The per-thread tables of the parallel ilu* and
+                        // gauss_seidel do not depend on the team that builds
+                        // them, so the relaxations applied with nt threads
+                        // may be built with nt / 2.
+#pragma omp task firstprivate(A, L) shared(error)
+                        {
+                            try {
+                                omp_set_num_threads(nt / 2);
+                                L->relax = std::make_shared<relax_type>(*A, prm.relax, bprm);
+                            } catch(...) {
+#pragma omp critical(amgcl_task_setup)
+                                error = std::current_exception();
+                            }
+                        }
+
+                        if (levels.size() >= prm.max_levels) break;
+
+                        A = L->step_down(A, C, prm, bprm);
+                        if (!A) {
+                            direct_coarse_solve = false;
+                            break;
+                        }
+                    }
+
+                    if (!A || backend::rows(*A) > prm.coarse_enough) {
+                        direct_coarse_solve = false;
+                    }
+
+                    if (direct_coarse_solve) {
+                        if (prm.direct_coarse) {
+                            level l;
+                            l.create_coarse(A, bprm, levels.empty());
+                            levels.push_back( l );
+                        } else {
+                            levels.push_back( level(A, prm, bprm) );
+                        }
+                    }
+                } catch(...) {
+#pragma omp critical(amgcl_task_setup)
+                    error = std::current_exception();
+                }
+
+#pragma omp taskwait
+            }
+
+            if (error) std::rethrow_exception(error);
+        }
+#endif
+
+        // Checksum of the sparsity pattern (the row and column indices of the
+        // nonzeros). The checksum does not depend on the order of the
+        // nonzeros within the rows.
+        static size_t pattern_checksum(const build_matrix &A) {
+            const ptrdiff_t n = backend::rows(A);
+
+            size_t sum = 0;
+
+#pragma omp parallel for reduction(+:sum)
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                size_t r = detail::mix_hash(i);
+
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j)
+                    sum += detail::mix_hash(r ^ A.col[j]);
+            }
+
+            return sum;
+        }
+
         void do_init(
                 std::shared_ptr<build_matrix> A,
                 const backend_params &bprm = backend_params()
                 )
         {
+            if (prm.allow_rebuild) pattern = pattern_checksum(*A);
+
 #ifdef AMGCL_ASYNC_SETUP
             done = false;
             if (prm.async_setup) {
@@ -469,6 +717,11 @@ class amg {
                     while(levels.empty()) ready_to_cycle.wait(lock);
                 }
             } else
+#endif
+#if defined(_OPENMP) && !defined(AMGCL_PROFILING)
+            if (prm.task_setup) {
+                init_tasks(A, bprm);
+            } else
 #endif
             {
                 init(A, bprm);
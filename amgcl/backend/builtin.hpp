@@ -396,9 +396,9 @@ void scale(crs<Val, Col, Ptr> &A, T s) {
 }
 
 // Reduce matrix to a pointwise one
-template <class value_type>
-std::shared_ptr< crs<typename math::scalar_of<value_type>::type> >
-pointwise_matrix(const crs<value_type> &A, unsigned block_size) {
+template <class value_type, class col_type, class ptr_type>
+std::shared_ptr< crs<typename math::scalar_of<value_type>::type, col_type, ptr_type> >
+pointwise_matrix(const crs<value_type, col_type, ptr_type> &A, unsigned block_size) {
     typedef value_type V;
     typedef typename math::scalar_of<V>::type S;
 
@@ -411,8 +411,8 @@ pointwise_matrix(const crs<value_type> &A, unsigned block_size) {
     precondition(np * block_size == n,
             "Matrix size should be divisible by block_size");
 
-    auto ap = std::make_shared< crs<S> >();
-    crs<S> &Ap = *ap;
+    auto ap = std::make_shared< crs<S, col_type, ptr_type> >();
+    crs<S, col_type, ptr_type> &Ap = *ap;
 
     Ap.set_size(np, mp, true);
 
@@ -807,17 +807,25 @@ spectral_radius(const Matrix &A, int power_iters = 0) {
  * instances of ``std::vector<value_type>``. There is no usual overhead of
  * moving the constructed hierarchy to the builtin backend, since the backend
  * is used internally during setup.
+ *
+ * The index types of the matrices may be changed with the ColumnType and
+ * PointerType template parameters. For example, the input matrix with 32-bit
+ * indices may be used by ``amg<builtin<double, int>, ...>`` without copying
+ * (see amgcl/adapter/zero_copy.hpp), and the rest of the hierarchy will also
+ * use 32-bit indices.
  */
-template <typename ValueType>
+template <typename ValueType, typename ColumnType = ptrdiff_t, typename PointerType = ColumnType>
 struct builtin {
     typedef ValueType      value_type;
     typedef ptrdiff_t      index_type;
+    typedef ColumnType     col_type;
+    typedef PointerType    ptr_type;
 
     typedef typename math::rhs_of<value_type>::type rhs_type;
 
     struct provides_row_iterator : std::true_type {};
 
-    typedef crs<value_type, index_type>    matrix;
+    typedef crs<value_type, col_type, ptr_type> matrix;
     typedef numa_vector<rhs_type>          vector;
     typedef numa_vector<value_type>        matrix_diagonal;
     typedef solver::skyline_lu<value_type> direct_solver;
@@ -865,8 +873,12 @@ struct builtin {
 
         template <class InVec, class OutVec>
         void operator()(const InVec &vec, OutVec &vals) const {
-            for(size_t i = 0; i < I.size(); ++i)
-                vals[i] = vec[I[i]];
+            const ptrdiff_t n = I.size();
+            const ptrdiff_t *idx = I.data();
+
+#pragma omp parallel for if(n > 4096)
+            for(ptrdiff_t i = 0; i < n; ++i)
+                vals[i] = vec[idx[i]];
         }
     };
 
@@ -902,8 +914,23 @@ struct is_builtin_vector< numa_vector<V> > : std::true_type {};
 //---------------------------------------------------------------------------
 // Specialization of backend interface
 //---------------------------------------------------------------------------
-template <typename T1, typename T2>
-struct backends_compatible< builtin<T1>, builtin<T2> > : std::true_type {};
+template <typename T1, typename C1, typename P1, typename T2, typename C2, typename P2>
+struct backends_compatible< builtin<T1, C1, P1>, builtin<T2, C2, P2> > : std::true_type {};
+
+/// Matrix format used to build a hierarchy for the given backend.
+/**
+ * The hierarchy is constructed in the builtin CRS format and is then moved
+ * to the backend. The builtin backend keeps its index types during setup.
+ */
+template <class Backend>
+struct builtin_matrix {
+    typedef crs<typename Backend::value_type> type;
+};
+
+template <typename V, typename C, typename P>
+struct builtin_matrix< builtin<V, C, P> > {
+    typedef crs<V, C, P> type;
+};
 
 template < typename V, typename C, typename P >
 struct value_type< crs<V, C, P> > {
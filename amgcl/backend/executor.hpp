@@ -0,0 +1,675 @@
+#ifndef AMGCL_BACKEND_EXECUTOR_HPP
+#define AMGCL_BACKEND_EXECUTOR_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2018 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/backend/executor.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Builtin-compatible backend running on a pluggable executor.
+ */
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <algorithm>
+#include <numeric>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include <amgcl/util.hpp>
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/value_type/interface.hpp>
+#include <amgcl/solver/skyline_lu.hpp>
+
+namespace amgcl {
+namespace backend {
+
+/// Executor interface for the executor backend.
+/**
+ * The backend kernels split the work into a number of independent tasks and
+ * pass them to the executor. Implement this interface to run the kernels on
+ * a thread pool or a task scheduler of the host application.
+ */
+struct executor {
+    virtual ~executor() {}
+
+    /// Maximum number of tasks the work should be split into.
+    virtual int concurrency() const = 0;
+
+    /// Calls task(0), ..., task(ntasks - 1) and returns when all are done.
+    /**
+     * The tasks are independent and may be executed concurrently. The
+     * method may be called concurrently from several threads.
+     */
+    virtual void run(int ntasks, const std::function<void(int)> &task) = 0;
+};
+
+/// Executes the tasks one after another in the calling thread.
+struct serial_executor : public executor {
+    int concurrency() const { return 1; }
+
+    void run(int ntasks, const std::function<void(int)> &task) {
+        for(int i = 0; i < ntasks; ++i) task(i);
+    }
+};
+
+/// Simple pool of worker threads.
+/**
+ * The calling thread takes part in the execution of its tasks, so that a
+ * pool with nthreads workers provides the concurrency of nthreads + 1.
+ * Several threads may submit the work to the same pool at once.
+ */
+class thread_pool : public executor {
+    public:
+        thread_pool(int nthreads = default_workers())
+            : stop(false)
+        {
+            for(int i = 0; i < nthreads; ++i)
+                workers.emplace_back(&thread_pool::worker, this);
+        }
+
+        ~thread_pool() {
+            {
+                std::lock_guard<std::mutex> lock(mx);
+                stop = true;
+            }
+            has_work.notify_all();
+            for(auto &w : workers) w.join();
+        }
+
+        int concurrency() const {
+            return workers.size() + 1;
+        }
+
+        void run(int ntasks, const std::function<void(int)> &task) {
+            if (ntasks == 1 || workers.empty()) {
+                for(int i = 0; i < ntasks; ++i) task(i);
+                return;
+            }
+
+            job j(ntasks, task);
+
+            {
+                std::lock_guard<std::mutex> lock(mx);
+                queue.push_back(&j);
+            }
+
+            // The job lives on the stack, so it has to be out of the queue
+            // and left by all workers before we return, even when a task
+            // throws in this thread.
+            job_guard guard(*this, j);
+
+            has_work.notify_all();
+            j.process();
+        }
+
+    private:
+        struct job {
+            int ntasks;
+            const std::function<void(int)> &task;
+
+            std::atomic<int> next;
+            int workers; // protected by the pool mutex
+
+            job(int ntasks, const std::function<void(int)> &task)
+                : ntasks(ntasks), task(task), next(0), workers(0) {}
+
+            bool exhausted() const {
+                return next >= ntasks;
+            }
+
+            void process() {
+                for(int i; (i = next++) < ntasks; ) task(i);
+            }
+        };
+
+        struct job_guard {
+            thread_pool &pool;
+            job &j;
+
+            job_guard(thread_pool &pool, job &j) : pool(pool), j(j) {}
+
+            ~job_guard() {
+                // Skip the remaining tasks (if we are here because of an
+                // exception). Once the job is out of the queue, no new
+                // workers may pick it up, and the job is done when the
+                // current ones are finished.
+                j.next = j.ntasks;
+
+                std::unique_lock<std::mutex> lock(pool.mx);
+                auto pos = std::find(pool.queue.begin(), pool.queue.end(), &j);
+                if (pos != pool.queue.end()) pool.queue.erase(pos);
+                pool.job_done.wait(lock, [this]{ return j.workers == 0; });
+            }
+        };
+
+        static int default_workers() {
+            return std::max(std::thread::hardware_concurrency(), 1u) - 1;
+        }
+
+        bool stop;
+        std::mutex mx;
+        std::condition_variable has_work, job_done;
+        std::deque<job*> queue;
+        std::vector<std::thread> workers;
+
+        void worker() {
+            std::unique_lock<std::mutex> lock(mx);
+
+            while(true) {
+                has_work.wait(lock, [this]{ return stop || !queue.empty(); });
+                if (stop) return;
+
+                job *j = queue.front();
+                if (j->exhausted()) {
+                    queue.pop_front();
+                    continue;
+                }
+
+                ++j->workers;
+                lock.unlock();
+                j->process();
+                lock.lock();
+
+                if (--j->workers == 0) job_done.notify_all();
+            }
+        }
+};
+
+namespace detail {
+
+// Number of tasks to split n items into.
+inline int executor_tasks(const executor *e, ptrdiff_t n, ptrdiff_t grain_size) {
+    if (!e) return 1;
+    ptrdiff_t nt = std::min<ptrdiff_t>(e->concurrency(), (n + grain_size - 1) / grain_size);
+    return static_cast<int>(std::max<ptrdiff_t>(nt, 1));
+}
+
+// Calls f(task, beg, end) for nt contiguous chunks of [0, n).
+template <class Func>
+void executor_for(executor *e, int nt, ptrdiff_t n, const Func &f) {
+    if (nt == 1) {
+        f(0, 0, n);
+    } else {
+        e->run(nt, [nt, n, &f](int t) {
+                f(t, n * t / nt, n * (t + 1) / nt);
+                });
+    }
+}
+
+} // namespace detail
+
+/// Vector type of the executor backend.
+/**
+ * A thin wrapper over amgcl::backend::numa_vector<> that also knows the
+ * executor to run the kernels on.
+ */
+template <typename T>
+class executor_vector {
+    public:
+        typedef T              value_type;
+        typedef numa_vector<T> Base;
+
+        executor *exec;
+        ptrdiff_t grain_size;
+
+        executor_vector(size_t n, executor *exec = 0, ptrdiff_t grain_size = 4096)
+            : exec(exec), grain_size(grain_size), base(std::make_shared<Base>(n, false))
+        {
+            T *x = base->data();
+            detail::executor_for(exec, tasks(), n,
+                    [x](int, ptrdiff_t beg, ptrdiff_t end) {
+                        for(ptrdiff_t i = beg; i < end; ++i) x[i] = math::zero<T>();
+                    });
+        }
+
+        /// Wraps the existing builtin vector (no copy is made).
+        executor_vector(std::shared_ptr<Base> x, executor *exec = 0, ptrdiff_t grain_size = 4096)
+            : exec(exec), grain_size(grain_size), base(x)
+        {}
+
+        size_t size() const { return base->size(); }
+
+        const T& operator[](size_t i) const { return (*base)[i]; }
+        T& operator[](size_t i) { return (*base)[i]; }
+
+        const T* data() const { return base->data(); }
+        T*       data()       { return base->data(); }
+
+        const T* begin() const { return data(); }
+        const T* end()   const { return data() + size(); }
+
+        T* begin() { return data(); }
+        T* end()   { return data() + size(); }
+
+        /// Number of tasks the vector operations are split into.
+        int tasks() const {
+            return detail::executor_tasks(exec, size(), grain_size);
+        }
+    private:
+        std::shared_ptr<Base> base;
+};
+
+/// Matrix type of the executor backend.
+/**
+ * A thin wrapper over amgcl::backend::crs<>. The rows are split between the
+ * tasks so that each task gets about the same number of nonzeros.
+ */
+template <typename V, typename C, typename P>
+class executor_matrix {
+    public:
+        typedef V value_type;
+        typedef crs<V, C, P> Base;
+        typedef typename Base::row_iterator row_iterator;
+
+        executor *exec;
+        std::vector<ptrdiff_t> split;
+
+        executor_matrix(std::shared_ptr<Base> A, executor *exec, ptrdiff_t grain_size)
+            : exec(exec), base(A)
+        {
+            const ptrdiff_t n  = A->nrows;
+            const ptrdiff_t nt = detail::executor_tasks(exec, n, grain_size);
+
+            split.resize(nt + 1);
+            for(ptrdiff_t t = 0; t <= nt; ++t) {
+                P nnz = A->nnz * t / nt;
+                split[t] = std::lower_bound(A->ptr, A->ptr + n, nnz) - A->ptr;
+            }
+            split[nt] = n;
+        }
+
+        size_t rows()     const { return base->nrows; }
+        size_t cols()     const { return base->ncols; }
+        size_t nonzeros() const { return base->nnz;   }
+
+        row_iterator row_begin(size_t row) const {
+            return base->row_begin(row);
+        }
+
+        /// Calls f(beg, end) for the row ranges of each of the tasks.
+        template <class Func>
+        void for_rows(const Func &f) const {
+            int nt = split.size() - 1;
+            const ptrdiff_t *s = split.data();
+
+            if (nt == 1) {
+                f(s[0], s[1]);
+            } else {
+                exec->run(nt, [s, &f](int t) { f(s[t], s[t+1]); });
+            }
+        }
+
+        const Base& base_matrix() const { return *base; }
+    private:
+        std::shared_ptr<Base> base;
+};
+
+/// Backend running the builtin kernels on a pluggable executor.
+/**
+ * The matrices and the vectors are the builtin amgcl::backend::crs<> and
+ * amgcl::backend::numa_vector<> types, wrapped together with the executor.
+ * The kernels do not use OpenMP; the work is split into tasks that are
+ * passed to the executor. This allows to run the solution phase inside the
+ * thread pool or the task scheduler (e.g. a TBB task arena) of the host
+ * application. The executor is not owned by the backend, and should outlive
+ * the solver. When no executor is given, the kernels run serially in the
+ * calling thread.
+ *
+ * \note The setup of the hierarchy is done with the builtin backend, so it
+ * still runs on the OpenMP threads (when OpenMP is enabled), and not on the
+ * executor.
+ */
+template <typename V, typename C = ptrdiff_t, typename P = C>
+struct executor_backend {
+    typedef V         value_type;
+    typedef ptrdiff_t index_type;
+    typedef C         col_type;
+    typedef P         ptr_type;
+
+    typedef typename math::rhs_of<value_type>::type rhs_type;
+
+    struct provides_row_iterator : std::false_type {};
+
+    struct params {
+        /// Executor to run the kernels on.
+        executor *exec;
+
+        /// Minimum number of vector elements in a single task.
+        ptrdiff_t grain_size;
+
+        params(executor *exec = 0) : exec(exec), grain_size(4096) {}
+
+        params(const boost::property_tree::ptree &p)
+            : AMGCL_PARAMS_IMPORT_VALUE(p, grain_size)
+        {
+            exec = p.get("exec", static_cast<executor*>(0));
+            check_params(p, {"exec", "grain_size"});
+        }
+
+        void get(boost::property_tree::ptree &p, const std::string &path) const {
+            p.put(path + "exec", exec);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, grain_size);
+        }
+    };
+
+    typedef executor_matrix<value_type, col_type, ptr_type> matrix;
+    typedef executor_vector<rhs_type>                        vector;
+    typedef executor_vector<value_type>                      matrix_diagonal;
+    typedef solver::skyline_lu<value_type>                   direct_solver;
+
+    static std::string name() { return "executor"; }
+
+    // Copy matrix from builtin backend. The matrix data is shared.
+    static std::shared_ptr<matrix>
+    copy_matrix(std::shared_ptr< crs<value_type, col_type, ptr_type> > A, const params &p)
+    {
+        return std::make_shared<matrix>(A, p.exec, p.grain_size);
+    }
+
+    // Copy vector to the backend.
+    template <class T>
+    static std::shared_ptr< executor_vector<T> >
+    copy_vector(const std::vector<T> &x, const params &p)
+    {
+        return std::make_shared< executor_vector<T> >(
+                std::make_shared< numa_vector<T> >(x), p.exec, p.grain_size);
+    }
+
+    // Copy vector to the backend. The vector data is shared.
+    template <class T>
+    static std::shared_ptr< executor_vector<T> >
+    copy_vector(std::shared_ptr< numa_vector<T> > x, const params &p)
+    {
+        return std::make_shared< executor_vector<T> >(x, p.exec, p.grain_size);
+    }
+
+    // Create vector of the specified size.
+    static std::shared_ptr<vector>
+    create_vector(size_t size, const params &p)
+    {
+        return std::make_shared<vector>(size, p.exec, p.grain_size);
+    }
+
+    // Create direct solver for coarse level
+    static std::shared_ptr<direct_solver>
+    create_solver(std::shared_ptr< crs<value_type, col_type, ptr_type> > A, const params&)
+    {
+        return std::make_shared<direct_solver>(*A);
+    }
+};
+
+//---------------------------------------------------------------------------
+// Backend interface implementation
+//---------------------------------------------------------------------------
+template <typename V, typename C, typename P>
+struct builtin_matrix< executor_backend<V, C, P> > {
+    typedef crs<V, C, P> type;
+};
+
+template <typename V, typename C, typename P>
+struct rows_impl< executor_matrix<V, C, P> > {
+    static size_t get(const executor_matrix<V, C, P> &A) {
+        return A.rows();
+    }
+};
+
+template <typename V, typename C, typename P>
+struct cols_impl< executor_matrix<V, C, P> > {
+    static size_t get(const executor_matrix<V, C, P> &A) {
+        return A.cols();
+    }
+};
+
+template <typename V, typename C, typename P>
+struct nonzeros_impl< executor_matrix<V, C, P> > {
+    static size_t get(const executor_matrix<V, C, P> &A) {
+        return A.nonzeros();
+    }
+};
+
+template <typename V, typename C, typename P>
+struct row_iterator< executor_matrix<V, C, P> > {
+    typedef typename executor_matrix<V, C, P>::row_iterator type;
+};
+
+template <typename V, typename C, typename P>
+struct row_begin_impl< executor_matrix<V, C, P> > {
+    static typename executor_matrix<V, C, P>::row_iterator
+    get(const executor_matrix<V, C, P> &A, size_t row) {
+        return A.row_begin(row);
+    }
+};
+
+template <class Alpha, typename V, typename C, typename P, class T1, class Beta, class T2>
+struct spmv_impl<
+    Alpha, executor_matrix<V, C, P>, executor_vector<T1>,
+    Beta,  executor_vector<T2>
+    >
+{
+    static void apply(Alpha alpha, const executor_matrix<V, C, P> &A,
+            const executor_vector<T1> &x, Beta beta, executor_vector<T2> &y)
+    {
+        const crs<V, C, P> &B = A.base_matrix();
+        const T1 *xp = x.data();
+        T2       *yp = y.data();
+
+        const bool scale = !math::is_zero(beta);
+
+        A.for_rows([&B, xp, yp, alpha, beta, scale](ptrdiff_t beg, ptrdiff_t end) {
+                for(ptrdiff_t i = beg; i < end; ++i) {
+                    T2 sum = math::zero<T2>();
+                    for(P j = B.ptr[i], e = B.ptr[i+1]; j < e; ++j)
+                        sum += B.val[j] * xp[B.col[j]];
+
+                    if (scale)
+                        yp[i] = alpha * sum + beta * yp[i];
+                    else
+                        yp[i] = alpha * sum;
+                }
+            });
+    }
+};
+
+template <typename V, typename C, typename P, class T1, class T2, class T3>
+struct residual_impl<
+    executor_matrix<V, C, P>,
+    executor_vector<T1>, executor_vector<T2>, executor_vector<T3>
+    >
+{
+    static void apply(const executor_vector<T1> &rhs,
+            const executor_matrix<V, C, P> &A,
+            const executor_vector<T2> &x, executor_vector<T3> &r)
+    {
+        const crs<V, C, P> &B = A.base_matrix();
+        const T1 *fp = rhs.data();
+        const T2 *xp = x.data();
+        T3       *rp = r.data();
+
+        A.for_rows([&B, fp, xp, rp](ptrdiff_t beg, ptrdiff_t end) {
+                for(ptrdiff_t i = beg; i < end; ++i) {
+                    T3 sum = math::zero<T3>();
+                    for(P j = B.ptr[i], e = B.ptr[i+1]; j < e; ++j)
+                        sum += B.val[j] * xp[B.col[j]];
+                    rp[i] = fp[i] - sum;
+                }
+            });
+    }
+};
+
+template <class T>
+struct clear_impl< executor_vector<T> >
+{
+    static void apply(executor_vector<T> &x) {
+        T *xp = x.data();
+
+        detail::executor_for(x.exec, x.tasks(), x.size(),
+                [xp](int, ptrdiff_t beg, ptrdiff_t end) {
+                    for(ptrdiff_t i = beg; i < end; ++i) xp[i] = math::zero<T>();
+                });
+    }
+};
+
+template <class T1, class T2>
+struct copy_impl< executor_vector<T1>, executor_vector<T2> >
+{
+    static void apply(const executor_vector<T1> &x, executor_vector<T2> &y) {
+        const T1 *xp = x.data();
+        T2       *yp = y.data();
+
+        detail::executor_for(y.exec, y.tasks(), y.size(),
+                [xp, yp](int, ptrdiff_t beg, ptrdiff_t end) {
+                    for(ptrdiff_t i = beg; i < end; ++i) yp[i] = xp[i];
+                });
+    }
+};
+
+template <class T1, class T2>
+struct inner_product_impl< executor_vector<T1>, executor_vector<T2> >
+{
+    typedef typename math::inner_product_impl<T1>::return_type return_type;
+
+    static return_type get(const executor_vector<T1> &x, const executor_vector<T2> &y)
+    {
+        const T1 *xp = x.data();
+        const T2 *yp = y.data();
+
+        // The chunks of the vectors are fixed by the number of tasks, and
+        // the partial sums of the tasks are added up in order, so the result
+        // does not depend on the executor or the scheduling of the tasks.
+        // The partial sums use the Kahan summation to reduce the round-off.
+        const int nt = x.tasks();
+        std::vector<return_type> sum(nt);
+        return_type *s = sum.data();
+
+        detail::executor_for(x.exec, nt, x.size(),
+                [xp, yp, s](int t, ptrdiff_t beg, ptrdiff_t end) {
+                    return_type acc = math::zero<return_type>();
+                    return_type c   = math::zero<return_type>();
+
+                    for(ptrdiff_t i = beg; i < end; ++i) {
+                        return_type d = math::inner_product(xp[i], yp[i]) - c;
+                        return_type r = acc + d;
+                        c = (r - acc) - d;
+                        acc = r;
+                    }
+
+                    s[t] = acc;
+                });
+
+        return std::accumulate(sum.begin(), sum.end(), math::zero<return_type>());
+    }
+};
+
+template <class A, class T1, class B, class T2>
+struct axpby_impl< A, executor_vector<T1>, B, executor_vector<T2> >
+{
+    static void apply(A a, const executor_vector<T1> &x, B b, executor_vector<T2> &y)
+    {
+        const T1 *xp = x.data();
+        T2       *yp = y.data();
+
+        const bool scale = !math::is_zero(b);
+
+        detail::executor_for(y.exec, y.tasks(), y.size(),
+                [a, xp, b, yp, scale](int, ptrdiff_t beg, ptrdiff_t end) {
+                    if (scale) {
+                        for(ptrdiff_t i = beg; i < end; ++i)
+                            yp[i] = a * xp[i] + b * yp[i];
+                    } else {
+                        for(ptrdiff_t i = beg; i < end; ++i)
+                            yp[i] = a * xp[i];
+                    }
+                });
+    }
+};
+
+template <class A, class T1, class B, class T2, class C, class T3>
+struct axpbypcz_impl<
+    A, executor_vector<T1>,
+    B, executor_vector<T2>,
+    C, executor_vector<T3>
+    >
+{
+    static void apply(A a, const executor_vector<T1> &x,
+            B b, const executor_vector<T2> &y,
+            C c, executor_vector<T3> &z)
+    {
+        const T1 *xp = x.data();
+        const T2 *yp = y.data();
+        T3       *zp = z.data();
+
+        const bool scale = !math::is_zero(c);
+
+        detail::executor_for(z.exec, z.tasks(), z.size(),
+                [a, xp, b, yp, c, zp, scale](int, ptrdiff_t beg, ptrdiff_t end) {
+                    if (scale) {
+                        for(ptrdiff_t i = beg; i < end; ++i)
+                            zp[i] = a * xp[i] + b * yp[i] + c * zp[i];
+                    } else {
+                        for(ptrdiff_t i = beg; i < end; ++i)
+                            zp[i] = a * xp[i] + b * yp[i];
+                    }
+                });
+    }
+};
+
+template <class A, class T1, class T2, class B, class T3>
+struct vmul_impl<
+    A, executor_vector<T1>, executor_vector<T2>,
+    B, executor_vector<T3>
+    >
+{
+    static void apply(A a, const executor_vector<T1> &x,
+            const executor_vector<T2> &y, B b, executor_vector<T3> &z)
+    {
+        const T1 *xp = x.data();
+        const T2 *yp = y.data();
+        T3       *zp = z.data();
+
+        const bool scale = !math::is_zero(b);
+
+        detail::executor_for(z.exec, z.tasks(), z.size(),
+                [a, xp, yp, b, zp, scale](int, ptrdiff_t beg, ptrdiff_t end) {
+                    if (scale) {
+                        for(ptrdiff_t i = beg; i < end; ++i)
+                            zp[i] = a * xp[i] * yp[i] + b * zp[i];
+                    } else {
+                        for(ptrdiff_t i = beg; i < end; ++i)
+                            zp[i] = a * xp[i] * yp[i];
+                    }
+                });
+    }
+};
+
+} // namespace backend
+} // namespace amgcl
+
+#endif
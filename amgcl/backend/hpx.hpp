@@ -41,6 +41,7 @@ THE SOFTWARE.
 #include <boost/range/irange.hpp>
 #include <boost/range/algorithm.hpp>
 #include <boost/range/iterator_range.hpp>
+#include <boost/range/empty.hpp>
 
 #include <amgcl/util.hpp>
 #include <amgcl/backend/builtin.hpp>
@@ -48,6 +49,16 @@ THE SOFTWARE.
 namespace amgcl {
 namespace backend {
 
+namespace detail {
+
+// Dataflow task that only waits for its dependencies.
+struct hpx_wait_all {
+    template <class... T>
+    void operator()(T&&...) const {}
+};
+
+} // namespace detail
+
 /// The matrix is a thin wrapper on top of amgcl::builtin::crs<>.
 template <typename real>
 class hpx_matrix {
@@ -77,7 +88,7 @@ class hpx_matrix {
             index_type mseg = (m + grain_size - 1) / grain_size;
 
             xrange.resize(nseg);
-            yrange.resize(mseg, std::make_tuple(m, 0));
+            yrange.resize(mseg, std::make_tuple(nseg, 0));
 
             auto range = boost::irange<index_type>(0, nseg);
 
@@ -89,18 +100,31 @@ class hpx_matrix {
                         index_type beg = A->ptr[i];
                         index_type end = A->ptr[std::min<index_type>(i + grain_size, n)];
 
+                        if (beg == end) {
+                            xrange[seg] = std::make_tuple(0, 0);
+                            return;
+                        }
+
                         auto mm = std::minmax_element(A->col + beg, A->col + end);
 
                         index_type xbeg = *std::get<0>(mm) / grain_size;
                         index_type xend = *std::get<1>(mm) / grain_size + 1;
 
                         xrange[seg] = std::make_tuple(xbeg, xend);
-
-                        for(index_type i = xbeg; i < xend; ++i) {
-                            std::get<0>(yrange[i]) = std::min(seg,   std::get<0>(yrange[i]));
-                            std::get<1>(yrange[i]) = std::max(seg+1, std::get<1>(yrange[i]));
-                        }
                     });
+
+            // The inverted dependencies are collected serially, since
+            // several segments of y may update the same segment of x.
+            for(index_type seg = 0; seg < nseg; ++seg) {
+                for(index_type i = std::get<0>(xrange[seg]); i < std::get<1>(xrange[seg]); ++i) {
+                    std::get<0>(yrange[i]) = std::min(seg,   std::get<0>(yrange[i]));
+                    std::get<1>(yrange[i]) = std::max(seg+1, std::get<1>(yrange[i]));
+                }
+            }
+
+            // Segments of x that no segment of y depends on get empty ranges.
+            for(auto &r : yrange)
+                if (std::get<0>(r) >= std::get<1>(r)) r = std::make_tuple(0, 0);
         }
 
         size_t rows()     const { return backend::rows(*base);     }
@@ -125,6 +149,12 @@ class hpx_matrix {
  * may be the last one that is allowed to be shorter.
  * A vector of shared_futures corresponding to each of the segments is stored
  * along the data vector to facilitate construction of HPX dependency graph.
+ *
+ * The backend operations only submit the tasks into the dependency graph and
+ * return immediately, so that a complete V-cycle is expressed as a single
+ * dataflow graph. The tasks of different levels may overlap, and the only
+ * synchronization points are the inner products. Use wait() before
+ * accessing the vector data directly.
  */
 template < typename real >
 class hpx_vector {
@@ -137,7 +167,9 @@ class hpx_vector {
         int nseg;        // Number of segments in the vector
         int grain_size;  // Segment size.
 
-        // Futures associated with each segment:
+        // Futures associated with each segment. The segment is safe to read
+        // when the last write to it is done, and is safe to write when the
+        // last write and all the reads that followed it are done.
         mutable std::vector<hpx::shared_future<void>> safe_to_read;
         mutable std::vector<hpx::shared_future<void>> safe_to_write;
 
@@ -160,6 +192,18 @@ class hpx_vector {
             init_futures();
         }
 
+        // The pending tasks reference the vector data, so the vector may not
+        // be destroyed before they are done.
+        ~hpx_vector() {
+            for(auto &f : safe_to_write) if (f.valid()) f.wait();
+        }
+
+        // A copy would share the data but track its own futures, so the
+        // tasks registered with one copy would not be ordered with those of
+        // the other. The vectors are always held by shared_ptr instead.
+        hpx_vector(const hpx_vector&) = delete;
+        hpx_vector& operator=(const hpx_vector&) = delete;
+
         size_t size() const { return buf->size(); }
 
         const real & operator[](size_t i) const { return (*buf)[i]; }
@@ -177,6 +221,15 @@ class hpx_vector {
         const_iterator cbegin() const { return buf->cbegin(); }
         const_iterator cend()   const { return buf->cend();   }
 
+        /// Segment bounds.
+        ptrdiff_t seg_begin(ptrdiff_t seg) const {
+            return seg * grain_size;
+        }
+
+        ptrdiff_t seg_end(ptrdiff_t seg) const {
+            return std::min<ptrdiff_t>((seg + 1) * grain_size, size());
+        }
+
         template <class IdxTuple>
         boost::iterator_range<
             typename std::vector< hpx::shared_future<void> >::iterator
@@ -187,6 +240,41 @@ class hpx_vector {
                     safe_to_read.begin() + std::get<1>(idx)
                     );
         }
+
+        /// Registers the task writing to the segment.
+        void written(ptrdiff_t seg, const hpx::shared_future<void> &task) const {
+            safe_to_read[seg]  = task;
+            safe_to_write[seg] = task;
+        }
+
+        /// Registers the task reading the segment.
+        /** The segment may not be overwritten until the task is done. */
+        void read_by(ptrdiff_t seg, const hpx::shared_future<void> &task) const {
+            // Completed tasks are dropped from the dependency chain.
+            if (safe_to_write[seg].is_ready())
+                safe_to_write[seg] = task;
+            else
+                safe_to_write[seg] = hpx::dataflow(hpx::launch::async,
+                        detail::hpx_wait_all(), safe_to_write[seg], task);
+        }
+
+        /// Registers the tasks reading the segment.
+        template <class Range>
+        void read_by_range(ptrdiff_t seg, const Range &tasks) const {
+            if (boost::empty(tasks)) return;
+
+            if (safe_to_write[seg].is_ready())
+                safe_to_write[seg] = hpx::dataflow(hpx::launch::async,
+                        detail::hpx_wait_all(), tasks);
+            else
+                safe_to_write[seg] = hpx::dataflow(hpx::launch::async,
+                        detail::hpx_wait_all(), safe_to_write[seg], tasks);
+        }
+
+        /// Waits until all pending operations on the vector are done.
+        void wait() const {
+            hpx::wait_all(safe_to_write);
+        }
     private:
         // Segments stored in a continuous array.
         // The base vector is stored with shared_ptr for the same reason as with
@@ -208,6 +296,15 @@ class hpx_vector {
  * This is a backend that is based on HPX -- a general purpose C++ runtime
  * system for parallel and distributed applications of any scale
  * http://stellar-group.org/libraries/hpx.
+ *
+ * \note The backend operations return before they are completed, and so
+ * does the solver. Call hpx_vector::wait() on the solution vector after the
+ * solve and before reading its contents (the destructor of hpx_vector also
+ * waits for the pending tasks, so temporaries are never freed early):
+ * \code
+ * std::tie(iters, error) = solve(*f, *x);
+ * x->wait();
+ * \endcode
  */
 template <typename real>
 struct HPX {
@@ -270,7 +367,11 @@ struct HPX {
                     x.safe_to_write
                     );
 
-            boost::fill(x.safe_to_read, solve);
+            for(ptrdiff_t seg = 0; seg < rhs.nseg; ++seg)
+                rhs.read_by(seg, solve);
+
+            for(ptrdiff_t seg = 0; seg < x.nseg; ++seg)
+                x.written(seg, solve);
         }
     };
 
@@ -388,11 +489,6 @@ struct spmv_impl<
         }
     };
 
-    struct wait_for_it {
-        template <class T>
-        void operator()(T&&) const {}
-    };
-
     static void apply(Alpha alpha, const matrix &A, const vector &x,
             Beta beta, vector &y)
     {
@@ -401,53 +497,34 @@ struct spmv_impl<
 
         using hpx::dataflow;
 
-        auto range = boost::irange(0, y.nseg);
+        for(ptrdiff_t seg = 0; seg < y.nseg; ++seg) {
+            ptrdiff_t beg = y.seg_begin(seg);
+            ptrdiff_t end = y.seg_end(seg);
+
+            hpx::shared_future<void> task;
+
+            if (beta) {
+                // y = alpha * A * x + beta * y
+                task = dataflow(hpx::launch::async,
+                        process_ab{alpha, A, xptr, beta, yptr, beg, end},
+                        y.safe_to_write[seg],
+                        x.safe_range(A.xrange[seg])
+                        );
+            } else {
+                // y = alpha * A * x
+                task = dataflow(hpx::launch::async,
+                        process_a{alpha, A, xptr, yptr, beg, end},
+                        y.safe_to_write[seg],
+                        x.safe_range(A.xrange[seg])
+                        );
+            }
 
-        if (beta) {
-            // y = alpha * A * x + beta * y
-            hpx::parallel::for_each(
-                    hpx::parallel::par,
-                    boost::begin(range), boost::end(range),
-                    [alpha, &A, &x, beta, &y, xptr, yptr](ptrdiff_t seg) {
-                        ptrdiff_t beg = seg * y.grain_size;
-                        ptrdiff_t end = std::min<ptrdiff_t>(beg + y.grain_size, y.size());
-
-                        y.safe_to_read[seg] = dataflow(
-                                hpx::launch::async,
-                                process_ab{alpha, A, xptr, beta, yptr, beg, end},
-                                y.safe_to_read[seg],
-                                y.safe_to_write[seg],
-                                x.safe_range(A.xrange[seg])
-                                );
-                    });
-        } else {
-            // y = alpha * A * x
-            hpx::parallel::for_each(
-                    hpx::parallel::par,
-                    boost::begin(range), boost::end(range),
-                    [alpha, &A, &x, &y, xptr, yptr](ptrdiff_t seg) {
-                        ptrdiff_t beg = seg * y.grain_size;
-                        ptrdiff_t end = std::min<ptrdiff_t>(beg + y.grain_size, y.size());
-
-                        y.safe_to_read[seg] = dataflow(hpx::launch::async,
-                                process_a{alpha, A, xptr, yptr, beg, end},
-                                y.safe_to_write[seg],
-                                x.safe_range(A.xrange[seg])
-                                );
-                    });
+            y.written(seg, task);
         }
 
         // Do not update x until y is ready.
-        range = boost::irange(0, x.nseg);
-        hpx::parallel::for_each(
-                hpx::parallel::par,
-                boost::begin(range), boost::end(range),
-                [&A, &x, &y](ptrdiff_t seg) {
-                    x.safe_to_write[seg] = dataflow(hpx::launch::async,
-                            wait_for_it(),
-                            y.safe_range(A.yrange[seg])
-                            );
-                });
+        for(ptrdiff_t seg = 0; seg < x.nseg; ++seg)
+            x.read_by_range(seg, y.safe_range(A.yrange[seg]));
     }
 };
 
@@ -482,11 +559,6 @@ struct residual_impl<
         }
     };
 
-    struct wait_for_it {
-        template <class T>
-        void operator()(T&&) const {}
-    };
-
     static void apply(const vector &f, const matrix &A, const vector &x,
             vector &r)
     {
@@ -496,33 +568,21 @@ struct residual_impl<
 
         using hpx::dataflow;
 
-        auto range = boost::irange(0, f.nseg);
-        hpx::parallel::for_each(
-                hpx::parallel::par,
-                boost::begin(range), boost::end(range),
-                [&f, &A, &x, &r, xptr, fptr, rptr](ptrdiff_t seg) {
-                    ptrdiff_t beg = seg * f.grain_size;
-                    ptrdiff_t end = std::min<ptrdiff_t>(beg + f.grain_size, f.size());
-
-                    r.safe_to_read[seg] = dataflow(hpx::launch::async,
-                            process{fptr, A, xptr, rptr, beg, end},
-                            f.safe_to_read[seg],
-                            r.safe_to_write[seg],
-                            x.safe_range(A.xrange[seg])
-                            );
-                });
+        for(ptrdiff_t seg = 0; seg < f.nseg; ++seg) {
+            hpx::shared_future<void> task = dataflow(hpx::launch::async,
+                    process{fptr, A, xptr, rptr, f.seg_begin(seg), f.seg_end(seg)},
+                    f.safe_to_read[seg],
+                    r.safe_to_write[seg],
+                    x.safe_range(A.xrange[seg])
+                    );
+
+            f.read_by(seg, task);
+            r.written(seg, task);
+        }
 
         // Do not update x until r is ready.
-        range = boost::irange(0, x.nseg);
-        hpx::parallel::for_each(
-                hpx::parallel::par,
-                boost::begin(range), boost::end(range),
-                [&A, &x, &r](ptrdiff_t seg) {
-                    x.safe_to_write[seg] = dataflow(hpx::launch::async,
-                            wait_for_it(),
-                            r.safe_range(A.yrange[seg])
-                            );
-                });
+        for(ptrdiff_t seg = 0; seg < x.nseg; ++seg)
+            x.read_by_range(seg, r.safe_range(A.yrange[seg]));
     }
 };
 
@@ -551,19 +611,12 @@ struct clear_impl<
 
         using hpx::dataflow;
 
-        auto range = boost::irange(0, x.nseg);
-        hpx::parallel::for_each(
-                hpx::parallel::par,
-                boost::begin(range), boost::end(range),
-                [&x, xptr](ptrdiff_t seg) {
-                    ptrdiff_t beg = seg * x.grain_size;
-                    ptrdiff_t end = std::min<ptrdiff_t>(beg + x.grain_size, x.size());
-
-                    x.safe_to_read[seg] = dataflow(hpx::launch::async,
-                            process{xptr, beg, end},
-                            x.safe_to_write[seg]
-                            );
-                });
+        for(ptrdiff_t seg = 0; seg < x.nseg; ++seg) {
+            x.written(seg, dataflow(hpx::launch::async,
+                        process{xptr, x.seg_begin(seg), x.seg_end(seg)},
+                        x.safe_to_write[seg]
+                        ));
+        }
     }
 };
 
@@ -596,65 +649,33 @@ struct copy_impl<
 
         using hpx::dataflow;
 
-        auto range = boost::irange(0, x.nseg);
-        hpx::parallel::for_each(
-                hpx::parallel::par,
-                boost::begin(range), boost::end(range),
-                [&x, &y, xptr, yptr](ptrdiff_t seg) {
-                    ptrdiff_t beg = seg * x.grain_size;
-                    ptrdiff_t end = std::min<ptrdiff_t>(beg + x.grain_size, x.size());
-
-                    y.safe_to_read[seg] = dataflow(hpx::launch::async,
-                            process{xptr, yptr, beg, end},
-                            x.safe_to_read[seg],
-                            y.safe_to_write[seg]
-                            );
-                });
+        for(ptrdiff_t seg = 0; seg < x.nseg; ++seg) {
+            hpx::shared_future<void> task = dataflow(hpx::launch::async,
+                    process{xptr, yptr, x.seg_begin(seg), x.seg_end(seg)},
+                    x.safe_to_read[seg],
+                    y.safe_to_write[seg]
+                    );
+
+            x.read_by(seg, task);
+            y.written(seg, task);
+        }
     }
 };
 
 template < typename real >
-struct copy<
+struct copy_impl<
     std::vector<real>,
     hpx_vector<real>
     >
 {
     typedef hpx_vector<real> vector;
 
-    struct process {
-        const real *xptr;
-        real       *yptr;
-
-        ptrdiff_t beg;
-        ptrdiff_t end;
-
-        template <class... T>
-        void operator()(T&&...) const {
-            for(ptrdiff_t i = beg; i < end; ++i)
-                yptr[i] = xptr[i];
-        }
-    };
-
     static void apply(const std::vector<real> &x, vector &y)
     {
-        const real *xptr = &x[0];
-        real       *yptr = &y[0];
-
-        using hpx::dataflow;
-
-        auto range = boost::irange(0, y.nseg);
-        hpx::parallel::for_each(
-                hpx::parallel::par,
-                boost::begin(range), boost::end(range),
-                [&y, xptr, yptr](ptrdiff_t seg) {
-                    ptrdiff_t beg = seg * y.grain_size;
-                    ptrdiff_t end = std::min<ptrdiff_t>(beg + y.grain_size, y.size());
-
-                    y.safe_to_read[seg] = dataflow(hpx::launch::async,
-                            process{xptr, yptr, beg, end},
-                            y.safe_to_write[seg]
-                            );
-                });
+        // The source is not tracked by the dependency graph, so the copy is
+        // done synchronously.
+        y.wait();
+        std::copy(x.begin(), x.end(), y.begin());
     }
 };
 
@@ -674,7 +695,7 @@ struct inner_product_impl<
         ptrdiff_t end;
 
         template <class... T>
-        double operator()(T&&...) const {
+        real operator()(T&&...) const {
             real sum = 0;
 
             for(ptrdiff_t i = beg; i < end; ++i)
@@ -691,22 +712,22 @@ struct inner_product_impl<
 
         using hpx::dataflow;
 
-        auto range = boost::irange(0, x.nseg);
-        return hpx::parallel::transform_reduce(
-                hpx::parallel::par,
-                boost::begin(range), boost::end(range),
-                math::zero<real>(), std::plus<real>(),
-                [&x, &y, xptr, yptr](ptrdiff_t seg) {
-                    ptrdiff_t beg = seg * x.grain_size;
-                    ptrdiff_t end = std::min<ptrdiff_t>(beg + x.grain_size, x.size());
-
-                    return dataflow(hpx::launch::async,
-                            process{xptr, yptr, beg, end},
-                            x.safe_to_read[seg],
-                            y.safe_to_read[seg]
-                            ).get();
-                }
-                );
+        // This is the only synchronization point: the partial sums are
+        // submitted into the graph, and then collected.
+        std::vector< hpx::future<real> > part;
+        part.reserve(x.nseg);
+
+        for(ptrdiff_t seg = 0; seg < x.nseg; ++seg) {
+            part.push_back(dataflow(hpx::launch::async,
+                        process{xptr, yptr, x.seg_begin(seg), x.seg_end(seg)},
+                        x.safe_to_read[seg],
+                        y.safe_to_read[seg]
+                        ));
+        }
+
+        real sum = math::zero<real>();
+        for(auto &p : part) sum += p.get();
+        return sum;
     }
 };
 
@@ -760,38 +781,30 @@ struct axpby_impl<
 
         using hpx::dataflow;
 
-        auto range = boost::irange(0, x.nseg);
-        if (b) {
-            // y = a * x + b * y;
-            hpx::parallel::for_each(
-                    hpx::parallel::par,
-                    boost::begin(range), boost::end(range),
-                    [a, &x, b, &y, xptr, yptr](ptrdiff_t seg) {
-                        ptrdiff_t beg = seg * x.grain_size;
-                        ptrdiff_t end = std::min<ptrdiff_t>(beg + x.grain_size, x.size());
-
-                        y.safe_to_read[seg] = dataflow(hpx::launch::async,
-                                process_ab{a, xptr, b, yptr, beg, end},
-                                x.safe_to_read[seg],
-                                y.safe_to_read[seg],
-                                y.safe_to_write[seg]
-                                );
-                    });
-        } else {
-            // y = a * x;
-            hpx::parallel::for_each(
-                    hpx::parallel::par,
-                    boost::begin(range), boost::end(range),
-                    [a, &x, &y, xptr, yptr](ptrdiff_t seg) {
-                        ptrdiff_t beg = seg * x.grain_size;
-                        ptrdiff_t end = std::min<ptrdiff_t>(beg + x.grain_size, x.size());
-
-                        y.safe_to_read[seg] = dataflow(hpx::launch::async,
-                                process_a{a, xptr, yptr, beg, end},
-                                x.safe_to_read[seg],
-                                y.safe_to_write[seg]
-                                );
-                    });
+        for(ptrdiff_t seg = 0; seg < x.nseg; ++seg) {
+            ptrdiff_t beg = x.seg_begin(seg);
+            ptrdiff_t end = x.seg_end(seg);
+
+            hpx::shared_future<void> task;
+
+            if (b) {
+                // y = a * x + b * y;
+                task = dataflow(hpx::launch::async,
+                        process_ab{a, xptr, b, yptr, beg, end},
+                        x.safe_to_read[seg],
+                        y.safe_to_write[seg]
+                        );
+            } else {
+                // y = a * x;
+                task = dataflow(hpx::launch::async,
+                        process_a{a, xptr, yptr, beg, end},
+                        x.safe_to_read[seg],
+                        y.safe_to_write[seg]
+                        );
+            }
+
+            x.read_by(seg, task);
+            y.written(seg, task);
         }
     }
 };
@@ -852,40 +865,33 @@ struct axpbypcz_impl<
 
         using hpx::dataflow;
 
-        auto range = boost::irange(0, x.nseg);
-        if (c) {
-            //z = a * x + b * y + c * z;
-            hpx::parallel::for_each(
-                    hpx::parallel::par,
-                    boost::begin(range), boost::end(range),
-                    [a, &x, b, &y, c, &z, xptr, yptr, zptr](ptrdiff_t seg) {
-                        ptrdiff_t beg = seg * x.grain_size;
-                        ptrdiff_t end = std::min<ptrdiff_t>(beg + x.grain_size, x.size());
-
-                        z.safe_to_read[seg] = dataflow(hpx::launch::async,
-                                process_abc{a, xptr, b, yptr, c, zptr, beg, end},
-                                x.safe_to_read[seg],
-                                y.safe_to_read[seg],
-                                z.safe_to_read[seg],
-                                z.safe_to_write[seg]
-                                );
-                    });
-        } else {
-            //z = a * x + b * y;
-            hpx::parallel::for_each(
-                    hpx::parallel::par,
-                    boost::begin(range), boost::end(range),
-                    [a, &x, b, &y, &z, xptr, yptr, zptr](ptrdiff_t seg) {
-                        ptrdiff_t beg = seg * x.grain_size;
-                        ptrdiff_t end = std::min<ptrdiff_t>(beg + x.grain_size, x.size());
-
-                        z.safe_to_read[seg] = dataflow(hpx::launch::async,
-                                process_ab{a, xptr, b, yptr, zptr, beg, end},
-                                x.safe_to_read[seg],
-                                y.safe_to_read[seg],
-                                z.safe_to_write[seg]
-                                );
-                    });
+        for(ptrdiff_t seg = 0; seg < x.nseg; ++seg) {
+            ptrdiff_t beg = x.seg_begin(seg);
+            ptrdiff_t end = x.seg_end(seg);
+
+            hpx::shared_future<void> task;
+
+            if (c) {
+                //z = a * x + b * y + c * z;
+                task = dataflow(hpx::launch::async,
+                        process_abc{a, xptr, b, yptr, c, zptr, beg, end},
+                        x.safe_to_read[seg],
+                        y.safe_to_read[seg],
+                        z.safe_to_write[seg]
+                        );
+            } else {
+                //z = a * x + b * y;
+                task = dataflow(hpx::launch::async,
+                        process_ab{a, xptr, b, yptr, zptr, beg, end},
+                        x.safe_to_read[seg],
+                        y.safe_to_read[seg],
+                        z.safe_to_write[seg]
+                        );
+            }
+
+            x.read_by(seg, task);
+            y.read_by(seg, task);
+            z.written(seg, task);
         }
     }
 };
@@ -939,40 +945,33 @@ struct vmul_impl<
 
         using hpx::dataflow;
 
-        auto range = boost::irange(0, x.nseg);
-        if (b) {
-            //z = a * x * y + b * z;
-            hpx::parallel::for_each(
-                    hpx::parallel::par,
-                    boost::begin(range), boost::end(range),
-                    [a, &x, &y, b, &z, xptr, yptr, zptr](ptrdiff_t seg) {
-                        ptrdiff_t beg = seg * x.grain_size;
-                        ptrdiff_t end = std::min<ptrdiff_t>(beg + x.grain_size, x.size());
-
-                        z.safe_to_read[seg] = dataflow(hpx::launch::async,
-                                process_ab{a, xptr, yptr, b, zptr, beg, end},
-                                x.safe_to_read[seg],
-                                y.safe_to_read[seg],
-                                z.safe_to_read[seg],
-                                z.safe_to_write[seg]
-                                );
-                    });
-        } else {
-            //z = a * x * y;
-            hpx::parallel::for_each(
-                    hpx::parallel::par,
-                    boost::begin(range), boost::end(range),
-                    [a, &x, &y, &z, xptr, yptr, zptr](ptrdiff_t seg) {
-                        ptrdiff_t beg = seg * x.grain_size;
-                        ptrdiff_t end = std::min<ptrdiff_t>(beg + x.grain_size, x.size());
-
-                        z.safe_to_read[seg] = dataflow(hpx::launch::async,
-                                process_a{a, xptr, yptr, zptr, beg, end},
-                                x.safe_to_read[seg],
-                                y.safe_to_read[seg],
-                                z.safe_to_write[seg]
-                                );
-                    });
+        for(ptrdiff_t seg = 0; seg < x.nseg; ++seg) {
+            ptrdiff_t beg = x.seg_begin(seg);
+            ptrdiff_t end = x.seg_end(seg);
+
+            hpx::shared_future<void> task;
+
+            if (b) {
+                //z = a * x * y + b * z;
+                task = dataflow(hpx::launch::async,
+                        process_ab{a, xptr, yptr, b, zptr, beg, end},
+                        x.safe_to_read[seg],
+                        y.safe_to_read[seg],
+                        z.safe_to_write[seg]
+                        );
+            } else {
+                //z = a * x * y;
+                task = dataflow(hpx::launch::async,
+                        process_a{a, xptr, yptr, zptr, beg, end},
+                        x.safe_to_read[seg],
+                        y.safe_to_read[seg],
+                        z.safe_to_write[seg]
+                        );
+            }
+
+            x.read_by(seg, task);
+            y.read_by(seg, task);
+            z.written(seg, task);
         }
     }
 };
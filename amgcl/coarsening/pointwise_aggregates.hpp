@@ -91,8 +91,6 @@ class pointwise_aggregates {
         pointwise_aggregates(const Matrix &A, const params &prm, unsigned min_aggregate)
             : count(0)
         {
-            typedef typename backend::value_type<Matrix>::type value_type;
-            typedef typename math::scalar_of<value_type>::type scalar_type;
             if (prm.block_size == 1) {
                 plain_aggregates aggr(A, prm);
 
@@ -106,7 +104,7 @@ class pointwise_aggregates {
                 id.resize( rows(A) );
 
                 auto ap = backend::pointwise_matrix(A, prm.block_size);
-                backend::crs<scalar_type> &Ap = *ap;
+                auto &Ap = *ap;
 
                 plain_aggregates pw_aggr(Ap, prm);
 
@@ -43,6 +43,134 @@ THE SOFTWARE.
 
 namespace amgcl {
 namespace coarsening {
+namespace detail {
+
+// Split variables into C(oarse) and F(ine) sets.
+//
+// S holds the strong connections of A in S.val, and its transposition in
+// S.ptr and S.col (see ruge_stuben::connect()). Also used by the distributed
+// version of the coarsening (amgcl/mpi/coarsening/ruge_stuben.hpp).
+template <typename Val, typename Col, typename Ptr>
+void cfsplit(
+        backend::crs<Val,  Col, Ptr> const &A,
+        backend::crs<char, Col, Ptr> const &S,
+        std::vector<char>                  &cf
+        )
+{
+    const size_t n = rows(A);
+
+    std::vector<Col> lambda(n);
+
+    // Initialize lambdas:
+    for(size_t i = 0; i < n; ++i) {
+        Col temp = 0;
+        for(Ptr j = S.ptr[i], e = S.ptr[i+1]; j < e; ++j)
+            temp += ( cf[ S.col[j] ] == 'U' ? 1 : 2 );
+        lambda[i] = temp;
+    }
+
+    // Keep track of variable groups with equal lambda values.
+    // ptr - start of a group;
+    // cnt - size of a group;
+    // i2n - variable number;
+    // n2i - vaiable position in a group.
+    std::vector<Ptr> ptr(n+1, 0);
+    std::vector<Ptr> cnt(n, 0);
+    std::vector<Ptr> i2n(n);
+    std::vector<Ptr> n2i(n);
+
+    for(size_t i = 0; i < n; ++i) ++ptr[lambda[i] + 1];
+
+    std::partial_sum(ptr.begin(), ptr.end(), ptr.begin());
+
+    for(size_t i = 0; i < n; ++i) {
+        Col lam = lambda[i];
+        Ptr idx = ptr[lam] + cnt[lam]++;
+        i2n[idx] = i;
+        n2i[i] = idx;
+    }
+
+    // Process variables by decreasing lambda value.
+    // 1. The vaiable with maximum value of lambda becomes next C-variable.
+    // 2. Its neighbours from S' become F-variables.
+    // 3. Keep lambda values in sync.
+    for(size_t top = n; top-- > 0; ) {
+        Ptr i   = i2n[top];
+        Col lam = lambda[i];
+
+        if (lam == 0) {
+            std::replace(cf.begin(), cf.end(), 'U', 'C');
+            break;
+        }
+
+        // Remove tne variable from its group.
+        --cnt[lam];
+
+        if (cf[i] == 'F') continue;
+
+        // Mark the variable as 'C'.
+        cf[i] = 'C';
+
+        // Its neighbours from S' become F-variables.
+        for(Ptr j = S.ptr[i], e = S.ptr[i + 1]; j < e; ++j) {
+            Col c = S.col[j];
+
+            if (cf[c] != 'U') continue;
+
+            cf[c] = 'F';
+
+            // Increase lambdas of the newly created F's neighbours.
+            for(Ptr aj = A.ptr[c], ae = A.ptr[c + 1]; aj < ae; ++aj) {
+                if (!S.val[aj]) continue;
+
+                Col ac    = A.col[aj];
+                Col lam_a = lambda[ac];
+
+                if (cf[ac] != 'U' || static_cast<size_t>(lam_a) + 1 >= n)
+                    continue;
+
+                Ptr old_pos = n2i[ac];
+                Ptr new_pos = ptr[lam_a] + cnt[lam_a] - 1;
+
+                n2i[i2n[old_pos]] = new_pos;
+                n2i[i2n[new_pos]] = old_pos;
+
+                std::swap(i2n[old_pos], i2n[new_pos]);
+
+                --cnt[lam_a];
+                ++cnt[lam_a + 1];
+                ptr[lam_a + 1] = ptr[lam_a] + cnt[lam_a];
+
+                lambda[ac] = lam_a + 1;
+            }
+        }
+
+        // Decrease lambdas of the newly create C's neighbours.
+        for(Ptr j = A.ptr[i], e = A.ptr[i + 1]; j < e; j++) {
+            if (!S.val[j]) continue;
+
+            Col c   = A.col[j];
+            Col lam = lambda[c];
+
+            if (cf[c] != 'U' || lam == 0) continue;
+
+            Ptr old_pos = n2i[c];
+            Ptr new_pos = ptr[lam];
+
+            n2i[i2n[old_pos]] = new_pos;
+            n2i[i2n[new_pos]] = old_pos;
+
+            std::swap(i2n[old_pos], i2n[new_pos]);
+
+            --cnt[lam];
+            ++cnt[lam - 1];
+            ++ptr[lam];
+            lambda[c] = lam - 1;
+        }
+    }
+}
+
+} // namespace detail
 
 /// Classic Ruge-Stuben coarsening with direct interpolation.
 /**
@@ -112,11 +240,11 @@ struct ruge_stuben {
         static const Val zero = math::zero<Val>();
 
         std::vector<char> cf(n, 'U');
-        backend::crs<char, ptrdiff_t, ptrdiff_t> S;
+        backend::crs<char, typename Matrix::col_type, typename Matrix::ptr_type> S;
 
         AMGCL_TIC("C/F split");
         connect(A, prm.eps_strong, S, cf);
-        cfsplit(A, S, cf);
+        detail::cfsplit(A, S, cf);
         AMGCL_TOC("C/F split");
 
         AMGCL_TIC("interpolation");
@@ -309,127 +437,6 @@ struct ruge_stuben {
             std::rotate(S.ptr, S.ptr + n, S.ptr + n + 1);
             S.ptr[0] = 0;
         }
-
-        // Split variables into C(oarse) and F(ine) sets.
-        template <typename Val, typename Col, typename Ptr>
-        static void cfsplit(
-                backend::crs<Val,  Col, Ptr> const &A,
-                backend::crs<char, Col, Ptr> const &S,
-                std::vector<char>                  &cf
-                )
-        {
-            const size_t n = rows(A);
-
-            std::vector<Col> lambda(n);
-
-            // Initialize lambdas:
-            for(size_t i = 0; i < n; ++i) {
-                Col temp = 0;
-                for(Ptr j = S.ptr[i], e = S.ptr[i+1]; j < e; ++j)
-                    temp += ( cf[ S.col[j] ] == 'U' ? 1 : 2 );
-                lambda[i] = temp;
-            }
-
-            // Keep track of variable groups with equal lambda values.
-            // ptr - start of a group;
-            // cnt - size of a group;
-            // i2n - variable number;
-            // n2i - vaiable position in a group.
-            std::vector<Ptr> ptr(n+1, 0);
-            std::vector<Ptr> cnt(n, 0);
-            std::vector<Ptr> i2n(n);
-            std::vector<Ptr> n2i(n);
-
-            for(size_t i = 0; i < n; ++i) ++ptr[lambda[i] + 1];
-
-            std::partial_sum(ptr.begin(), ptr.end(), ptr.begin());
-
-            for(size_t i = 0; i < n; ++i) {
-                Col lam = lambda[i];
-                Ptr idx = ptr[lam] + cnt[lam]++;
-                i2n[idx] = i;
-                n2i[i] = idx;
-            }
-
-            // Process variables by decreasing lambda value.
-            // 1. The vaiable with maximum value of lambda becomes next C-variable.
-            // 2. Its neighbours from S' become F-variables.
-            // 3. Keep lambda values in sync.
-            for(size_t top = n; top-- > 0; ) {
-                Ptr i   = i2n[top];
-                Col lam = lambda[i];
-
-                if (lam == 0) {
-                    std::replace(cf.begin(), cf.end(), 'U', 'C');
-                    break;
-                }
-
-                // Remove tne variable from its group.
-                --cnt[lam];
-
-                if (cf[i] == 'F') continue;
-
-                // Mark the variable as 'C'.
-                cf[i] = 'C';
-
-                // Its neighbours from S' become F-variables.
-                for(Ptr j = S.ptr[i], e = S.ptr[i + 1]; j < e; ++j) {
-                    Col c = S.col[j];
-
-                    if (cf[c] != 'U') continue;
-
-                    cf[c] = 'F';
-
-                    // Increase lambdas of the newly created F's neighbours.
-                    for(Ptr aj = A.ptr[c], ae = A.ptr[c + 1]; aj < ae; ++aj) {
-                        if (!S.val[aj]) continue;
-
-                        Col ac    = A.col[aj];
-                        Col lam_a = lambda[ac];
-
-                        if (cf[ac] != 'U' || static_cast<size_t>(lam_a) + 1 >= n)
-                            continue;
-
-                        Ptr old_pos = n2i[ac];
-                        Ptr new_pos = ptr[lam_a] + cnt[lam_a] - 1;
-
-                        n2i[i2n[old_pos]] = new_pos;
-                        n2i[i2n[new_pos]] = old_pos;
-
-                        std::swap(i2n[old_pos], i2n[new_pos]);
-
-                        --cnt[lam_a];
-                        ++cnt[lam_a + 1];
-                        ptr[lam_a + 1] = ptr[lam_a] + cnt[lam_a];
-
-                        lambda[ac] = lam_a + 1;
-                    }
-                }
-
-                // Decrease lambdas of the newly create C's neighbours.
-                for(Ptr j = A.ptr[i], e = A.ptr[i + 1]; j < e; j++) {
-                    if (!S.val[j]) continue;
-
-                    Col c   = A.col[j];
-                    Col lam = lambda[c];
-
-                    if (cf[c] != 'U' || lam == 0) continue;
-
-                    Ptr old_pos = n2i[c];
-                    Ptr new_pos = ptr[lam];
-
-                    n2i[i2n[old_pos]] = new_pos;
-                    n2i[i2n[new_pos]] = old_pos;
-
-                    std::swap(i2n[old_pos], i2n[new_pos]);
-
-                    --cnt[lam];
-                    ++cnt[lam - 1];
-                    ++ptr[lam];
-                    lambda[c] = lam - 1;
-                }
-            }
-        }
 };
 
 } // namespace coarsening
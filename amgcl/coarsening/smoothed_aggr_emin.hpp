@@ -101,7 +101,7 @@ struct smoothed_aggr_emin {
                 );
 
         // Filter the system matrix
-        backend::crs<Val> Af;
+        Matrix Af;
         Af.set_size(rows(A), cols(A));
         Af.ptr[0] = 0;
 
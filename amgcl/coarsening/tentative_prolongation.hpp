@@ -175,7 +175,7 @@ std::shared_ptr<Matrix> tentative_prolongation(
                     Bnew.push_back( qr.R(ii,jj) );
 
             for(size_t ii = 0; ii < d; ++ii, ++offset) {
-                ptrdiff_t  *c = &P->col[P->ptr[order[offset]]];
+                auto       *c = &P->col[P->ptr[order[offset]]];
                 value_type *v = &P->val[P->ptr[order[offset]]];
 
                 for(int jj = 0; jj < nullspace.cols; ++jj) {
@@ -0,0 +1,134 @@
+#ifndef AMGCL_MAKE_REORDERED_SOLVER_HPP
+#define AMGCL_MAKE_REORDERED_SOLVER_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2018 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/make_reordered_solver.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Iterative solver working with the reordered copy of the system.
+ */
+
+#include <memory>
+#include <tuple>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/adapter/reorder.hpp>
+#include <amgcl/make_solver.hpp>
+
+namespace amgcl {
+
+/// Creates solver that works with the reordered copy of the system matrix.
+/**
+ * The matrix is reordered once on construction (see
+ * amgcl::adapter::reorder::materialize()), and the rhs and the solution
+ * vectors are permuted on entry into and on exit from the solver, so that the
+ * user works with the original numbering. The work vectors for the permuted
+ * rhs and solution are allocated once on construction, so that concurrent
+ * calls to operator() on the same instance are not allowed. The reordered
+ * matrix is handed to the solver as is, without another copy. Requires the
+ * builtin backend.
+ */
+template <
+    class Precond,
+    class IterativeSolver,
+    class Ordering = amgcl::reorder::cuthill_mckee<false>
+    >
+class make_reordered_solver {
+    public:
+        typedef typename Precond::backend_type             backend_type;
+        typedef typename backend_type::value_type          value_type;
+        typedef typename backend_type::params              backend_params;
+        typedef typename math::scalar_of<value_type>::type scalar_type;
+        typedef typename math::rhs_of<value_type>::type    rhs_type;
+
+        typedef typename make_solver<Precond, IterativeSolver>::params params;
+
+        template <class Matrix>
+        make_reordered_solver(
+                const Matrix &A,
+                const params &prm = params(),
+                const backend_params &bprm = backend_params()
+                ) : n(backend::rows(A)), perm(A), F(n, false), X(n, false)
+        {
+            S = std::make_shared<Solver>(perm.materialize(A), prm, bprm);
+        }
+
+        /// Rebuilds the preconditioner for the new values of the matrix.
+        /**
+         * The matrix should have the same structure as the one used on
+         * construction, so that the ordering is still valid.
+         * \sa amgcl::amg::rebuild()
+         */
+        template <class Matrix>
+        void rebuild(
+                const Matrix &A,
+                const backend_params &bprm = backend_params()
+                )
+        {
+            S->rebuild(perm.materialize(A), bprm);
+        }
+
+        template <class Vec1, class Vec2>
+        std::tuple<size_t, scalar_type>
+        operator()(const Vec1 &rhs, Vec2 &&x) const {
+            perm.forward(rhs, F);
+            perm.forward(x,   X);
+
+            std::tuple<size_t, scalar_type> info = (*S)(F, X);
+
+            perm.inverse(X, x);
+            return info;
+        }
+
+        const Precond& precond() const {
+            return S->precond();
+        }
+
+        std::shared_ptr<typename Precond::matrix> system_matrix_ptr() const {
+            return S->system_matrix_ptr();
+        }
+
+        /// The reordered system matrix.
+        typename Precond::matrix const& system_matrix() const {
+            return S->system_matrix();
+        }
+
+        friend std::ostream& operator<<(std::ostream &os, const make_reordered_solver &p) {
+            return os << *p.S << std::endl;
+        }
+    private:
+        typedef make_solver<Precond, IterativeSolver> Solver;
+
+        ptrdiff_t n;
+        adapter::reorder<Ordering> perm;
+        std::shared_ptr<Solver> S;
+
+        mutable backend::numa_vector<rhs_type> F, X;
+};
+
+} // namespace amgcl
+
+#endif
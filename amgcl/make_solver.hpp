@@ -56,7 +56,7 @@ class make_solver {
 
         typedef typename backend_type::value_type value_type;
         typedef typename backend_type::params backend_params;
-        typedef typename backend::builtin<value_type>::matrix build_matrix;
+        typedef typename backend::builtin_matrix<backend_type>::type build_matrix;
 
         typedef typename math::scalar_of<value_type>::type scalar_type;
 
@@ -109,6 +109,27 @@ class make_solver {
             S(backend::rows(*A), prm.solver, bprm)
         {}
 
+        /// Rebuilds the preconditioner for the new matrix values.
+        /** \sa amgcl::amg::rebuild() */
+        template <class Matrix>
+        void rebuild(
+                const Matrix &A,
+                const backend_params &bprm = backend_params()
+                )
+        {
+            P.rebuild(A, bprm);
+        }
+
+        // Rebuilds the preconditioner for the new matrix values.
+        // Takes shared pointer to the matrix in internal format.
+        void rebuild(
+                std::shared_ptr<build_matrix> A,
+                const backend_params &bprm = backend_params()
+                )
+        {
+            P.rebuild(A, bprm);
+        }
+
         /** Computes the solution for the given system matrix \p A and the
          * right-hand side \p rhs.  Returns the number of iterations made and
          * the achieved residual as a ``std::tuple``. The solution vector
@@ -45,6 +45,29 @@ THE SOFTWARE.
 
 namespace amgcl {
 namespace mpi {
+namespace detail {
+
+// Coarsening schemes may provide a coarse_operator() overload that takes a
+// galerkin_plan, so that the coarse matrix may be updated for the new values
+// of the system matrix. Schemes without the overload compute the Galerkin
+// product from scratch on each rebuild.
+template <class Coarsening, class Matrix, class Plan>
+auto coarse_operator(const Coarsening &C,
+        const Matrix &A, const Matrix &P, const Matrix &R, Plan &plan, int)
+    -> decltype(C.coarse_operator(A, P, R, plan))
+{
+    return C.coarse_operator(A, P, R, plan);
+}
+
+template <class Coarsening, class Matrix, class Plan>
+auto coarse_operator(const Coarsening &C,
+        const Matrix &A, const Matrix &P, const Matrix &R, Plan&, long)
+    -> decltype(C.coarse_operator(A, P, R))
+{
+    return C.coarse_operator(A, P, R);
+}
+
+} // namespace detail
 
 template <
     class Backend,
@@ -107,10 +130,36 @@ class amg {
             /// Number of cycles to make as part of preconditioning.
             unsigned pre_cycles;
 
+            /// Keep the data required to rebuild the hierarchy.
+            /**
+             * When set, the transfer operators, the repartitioning
+             * permutations and the product plans are kept, so that rebuild()
+             * may update the hierarchy for the new matrix values.
+             */
+            bool allow_rebuild;
+
+            /// Give the cores of the idle processes to the active ones.
+            /**
+             * When the coarse levels are agglomerated onto a subset of the
+             * processes, the processes that are still active on a compute
+             * node increase the number of OpenMP threads, so that all cores
+             * of the node are used.
+             *
+             * \note The idle processes wait for the active ones inside MPI
+             * calls, and most MPI implementations busy-poll there by
+             * default, which oversubscribes the cores given away. The MPI
+             * library should be told to yield or block when idle, e.g. with
+             * OMPI_MCA_mpi_yield_when_idle=1 for Open MPI, or
+             * I_MPI_WAIT_MODE=1 for Intel MPI. Otherwise the expanded
+             * thread teams compete for the cores with the polling processes.
+             */
+            bool expand_threads;
+
             params() :
                 coarse_enough(DirectSolver::coarse_enough()), direct_coarse(true),
                 max_levels( std::numeric_limits<unsigned>::max() ),
-                npre(1), npost(1), ncycle(1), pre_cycles(1)
+                npre(1), npost(1), ncycle(1), pre_cycles(1), allow_rebuild(false),
+                expand_threads(false)
             {}
 
             params(const boost::property_tree::ptree &p)
@@ -124,9 +173,11 @@ class amg {
                   AMGCL_PARAMS_IMPORT_VALUE(p, npre),
                   AMGCL_PARAMS_IMPORT_VALUE(p, npost),
                   AMGCL_PARAMS_IMPORT_VALUE(p, ncycle),
-                  AMGCL_PARAMS_IMPORT_VALUE(p, pre_cycles)
+                  AMGCL_PARAMS_IMPORT_VALUE(p, pre_cycles),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, allow_rebuild),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, expand_threads)
             {
-                check_params(p, {"coarsening", "relax", "direct", "repart", "coarse_enough",  "direct_coarse", "max_levels", "npre", "npost", "ncycle", "pre_cycles"});
+                check_params(p, {"coarsening", "relax", "direct", "repart", "coarse_enough",  "direct_coarse", "max_levels", "npre", "npost", "ncycle", "pre_cycles", "allow_rebuild", "expand_threads"});
 
                 amgcl::precondition(max_levels > 0, "max_levels should be positive");
             }
@@ -147,6 +198,8 @@ class amg {
                 AMGCL_PARAMS_EXPORT_VALUE(p, path, npost);
                 AMGCL_PARAMS_EXPORT_VALUE(p, path, ncycle);
                 AMGCL_PARAMS_EXPORT_VALUE(p, path, pre_cycles);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, allow_rebuild);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, expand_threads);
             }
         } prm;
 
@@ -156,7 +209,7 @@ class amg {
                 const Matrix &A,
                 const params &prm = params(),
                 const backend_params &bprm = backend_params()
-           ) : prm(prm), repart(prm.repart)
+           ) : prm(prm), repart(prm.repart), pattern(0)
         {
             init(std::make_shared<matrix>(comm, A, backend::rows(A)), bprm);
         }
@@ -166,11 +219,60 @@ class amg {
                 std::shared_ptr<matrix> A,
                 const params &prm = params(),
                 const backend_params &bprm = backend_params()
-           ) : prm(prm), repart(prm.repart)
+           ) : prm(prm), repart(prm.repart), pattern(0)
         {
             init(A, bprm);
         }
 
+        /// Rebuilds the hierarchy for the new values of the system matrix.
+        /**
+         * The matrix should have the same sparsity pattern and the same
+         * distribution between the processes as the one used to construct
+         * the preconditioner. The transfer operators, the repartitioning and
+         * the communication patterns are reused; only the Galerkin products,
+         * the smoothers, and the coarse solver are updated. Requires
+         * params::allow_rebuild to be set. The pattern is compared with the
+         * original one by a checksum of the local nonzero positions.
+         */
+        template <class Matrix>
+        void rebuild(
+                const Matrix &M,
+                const backend_params &bprm = backend_params()
+                )
+        {
+            rebuild(std::make_shared<matrix>(A->comm(), M, backend::rows(M)), bprm);
+        }
+
+        void rebuild(
+                std::shared_ptr<matrix> A,
+                const backend_params &bprm = backend_params()
+                )
+        {
+            A->comm().check(prm.allow_rebuild, "allow_rebuild is not set!");
+            A->comm().check(
+                    A->glob_rows()     == this->A->glob_rows() &&
+                    A->glob_nonzeros() == this->A->glob_nonzeros() &&
+                    detail::pattern_checksum(*A) == pattern,
+                    "The matrix structure has changed!");
+
+            this->A = A;
+            Coarsening C(prm.coarsening);
+
+            for(level &lvl : levels) {
+                scoped_threads nt(lvl.nthreads);
+                A = lvl.rebuild(A, C, prm, bprm);
+                if (!A) break;
+            }
+
+            // The finest level moves the system matrix to the backend, unless
+            // the whole problem is handled by the direct solver.
+            if (levels.empty() || levels.front().solve) {
+                AMGCL_TIC("move to backend");
+                this->A->move_to_backend(bprm);
+                AMGCL_TOC("move to backend");
+            }
+        }
+
         template <class Vec1, class Vec2>
         void cycle(const Vec1 &rhs, Vec2 &&x) const {
             cycle(levels.begin(), rhs, x);
@@ -197,23 +299,35 @@ class amg {
         }
     private:
         struct level {
+            // The data kept for rebuild(): the transfer operators (before
+            // repartitioning), the repartitioning operators, and the plans
+            // of the products that form the coarse matrix.
+            struct rebuild_data {
+                std::shared_ptr<matrix> P, R, I, J;
+                galerkin_plan<Backend>  RAP;
+                product_plan<Backend>   AI, JAI;
+            };
+
             ptrdiff_t nrows, nnz;
             int active_procs;
+            int nthreads;
 
             std::shared_ptr<matrix>       A, P, R;
             std::shared_ptr<vector>       f, u, t;
             std::shared_ptr<Relaxation>   relax;
             std::shared_ptr<DirectSolver> solve;
+            std::shared_ptr<rebuild_data> keep;
 
-            level() {}
+            level() : nthreads(0) {}
 
             level(
                     std::shared_ptr<matrix> a,
                     params &prm,
                     const backend_params &bprm,
+                    int nthreads,
                     bool direct = false
                  )
-                : nrows(a->glob_rows()), nnz(a->glob_nonzeros()),
+                : nrows(a->glob_rows()), nnz(a->glob_nonzeros()), nthreads(nthreads),
                   f(Backend::create_vector(a->loc_rows(), bprm)),
                   u(Backend::create_vector(a->loc_rows(), bprm))
             {
@@ -236,7 +350,8 @@ class amg {
                 }
             }
 
-            std::shared_ptr<matrix> step_down(Coarsening &C, const Repartition &repart)
+            std::shared_ptr<matrix> step_down(
+                    Coarsening &C, const Repartition &repart, bool allow_rebuild)
             {
                 AMGCL_TIC("transfer operators");
                 std::tie(P, R) = C.transfer_operators(*A);
@@ -253,6 +368,10 @@ class amg {
                     return std::shared_ptr<matrix>();
                 }
 
+                partition::coarsen_coords(repart, *R);
+
+                if (allow_rebuild) return step_down_keep(C, repart);
+
                 AMGCL_TIC("coarse operator");
                 auto Ac = C.coarse_operator(*A, *P, *R);
                 AMGCL_TOC("coarse operator");
@@ -271,6 +390,90 @@ class amg {
                 return Ac;
             }
 
+            // Same as the second half of step_down(), but keeps the data
+            // required by rebuild().
+            std::shared_ptr<matrix> step_down_keep(
+                    Coarsening &C, const Repartition &repart)
+            {
+                keep = std::make_shared<rebuild_data>();
+
+                AMGCL_TIC("coarse operator");
+                auto Ac = detail::coarse_operator(C, *A, *P, *R, keep->RAP, 0);
+                AMGCL_TOC("coarse operator");
+
+                keep->P = P;
+                keep->R = R;
+
+                if (repart.is_needed(*Ac)) {
+                    AMGCL_TIC("partition");
+                    keep->I = repart(*Ac, block_size(C));
+                    keep->J = transpose(*keep->I);
+
+                    P  = product(*P, *keep->I);
+                    R  = product(*keep->J, *R);
+                    Ac = keep->JAI(*keep->J, *keep->AI(*Ac, *keep->I));
+                    AMGCL_TOC("partition");
+                } else {
+                    // P and R are moved to the backend, which renumbers the
+                    // columns of their remote parts in place.
+                    keep->P = copy(*P);
+                    keep->R = copy(*R);
+                }
+
+                return Ac;
+            }
+
+            // Updates the level for the new matrix values, returns the new
+            // coarse matrix.
+            std::shared_ptr<matrix> rebuild(
+                    std::shared_ptr<matrix> a,
+                    const Coarsening &C,
+                    params &prm,
+                    const backend_params &bprm
+                    )
+            {
+                sort_rows(*a);
+
+                if (solve) {
+                    AMGCL_TIC("direct solver");
+                    solve = std::make_shared<DirectSolver>(a->comm(), *a, prm.direct);
+                    AMGCL_TOC("direct solver");
+                    return std::shared_ptr<matrix>();
+                }
+
+                A = a;
+
+                AMGCL_TIC("relaxation");
+                relax = std::make_shared<Relaxation>(*a, prm.relax, bprm);
+                AMGCL_TOC("relaxation");
+
+                std::shared_ptr<matrix> Ac;
+
+                if (keep) {
+                    AMGCL_TIC("coarse operator");
+                    Ac = detail::coarse_operator(C, *A, *keep->P, *keep->R, keep->RAP, 0);
+                    AMGCL_TOC("coarse operator");
+
+                    if (keep->I) {
+                        AMGCL_TIC("partition");
+                        Ac = keep->JAI(*keep->J, *keep->AI(*Ac, *keep->I));
+                        AMGCL_TOC("partition");
+                    }
+                }
+
+                AMGCL_TIC("move to backend");
+                A->move_to_backend(bprm);
+                AMGCL_TOC("move to backend");
+
+                return Ac;
+            }
+
+            static std::shared_ptr<matrix> copy(const matrix &M) {
+                return std::make_shared<matrix>(M.comm(), M.local(),
+                        std::make_shared<typename matrix::build_matrix>(*M.remote()),
+                        M.cpat_ptr());
+            }
+
             void move_to_backend(const backend_params &bprm) {
                 AMGCL_TIC("move to backend");
                 if (A) A->move_to_backend(bprm);
@@ -290,27 +493,62 @@ class amg {
 
         typedef typename std::list<level>::const_iterator level_iterator;
 
+        // Number of OpenMP threads to use on each level
+        // (see params::expand_threads).
+        struct thread_count {
+            bool enable;
+            communicator node;
+            int base;
+
+            thread_count(communicator comm, bool enable)
+                : enable(enable), node(enable ? comm.node() : comm), base(1)
+            {
+                if (!enable) return;
+
+#ifdef _OPENMP
+                base = omp_get_max_threads();
+#endif
+            }
+
+            int operator()(const matrix &A) const {
+                if (!enable) return 0;
+
+                int active = (A.loc_rows() > 0);
+                int node_active = node.reduce(MPI_SUM, active);
+
+                if (!active || node_active == node.size) return 0;
+                return base * node.size / node_active;
+            }
+        };
+
         std::shared_ptr<matrix> A;
         Repartition repart;
         std::list<level> levels;
+        size_t pattern;
 
         void init(std::shared_ptr<matrix> A, const backend_params &bprm)
         {
             A->comm().check(A->glob_rows() == A->glob_cols(), "Matrix should be square!");
 
+            if (prm.allow_rebuild) pattern = detail::pattern_checksum(*A);
+
             this->A = A;
             Coarsening C(prm.coarsening);
+            thread_count threads(A->comm(), prm.expand_threads);
             bool need_coarse = true;
 
             while(A->glob_rows() > prm.coarse_enough) {
-                levels.push_back( level(A, prm, bprm) );
+                int nt = threads(*A);
+                scoped_threads st(nt);
+
+                levels.push_back( level(A, prm, bprm, nt) );
 
                 if (levels.size() >= prm.max_levels) {
                     levels.back().move_to_backend(bprm);
                     break;
                 }
 
-                A = levels.back().step_down(C, repart);
+                A = levels.back().step_down(C, repart, prm.allow_rebuild);
                 levels.back().move_to_backend(bprm);
 
                 if (!A) {
@@ -328,7 +566,10 @@ class amg {
             }
 
             if (A && need_coarse) {
-                levels.push_back(level(A, prm, bprm, prm.direct_coarse));
+                int nt = threads(*A);
+                scoped_threads st(nt);
+
+                levels.push_back(level(A, prm, bprm, nt, prm.direct_coarse));
                 levels.back().move_to_backend(bprm);
             }
 
@@ -339,6 +580,8 @@ class amg {
 
         template <class Vec1, class Vec2>
         void cycle(level_iterator lvl, const Vec1 &rhs, Vec2 &x) const {
+            scoped_threads nt(lvl->nthreads);
+
             level_iterator nxt = lvl, end = levels.end();
             ++nxt;
 
@@ -0,0 +1,460 @@
+#ifndef AMGCL_MPI_ASSEMBLER_HPP
+#define AMGCL_MPI_ASSEMBLER_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2018 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/mpi/assembler.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Distributed matrix assembly from contributions to arbitrary rows.
+ */
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include <mpi.h>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/util.hpp>
+#include <amgcl/mpi/util.hpp>
+#include <amgcl/mpi/distributed_matrix.hpp>
+
+namespace amgcl {
+namespace mpi {
+
+/// Assembles a distributed matrix from the COO contributions.
+/**
+ * Each process owns a contiguous chunk of rows, but may insert
+ * contributions to any global row. The entries belonging to the rows owned
+ * by other processes are stashed and sent to their owners on assembly.
+ * Only the processes that actually exchange the entries talk to each
+ * other. The duplicate entries are summed.
+ *
+ * The structure of the assembled matrix is kept, so that the matrix with
+ * the same sparsity pattern and new values may be assembled with
+ * reassemble(), which only sends the values. Example:
+ * \code
+ * amgcl::mpi::assembler<Backend> assemble(comm, n_loc_rows);
+ * for(...) assemble.insert(row, col, val);
+ * auto A = assemble();
+ *
+ * amgcl::mpi::make_solver<...> solve(comm, A, prm);
+ * ...
+ * // The values were updated (in the same order as they were inserted):
+ * solve.rebuild(assemble.reassemble(new_vals));
+ * \endcode
+ */
+template <class Backend>
+class assembler {
+    public:
+        typedef typename Backend::value_type value_type;
+        typedef backend::crs<value_type>     build_matrix;
+        typedef distributed_matrix<Backend>  matrix;
+        typedef comm_pattern<Backend>        CommPattern;
+
+        /// Creates the assembler.
+        /**
+         * \param comm       MPI communicator.
+         * \param n_loc_rows Number of rows owned by the current process.
+         */
+        assembler(communicator comm, ptrdiff_t n_loc_rows)
+            : comm(comm), n(n_loc_rows), dom(comm.exclusive_sum(n_loc_rows))
+        {}
+
+        /// Reserves space for the given number of contributions.
+        void reserve(size_t nnz) {
+            row.reserve(nnz);
+            col.reserve(nnz);
+            val.reserve(nnz);
+        }
+
+        /// Adds contribution to the global row and column.
+        void insert(ptrdiff_t r, ptrdiff_t c, const value_type &v) {
+            precondition(r >= 0 && r < dom.back(), "Row index is out of range");
+
+            row.push_back(r);
+            col.push_back(c);
+            val.push_back(v);
+        }
+
+        /// Adds a batch of contributions.
+        void insert(size_t nnz, const ptrdiff_t *r, const ptrdiff_t *c, const value_type *v) {
+            for(size_t i = 0; i < nnz; ++i)
+                precondition(r[i] >= 0 && r[i] < dom.back(), "Row index is out of range");
+
+            row.insert(row.end(), r, r + nnz);
+            col.insert(col.end(), c, c + nnz);
+            val.insert(val.end(), v, v + nnz);
+        }
+
+        /// Assembles the matrix from the contributions inserted so far.
+        /**
+         * This is a collective operation. The inserted contributions are
+         * discarded afterwards.
+         */
+        std::shared_ptr<matrix> operator()() {
+            AMGCL_TIC("assemble");
+            structure();
+            std::shared_ptr<matrix> A = values(val);
+            AMGCL_TOC("assemble");
+
+            std::vector<ptrdiff_t>().swap(row);
+            std::vector<ptrdiff_t>().swap(col);
+            std::vector<value_type>().swap(val);
+
+            return A;
+        }
+
+        /// Assembles the matrix with the structure of the last assembly.
+        /**
+         * The values should be given in the same order as the
+         * contributions that were inserted before the last call to
+         * operator(). This is a collective operation.
+         */
+        template <class ValRange>
+        std::shared_ptr<matrix> reassemble(const ValRange &v) {
+            precondition(static_cast<ptrdiff_t>(std::distance(std::begin(v), std::end(v))) == n_in,
+                    "Number of values differs from the number of contributions");
+
+            AMGCL_TIC("reassemble");
+            std::shared_ptr<matrix> A = values(v);
+            AMGCL_TOC("reassemble");
+
+            return A;
+        }
+    private:
+        static const int tag_exc_cnt = 7000;
+        static const int tag_exc_row = 7001;
+        static const int tag_exc_col = 7002;
+        static const int tag_exc_val = 7003;
+
+        communicator comm;
+        ptrdiff_t n;
+        std::vector<ptrdiff_t> dom;
+
+        // Contributions inserted since the last assembly.
+        std::vector<ptrdiff_t>  row, col;
+        std::vector<value_type> val;
+
+        // Number of contributions and their positions in the packed
+        // array, where the local ones come first, followed by the entries
+        // to send to each of the neighbours.
+        ptrdiff_t n_in, n_own;
+        std::vector<ptrdiff_t> pos;
+
+        std::vector<int>       send_nbr, recv_nbr;
+        std::vector<ptrdiff_t> send_ptr, recv_ptr;
+
+        // The local and the received entries sorted by the matrix
+        // nonzeros they contribute to. Contributions to the nonzero k are
+        // order[run[k]] ... order[run[k+1]-1], where the nonzeros of
+        // each row are numbered from the local to the remote ones.
+        std::vector<ptrdiff_t> order, run;
+
+        std::vector<ptrdiff_t> loc_ptr, loc_col;
+        std::vector<ptrdiff_t> rem_ptr, rem_col;
+
+        std::shared_ptr<CommPattern> C;
+
+        void structure() {
+            const ptrdiff_t beg = dom[comm.rank];
+            const ptrdiff_t end = dom[comm.rank + 1];
+
+            n_in = row.size();
+
+            // Find the owners of the contributions.
+            std::vector<int> dst(n_in);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n_in; ++i) {
+                ptrdiff_t r = row[i];
+
+                if (r >= beg && r < end) {
+                    dst[i] = comm.rank;
+                } else {
+                    dst[i] = std::upper_bound(dom.begin(), dom.end(), r) - dom.begin() - 1;
+                }
+            }
+
+            std::vector<int> scount(comm.size, 0);
+            for(ptrdiff_t i = 0; i < n_in; ++i) ++scount[dst[i]];
+
+            n_own = scount[comm.rank];
+            scount[comm.rank] = 0;
+
+            send_nbr.clear(); send_ptr.clear(); send_ptr.push_back(0);
+            recv_nbr.clear(); recv_ptr.clear(); recv_ptr.push_back(0);
+
+            std::vector<ptrdiff_t> head(comm.size);
+            head[comm.rank] = 0;
+
+            for(int d = 0; d < comm.size; ++d) {
+                if (scount[d]) {
+                    head[d] = n_own + send_ptr.back();
+                    send_nbr.push_back(d);
+                    send_ptr.push_back(send_ptr.back() + scount[d]);
+                }
+            }
+
+            // Find out how many processes are going to send us their
+            // entries, and get the entry counts from the senders directly.
+            // The next collective operation (the communication pattern
+            // setup in values()) makes sure the counts of a later assembly
+            // are not mixed up with these.
+            int n_recv_nbr;
+            {
+                std::vector<int> is_nbr(comm.size, 0);
+                for(int d : send_nbr) is_nbr[d] = 1;
+
+                MPI_Reduce_scatter_block(is_nbr.data(), &n_recv_nbr, 1, MPI_INT, MPI_SUM, comm);
+            }
+
+            {
+                std::vector<MPI_Request> req(send_nbr.size());
+                for(size_t i = 0; i < send_nbr.size(); ++i)
+                    MPI_Isend(&scount[send_nbr[i]], 1, MPI_INT, send_nbr[i], tag_exc_cnt, comm, &req[i]);
+
+                std::vector<std::pair<int, int>> rcount(n_recv_nbr);
+                for(int i = 0; i < n_recv_nbr; ++i) {
+                    MPI_Status s;
+                    MPI_Recv(&rcount[i].second, 1, MPI_INT, MPI_ANY_SOURCE, tag_exc_cnt, comm, &s);
+                    rcount[i].first = s.MPI_SOURCE;
+                }
+
+                MPI_Waitall(req.size(), req.data(), MPI_STATUSES_IGNORE);
+
+                // Keep the received entries ordered by the sender rank.
+                std::sort(rcount.begin(), rcount.end());
+
+                for(const auto &r : rcount) {
+                    recv_nbr.push_back(r.first);
+                    recv_ptr.push_back(recv_ptr.back() + r.second);
+                }
+            }
+
+            pos.resize(n_in);
+            for(ptrdiff_t i = 0; i < n_in; ++i) pos[i] = head[dst[i]]++;
+
+            // Send the stashed row and column indices to their owners.
+            const ptrdiff_t n_recv = recv_ptr.back();
+            const ptrdiff_t n_all  = n_own + n_recv;
+
+            // The received entries follow the local ones, and the outgoing
+            // ones are packed into a separate buffer.
+            std::vector<ptrdiff_t> all_row(n_all), all_col(n_all);
+            std::vector<ptrdiff_t> send_row(send_ptr.back()), send_col(send_ptr.back());
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n_in; ++i) {
+                ptrdiff_t p = pos[i];
+                if (p < n_own) {
+                    all_row[p] = row[i];
+                    all_col[p] = col[i];
+                } else {
+                    send_row[p - n_own] = row[i];
+                    send_col[p - n_own] = col[i];
+                }
+            }
+
+            std::vector<MPI_Request> req;
+            req.reserve(2 * (send_nbr.size() + recv_nbr.size()));
+
+            for(size_t i = 0; i < recv_nbr.size(); ++i) {
+                ptrdiff_t b = n_own + recv_ptr[i];
+                int       m = recv_ptr[i+1] - recv_ptr[i];
+
+                req.push_back(MPI_REQUEST_NULL);
+                MPI_Irecv(&all_row[b], m, datatype<ptrdiff_t>(), recv_nbr[i], tag_exc_row, comm, &req.back());
+
+                req.push_back(MPI_REQUEST_NULL);
+                MPI_Irecv(&all_col[b], m, datatype<ptrdiff_t>(), recv_nbr[i], tag_exc_col, comm, &req.back());
+            }
+
+            for(size_t i = 0; i < send_nbr.size(); ++i) {
+                ptrdiff_t b = send_ptr[i];
+                int       m = send_ptr[i+1] - send_ptr[i];
+
+                req.push_back(MPI_REQUEST_NULL);
+                MPI_Isend(&send_row[b], m, datatype<ptrdiff_t>(), send_nbr[i], tag_exc_row, comm, &req.back());
+
+                req.push_back(MPI_REQUEST_NULL);
+                MPI_Isend(&send_col[b], m, datatype<ptrdiff_t>(), send_nbr[i], tag_exc_col, comm, &req.back());
+            }
+
+            MPI_Waitall(req.size(), req.data(), MPI_STATUSES_IGNORE);
+
+            // Sort the entries by rows, and then by columns inside each row,
+            // placing the local columns first.
+            loc_ptr.assign(n + 1, 0);
+            rem_ptr.assign(n + 1, 0);
+
+            std::vector<ptrdiff_t> row_ptr(n + 1, 0);
+            for(ptrdiff_t i = 0; i < n_all; ++i) ++row_ptr[all_row[i] - beg + 1];
+            std::partial_sum(row_ptr.begin(), row_ptr.end(), row_ptr.begin());
+
+            order.resize(n_all);
+            {
+                std::vector<ptrdiff_t> h(row_ptr.begin(), row_ptr.end() - 1);
+                for(ptrdiff_t i = 0; i < n_all; ++i) order[h[all_row[i] - beg]++] = i;
+            }
+
+            auto is_loc = [&](ptrdiff_t c) { return c >= beg && c < end; };
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                std::sort(order.begin() + row_ptr[i], order.begin() + row_ptr[i+1],
+                        [&](ptrdiff_t a, ptrdiff_t b) {
+                            ptrdiff_t ca = all_col[a];
+                            ptrdiff_t cb = all_col[b];
+                            bool la = is_loc(ca);
+                            bool lb = is_loc(cb);
+                            return la == lb ? ca < cb : la;
+                        });
+
+                ptrdiff_t nl = 0, nr = 0;
+                for(ptrdiff_t j = row_ptr[i], e = row_ptr[i+1]; j < e; ++j) {
+                    ptrdiff_t c = all_col[order[j]];
+                    if (j > row_ptr[i] && c == all_col[order[j-1]]) continue;
+                    if (is_loc(c)) ++nl; else ++nr;
+                }
+
+                loc_ptr[i+1] = nl;
+                rem_ptr[i+1] = nr;
+            }
+
+            std::partial_sum(loc_ptr.begin(), loc_ptr.end(), loc_ptr.begin());
+            std::partial_sum(rem_ptr.begin(), rem_ptr.end(), rem_ptr.begin());
+
+            loc_col.resize(loc_ptr.back());
+            rem_col.resize(rem_ptr.back());
+            run.resize(loc_ptr.back() + rem_ptr.back() + 1);
+            run.back() = n_all;
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                ptrdiff_t k  = loc_ptr[i] + rem_ptr[i];
+                ptrdiff_t lh = loc_ptr[i];
+                ptrdiff_t rh = rem_ptr[i];
+
+                for(ptrdiff_t j = row_ptr[i], e = row_ptr[i+1]; j < e; ++j) {
+                    ptrdiff_t c = all_col[order[j]];
+                    if (j > row_ptr[i] && c == all_col[order[j-1]]) continue;
+
+                    run[k++] = j;
+
+                    if (is_loc(c))
+                        loc_col[lh++] = c - beg;
+                    else
+                        rem_col[rh++] = c;
+                }
+            }
+
+            C.reset();
+        }
+
+        template <class ValRange>
+        std::shared_ptr<matrix> values(const ValRange &v) {
+            const ptrdiff_t n_all = order.size();
+
+            // Send the stashed values to their owners.
+            std::vector<value_type> all_val(n_all);
+            std::vector<value_type> send_val(send_ptr.back());
+
+            auto vi = std::begin(v);
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n_in; ++i) {
+                ptrdiff_t p = pos[i];
+                if (p < n_own)
+                    all_val[p] = vi[i];
+                else
+                    send_val[p - n_own] = vi[i];
+            }
+
+            std::vector<MPI_Request> req;
+            req.reserve(send_nbr.size() + recv_nbr.size());
+
+            for(size_t i = 0; i < recv_nbr.size(); ++i) {
+                req.push_back(MPI_REQUEST_NULL);
+                MPI_Irecv(&all_val[n_own + recv_ptr[i]], recv_ptr[i+1] - recv_ptr[i],
+                        datatype<value_type>(), recv_nbr[i], tag_exc_val, comm, &req.back());
+            }
+
+            for(size_t i = 0; i < send_nbr.size(); ++i) {
+                req.push_back(MPI_REQUEST_NULL);
+                MPI_Isend(&send_val[send_ptr[i]], send_ptr[i+1] - send_ptr[i],
+                        datatype<value_type>(), send_nbr[i], tag_exc_val, comm, &req.back());
+            }
+
+            MPI_Waitall(req.size(), req.data(), MPI_STATUSES_IGNORE);
+
+            // Sum the duplicates.
+            auto a_loc = std::make_shared<build_matrix>();
+            auto a_rem = std::make_shared<build_matrix>();
+
+            a_loc->set_size(n, n);
+            a_rem->set_size(n, 0);
+
+            std::copy(loc_ptr.begin(), loc_ptr.end(), a_loc->ptr);
+            std::copy(rem_ptr.begin(), rem_ptr.end(), a_rem->ptr);
+
+            a_loc->set_nonzeros(loc_col.size());
+            a_rem->set_nonzeros(rem_col.size());
+
+            std::copy(loc_col.begin(), loc_col.end(), a_loc->col);
+            std::copy(rem_col.begin(), rem_col.end(), a_rem->col);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                ptrdiff_t k = loc_ptr[i] + rem_ptr[i];
+
+                for(ptrdiff_t j = loc_ptr[i], e = loc_ptr[i+1]; j < e; ++j, ++k)
+                    a_loc->val[j] = sum(all_val, k);
+
+                for(ptrdiff_t j = rem_ptr[i], e = rem_ptr[i+1]; j < e; ++j, ++k)
+                    a_rem->val[j] = sum(all_val, k);
+            }
+
+            // The communication pattern is shared by all the matrices with
+            // the same structure.
+            auto A = std::make_shared<matrix>(comm, a_loc, a_rem, C);
+            C = A->cpat_ptr();
+            return A;
+        }
+
+        value_type sum(const std::vector<value_type> &v, ptrdiff_t k) const {
+            value_type s = math::zero<value_type>();
+            for(ptrdiff_t j = run[k], e = run[k+1]; j < e; ++j)
+                s += v[order[j]];
+            return s;
+        }
+};
+
+} // namespace mpi
+} // namespace amgcl
+
+#endif
@@ -107,6 +107,19 @@ struct aggregation {
         return amgcl::coarsening::detail::scaled_galerkin(A, P, R, 1 / prm.over_interp);
     }
 
+    std::shared_ptr< distributed_matrix<Backend> >
+    coarse_operator(
+            const distributed_matrix<Backend> &A,
+            const distributed_matrix<Backend> &P,
+            const distributed_matrix<Backend> &R,
+            galerkin_plan<Backend> &plan
+            ) const
+    {
+        auto Ac = plan(A, P, R);
+        scale(*Ac, 1 / prm.over_interp);
+        return Ac;
+    }
+
 };
 
 template <class Backend>
@@ -31,8 +31,11 @@ THE SOFTWARE.
  * \brief  Distributed PMIS aggregation.
  */
 
+#include <vector>
 #include <tuple>
 #include <memory>
+#include <algorithm>
+#include <cstdint>
 
 #include <amgcl/backend/builtin.hpp>
 #include <amgcl/util.hpp>
@@ -61,18 +64,29 @@ struct pmis {
         // Block size for non-scalar problems.
         unsigned    block_size;
 
-        params() : eps_strong(0.08), block_size(1) { }
+        // Use the distributed MIS-2 aggregation.
+        // The aggregate roots are selected as a distance-2 maximal
+        // independent set of the connectivity graph, with the ties broken
+        // by the hashed global indices of the nodes. The aggregates freely
+        // cross the process boundaries, the result does not depend on the
+        // number of processes or threads, and the selection is done in
+        // parallel within each process.
+        bool        mis2;
+
+        params() : eps_strong(0.08), block_size(1), mis2(false) { }
 
         params(const boost::property_tree::ptree &p)
             : AMGCL_PARAMS_IMPORT_VALUE(p, eps_strong),
-              AMGCL_PARAMS_IMPORT_VALUE(p, block_size)
+              AMGCL_PARAMS_IMPORT_VALUE(p, block_size),
+              AMGCL_PARAMS_IMPORT_VALUE(p, mis2)
         {
-            check_params(p, {"eps_strong", "block_size"});
+            check_params(p, {"eps_strong", "block_size", "mis2"});
         }
 
         void get(boost::property_tree::ptree &p, const std::string &path) const {
             AMGCL_PARAMS_EXPORT_VALUE(p, path, eps_strong);
             AMGCL_PARAMS_EXPORT_VALUE(p, path, block_size);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, mis2);
         }
     };
 
@@ -87,7 +101,9 @@ struct pmis {
         if (prm.block_size == 1) {
             conn = conn_strength(A, prm.eps_strong);
 
-            ptrdiff_t naggr = aggregates(*conn, state, owner);
+            ptrdiff_t naggr = prm.mis2 ?
+                mis2_aggregates(*conn, state, owner) :
+                aggregates(*conn, state, owner);
             p_tent = tentative_prolongation(A.comm(), n, naggr, state, owner);
         } else {
             typedef typename math::scalar_of<value_type>::type scalar;
@@ -107,7 +123,9 @@ struct pmis {
             std::vector<ptrdiff_t> state_pw(np);
             std::vector<int>       owner_pw(np);
 
-            ptrdiff_t naggr = aggregates(*conn_pw, state_pw, owner_pw);
+            ptrdiff_t naggr = prm.mis2 ?
+                mis2_aggregates(*conn_pw, state_pw, owner_pw) :
+                aggregates(*conn_pw, state_pw, owner_pw);
 
             conn = std::make_shared< distributed_matrix<bool_backend> >(
                     A.comm(),
@@ -617,6 +635,148 @@ struct pmis {
         return naggr;
     }
 
+    ptrdiff_t mis2_aggregates(
+            const distributed_matrix<bool_backend> &A,
+            std::vector<ptrdiff_t> &loc_state,
+            std::vector<int>       &loc_owner
+            )
+    {
+        AMGCL_TIC("MIS-2");
+        const bool_matrix &A_loc = *A.local();
+        const bool_matrix &A_rem = *A.remote();
+        const comm_pattern<bool_backend> &C = A.cpat();
+
+        ptrdiff_t n   = A_loc.nrows;
+        ptrdiff_t beg = A.loc_col_shift();
+
+        communicator comm = A.comm();
+
+        // 1. Find distance-2 maximal independent set.
+        // Each node has a key combining its state (in the two highest
+        // bits) and the hashed global index. Nodes that are not yet
+        // decided take the max of the keys over their two-hop
+        // neighborhood. A node is selected when its own key wins, and is
+        // removed when an already selected node wins.
+        std::vector<ptrdiff_t> key(n), t1(n), t2(n);
+        std::vector<ptrdiff_t> send_val(C.send.count());
+        std::vector<ptrdiff_t> recv_val(C.recv.count());
+
+        ptrdiff_t n_undone = 0;
+#pragma omp parallel for reduction(+:n_undone)
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            ptrdiff_t wl = A_loc.ptr[i+1] - A_loc.ptr[i];
+            ptrdiff_t wr = A_rem.ptr[i+1] - A_rem.ptr[i];
+
+            if (wl + wr == 1) {
+                key[i] = mis2_key(mis2_removed, beg + i);
+            } else {
+                key[i] = mis2_key(mis2_undone, beg + i);
+                ++n_undone;
+            }
+        }
+
+        auto max_neighbor = [&](const std::vector<ptrdiff_t> &src, std::vector<ptrdiff_t> &dst) {
+            for(size_t i = 0, m = C.send.count(); i < m; ++i)
+                send_val[i] = src[C.send.col[i]];
+            C.exchange(send_val.data(), recv_val.data());
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                ptrdiff_t v = src[i];
+
+                for(ptrdiff_t j = A_loc.ptr[i], e = A_loc.ptr[i+1]; j < e; ++j)
+                    v = std::max(v, src[A_loc.col[j]]);
+
+                for(ptrdiff_t j = A_rem.ptr[i], e = A_rem.ptr[i+1]; j < e; ++j)
+                    v = std::max(v, recv_val[C.local_index(A_rem.col[j])]);
+
+                dst[i] = v;
+            }
+        };
+
+        while(comm.reduce(MPI_SUM, n_undone)) {
+            max_neighbor(key, t1);
+            max_neighbor(t1,  t2);
+
+            n_undone = 0;
+#pragma omp parallel for reduction(+:n_undone)
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                if (mis2_state(key[i]) != mis2_undone) continue;
+
+                if (t2[i] == key[i]) {
+                    key[i] = mis2_key(mis2_selected, beg + i);
+                } else if (mis2_state(t2[i]) == mis2_selected) {
+                    key[i] = mis2_key(mis2_removed, beg + i);
+                } else {
+                    ++n_undone;
+                }
+            }
+        }
+
+        // 2. Number the aggregates.
+        // The aggregates are numbered in the order of the global indices
+        // of their roots, so that the ties below are broken consistently
+        // for any number of processes.
+        ptrdiff_t naggr = 0;
+        std::vector<ptrdiff_t> &aggr = t1;
+        for(ptrdiff_t i = 0; i < n; ++i)
+            aggr[i] = (mis2_state(key[i]) == mis2_selected) ? naggr++ : -1;
+
+        std::vector<ptrdiff_t> dom = comm.exclusive_sum(naggr);
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i)
+            if (aggr[i] >= 0) aggr[i] += dom[comm.rank];
+
+        // 3. Neighbors of the roots join the aggregates, then the nodes
+        // that are two hops away join the aggregates of their neighbors.
+        // Each pass only looks at the results of the previous one.
+        std::vector<ptrdiff_t> &next = t2;
+        for(int pass = 0; pass < 2; ++pass) {
+            for(size_t i = 0, m = C.send.count(); i < m; ++i)
+                send_val[i] = aggr[C.send.col[i]];
+            C.exchange(send_val.data(), recv_val.data());
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                ptrdiff_t a = aggr[i];
+
+                // Lonely nodes are left out.
+                ptrdiff_t w = A_loc.ptr[i+1] - A_loc.ptr[i] + A_rem.ptr[i+1] - A_rem.ptr[i];
+
+                if (a < 0 && w > 1) {
+                    for(ptrdiff_t j = A_loc.ptr[i], e = A_loc.ptr[i+1]; j < e; ++j)
+                        a = std::max(a, aggr[A_loc.col[j]]);
+
+                    for(ptrdiff_t j = A_rem.ptr[i], e = A_rem.ptr[i+1]; j < e; ++j)
+                        a = std::max(a, recv_val[C.local_index(A_rem.col[j])]);
+                }
+
+                next[i] = a;
+            }
+
+            aggr.swap(next);
+        }
+
+        // 4. Convert to the (local id, owner) pairs.
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            ptrdiff_t a = aggr[i];
+
+            if (a < 0) {
+                loc_state[i] = deleted;
+                loc_owner[i] = -1;
+            } else {
+                int d = std::upper_bound(dom.begin(), dom.end(), a) - dom.begin() - 1;
+                loc_state[i] = a - dom[d];
+                loc_owner[i] = d;
+            }
+        }
+        AMGCL_TOC("MIS-2");
+
+        return naggr;
+    }
+
     std::shared_ptr<matrix>
     tentative_prolongation(communicator comm, ptrdiff_t n, ptrdiff_t naggr,
             std::vector<ptrdiff_t> &state, std::vector<int> &owner)
@@ -763,6 +923,29 @@ struct pmis {
     private:
         static const int undone = -2;
         static const int deleted = -1;
+
+        // Node states for MIS-2, ordered by priority.
+        static const int mis2_removed  = 0;
+        static const int mis2_undone   = 1;
+        static const int mis2_selected = 2;
+
+        // Bijective hash of the 61-bit global index with the node state
+        // in the higher bits.
+        static ptrdiff_t mis2_key(int state, ptrdiff_t idx) {
+            const uint64_t mask = (static_cast<uint64_t>(1) << 61) - 1;
+
+            uint64_t x = static_cast<uint64_t>(idx);
+            x = (x * 0x9E3779B97F4A7C15ull) & mask;
+            x ^= x >> 29;
+            x = (x * 0xBF58476D1CE4E5B9ull) & mask;
+            x ^= x >> 32;
+
+            return static_cast<ptrdiff_t>((static_cast<uint64_t>(state) << 61) | x);
+        }
+
+        static int mis2_state(ptrdiff_t key) {
+            return static_cast<int>(key >> 61);
+        }
 };
 
 } // namespace coarsening
@@ -0,0 +1,902 @@
+#ifndef AMGCL_MPI_COARSENING_RUGE_STUBEN_HPP
+#define AMGCL_MPI_COARSENING_RUGE_STUBEN_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2018 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/mpi/coarsening/ruge_stuben.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Distributed classical AMG coarsening.
+ */
+
+#include <vector>
+#include <tuple>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/coarsening/ruge_stuben.hpp>
+#include <amgcl/coarsening/detail/galerkin.hpp>
+#include <amgcl/util.hpp>
+#include <amgcl/mpi/util.hpp>
+#include <amgcl/mpi/distributed_matrix.hpp>
+
+namespace amgcl {
+namespace mpi {
+namespace coarsening {
+
+/// Distributed classical AMG coarsening.
+/**
+ * The variables are split into C and F sets with the HMIS algorithm: the
+ * first pass of the Ruge-Stuben algorithm is applied independently on each
+ * process, and the resulting C-variables are used as the candidates for the
+ * PMIS algorithm, which makes the split consistent across the process
+ * boundaries. The prolongation operator uses extended+i interpolation,
+ * which takes the distance-two coarse variables into account, and so
+ * works well with the sparse coarse grids produced by HMIS.
+ *
+ * Aggressive coarsening may be used on the finest levels of the hierarchy.
+ * In this case the split is repeated on the coarse grid, and the
+ * prolongation operator is the product of the two interpolation operators
+ * (two-stage interpolation).
+ *
+ * Only scalar problems are supported.
+ *
+ * \sa \cite Stuben1999
+ */
+template <class Backend>
+struct ruge_stuben {
+    typedef typename Backend::value_type value_type;
+    typedef typename math::scalar_of<value_type>::type scalar_type;
+    typedef distributed_matrix<Backend> matrix;
+    typedef backend::crs<value_type> build_matrix;
+    typedef backend::builtin<char> bool_backend;
+    typedef backend::crs<char>     bool_matrix;
+    typedef backend::builtin<ptrdiff_t> idx_backend;
+    typedef backend::crs<ptrdiff_t>     idx_matrix;
+
+    static_assert(math::static_rows<value_type>::value == 1,
+            "mpi::coarsening::ruge_stuben only supports scalar problems");
+
+    struct params {
+        /// Parameter \f$\varepsilon_{str}\f$ defining strong couplings.
+        /**
+         * Variable \f$i\f$ is strongly coupled to variable \f$j\f$ if
+         * \f$-a_{ij} \geq \varepsilon_{str}\max\limits_{a_{ik}<0}|a_{ik}|\f$.
+         */
+        float eps_strong;
+
+        /// Use HMIS for the C/F splitting.
+        /**
+         * When not set, plain PMIS is used. PMIS is cheaper, but produces
+         * coarser grids, which need the long range interpolation.
+         */
+        bool hmis;
+
+        /// Number of the finest levels to use the aggressive coarsening on.
+        unsigned aggressive_levels;
+
+        /// Truncate prolongation operator?
+        bool do_trunc;
+
+        /// Truncation threshold.
+        /**
+         * The interpolation weights that are smaller (in absolute value)
+         * than the largest one in the row by a factor of eps_trunc are
+         * dropped. The remaining weights are rescaled so that the row sum
+         * remains unchanged.
+         */
+        float eps_trunc;
+
+        /// Maximum number of interpolation weights in a row.
+        /** Zero means no limit. */
+        unsigned max_elements;
+
+        params()
+            : eps_strong(0.25f), hmis(true), aggressive_levels(0),
+              do_trunc(true), eps_trunc(0.2f), max_elements(4)
+        {}
+
+        params(const boost::property_tree::ptree &p)
+            : AMGCL_PARAMS_IMPORT_VALUE(p, eps_strong),
+              AMGCL_PARAMS_IMPORT_VALUE(p, hmis),
+              AMGCL_PARAMS_IMPORT_VALUE(p, aggressive_levels),
+              AMGCL_PARAMS_IMPORT_VALUE(p, do_trunc),
+              AMGCL_PARAMS_IMPORT_VALUE(p, eps_trunc),
+              AMGCL_PARAMS_IMPORT_VALUE(p, max_elements)
+        {
+            check_params(p, {"eps_strong", "hmis", "aggressive_levels", "do_trunc", "eps_trunc", "max_elements"});
+        }
+
+        void get(boost::property_tree::ptree &p, const std::string &path) const {
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, eps_strong);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, hmis);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, aggressive_levels);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, do_trunc);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, eps_trunc);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, max_elements);
+        }
+    } prm;
+
+    ruge_stuben(const params &prm = params()) : prm(prm), level(0) {}
+
+    std::tuple< std::shared_ptr<matrix>, std::shared_ptr<matrix> >
+    transfer_operators(const matrix &A) {
+        auto P = interpolation(A);
+
+        if (level++ < prm.aggressive_levels && P->glob_cols() > 0) {
+            AMGCL_TIC("aggressive coarsening");
+            auto R  = transpose(*P);
+            auto Ac = amgcl::coarsening::detail::galerkin(A, *P, *R);
+            P = product(*P, *interpolation(*Ac));
+            AMGCL_TOC("aggressive coarsening");
+        }
+
+        return std::make_tuple(P, transpose(*P));
+    }
+
+    std::shared_ptr<matrix>
+    coarse_operator(const matrix &A, const matrix &P, const matrix &R) const {
+        return amgcl::coarsening::detail::galerkin(A, P, R);
+    }
+
+    std::shared_ptr<matrix>
+    coarse_operator(const matrix &A, const matrix &P, const matrix &R,
+            galerkin_plan<Backend> &plan) const
+    {
+        return plan(A, P, R);
+    }
+
+    private:
+        unsigned level;
+
+        // Codes of the matrix columns used in the interpolation.
+        // A coarse column is encoded with its global coarse index.
+        static ptrdiff_t c_code(ptrdiff_t cid, bool strong) {
+            return 2 * cid + strong;
+        }
+
+        static ptrdiff_t f_code(bool strong) {
+            return strong ? -2 : -1;
+        }
+
+        // A row of the matrix with the global column numbers.
+        struct row_view {
+            const ptrdiff_t  *col;
+            const value_type *val;
+            const ptrdiff_t  *code;
+            ptrdiff_t         size;
+        };
+
+        std::shared_ptr<matrix> interpolation(const matrix &A) const {
+            std::vector<char> s_loc, s_rem;
+            strength(A, s_loc, s_rem);
+
+            std::vector<char> cf;
+            cfsplit(A, s_loc, s_rem, cf);
+
+            return extended_i(A, s_loc, s_rem, cf);
+        }
+
+        // Marks the strong couplings in the local and the remote parts of
+        // the matrix.
+        void strength(const matrix &A,
+                std::vector<char> &s_loc, std::vector<char> &s_rem) const
+        {
+            AMGCL_TIC("strength");
+            const build_matrix &A_loc = *A.local();
+            const build_matrix &A_rem = *A.remote();
+
+            ptrdiff_t n = A.loc_rows();
+            const scalar_type eps = amgcl::detail::eps<scalar_type>(1);
+
+            s_loc.resize(A_loc.nnz);
+            s_rem.resize(A_rem.nnz);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                value_type a_min = math::zero<value_type>();
+
+                for(ptrdiff_t j = A_loc.ptr[i], e = A_loc.ptr[i+1]; j < e; ++j)
+                    if (A_loc.col[j] != i) a_min = std::min(a_min, A_loc.val[j]);
+
+                for(ptrdiff_t j = A_rem.ptr[i], e = A_rem.ptr[i+1]; j < e; ++j)
+                    a_min = std::min(a_min, A_rem.val[j]);
+
+                if (math::norm(a_min) < eps) {
+                    std::fill(s_loc.begin() + A_loc.ptr[i], s_loc.begin() + A_loc.ptr[i+1], 0);
+                    std::fill(s_rem.begin() + A_rem.ptr[i], s_rem.begin() + A_rem.ptr[i+1], 0);
+                    continue;
+                }
+
+                a_min *= prm.eps_strong;
+
+                for(ptrdiff_t j = A_loc.ptr[i], e = A_loc.ptr[i+1]; j < e; ++j)
+                    s_loc[j] = (A_loc.col[j] != i && A_loc.val[j] < a_min);
+
+                for(ptrdiff_t j = A_rem.ptr[i], e = A_rem.ptr[i+1]; j < e; ++j)
+                    s_rem[j] = (A_rem.val[j] < a_min);
+            }
+            AMGCL_TOC("strength");
+        }
+
+        // Extracts the pattern of the marked nonzeros.
+        static std::shared_ptr<bool_matrix> pattern(
+                const build_matrix &A, const std::vector<char> &s, ptrdiff_t ncols)
+        {
+            ptrdiff_t n = A.nrows;
+
+            auto p = std::make_shared<bool_matrix>();
+            bool_matrix &P = *p;
+
+            P.set_size(n, ncols, true);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i)
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j)
+                    if (s[j]) ++P.ptr[i+1];
+
+            P.set_nonzeros(P.scan_row_sizes());
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                ptrdiff_t head = P.ptr[i];
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                    if (s[j]) {
+                        P.col[head] = A.col[j];
+                        P.val[head] = 1;
+                        ++head;
+                    }
+                }
+            }
+
+            return p;
+        }
+
+        // Union of the patterns of two matrices.
+        static std::shared_ptr<bool_matrix> merge(
+                const bool_matrix &A, const bool_matrix &B)
+        {
+            ptrdiff_t n = A.nrows;
+
+            auto c = std::make_shared<bool_matrix>();
+            bool_matrix &C = *c;
+
+            C.set_size(n, A.ncols, false);
+            C.ptr[0] = 0;
+
+            std::vector<ptrdiff_t> col;
+            col.reserve(A.nnz + B.nnz);
+
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                ptrdiff_t beg = col.size();
+
+                col.insert(col.end(), A.col + A.ptr[i], A.col + A.ptr[i+1]);
+                col.insert(col.end(), B.col + B.ptr[i], B.col + B.ptr[i+1]);
+
+                std::sort(col.begin() + beg, col.end());
+                col.erase(std::unique(col.begin() + beg, col.end()), col.end());
+
+                C.ptr[i+1] = col.size();
+            }
+
+            C.set_nonzeros(col.size());
+            std::copy(col.begin(), col.end(), C.col);
+            std::fill(C.val, C.val + C.nnz, 1);
+
+            return c;
+        }
+
+        // Pseudo-random weight in [0,1), used to break the ties in the
+        // PMIS measures. Depends on the global index only, so the split
+        // does not depend on the number of threads.
+        static double random_weight(ptrdiff_t i) {
+            uint64_t x = static_cast<uint64_t>(i);
+            x ^= x >> 33;
+            x *= 0xff51afd7ed558ccdULL;
+            x ^= x >> 33;
+            x *= 0xc4ceb9fe1a85ec53ULL;
+            x ^= x >> 33;
+            return (x >> 11) * (1.0 / 9007199254740992.0);
+        }
+
+        void cfsplit(const matrix &A,
+                const std::vector<char> &s_loc, const std::vector<char> &s_rem,
+                std::vector<char> &cf) const
+        {
+            static const char undone = 'U';
+
+            AMGCL_TIC("C/F split");
+            communicator comm = A.comm();
+
+            const build_matrix &A_loc = *A.local();
+            const build_matrix &A_rem = *A.remote();
+
+            ptrdiff_t n   = A.loc_rows();
+            ptrdiff_t beg = A.loc_col_shift();
+
+            // Strong couplings S, and its transpose. The rows of S^T
+            // give the variables that are strongly influenced by the
+            // given one.
+            distributed_matrix<bool_backend> S(comm,
+                    pattern(A_loc, s_loc, n), pattern(A_rem, s_rem, 0));
+
+            const bool_matrix &S_loc = *S.local();
+            const bool_matrix &S_rem = *S.remote();
+
+            auto St = transpose(S);
+
+            // Neighbours in either direction.
+            distributed_matrix<bool_backend> N(comm,
+                    merge(S_loc, *St->local()), merge(S_rem, *St->remote()));
+
+            const bool_matrix &N_loc = *N.local();
+            const bool_matrix &N_rem = *N.remote();
+            const comm_pattern<bool_backend> &Np = N.cpat();
+
+            cf.resize(n);
+
+            // The candidates for the coarse variables.
+            std::vector<char> state(n);
+
+            if (prm.hmis) {
+                // First pass of Ruge-Stuben, local to the process.
+                bool_matrix T;
+                local_transpose(A_loc, s_loc, T);
+
+                std::fill(cf.begin(), cf.end(), 'U');
+                amgcl::coarsening::detail::cfsplit(A_loc, T, cf);
+
+                for(ptrdiff_t i = 0; i < n; ++i)
+                    state[i] = (cf[i] == 'C' ? undone : 'F');
+            } else {
+                std::fill(state.begin(), state.end(), undone);
+            }
+
+            // Measures: the number of the variables strongly influenced
+            // by the variable, plus a random number in [0,1).
+            const bool_matrix &St_loc = *St->local();
+            const bool_matrix &St_rem = *St->remote();
+
+            std::vector<double> w(n);
+
+            ptrdiff_t n_undone = 0;
+#pragma omp parallel for reduction(+:n_undone)
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                ptrdiff_t lambda =
+                    (St_loc.ptr[i+1] - St_loc.ptr[i]) +
+                    (St_rem.ptr[i+1] - St_rem.ptr[i]);
+
+                // Nobody depends on the variable, it should not be coarse.
+                if (!lambda) state[i] = 'F';
+
+                w[i] = lambda + random_weight(beg + i);
+
+                if (state[i] == undone) ++n_undone;
+            }
+
+            std::vector<double> w_send(Np.send.count());
+            std::vector<double> w_rem(Np.recv.count());
+
+            for(size_t i = 0; i < Np.send.count(); ++i)
+                w_send[i] = w[Np.send.col[i]];
+            Np.exchange(w_send.data(), w_rem.data());
+
+            std::vector<ptrdiff_t> rem_gid(Np.recv.count());
+            for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(N_rem.nrows); ++i)
+                for(ptrdiff_t j = N_rem.ptr[i], e = N_rem.ptr[i+1]; j < e; ++j)
+                    rem_gid[Np.local_index(N_rem.col[j])] = N_rem.col[j];
+
+            std::vector<char> s_send(Np.send.count());
+            std::vector<char> s_recv(Np.recv.count());
+            std::vector<char> sel(n);
+
+            auto exchange_state = [&]() {
+                for(size_t i = 0; i < Np.send.count(); ++i)
+                    s_send[i] = state[Np.send.col[i]];
+                Np.exchange(s_send.data(), s_recv.data());
+            };
+
+            // PMIS: the undone variables with the locally maximal measure
+            // become coarse, and the undone variables strongly depending on
+            // the new coarse variables become fine.
+            while(comm.reduce(MPI_SUM, n_undone)) {
+                exchange_state();
+
+#pragma omp parallel for
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    sel[i] = false;
+                    if (state[i] != undone) continue;
+
+                    double    wi = w[i];
+                    ptrdiff_t gi = beg + i;
+                    bool      is_max = true;
+
+                    for(ptrdiff_t j = N_loc.ptr[i], e = N_loc.ptr[i+1]; j < e && is_max; ++j) {
+                        ptrdiff_t c = N_loc.col[j];
+                        if (c == i || state[c] != undone) continue;
+                        if (w[c] > wi || (w[c] == wi && c > i)) is_max = false;
+                    }
+
+                    for(ptrdiff_t j = N_rem.ptr[i], e = N_rem.ptr[i+1]; j < e && is_max; ++j) {
+                        ptrdiff_t c = Np.local_index(N_rem.col[j]);
+                        if (s_recv[c] != undone) continue;
+                        if (w_rem[c] > wi || (w_rem[c] == wi && rem_gid[c] > gi)) is_max = false;
+                    }
+
+                    sel[i] = is_max;
+                }
+
+                for(ptrdiff_t i = 0; i < n; ++i)
+                    if (sel[i]) state[i] = 'C';
+
+                exchange_state();
+
+                n_undone = 0;
+#pragma omp parallel for reduction(+:n_undone)
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    if (state[i] != undone) continue;
+
+                    bool f = false;
+
+                    for(ptrdiff_t j = S_loc.ptr[i], e = S_loc.ptr[i+1]; j < e && !f; ++j)
+                        f = (state[S_loc.col[j]] == 'C');
+
+                    for(ptrdiff_t j = S_rem.ptr[i], e = S_rem.ptr[i+1]; j < e && !f; ++j)
+                        f = (s_recv[Np.local_index(S_rem.col[j])] == 'C');
+
+                    if (f) state[i] = 'F'; else ++n_undone;
+                }
+            }
+
+            for(ptrdiff_t i = 0; i < n; ++i)
+                cf[i] = (state[i] == 'C' ? 'C' : 'F');
+
+            AMGCL_TOC("C/F split");
+        }
+
+        // Transpose of the local strong couplings, in the format expected
+        // by amgcl::coarsening::detail::cfsplit(): T.val marks the strong
+        // couplings in A, and T.ptr, T.col hold the transposed pattern.
+        // The number of the strong couplings does not exceed A.nnz, so both
+        // arrays are allocated with A.nnz elements.
+        static void local_transpose(const build_matrix &A,
+                const std::vector<char> &s, bool_matrix &T)
+        {
+            ptrdiff_t n = A.nrows;
+
+            T.set_size(n, n, true);
+            T.set_nonzeros(A.nnz);
+            std::copy(s.begin(), s.end(), T.val);
+
+            for(ptrdiff_t j = 0; j < static_cast<ptrdiff_t>(A.nnz); ++j)
+                if (s[j]) ++T.ptr[A.col[j] + 1];
+
+            T.scan_row_sizes();
+
+            for(ptrdiff_t i = 0; i < n; ++i)
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j)
+                    if (s[j]) T.col[T.ptr[A.col[j]]++] = i;
+
+            std::rotate(T.ptr, T.ptr + n, T.ptr + n + 1);
+            T.ptr[0] = 0;
+        }
+
+        std::shared_ptr<matrix> extended_i(const matrix &A,
+                const std::vector<char> &s_loc, const std::vector<char> &s_rem,
+                const std::vector<char> &cf) const
+        {
+            AMGCL_TIC("interpolation");
+            communicator comm = A.comm();
+
+            const build_matrix &A_loc = *A.local();
+            const build_matrix &A_rem = *A.remote();
+            const comm_pattern<Backend> &C = A.cpat();
+
+            ptrdiff_t n   = A.loc_rows();
+            ptrdiff_t beg = A.loc_col_shift();
+
+            // Global numbering of the coarse variables.
+            std::vector<ptrdiff_t> cid(n, -1);
+            ptrdiff_t nc = 0;
+            for(ptrdiff_t i = 0; i < n; ++i)
+                if (cf[i] == 'C') cid[i] = nc++;
+
+            std::vector<ptrdiff_t> c_dom = comm.exclusive_sum(nc);
+            ptrdiff_t c_beg = c_dom[comm.rank];
+            ptrdiff_t c_end = c_beg + nc;
+
+            for(ptrdiff_t i = 0; i < n; ++i)
+                if (cid[i] >= 0) cid[i] += c_beg;
+
+            std::vector<ptrdiff_t> cid_send(C.send.count());
+            std::vector<ptrdiff_t> cid_rem(C.recv.count());
+
+            for(size_t i = 0; i < C.send.count(); ++i)
+                cid_send[i] = cid[C.send.col[i]];
+            C.exchange(cid_send.data(), cid_rem.data());
+
+            // Local rows with global column numbers and the column codes.
+            auto e_loc = std::make_shared<idx_matrix>();
+            auto e_rem = std::make_shared<idx_matrix>();
+
+            e_loc->set_size(n, n, false);
+            e_rem->set_size(n, 0, false);
+
+            std::copy(A_loc.ptr, A_loc.ptr + n + 1, e_loc->ptr);
+            std::copy(A_rem.ptr, A_rem.ptr + n + 1, e_rem->ptr);
+
+            e_loc->set_nonzeros(A_loc.nnz);
+            e_rem->set_nonzeros(A_rem.nnz);
+
+            std::vector<ptrdiff_t> G_ptr(n + 1, 0);
+            for(ptrdiff_t i = 0; i < n; ++i)
+                G_ptr[i+1] = G_ptr[i] +
+                    (A_loc.ptr[i+1] - A_loc.ptr[i]) +
+                    (A_rem.ptr[i+1] - A_rem.ptr[i]);
+
+            std::vector<ptrdiff_t>  G_col(G_ptr[n]);
+            std::vector<value_type> G_val(G_ptr[n]);
+            std::vector<ptrdiff_t>  G_code(G_ptr[n]);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                ptrdiff_t head = G_ptr[i];
+
+                for(ptrdiff_t j = A_loc.ptr[i], e = A_loc.ptr[i+1]; j < e; ++j) {
+                    ptrdiff_t c = A_loc.col[j];
+                    ptrdiff_t k = cid[c] >= 0 ? c_code(cid[c], s_loc[j]) : f_code(s_loc[j]);
+
+                    e_loc->col[j] = c;
+                    e_loc->val[j] = k;
+
+                    G_col[head]  = c + beg;
+                    G_val[head]  = A_loc.val[j];
+                    G_code[head] = k;
+                    ++head;
+                }
+
+                for(ptrdiff_t j = A_rem.ptr[i], e = A_rem.ptr[i+1]; j < e; ++j) {
+                    ptrdiff_t c = A_rem.col[j];
+                    ptrdiff_t r = cid_rem[C.local_index(c)];
+                    ptrdiff_t k = r >= 0 ? c_code(r, s_rem[j]) : f_code(s_rem[j]);
+
+                    e_rem->col[j] = c;
+                    e_rem->val[j] = k;
+
+                    G_col[head]  = c;
+                    G_val[head]  = A_rem.val[j];
+                    G_code[head] = k;
+                    ++head;
+                }
+            }
+
+            // Rows of the remote neighbours, together with their codes.
+            // The communication pattern of E is the same as the one of A,
+            // so the rows come in the same order.
+            distributed_matrix<idx_backend> E(comm, e_loc, e_rem);
+
+            auto a_nbr = remote_rows(C, A, true);
+            auto e_nbr = remote_rows(E.cpat(), E, true);
+
+            const build_matrix &A_nbr = *a_nbr;
+            const idx_matrix   &E_nbr = *e_nbr;
+
+            auto row = [&](ptrdiff_t g) -> row_view {
+                row_view r;
+                if (g >= beg && g < beg + n) {
+                    ptrdiff_t i = g - beg;
+                    r.col  = &G_col[0]  + G_ptr[i];
+                    r.val  = &G_val[0]  + G_ptr[i];
+                    r.code = &G_code[0] + G_ptr[i];
+                    r.size = G_ptr[i+1] - G_ptr[i];
+                } else {
+                    ptrdiff_t i = C.local_index(g);
+                    r.col  = A_nbr.col + A_nbr.ptr[i];
+                    r.val  = A_nbr.val + A_nbr.ptr[i];
+                    r.code = E_nbr.val + E_nbr.ptr[i];
+                    r.size = A_nbr.ptr[i+1] - A_nbr.ptr[i];
+                }
+                return r;
+            };
+
+            auto p_loc = std::make_shared<build_matrix>();
+            auto p_rem = std::make_shared<build_matrix>();
+
+            build_matrix &P_loc = *p_loc;
+            build_matrix &P_rem = *p_rem;
+
+            P_loc.set_size(n, nc, true);
+            P_rem.set_size(n, 0,  true);
+
+            const scalar_type eps = amgcl::detail::eps<scalar_type>(1);
+            const value_type  zero = math::zero<value_type>();
+
+#pragma omp parallel
+            {
+                // Coarse columns of the current row, and positions of the
+                // local coarse columns in the row.
+                std::vector<ptrdiff_t>  ccol;
+                std::vector<value_type> cval;
+                std::vector<ptrdiff_t>  marker(nc, -1);
+
+                // Interpolation weights computed by this thread.
+                std::vector<ptrdiff_t>  t_col;
+                std::vector<value_type> t_val;
+
+                auto find = [&](ptrdiff_t c) -> ptrdiff_t {
+                    if (c >= c_beg && c < c_end) {
+                        ptrdiff_t p = marker[c - c_beg];
+                        return (p >= 0 && p < static_cast<ptrdiff_t>(ccol.size()) && ccol[p] == c) ? p : -1;
+                    }
+                    for(ptrdiff_t p = 0, m = ccol.size(); p < m; ++p)
+                        if (ccol[p] == c) return p;
+                    return -1;
+                };
+
+                auto insert = [&](ptrdiff_t c) {
+                    if (find(c) >= 0) return;
+                    if (c >= c_beg && c < c_end) marker[c - c_beg] = ccol.size();
+                    ccol.push_back(c);
+                    cval.push_back(zero);
+                };
+
+#pragma omp for schedule(static)
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    if (cf[i] == 'C') {
+                        t_col.push_back(cid[i]);
+                        t_val.push_back(math::identity<value_type>());
+                        ++P_loc.ptr[i+1];
+                        continue;
+                    }
+
+                    ptrdiff_t gi = beg + i;
+                    row_view  ri = row(gi);
+
+                    ccol.clear();
+                    cval.clear();
+
+                    // The extended set of the interpolatory variables:
+                    // strong coarse neighbours of i, and strong coarse
+                    // neighbours of strong fine neighbours of i.
+                    for(ptrdiff_t j = 0; j < ri.size; ++j) {
+                        ptrdiff_t k = ri.code[j];
+
+                        if (k >= 0) {
+                            if (k & 1) insert(k >> 1);
+                        } else if (k == f_code(true)) {
+                            row_view rk = row(ri.col[j]);
+                            for(ptrdiff_t l = 0; l < rk.size; ++l) {
+                                ptrdiff_t kl = rk.code[l];
+                                if (kl >= 0 && (kl & 1)) insert(kl >> 1);
+                            }
+                        }
+                    }
+
+                    if (ccol.empty()) continue;
+
+                    value_type dia = zero;
+
+                    for(ptrdiff_t j = 0; j < ri.size; ++j) {
+                        ptrdiff_t  c = ri.col[j];
+                        ptrdiff_t  k = ri.code[j];
+                        value_type v = ri.val[j];
+
+                        if (c == gi) {
+                            dia += v;
+                            continue;
+                        }
+
+                        if (k >= 0) {
+                            ptrdiff_t p = find(k >> 1);
+                            if (p >= 0) {
+                                cval[p] += v;
+                                continue;
+                            }
+                        }
+
+                        if (k != f_code(true)) {
+                            // Weak connection outside of the interpolatory set.
+                            dia += v;
+                            continue;
+                        }
+
+                        // Distribute the strong fine connection between the
+                        // interpolatory variables and i itself.
+                        row_view rk = row(c);
+
+                        value_type a_kk = zero;
+                        for(ptrdiff_t l = 0; l < rk.size; ++l)
+                            if (rk.col[l] == c) a_kk += rk.val[l];
+
+                        value_type sum = zero;
+                        for(ptrdiff_t l = 0; l < rk.size; ++l) {
+                            value_type a = rk.val[l];
+                            if (a * a_kk >= zero) continue;
+
+                            ptrdiff_t kl = rk.code[l];
+                            if (rk.col[l] == gi || (kl >= 0 && find(kl >> 1) >= 0))
+                                sum += a;
+                        }
+
+                        if (math::norm(sum) < eps) {
+                            dia += v;
+                            continue;
+                        }
+
+                        value_type f = v / sum;
+
+                        for(ptrdiff_t l = 0; l < rk.size; ++l) {
+                            value_type a = rk.val[l];
+                            if (a * a_kk >= zero) continue;
+
+                            ptrdiff_t kl = rk.code[l];
+                            if (rk.col[l] == gi) {
+                                dia += f * a;
+                            } else if (kl >= 0) {
+                                ptrdiff_t p = find(kl >> 1);
+                                if (p >= 0) cval[p] += f * a;
+                            }
+                        }
+                    }
+
+                    if (math::norm(dia) < eps) continue;
+
+                    ptrdiff_t m = ccol.size();
+                    for(ptrdiff_t p = 0; p < m; ++p) cval[p] = -cval[p] / dia;
+
+                    if (prm.do_trunc) m = truncate(ccol, cval);
+
+                    for(ptrdiff_t p = 0; p < m; ++p) {
+                        if (math::is_zero(cval[p])) continue;
+
+                        t_col.push_back(ccol[p]);
+                        t_val.push_back(cval[p]);
+
+                        if (ccol[p] >= c_beg && ccol[p] < c_end)
+                            ++P_loc.ptr[i+1];
+                        else
+                            ++P_rem.ptr[i+1];
+                    }
+                }
+
+#pragma omp single
+                {
+                    P_loc.set_nonzeros(P_loc.scan_row_sizes());
+                    P_rem.set_nonzeros(P_rem.scan_row_sizes());
+                }
+
+                // The same static schedule gives the same rows to the
+                // thread, so the weights may be copied in order.
+                ptrdiff_t head = 0;
+
+#pragma omp for schedule(static)
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    ptrdiff_t loc_head = P_loc.ptr[i];
+                    ptrdiff_t rem_head = P_rem.ptr[i];
+                    ptrdiff_t end = head + (P_loc.ptr[i+1] - loc_head) + (P_rem.ptr[i+1] - rem_head);
+
+                    for(; head < end; ++head) {
+                        ptrdiff_t c = t_col[head];
+
+                        if (c >= c_beg && c < c_end) {
+                            P_loc.col[loc_head] = c - c_beg;
+                            P_loc.val[loc_head] = t_val[head];
+                            ++loc_head;
+                        } else {
+                            P_rem.col[rem_head] = c;
+                            P_rem.val[rem_head] = t_val[head];
+                            ++rem_head;
+                        }
+                    }
+                }
+            }
+            AMGCL_TOC("interpolation");
+
+            return std::make_shared<matrix>(comm, p_loc, p_rem);
+        }
+
+        // Drops the small interpolation weights, keeps at most
+        // max_elements largest weights, and rescales the rest so that the
+        // row sum remains unchanged. Returns the number of the weights
+        // kept at the beginning of the arrays.
+        ptrdiff_t truncate(std::vector<ptrdiff_t> &col, std::vector<value_type> &val) const {
+            ptrdiff_t m = col.size();
+
+            value_type sum_all = math::zero<value_type>();
+            scalar_type w_max = 0;
+
+            for(ptrdiff_t p = 0; p < m; ++p) {
+                sum_all += val[p];
+                w_max = std::max(w_max, math::norm(val[p]));
+            }
+
+            scalar_type w_min = prm.eps_trunc * w_max;
+
+            ptrdiff_t k = 0;
+            for(ptrdiff_t p = 0; p < m; ++p) {
+                if (math::norm(val[p]) >= w_min) {
+                    col[k] = col[p];
+                    val[k] = val[p];
+                    ++k;
+                }
+            }
+
+            if (prm.max_elements && k > static_cast<ptrdiff_t>(prm.max_elements)) {
+                std::vector<ptrdiff_t> idx(k);
+                for(ptrdiff_t p = 0; p < k; ++p) idx[p] = p;
+
+                std::nth_element(idx.begin(), idx.begin() + prm.max_elements, idx.end(),
+                        [&](ptrdiff_t a, ptrdiff_t b) {
+                            return math::norm(val[a]) > math::norm(val[b]);
+                        });
+
+                std::sort(idx.begin(), idx.begin() + prm.max_elements);
+
+                for(unsigned p = 0; p < prm.max_elements; ++p) {
+                    col[p] = col[idx[p]];
+                    val[p] = val[idx[p]];
+                }
+
+                k = prm.max_elements;
+            }
+
+            value_type sum_new = math::zero<value_type>();
+            for(ptrdiff_t p = 0; p < k; ++p) sum_new += val[p];
+
+            if (math::norm(sum_new) > amgcl::detail::eps<scalar_type>(1)) {
+                value_type s = sum_all / sum_new;
+                for(ptrdiff_t p = 0; p < k; ++p) val[p] *= s;
+            }
+
+            return k;
+        }
+};
+
+template <class Backend>
+unsigned block_size(const ruge_stuben<Backend>&) {
+    return 1;
+}
+
+} // namespace coarsening
+} // namespace mpi
+
+namespace backend {
+
+template <class Backend>
+struct coarsening_is_supported<
+    Backend,
+    mpi::coarsening::ruge_stuben,
+    typename std::enable_if<
+        !std::is_arithmetic<typename backend::value_type<Backend>::type>::value
+        >::type
+    > : std::false_type
+{};
+
+} // namespace backend
+} // namespace amgcl
+
+#endif
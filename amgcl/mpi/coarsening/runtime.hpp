@@ -36,6 +36,7 @@ THE SOFTWARE.
 #include <amgcl/mpi/distributed_matrix.hpp>
 #include <amgcl/mpi/coarsening/aggregation.hpp>
 #include <amgcl/mpi/coarsening/smoothed_aggregation.hpp>
+#include <amgcl/mpi/coarsening/ruge_stuben.hpp>
 
 namespace amgcl {
 namespace runtime {
@@ -44,7 +45,8 @@ namespace coarsening {
 
 enum type {
     aggregation,
-    smoothed_aggregation
+    smoothed_aggregation,
+    ruge_stuben
 };
 
 std::ostream& operator<<(std::ostream &os, type s)
@@ -54,6 +56,8 @@ std::ostream& operator<<(std::ostream &os, type s)
             return os << "aggregation";
         case smoothed_aggregation:
             return os << "smoothed_aggregation";
+        case ruge_stuben:
+            return os << "ruge_stuben";
         default:
             return os << "???";
     }
@@ -67,10 +71,12 @@ std::istream& operator>>(std::istream &in, type &s)
     if (val == "aggregation")
         s = aggregation;
     else if (val == "smoothed_aggregation")
-        s = aggregation;
+        s = smoothed_aggregation;
+    else if (val == "ruge_stuben")
+        s = ruge_stuben;
     else
         throw std::invalid_argument("Invalid coarsening value. Valid choices are: "
-                "aggregation, smoothed_aggregation.");
+                "aggregation, smoothed_aggregation, ruge_stuben.");
 
     return in;
 }
@@ -101,6 +107,9 @@ struct wrapper {
                     handle = static_cast<void*>(new C(prm));
                 }
                 break;
+            case ruge_stuben:
+                handle = call_constructor<amgcl::mpi::coarsening::ruge_stuben>(prm);
+                break;
             default:
                 throw std::invalid_argument("Unsupported coarsening type");
         }
@@ -120,6 +129,9 @@ struct wrapper {
                     delete static_cast<C*>(handle);
                 }
                 break;
+            case ruge_stuben:
+                call_destructor<amgcl::mpi::coarsening::ruge_stuben>();
+                break;
             default:
                 break;
         }
@@ -138,6 +150,8 @@ struct wrapper {
                     typedef amgcl::mpi::coarsening::smoothed_aggregation<Backend> C;
                     return static_cast<C*>(handle)->transfer_operators(A);
                 }
+            case ruge_stuben:
+                return make_operators<amgcl::mpi::coarsening::ruge_stuben>(A);
             default:
                 throw std::invalid_argument("Unsupported partition type");
         }
@@ -156,10 +170,112 @@ struct wrapper {
                     typedef amgcl::mpi::coarsening::smoothed_aggregation<Backend> C;
                     return static_cast<C*>(handle)->coarse_operator(A, P, R);
                 }
+            case ruge_stuben:
+                return make_coarse<amgcl::mpi::coarsening::ruge_stuben>(A, P, R);
             default:
                 throw std::invalid_argument("Unsupported partition type");
         }
     }
+
+    std::shared_ptr<matrix>
+    coarse_operator(const matrix &A, const matrix &P, const matrix &R,
+            amgcl::mpi::galerkin_plan<Backend> &plan) const
+    {
+        switch (c) {
+            case aggregation:
+                {
+                    typedef amgcl::mpi::coarsening::aggregation<Backend> C;
+                    return static_cast<C*>(handle)->coarse_operator(A, P, R, plan);
+                }
+            case smoothed_aggregation:
+                {
+                    typedef amgcl::mpi::coarsening::smoothed_aggregation<Backend> C;
+                    return static_cast<C*>(handle)->coarse_operator(A, P, R, plan);
+                }
+            case ruge_stuben:
+                return make_coarse<amgcl::mpi::coarsening::ruge_stuben>(A, P, R, &plan);
+            default:
+                throw std::invalid_argument("Unsupported partition type");
+        }
+    }
+
+    private:
+        // Classical AMG only supports scalar value types.
+        template <template <class> class Coarsening>
+        typename std::enable_if<
+            backend::coarsening_is_supported<Backend, Coarsening>::value,
+            void*
+        >::type
+        call_constructor(const params &prm) {
+            return static_cast<void*>(new Coarsening<Backend>(prm));
+        }
+
+        template <template <class> class Coarsening>
+        typename std::enable_if<
+            !backend::coarsening_is_supported<Backend, Coarsening>::value,
+            void*
+        >::type
+        call_constructor(const params&) {
+            throw std::logic_error("The coarsening is not supported by the backend");
+        }
+
+        template <template <class> class Coarsening>
+        typename std::enable_if<
+            backend::coarsening_is_supported<Backend, Coarsening>::value,
+            void
+        >::type
+        call_destructor() {
+            delete static_cast<Coarsening<Backend>*>(handle);
+        }
+
+        template <template <class> class Coarsening>
+        typename std::enable_if<
+            !backend::coarsening_is_supported<Backend, Coarsening>::value,
+            void
+        >::type
+        call_destructor() {
+        }
+
+        template <template <class> class Coarsening>
+        typename std::enable_if<
+            backend::coarsening_is_supported<Backend, Coarsening>::value,
+            std::tuple< std::shared_ptr<matrix>, std::shared_ptr<matrix> >
+        >::type
+        make_operators(const matrix &A) {
+            return static_cast<Coarsening<Backend>*>(handle)->transfer_operators(A);
+        }
+
+        template <template <class> class Coarsening>
+        typename std::enable_if<
+            !backend::coarsening_is_supported<Backend, Coarsening>::value,
+            std::tuple< std::shared_ptr<matrix>, std::shared_ptr<matrix> >
+        >::type
+        make_operators(const matrix&) {
+            throw std::logic_error("The coarsening is not supported by the backend");
+        }
+
+        template <template <class> class Coarsening>
+        typename std::enable_if<
+            backend::coarsening_is_supported<Backend, Coarsening>::value,
+            std::shared_ptr<matrix>
+        >::type
+        make_coarse(const matrix &A, const matrix &P, const matrix &R,
+                amgcl::mpi::galerkin_plan<Backend> *plan = 0) const
+        {
+            const Coarsening<Backend> *C = static_cast<const Coarsening<Backend>*>(handle);
+            return plan ? C->coarse_operator(A, P, R, *plan) : C->coarse_operator(A, P, R);
+        }
+
+        template <template <class> class Coarsening>
+        typename std::enable_if<
+            !backend::coarsening_is_supported<Backend, Coarsening>::value,
+            std::shared_ptr<matrix>
+        >::type
+        make_coarse(const matrix&, const matrix&, const matrix&,
+                amgcl::mpi::galerkin_plan<Backend>* = 0) const
+        {
+            throw std::logic_error("The coarsening is not supported by the backend");
+        }
 };
 
 template <class Backend>
@@ -175,6 +291,8 @@ unsigned block_size(const wrapper<Backend> &w) {
                 typedef amgcl::mpi::coarsening::smoothed_aggregation<Backend> C;
                 return block_size(*static_cast<const C*>(w.handle));
             }
+        case ruge_stuben:
+            return 1;
         default:
             throw std::invalid_argument("Unsupported coarsening type");
     }
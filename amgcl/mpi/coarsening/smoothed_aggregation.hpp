@@ -197,6 +197,17 @@ struct smoothed_aggregation {
         return amgcl::coarsening::detail::galerkin(A, P, R);
     }
 
+    std::shared_ptr< distributed_matrix<Backend> >
+    coarse_operator(
+            const distributed_matrix<Backend> &A,
+            const distributed_matrix<Backend> &P,
+            const distributed_matrix<Backend> &R,
+            galerkin_plan<Backend> &plan
+            ) const
+    {
+        return plan(A, P, R);
+    }
+
 };
 
 template <class Backend>
@@ -60,13 +60,13 @@ class eigen_splu : public solver_base< value_type, eigen_splu<value_type> > {
                     >
                 >
             Solver;
-        typedef typename Solver::params params;
+        typedef serial_solver_params params;
         typedef backend::crs<value_type> build_matrix;
 
         /// Constructor.
         template <class Matrix>
         eigen_splu(communicator comm, const Matrix &A,
-                const params &prm = params()) : prm(prm)
+                const params &prm = params()) : Base(prm.replicate), prm(prm)
         {
             static_cast<Base*>(this)->init(comm, A);
         }
@@ -80,7 +80,7 @@ class eigen_splu : public solver_base< value_type, eigen_splu<value_type> > {
         }
 
         void init(communicator, const build_matrix &A) {
-            S = std::make_shared<Solver>(A, prm);
+            S = std::make_shared<Solver>(A);
         }
 
         /// Solves the problem for the given right-hand side.
@@ -53,14 +53,14 @@ template <typename value_type>
 class skyline_lu : public solver_base< value_type, skyline_lu<value_type> > {
     public:
         typedef amgcl::solver::skyline_lu<value_type> Solver;
-        typedef typename Solver::params params;
+        typedef serial_solver_params params;
         typedef backend::crs<value_type> build_matrix;
 
         /// Constructor.
         template <class Matrix>
         skyline_lu(communicator comm, const Matrix &A,
                 const params &prm = params()
-                ) : prm(prm)
+                ) : Base(prm.replicate), prm(prm)
         {
             static_cast<Base*>(this)->init(comm, A);
         }
@@ -74,7 +74,7 @@ class skyline_lu : public solver_base< value_type, skyline_lu<value_type> > {
         }
 
         void init(communicator, const build_matrix &A) {
-            S = std::make_shared<Solver>(A, prm);
+            S = std::make_shared<Solver>(A);
         }
 
         /// Solves the problem for the given right-hand side.
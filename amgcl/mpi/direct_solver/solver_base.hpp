@@ -38,6 +38,35 @@ namespace amgcl {
 namespace mpi {
 namespace direct {
 
+/// Parameters for the distributed wrappers around serial direct solvers.
+struct serial_solver_params {
+    typedef serial_solver_params params;
+
+    /// Replicate the coarse problem on every process.
+    /**
+     * By default, the coarse matrix is consolidated on a single process,
+     * and the right-hand side is gathered to and the solution is scattered
+     * from that process on each solve. When the option is set, the complete
+     * coarse matrix is factorized on each of the active processes, so that
+     * each solve only needs a single MPI_Allgatherv of the right-hand side.
+     * This trades memory and setup work for the latency on the coarsest
+     * level of the cycle.
+     */
+    bool replicate;
+
+    serial_solver_params() : replicate(false) {}
+
+    serial_solver_params(const boost::property_tree::ptree &p)
+        : AMGCL_PARAMS_IMPORT_VALUE(p, replicate)
+    {
+        check_params(p, {"replicate"});
+    }
+
+    void get(boost::property_tree::ptree &p, const std::string &path = "") const {
+        AMGCL_PARAMS_EXPORT_VALUE(p, path, replicate);
+    }
+};
+
 template <class value_type, class Solver>
 class solver_base {
     public:
@@ -45,7 +74,7 @@ class solver_base {
         typedef typename math::rhs_of<value_type>::type    rhs_type;
         typedef backend::crs<value_type> build_matrix;
 
-        solver_base() {}
+        solver_base(bool replicate = false) : replicate(replicate) {}
 
         void init(communicator comm, const build_matrix &Astrip) {
             this->comm = comm;
@@ -63,6 +92,16 @@ class solver_base {
                 }
             }
 
+            if (replicate) {
+                // Each active process gets the complete matrix.
+                group_master = comm.rank;
+
+                MPI_Comm_split(comm, n ? 0 : MPI_UNDEFINED, comm.rank, &masters_comm);
+
+                if (n) gather_all(Astrip, domain, active);
+                return;
+            }
+
             // Consolidate the matrix on a fewer processes.
             int nmasters = std::min<int>(active.size(), solver().comm_size(domain.back()));
             int slaves_per_master = (active.size() + nmasters - 1) / nmasters;
@@ -218,7 +257,13 @@ class solver_base {
 
             backend::copy(f, host_v);
 
-            if (comm.rank == group_master) {
+            if (replicate) {
+                MPI_Allgatherv(&host_v[0], n, T, &cons_f[0], &counts[0], &displs[0], T, masters_comm);
+
+                solver().solve(cons_f, cons_x);
+
+                std::copy(cons_x.begin() + row_beg, cons_x.begin() + row_beg + n, host_v.begin());
+            } else if (comm.rank == group_master) {
                 std::copy(host_v.begin(), host_v.end(), cons_f.begin());
 
                 int shift = n, j = 0;
@@ -257,12 +302,72 @@ class solver_base {
 
         communicator comm;
         int          n;
+        int          row_beg;
         int          group_master;
+        bool         replicate;
         MPI_Comm     masters_comm;
         std::vector<int> slaves;
         std::vector<int> counts;
+        std::vector<int> displs;
         mutable std::vector<rhs_type> cons_f, cons_x, host_v;
         mutable std::vector<MPI_Request> solve_req;
+
+        void gather_all(
+                const build_matrix &Astrip,
+                const std::vector<int> &domain,
+                const std::vector<int> &active
+                )
+        {
+            int nact = active.size();
+            int nrows = domain.back();
+
+            row_beg = domain[comm.rank];
+
+            counts.resize(nact);
+            displs.resize(nact);
+
+            for(int j = 0; j < nact; ++j) {
+                int i = active[j];
+                displs[j] = domain[i];
+                counts[j] = domain[i+1] - domain[i];
+            }
+
+            std::vector<ptrdiff_t> widths(n);
+            for(ptrdiff_t i = 0; i < n; ++i)
+                widths[i] = Astrip.ptr[i+1] - Astrip.ptr[i];
+
+            build_matrix A;
+            A.set_size(nrows, nrows, false);
+            A.ptr[0] = 0;
+
+            MPI_Allgatherv(widths.data(), n, datatype<ptrdiff_t>(),
+                    &A.ptr[1], &counts[0], &displs[0], datatype<ptrdiff_t>(),
+                    masters_comm);
+
+            A.set_nonzeros(A.scan_row_sizes());
+
+            std::vector<int> nnz_counts(nact);
+            std::vector<int> nnz_displs(nact);
+
+            for(int j = 0; j < nact; ++j) {
+                nnz_displs[j] = A.ptr[displs[j]];
+                nnz_counts[j] = A.ptr[displs[j] + counts[j]] - nnz_displs[j];
+            }
+
+            MPI_Allgatherv(Astrip.col, Astrip.nnz, datatype<ptrdiff_t>(),
+                    A.col, &nnz_counts[0], &nnz_displs[0], datatype<ptrdiff_t>(),
+                    masters_comm);
+
+            MPI_Allgatherv(Astrip.val, Astrip.nnz, datatype<value_type>(),
+                    A.val, &nnz_counts[0], &nnz_displs[0], datatype<value_type>(),
+                    masters_comm);
+
+            cons_f.resize(nrows);
+            cons_x.resize(nrows);
+            host_v.resize(n);
+
+            solver().init(masters_comm, A);
+        }
 };
 
 } // namespace direct
@@ -44,9 +44,36 @@ THE SOFTWARE.
  * \brief  Distributed matrix implementation.
  */
 
+// Number of local rows processed between the MPI progress polls in the
+// distributed SpMV and SpGEMM with the builtin backend. The polls are made
+// from the master thread inside OpenMP parallel regions, which requires MPI
+// to be initialized with at least MPI_THREAD_FUNNELED support. Polling is
+// disabled by default, and is skipped at runtime when the thread support
+// level is not sufficient.
+#ifndef AMGCL_MPI_PROGRESS_CHUNK
+#  define AMGCL_MPI_PROGRESS_CHUNK 0
+#endif
+
+// Use MPI-3 shared memory windows for the halo exchange between processes
+// on the same compute node (builtin backend only).
+#if !defined(AMGCL_MPI_DISABLE_SHARED_MEMORY) && defined(MPI_VERSION) && MPI_VERSION >= 3
+#  define AMGCL_MPI_SHARED_MEMORY
+#endif
+
 namespace amgcl {
 namespace mpi {
 
+/// Enables the halo exchange through MPI-3 shared memory on a node.
+/**
+ * The exchange is enabled by default, unless AMGCL_MPI_DISABLE_SHARED_MEMORY
+ * is defined. The setting takes effect for the matrices moved to the backend
+ * after the change, and should be the same on all processes.
+ */
+inline bool& shared_memory_exchange() {
+    static bool enable = true;
+    return enable;
+}
+
 template <class Backend>
 class comm_pattern {
     public:
@@ -68,6 +95,7 @@ class comm_pattern {
 
             mutable std::vector<rhs_type>    val;
             mutable std::vector<MPI_Request> req;
+            mutable std::vector<MPI_Request> preq; // persistent requests
         } send;
 
         struct {
@@ -80,6 +108,7 @@ class comm_pattern {
 
             mutable std::vector<rhs_type>    val;
             mutable std::vector<MPI_Request> req;
+            mutable std::vector<MPI_Request> preq; // persistent requests
         } recv;
 
         std::shared_ptr<vector> x_rem;
@@ -88,8 +117,11 @@ class comm_pattern {
                 communicator comm,
                 ptrdiff_t n_loc_cols,
                 size_t n_rem_cols, const ptrdiff_t *p_rem_cols
-                ) : comm(comm), loc_cols(n_loc_cols)
+                ) : comm(comm), loc_cols(n_loc_cols), recv_buf(0)
         {
+#ifdef AMGCL_MPI_SHARED_MEMORY
+            shm.active = false;
+#endif
             AMGCL_TIC("communication pattern");
             // Get domain boundaries
             std::vector<ptrdiff_t> domain = comm.exclusive_sum(n_loc_cols);
@@ -184,9 +216,61 @@ class comm_pattern {
             AMGCL_TOC("communication pattern");
         }
 
+        /// Whether the exchange with the on-node neighbours goes through
+        /// shared memory.
+        bool shared_memory() const {
+#ifdef AMGCL_MPI_SHARED_MEMORY
+            return shm.active;
+#else
+            return false;
+#endif
+        }
+
+        comm_pattern(const comm_pattern&) = delete;
+        comm_pattern& operator=(const comm_pattern&) = delete;
+
+        ~comm_pattern() {
+            free_requests();
+        }
+
         void move_to_backend(const backend_params &bprm = backend_params()) {
+            // The pattern may be shared between several matrices (and is
+            // moved to the backend with each of them), but the setup below
+            // is collective and should only be done once.
+            if (x_rem) return;
+
             x_rem  = Backend::create_vector(recv.count(), bprm);
             gather = std::make_shared<Gather>(loc_cols, send.col, bprm);
+
+            // The neighbours and the message sizes do not change during the
+            // lifetime of the pattern, so the value exchange is set up once
+            // with persistent requests and is simply restarted in
+            // start_exchange(). When the ghost vector lives in host memory,
+            // the values are received directly into it.
+            recv_buf = host_ptr(*x_rem);
+            rhs_type *rbuf = recv_buf ? recv_buf : recv.val.data();
+            rhs_type *sbuf = send.val.data();
+
+            std::vector<char> on_node_recv(recv.nbr.size(), false);
+            std::vector<char> on_node_send(send.nbr.size(), false);
+
+#ifdef AMGCL_MPI_SHARED_MEMORY
+            if (recv_buf) init_shm(on_node_recv, on_node_send, sbuf);
+#endif
+
+            for(size_t i = 0; i < recv.nbr.size(); ++i) {
+                if (on_node_recv[i]) continue;
+                recv.preq.push_back(MPI_REQUEST_NULL);
+                MPI_Recv_init(rbuf + recv.ptr[i], recv.ptr[i+1] - recv.ptr[i],
+                        datatype<rhs_type>(), recv.nbr[i], tag_exc_vals, comm, &recv.preq.back());
+            }
+
+            for(size_t i = 0; i < send.nbr.size(); ++i) {
+                if (on_node_send[i]) continue;
+                send.preq.push_back(MPI_REQUEST_NULL);
+                MPI_Send_init(sbuf + send.ptr[i], send.ptr[i+1] - send.ptr[i],
+                        datatype<rhs_type>(), send.nbr[i], tag_exc_vals, comm, &send.preq.back());
+            }
         }
 
         int domain(ptrdiff_t col) const {
@@ -214,30 +298,85 @@ class comm_pattern {
         template <class Vector>
         void start_exchange(const Vector &x) const {
             // Start receiving ghost values from our neighbours.
-            for(size_t i = 0; i < recv.nbr.size(); ++i)
-                MPI_Irecv(&recv.val[recv.ptr[i]], recv.ptr[i+1] - recv.ptr[i],
-                        datatype<rhs_type>(), recv.nbr[i], tag_exc_vals, comm, &recv.req[i]);
+            if (!recv.preq.empty())
+                MPI_Startall(recv.preq.size(), recv.preq.data());
+
+#ifdef AMGCL_MPI_SHARED_MEMORY
+            if (shm.active) {
+                start_all(shm.ready_recv);
+
+                // Our on-node neighbours should be done reading the
+                // previously exchanged values before we overwrite them.
+                if (shm.done_pending) {
+                    wait_all(shm.done_recv);
+                    wait_all(shm.done_send);
+                }
+
+                if (!send.val.empty()) {
+                    gather_shm(x, std::is_same<Backend, backend::builtin<value_type> >());
+                    MPI_Win_sync(shm.win);
+                }
+
+                start_all(send.preq);
+                start_all(shm.ready_send);
+                start_all(shm.done_recv);
+                shm.done_pending = true;
+                return;
+            }
+#endif
 
             // Start sending our data to neighbours.
-            if (!send.val.empty()) {
+            if (!send.preq.empty()) {
                 (*gather)(x, send.val);
-
-                for(size_t i = 0; i < send.nbr.size(); ++i)
-                    MPI_Isend(&send.val[send.ptr[i]], send.ptr[i+1] - send.ptr[i],
-                            datatype<rhs_type>(), send.nbr[i], tag_exc_vals, comm, &send.req[i]);
+                MPI_Startall(send.preq.size(), send.preq.data());
             }
         }
 
         void finish_exchange() const {
             AMGCL_TIC("MPI Wait");
-            MPI_Waitall(recv.req.size(), &recv.req[0], MPI_STATUSES_IGNORE);
-            MPI_Waitall(send.req.size(), &send.req[0], MPI_STATUSES_IGNORE);
+            if (!recv.preq.empty())
+                MPI_Waitall(recv.preq.size(), recv.preq.data(), MPI_STATUSES_IGNORE);
+#ifdef AMGCL_MPI_SHARED_MEMORY
+            if (shm.active) {
+                // Read the ghost values of our on-node neighbours directly
+                // from their send buffers.
+                wait_all(shm.ready_recv);
+                MPI_Win_sync(shm.win);
+
+                for(size_t k = 0; k < shm.recv_idx.size(); ++k) {
+                    int i = shm.recv_idx[k];
+                    std::copy(shm.recv_src[k], shm.recv_src[k] + recv.ptr[i+1] - recv.ptr[i],
+                            recv_buf + recv.ptr[i]);
+                }
+
+                start_all(shm.done_send);
+                wait_all(shm.ready_send);
+            }
+#endif
+            if (!send.preq.empty())
+                MPI_Waitall(send.preq.size(), send.preq.data(), MPI_STATUSES_IGNORE);
             AMGCL_TOC("MPI Wait");
 
-            if (!recv.val.empty())
+            if (!recv.val.empty() && !recv_buf)
                 backend::copy(recv.val, *x_rem);
         }
 
+        // Makes progress on the outstanding halo exchange. Most MPI
+        // implementations only advance non-blocking communication from
+        // inside MPI calls, so this should be called periodically while the
+        // local part of the work is being done.
+        void progress() const {
+            int flag;
+            if (!recv.preq.empty())
+                MPI_Testall(recv.preq.size(), recv.preq.data(), &flag, MPI_STATUSES_IGNORE);
+            if (!send.preq.empty())
+                MPI_Testall(send.preq.size(), send.preq.data(), &flag, MPI_STATUSES_IGNORE);
+#ifdef AMGCL_MPI_SHARED_MEMORY
+            if (shm.active && !shm.ready_recv.empty())
+                MPI_Testall(shm.ready_recv.size(), shm.ready_recv.data(), &flag, MPI_STATUSES_IGNORE);
+#endif
+        }
+
         template <typename T>
         void exchange(const T *send_val, T *recv_val) const {
             for(size_t i = 0; i < recv.nbr.size(); ++i)
@@ -268,14 +407,504 @@ class comm_pattern {
         static const int tag_set_comm = 1001;
         static const int tag_exc_cols = 1002;
         static const int tag_exc_vals = 1003;
+        static const int tag_shm_base = 1004;
 
         communicator comm;
 
         std::unordered_map<ptrdiff_t, std::tuple<int, int> > idx;
         std::shared_ptr<Gather> gather;
         ptrdiff_t loc_beg, loc_cols;
+
+        rhs_type *recv_buf;
+
+        static rhs_type* host_ptr(backend::numa_vector<rhs_type> &x) {
+            return x.data();
+        }
+
+        template <class Vector>
+        static rhs_type* host_ptr(Vector&) {
+            return 0;
+        }
+
+#ifdef AMGCL_MPI_SHARED_MEMORY
+        // Halo exchange between the processes sharing a compute node.
+        // Send buffers are allocated in MPI-3 shared memory windows, and the
+        // on-node neighbours read the ghost values from there directly. The
+        // point-to-point messages are only used for zero-size notifications
+        // (the values are ready / the values have been read).
+        struct {
+            bool      active;
+            MPI_Comm  comm;
+            MPI_Win   win;
+            rhs_type *send_buf;
+            int       tag_offsets, tag_ready, tag_done;
+
+            std::vector<int>             recv_idx;
+            std::vector<const rhs_type*> recv_src;
+
+            mutable bool done_pending;
+            mutable std::vector<MPI_Request> ready_send, ready_recv;
+            mutable std::vector<MPI_Request> done_send,  done_recv;
+        } shm;
+
+        template <class Vector>
+        void gather_shm(const Vector &x, std::true_type) const {
+            (*gather)(x, shm.send_buf);
+        }
+
+        template <class Vector>
+        void gather_shm(const Vector&, std::false_type) const {}
+
+        static void start_all(std::vector<MPI_Request> &req) {
+            if (!req.empty()) MPI_Startall(req.size(), req.data());
+        }
+
+        static void wait_all(std::vector<MPI_Request> &req) {
+            if (!req.empty()) MPI_Waitall(req.size(), req.data(), MPI_STATUSES_IGNORE);
+        }
+
+        // Sequence number of the shared memory pattern on the node. The
+        // patterns are set up collectively on the node communicator, so the
+        // numbers agree between the processes. The counter is kept as an
+        // attribute of the node communicator.
+        static int next_shm_seq(MPI_Comm node) {
+            static const int key = shm_seq_keyval();
+
+            int *seq, found;
+            MPI_Comm_get_attr(node, key, &seq, &found);
+
+            if (!found) {
+                seq = new int(0);
+                MPI_Comm_set_attr(node, key, seq);
+            }
+
+            // Wrap around within the valid tag range.
+            int *tag_ub;
+            MPI_Comm_get_attr(node, MPI_TAG_UB, &tag_ub, &found);
+            int nseq = ((found ? *tag_ub : 32767) - tag_shm_base) / 3;
+
+            int s = *seq;
+            *seq = (s + 1) % nseq;
+            return s;
+        }
+
+        static int shm_seq_keyval() {
+            int key;
+            MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, free_shm_seq, &key, 0);
+            return key;
+        }
+
+        static int free_shm_seq(MPI_Comm, int, void *val, void*) {
+            delete static_cast<int*>(val);
+            return MPI_SUCCESS;
+        }
+
+        void init_shm(
+                std::vector<char> &on_node_recv,
+                std::vector<char> &on_node_send,
+                rhs_type* &sbuf
+                )
+        {
+            // Only the builtin backend is able to gather directly into the
+            // shared memory window.
+            if (!std::is_same<Backend, backend::builtin<value_type> >::value)
+                return;
+
+            if (!shared_memory_exchange()) return;
+
+            // The node communicator is cached by the parent one, so it is
+            // shared by all the patterns built on the same communicator.
+            communicator node = comm.node();
+            if (node.size == 1) return;
+
+            shm.comm = node;
+
+            // The node communicator is shared with the other patterns, so
+            // each pattern uses its own tags for the on-node messages.
+            int seq = next_shm_seq(node);
+            shm.tag_offsets = tag_shm_base + 3 * seq;
+            shm.tag_ready   = shm.tag_offsets + 1;
+            shm.tag_done    = shm.tag_offsets + 2;
+
+            shm.active = true;
+            shm.done_pending = false;
+
+            MPI_Win_allocate_shared(send.count() * sizeof(rhs_type), sizeof(rhs_type),
+                    MPI_INFO_NULL, shm.comm, &shm.send_buf, &shm.win);
+            MPI_Win_lock_all(MPI_MODE_NOCHECK, shm.win);
+            sbuf = shm.send_buf;
+
+            // Find out which of our neighbours live on the same node.
+            MPI_Group glob_group, node_group;
+            MPI_Comm_group(comm, &glob_group);
+            MPI_Comm_group(shm.comm, &node_group);
+
+            std::vector<int> recv_nbr(recv.nbr.begin(), recv.nbr.end());
+            std::vector<int> send_nbr(send.nbr.begin(), send.nbr.end());
+            std::vector<int> recv_loc(recv_nbr.size());
+            std::vector<int> send_loc(send_nbr.size());
+
+            if (!recv_nbr.empty())
+                MPI_Group_translate_ranks(glob_group, recv_nbr.size(), recv_nbr.data(), node_group, recv_loc.data());
+            if (!send_nbr.empty())
+                MPI_Group_translate_ranks(glob_group, send_nbr.size(), send_nbr.data(), node_group, send_loc.data());
+
+            MPI_Group_free(&glob_group);
+            MPI_Group_free(&node_group);
+
+            // Let the on-node neighbours know where their values are
+            // located in our send buffer.
+            std::vector<ptrdiff_t>   offset(recv_nbr.size());
+            std::vector<MPI_Request> req;
+
+            for(size_t i = 0; i < recv_nbr.size(); ++i) {
+                if (recv_loc[i] == MPI_UNDEFINED) continue;
+                on_node_recv[i] = true;
+                shm.recv_idx.push_back(i);
+
+                req.push_back(MPI_REQUEST_NULL);
+                MPI_Irecv(&offset[i], 1, datatype<ptrdiff_t>(), recv_loc[i], shm.tag_offsets, shm.comm, &req.back());
+
+                shm.ready_recv.push_back(MPI_REQUEST_NULL);
+                MPI_Recv_init(0, 0, MPI_CHAR, recv_loc[i], shm.tag_ready, shm.comm, &shm.ready_recv.back());
+
+                shm.done_send.push_back(MPI_REQUEST_NULL);
+                MPI_Send_init(0, 0, MPI_CHAR, recv_loc[i], shm.tag_done, shm.comm, &shm.done_send.back());
+            }
+
+            for(size_t i = 0; i < send_nbr.size(); ++i) {
+                if (send_loc[i] == MPI_UNDEFINED) continue;
+                on_node_send[i] = true;
+
+                req.push_back(MPI_REQUEST_NULL);
+                MPI_Isend(&send.ptr[i], 1, datatype<ptrdiff_t>(), send_loc[i], shm.tag_offsets, shm.comm, &req.back());
+
+                shm.ready_send.push_back(MPI_REQUEST_NULL);
+                MPI_Send_init(0, 0, MPI_CHAR, send_loc[i], shm.tag_ready, shm.comm, &shm.ready_send.back());
+
+                shm.done_recv.push_back(MPI_REQUEST_NULL);
+                MPI_Recv_init(0, 0, MPI_CHAR, send_loc[i], shm.tag_done, shm.comm, &shm.done_recv.back());
+            }
+
+            wait_all(req);
+
+            for(int i : shm.recv_idx) {
+                MPI_Aint size;
+                int      disp;
+                rhs_type *base;
+
+                MPI_Win_shared_query(shm.win, recv_loc[i], &size, &disp, &base);
+                shm.recv_src.push_back(base + offset[i]);
+            }
+        }
+
+        void free_shm(bool finalized) {
+            if (!shm.active) return;
+
+            if (!finalized) {
+                if (shm.done_pending) {
+                    wait_all(shm.done_recv);
+                    wait_all(shm.done_send);
+                }
+
+                for(MPI_Request &r : shm.ready_send) MPI_Request_free(&r);
+                for(MPI_Request &r : shm.ready_recv) MPI_Request_free(&r);
+                for(MPI_Request &r : shm.done_send)  MPI_Request_free(&r);
+                for(MPI_Request &r : shm.done_recv)  MPI_Request_free(&r);
+
+                MPI_Win_unlock_all(shm.win);
+                MPI_Win_free(&shm.win);
+            }
+
+            shm.ready_send.clear();
+            shm.ready_recv.clear();
+            shm.done_send.clear();
+            shm.done_recv.clear();
+            shm.recv_idx.clear();
+            shm.recv_src.clear();
+
+            shm.active = false;
+        }
+#endif
+
+        void free_requests() {
+            int finalized;
+            MPI_Finalized(&finalized);
+
+            if (!finalized) {
+                for(MPI_Request &r : recv.preq) MPI_Request_free(&r);
+                for(MPI_Request &r : send.preq) MPI_Request_free(&r);
+            }
+
+#ifdef AMGCL_MPI_SHARED_MEMORY
+            free_shm(finalized);
+#endif
+
+            recv.preq.clear();
+            send.preq.clear();
+            recv_buf = 0;
+        }
 };
 
+namespace detail {
+
+// Number of iterations between the MPI progress polls, or zero when polling
+// is disabled. Should be called outside of OpenMP parallel regions.
+inline ptrdiff_t progress_chunk() {
+    if (AMGCL_MPI_PROGRESS_CHUNK <= 0) return 0;
+
+    int level;
+    MPI_Query_thread(&level);
+    return level >= MPI_THREAD_FUNNELED ? AMGCL_MPI_PROGRESS_CHUNK : 0;
+}
+
+// Static partition of [0, n) between the threads of the enclosing parallel
+// region. The master thread calls progress() every chunk iterations.
+template <class Progress, class Func>
+void progress_for(ptrdiff_t n, ptrdiff_t chunk, const Progress &progress, const Func &f) {
+
+#ifdef _OPENMP
+    const int nt  = omp_get_num_threads();
+    const int tid = omp_get_thread_num();
+#else
+    const int nt  = 1;
+    const int tid = 0;
+#endif
+    const ptrdiff_t beg = n * tid / nt;
+    const ptrdiff_t end = n * (tid + 1) / nt;
+
+    if (tid == 0 && chunk) {
+        for(ptrdiff_t i = beg; i < end; i += chunk) {
+            progress();
+            for(ptrdiff_t k = i, e = std::min(i + chunk, end); k < e; ++k) f(k);
+        }
+    } else {
+        for(ptrdiff_t i = beg; i < end; ++i) f(i);
+    }
+}
+
+// Open addressing hash table (linear probing, power of two capacity) that
+// assigns compact local numbers to global column indices.
+class col_map {
+    public:
+        col_map() : count(0), shift(0) {}
+
+        void clear() {
+            slots.clear();
+            count = 0;
+        }
+
+        // Returns the local number of the column, adds the column if needed.
+        int insert(ptrdiff_t c) {
+            if (2 * (count + 1) > slots.size()) rehash();
+
+            std::pair<ptrdiff_t, int> &s = slots[find(c)];
+            if (s.first < 0) {
+                s.first  = c;
+                s.second = static_cast<int>(count++);
+            }
+            return s.second;
+        }
+
+        // Returns the local number of a column that is known to be present.
+        int at(ptrdiff_t c) const {
+            return slots[find(c)].second;
+        }
+
+        size_t size() const {
+            return count;
+        }
+
+    private:
+        std::vector< std::pair<ptrdiff_t, int> > slots;
+        size_t count;
+        int    shift;
+
+        size_t find(ptrdiff_t c) const {
+            const size_t mask = slots.size() - 1;
+
+            // Fibonacci hashing: take the high bits of the product.
+            size_t i = (static_cast<size_t>(c) * static_cast<size_t>(0x9E3779B97F4A7C15ull)) >> shift;
+
+            while(slots[i].first >= 0 && slots[i].first != c) i = (i + 1) & mask;
+            return i;
+        }
+
+        void rehash() {
+            std::vector< std::pair<ptrdiff_t, int> > old(std::max<size_t>(64, 2 * slots.size()), std::make_pair(-1, 0));
+            old.swap(slots);
+
+            shift = 8 * sizeof(size_t);
+            for(size_t n = slots.size(); n > 1; n /= 2) --shift;
+
+            for(const auto &s : old)
+                if (s.first >= 0) slots[find(s.first)] = s;
+        }
+};
+
+// Distributed matrix-vector product. The halo exchange is started, the local
+// part of the product is computed while the exchange is in flight, and the
+// remote part is added once the ghost values have arrived.
+template <class Backend, class Enable = void>
+struct split_product {
+    typedef typename Backend::value_type value_type;
+    typedef typename Backend::params     backend_params;
+    typedef backend::crs<value_type>     build_matrix;
+    typedef comm_pattern<Backend>        CommPattern;
+
+    void init(const build_matrix&) {}
+
+    template <class Alpha, class Matrix, class Vec1, class Beta, class Vec2>
+    void spmv(Alpha alpha, const Matrix &A_loc, const Matrix &A_rem,
+            const Vec1 &x, Beta beta, Vec2 &y, const CommPattern &C) const
+    {
+        C.start_exchange(x);
+        backend::spmv(alpha, A_loc, x, beta, y);
+        C.finish_exchange();
+
+        if (C.needs_remote())
+            backend::spmv(alpha, A_rem, *C.x_rem, 1, y);
+    }
+
+    template <class Matrix, class Vec1, class Vec2, class Vec3>
+    void residual(const Vec1 &f, const Matrix &A_loc, const Matrix &A_rem,
+            const Vec2 &x, Vec3 &r, const CommPattern &C) const
+    {
+        C.start_exchange(x);
+        backend::residual(f, A_loc, x, r);
+        C.finish_exchange();
+
+        if (C.needs_remote())
+            backend::spmv(-1, A_rem, *C.x_rem, 1, r);
+    }
+};
+
+// With the builtin backend, the local rows are split into the interior rows
+// (the rows without couplings to remote columns) and the boundary rows.
+// The interior rows are completely processed while the halo values are in
+// flight. After the exchange, the boundary rows are processed in a single
+// pass over both their local and remote parts. The split is kept as a pair
+// of row index lists, so the local numbering is not changed.
+template <class V>
+struct split_product< backend::builtin<V> > {
+    typedef V                                       value_type;
+    typedef typename math::rhs_of<value_type>::type rhs_type;
+    typedef backend::crs<value_type>                matrix;
+    typedef backend::crs<value_type>                build_matrix;
+    typedef comm_pattern< backend::builtin<V> >     CommPattern;
+
+    std::vector<ptrdiff_t> interior, boundary;
+    ptrdiff_t chunk;
+
+    split_product() : chunk(0) {}
+
+    void init(const build_matrix &A_rem) {
+        const ptrdiff_t n = A_rem.nrows;
+
+        chunk = progress_chunk();
+
+        interior.clear();
+        boundary.clear();
+
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            if (A_rem.ptr[i+1] > A_rem.ptr[i])
+                boundary.push_back(i);
+            else
+                interior.push_back(i);
+        }
+    }
+
+    template <class Alpha, class Vec1, class Beta, class Vec2>
+    void spmv(Alpha alpha, const matrix &A_loc, const matrix &A_rem,
+            const Vec1 &x, Beta beta, Vec2 &y, const CommPattern &C) const
+    {
+        const bool zero_beta = math::is_zero(beta);
+
+        C.start_exchange(x);
+
+        if (boundary.empty() && !polling()) {
+            backend::spmv(alpha, A_loc, x, beta, y);
+        } else {
+            rows(interior, C, [&](ptrdiff_t i) {
+                    rhs_type sum = row_sum(A_loc, i, x);
+                    y[i] = zero_beta ? alpha * sum : alpha * sum + beta * y[i];
+                    });
+        }
+
+        C.finish_exchange();
+
+        if (boundary.empty()) return;
+
+        const backend::numa_vector<rhs_type> &x_rem = *C.x_rem;
+        const ptrdiff_t m = boundary.size();
+
+#pragma omp parallel for
+        for(ptrdiff_t k = 0; k < m; ++k) {
+            ptrdiff_t i = boundary[k];
+            rhs_type sum = row_sum(A_loc, i, x) + row_sum(A_rem, i, x_rem);
+            y[i] = zero_beta ? alpha * sum : alpha * sum + beta * y[i];
+        }
+    }
+
+    template <class Vec1, class Vec2, class Vec3>
+    void residual(const Vec1 &f, const matrix &A_loc, const matrix &A_rem,
+            const Vec2 &x, Vec3 &r, const CommPattern &C) const
+    {
+        C.start_exchange(x);
+
+        if (boundary.empty() && !polling()) {
+            backend::residual(f, A_loc, x, r);
+        } else {
+            rows(interior, C, [&](ptrdiff_t i) {
+                    r[i] = f[i] - row_sum(A_loc, i, x);
+                    });
+        }
+
+        C.finish_exchange();
+
+        if (boundary.empty()) return;
+
+        const backend::numa_vector<rhs_type> &x_rem = *C.x_rem;
+        const ptrdiff_t m = boundary.size();
+
+#pragma omp parallel for
+        for(ptrdiff_t k = 0; k < m; ++k) {
+            ptrdiff_t i = boundary[k];
+            r[i] = f[i] - row_sum(A_loc, i, x) - row_sum(A_rem, i, x_rem);
+        }
+    }
+
+    template <class Vec>
+    static rhs_type row_sum(const matrix &A, ptrdiff_t i, const Vec &x) {
+        rhs_type sum = math::zero<rhs_type>();
+        for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j)
+            sum += A.val[j] * x[A.col[j]];
+        return sum;
+    }
+
+    bool polling() const {
+        return chunk > 0;
+    }
+
+    // When polling is enabled, the master thread polls the outstanding halo
+    // exchange every chunk rows, so that the communication actually
+    // progresses while the threads are busy with the interior rows.
+    template <class Func>
+    void rows(const std::vector<ptrdiff_t> &idx, const CommPattern &C, const Func &f) const {
+        const ptrdiff_t n = idx.size();
+
+        if (polling()) {
+#pragma omp parallel
+            progress_for(n, chunk, [&C]() { C.progress(); }, [&](ptrdiff_t k) { f(idx[k]); });
+        } else {
+#pragma omp parallel for
+            for(ptrdiff_t k = 0; k < n; ++k) f(idx[k]);
+        }
+    }
+};
+
+} // namespace detail
+
 template <class Backend>
 class distributed_matrix {
     public:
@@ -432,6 +1061,10 @@ class distributed_matrix {
             return *C;
         }
 
+        std::shared_ptr<CommPattern> cpat_ptr() const {
+            return C;
+        }
+
         void set_local(std::shared_ptr<matrix> a) {
             A_loc = a;
         }
@@ -443,6 +1076,7 @@ class distributed_matrix {
 
             if (!A_rem) {
                 C->renumber(a_rem->nnz, a_rem->col);
+                S.init(*a_rem);
                 A_rem = Backend::copy_matrix(a_rem, bprm);
             }
 
@@ -454,32 +1088,18 @@ class distributed_matrix {
 
         template <class A, class VecX, class B, class VecY>
         void mul(A alpha, const VecX &x, B beta, VecY &y) const {
-            C->start_exchange(x);
-
-            // Compute local part of the product.
-            backend::spmv(alpha, *A_loc, x, beta, y);
-
-            // Compute remote part of the product.
-            C->finish_exchange();
-
-            if (C->needs_remote())
-                backend::spmv(alpha, *A_rem, *C->x_rem, 1, y);
+            S.spmv(alpha, *A_loc, *A_rem, x, beta, y, *C);
         }
 
         template <class Vec1, class Vec2, class Vec3>
         void residual(const Vec1 &f, const Vec2 &x, Vec3 &r) const {
-            C->start_exchange(x);
-            backend::residual(f, *A_loc, x, r);
-
-            C->finish_exchange();
-
-            if (C->needs_remote())
-                backend::spmv(-1, *A_rem, *C->x_rem, 1, r);
+            S.residual(f, *A_loc, *A_rem, x, r, *C);
         }
 
     private:
         std::shared_ptr<CommPattern>  C;
         std::shared_ptr<matrix> A_loc, A_rem;
+        detail::split_product<Backend> S;
         std::shared_ptr<build_matrix> a_loc, a_rem;
 
         ptrdiff_t n_loc_rows, n_glob_rows;
@@ -646,245 +1266,411 @@ transpose(const distributed_matrix<Backend> &A) {
             comm, backend::transpose(A_loc), T_ptr);
 }
 
+namespace detail {
+
+// Exchange of the rows of a distributed matrix B that correspond to the
+// remote columns of a communication pattern. The exchange is started with
+// start() and completed with finish(); in between, the caller may do some
+// useful work, calling progress() every now and then. Once the structure of
+// the rows has been fetched, start_values() only exchanges the values.
 template <class Backend>
-std::shared_ptr< backend::crs<typename Backend::value_type> >
-remote_rows(
-        const comm_pattern<Backend> &C,
-        const distributed_matrix<Backend> &B,
-        bool need_values = true
-        )
-{
-    typedef typename Backend::value_type value_type;
-    typedef backend::crs<value_type>     build_matrix;
+class remote_rows_fetch {
+    public:
+        typedef typename Backend::value_type value_type;
+        typedef backend::crs<value_type>     build_matrix;
 
-    static const int tag_ptr = 3001;
-    static const int tag_col = 3002;
-    static const int tag_val = 3003;
+        remote_rows_fetch() : C(0), values(false), posted(false) {}
 
-    AMGCL_TIC("remote_rows");
-    communicator comm = C.mpi_comm();
+        remote_rows_fetch(const remote_rows_fetch&) = delete;
+        remote_rows_fetch& operator=(const remote_rows_fetch&) = delete;
 
-    build_matrix &B_loc = *B.local();
-    build_matrix &B_rem = *B.remote();
-    ptrdiff_t B_beg = B.loc_col_shift();
+        void start(
+                const comm_pattern<Backend> &cp,
+                const distributed_matrix<Backend> &B,
+                bool need_values = true
+                )
+        {
+            C = &cp;
+            values = need_values;
+            posted = false;
+
+            communicator comm = C->mpi_comm();
+
+            build_matrix &B_loc = *B.local();
+            build_matrix &B_rem = *B.remote();
+            ptrdiff_t B_beg = B.loc_col_shift();
 
-    size_t nrecv = C.recv.nbr.size();
-    size_t nsend = C.send.nbr.size();
+            size_t nrecv = C->recv.nbr.size();
+            size_t nsend = C->send.nbr.size();
 
-    // Create blocked matrix to send to each domain
-    // that needs data from us:
-    std::vector<MPI_Request> send_ptr_req(nsend);
-    std::vector<MPI_Request> send_col_req(nsend);
-    std::vector<MPI_Request> send_val_req(nsend);
+            // Create blocked matrix to send to each domain
+            // that needs data from us:
+            send_rows.clear();
+            send_rows.resize(nsend);
 
-    std::vector<build_matrix> send_rows(nsend);
+            for(size_t k = 0; k < nsend; ++k) {
+                ptrdiff_t beg = C->send.ptr[k];
+                ptrdiff_t end = C->send.ptr[k + 1];
 
-    for(size_t k = 0; k < nsend; ++k) {
-        ptrdiff_t beg = C.send.ptr[k];
-        ptrdiff_t end = C.send.ptr[k + 1];
+                build_matrix &m = send_rows[k];
+                m.set_size(end - beg, 0, false);
 
-        build_matrix &m = send_rows[k];
-        m.set_size(end - beg, 0, false);
+                for(ptrdiff_t i = 0, ii = beg; ii < end; ++i, ++ii) {
+                    ptrdiff_t r = C->send.col[ii];
+
+                    ptrdiff_t w =
+                        (B_loc.ptr[r + 1] - B_loc.ptr[r]) +
+                        (B_rem.ptr[r + 1] - B_rem.ptr[r]);
+
+                    m.ptr[i] = w;
+                    m.nnz += w;
+                }
 
-        for(ptrdiff_t i = 0, ii = beg; ii < end; ++i, ++ii) {
-            ptrdiff_t r = C.send.col[ii];
+                send(m.ptr, m.nrows, C->send.nbr[k], tag_ptr, comm);
+
+                m.set_nonzeros(m.nnz, need_values);
+
+                for(ptrdiff_t i = 0, ii = beg, head = 0; ii < end; ++i, ++ii) {
+                    ptrdiff_t r = C->send.col[ii];
+
+                    // Contribution of the local part:
+                    for(ptrdiff_t j = B_loc.ptr[r]; j < B_loc.ptr[r+1]; ++j) {
+                        m.col[head] = B_loc.col[j] + B_beg;
+
+                        if (need_values) m.val[head] = B_loc.val[j];
+
+                        ++head;
+                    }
+
+                    // Contribution of the remote part:
+                    for(ptrdiff_t j = B_rem.ptr[r]; j < B_rem.ptr[r+1]; ++j) {
+                        m.col[head] = B_rem.col[j];
+
+                        if (need_values) m.val[head] = B_rem.val[j];
+
+                        ++head;
+                    }
+                }
+
+                send(m.col, m.nnz, C->send.nbr[k], tag_col, comm);
+                if (need_values)
+                    send(m.val, m.nnz, C->send.nbr[k], tag_val, comm);
+            }
 
-            ptrdiff_t w =
-                (B_loc.ptr[r + 1] - B_loc.ptr[r]) +
-                (B_rem.ptr[r + 1] - B_rem.ptr[r]);
+            // Receive rows of B in block format from our neighbors:
+            B_nbr = std::make_shared<build_matrix>();
+            B_nbr->set_size(C->recv.count(), 0, false);
+            B_nbr->ptr[0] = 0;
 
-            m.ptr[i] = w;
-            m.nnz += w;
+            for(size_t k = 0; k < nrecv; ++k) {
+                ptrdiff_t beg = C->recv.ptr[k];
+                ptrdiff_t end = C->recv.ptr[k + 1];
+
+                ptr_req.push_back(MPI_REQUEST_NULL);
+                MPI_Irecv(&B_nbr->ptr[beg + 1], end - beg, datatype<ptrdiff_t>(),
+                        C->recv.nbr[k], tag_ptr, comm, &ptr_req.back());
+            }
         }
 
-        MPI_Isend(m.ptr, m.nrows, datatype<ptrdiff_t>(),
-                C.send.nbr[k], tag_ptr, comm, &send_ptr_req[k]);
+        // Exchanges the updated values of the rows fetched by the previous
+        // call to start(). The structure of B and the communication pattern
+        // should be the same as the last time.
+        void start_values(
+                const comm_pattern<Backend> &cp,
+                const distributed_matrix<Backend> &B
+                )
+        {
+            precondition(B_nbr && values, "remote rows structure has not been fetched yet");
 
-        m.set_nonzeros(m.nnz, need_values);
+            C = &cp;
+            posted = true;
 
-        for(ptrdiff_t i = 0, ii = beg, head = 0; ii < end; ++i, ++ii) {
-            ptrdiff_t r = C.send.col[ii];
+            communicator comm = C->mpi_comm();
 
-            // Contribution of the local part:
-            for(ptrdiff_t j = B_loc.ptr[r]; j < B_loc.ptr[r+1]; ++j) {
-                m.col[head] = B_loc.col[j] + B_beg;
+            build_matrix &B_loc = *B.local();
+            build_matrix &B_rem = *B.remote();
 
-                if (need_values) m.val[head] = B_loc.val[j];
+            for(size_t k = 0; k < send_rows.size(); ++k) {
+                build_matrix &m = send_rows[k];
 
-                ++head;
+                for(ptrdiff_t ii = C->send.ptr[k], head = 0; ii < C->send.ptr[k + 1]; ++ii) {
+                    ptrdiff_t r = C->send.col[ii];
+
+                    for(ptrdiff_t j = B_loc.ptr[r]; j < B_loc.ptr[r+1]; ++j)
+                        m.val[head++] = B_loc.val[j];
+
+                    for(ptrdiff_t j = B_rem.ptr[r]; j < B_rem.ptr[r+1]; ++j)
+                        m.val[head++] = B_rem.val[j];
+                }
+
+                send(m.val, m.nnz, C->send.nbr[k], tag_val, comm);
             }
 
-            // Contribution of the remote part:
-            for(ptrdiff_t j = B_rem.ptr[r]; j < B_rem.ptr[r+1]; ++j) {
-                m.col[head] = B_rem.col[j];
+            for(size_t k = 0; k < C->recv.nbr.size(); ++k) {
+                ptrdiff_t cbeg = B_nbr->ptr[C->recv.ptr[k]];
+                ptrdiff_t cend = B_nbr->ptr[C->recv.ptr[k + 1]];
 
-                if (need_values) m.val[head] = B_rem.val[j];
+                data_req.push_back(MPI_REQUEST_NULL);
+                MPI_Irecv(&B_nbr->val[cbeg], cend - cbeg, datatype<value_type>(),
+                        C->recv.nbr[k], tag_val, comm, &data_req.back());
+            }
+        }
 
-                ++head;
+        // Lets the outstanding communication progress. As soon as the row
+        // sizes have arrived, posts the receives for the columns and values.
+        void progress() {
+            if (posted) {
+                test_all(data_req);
+            } else if (test_all(ptr_req)) {
+                post_data();
             }
+
+            test_all(send_req);
         }
 
-        MPI_Isend(m.col, m.nnz, datatype<ptrdiff_t>(),
-                C.send.nbr[k], tag_col, comm, &send_col_req[k]);
-        if (need_values)
-            MPI_Isend(m.val, m.nnz, datatype<value_type>(),
-                    C.send.nbr[k], tag_val, comm, &send_val_req[k]);
-    }
+        std::shared_ptr<build_matrix> finish() {
+            AMGCL_TIC("MPI Wait");
+            if (!posted) {
+                wait_all(ptr_req);
+                post_data();
+            }
 
-    // Receive rows of B in block format from our neighbors:
-    std::vector<MPI_Request> recv_ptr_req(nrecv);
-    std::vector<MPI_Request> recv_col_req(nrecv);
-    std::vector<MPI_Request> recv_val_req(nrecv);
+            wait_all(data_req);
+            wait_all(send_req);
+            AMGCL_TOC("MPI Wait");
 
-    auto B_nbr = std::make_shared<build_matrix>();
-    B_nbr->set_size(C.recv.count(), 0, false);
-    B_nbr->ptr[0] = 0;
+            return B_nbr;
+        }
 
-    for(size_t k = 0; k < nrecv; ++k) {
-        ptrdiff_t beg = C.recv.ptr[k];
-        ptrdiff_t end = C.recv.ptr[k + 1];
+    private:
+        static const int tag_ptr = 3001;
+        static const int tag_col = 3002;
+        static const int tag_val = 3003;
 
-        MPI_Irecv(&B_nbr->ptr[beg + 1], end - beg, datatype<ptrdiff_t>(),
-                C.recv.nbr[k], tag_ptr, comm, &recv_ptr_req[k]);
-    }
+        const comm_pattern<Backend> *C;
+        bool values, posted;
 
-    AMGCL_TIC("MPI Wait");
-    MPI_Waitall(recv_ptr_req.size(), &recv_ptr_req[0], MPI_STATUSES_IGNORE);
-    AMGCL_TOC("MPI Wait");
+        std::vector<build_matrix>     send_rows;
+        std::shared_ptr<build_matrix> B_nbr;
 
-    B_nbr->set_nonzeros(B_nbr->scan_row_sizes(), need_values);
+        std::vector<MPI_Request> send_req, ptr_req, data_req;
 
-    for(size_t k = 0; k < nrecv; ++k) {
-        ptrdiff_t rbeg = C.recv.ptr[k];
-        ptrdiff_t rend = C.recv.ptr[k + 1];
+        template <class T>
+        void send(T *buf, ptrdiff_t n, int nbr, int tag, MPI_Comm comm) {
+            send_req.push_back(MPI_REQUEST_NULL);
+            MPI_Isend(buf, n, datatype<T>(), nbr, tag, comm, &send_req.back());
+        }
 
-        ptrdiff_t cbeg = B_nbr->ptr[rbeg];
-        ptrdiff_t cend = B_nbr->ptr[rend];
+        void post_data() {
+            communicator comm = C->mpi_comm();
 
-        MPI_Irecv(&B_nbr->col[cbeg], cend - cbeg, datatype<ptrdiff_t>(),
-                C.recv.nbr[k], tag_col, comm, &recv_col_req[k]);
+            B_nbr->set_nonzeros(B_nbr->scan_row_sizes(), values);
 
-        if (need_values)
-            MPI_Irecv(&B_nbr->val[cbeg], cend - cbeg, datatype<value_type>(),
-                    C.recv.nbr[k], tag_val, comm, &recv_val_req[k]);
-    }
+            for(size_t k = 0; k < C->recv.nbr.size(); ++k) {
+                ptrdiff_t cbeg = B_nbr->ptr[C->recv.ptr[k]];
+                ptrdiff_t cend = B_nbr->ptr[C->recv.ptr[k + 1]];
 
-    AMGCL_TIC("MPI Wait");
-    MPI_Waitall(send_ptr_req.size(), &send_ptr_req[0], MPI_STATUSES_IGNORE);
-    MPI_Waitall(send_col_req.size(), &send_col_req[0], MPI_STATUSES_IGNORE);
-    MPI_Waitall(recv_col_req.size(), &recv_col_req[0], MPI_STATUSES_IGNORE);
+                data_req.push_back(MPI_REQUEST_NULL);
+                MPI_Irecv(&B_nbr->col[cbeg], cend - cbeg, datatype<ptrdiff_t>(),
+                        C->recv.nbr[k], tag_col, comm, &data_req.back());
+
+                if (values) {
+                    data_req.push_back(MPI_REQUEST_NULL);
+                    MPI_Irecv(&B_nbr->val[cbeg], cend - cbeg, datatype<value_type>(),
+                            C->recv.nbr[k], tag_val, comm, &data_req.back());
+                }
+            }
+
+            ptr_req.clear();
+            posted = true;
+        }
+
+        static bool test_all(std::vector<MPI_Request> &req) {
+            if (req.empty()) return true;
+
+            int flag;
+            MPI_Testall(req.size(), req.data(), &flag, MPI_STATUSES_IGNORE);
+            if (flag) req.clear();
+            return flag;
+        }
 
-    if (need_values) {
-        MPI_Waitall(send_val_req.size(), &send_val_req[0], MPI_STATUSES_IGNORE);
-        MPI_Waitall(recv_val_req.size(), &recv_val_req[0], MPI_STATUSES_IGNORE);
+        static void wait_all(std::vector<MPI_Request> &req) {
+            if (!req.empty()) MPI_Waitall(req.size(), req.data(), MPI_STATUSES_IGNORE);
+            req.clear();
+        }
+};
+
+// Checksum of the local sparsity pattern (the global row and column
+// indices of the nonzeros) of a matrix that has not been moved to the
+// backend yet. The checksum does not depend on the order of the nonzeros
+// within the rows.
+template <class Backend>
+size_t pattern_checksum(const distributed_matrix<Backend> &A) {
+    typedef typename distributed_matrix<Backend>::build_matrix build_matrix;
+
+    const build_matrix &A_loc = *A.local();
+    const build_matrix &A_rem = *A.remote();
+
+    const ptrdiff_t n   = A.loc_rows();
+    const ptrdiff_t beg = A.loc_col_shift();
+
+    size_t sum = 0;
+
+#pragma omp parallel for reduction(+:sum)
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        size_t r = amgcl::detail::mix_hash(i + beg);
+
+        for(ptrdiff_t j = A_loc.ptr[i], e = A_loc.ptr[i+1]; j < e; ++j)
+            sum += amgcl::detail::mix_hash(r ^ (A_loc.col[j] + beg));
+
+        for(ptrdiff_t j = A_rem.ptr[i], e = A_rem.ptr[i+1]; j < e; ++j)
+            sum += amgcl::detail::mix_hash(r ^ A_rem.col[j]);
     }
-    AMGCL_TOC("MPI Wait");
 
+    return sum;
+}
+
+} // namespace detail
+
+template <class Backend>
+std::shared_ptr< backend::crs<typename Backend::value_type> >
+remote_rows(
+        const comm_pattern<Backend> &C,
+        const distributed_matrix<Backend> &B,
+        bool need_values = true
+        )
+{
+    AMGCL_TIC("remote_rows");
+    detail::remote_rows_fetch<Backend> fetch;
+    fetch.start(C, B, need_values);
+    auto B_nbr = fetch.finish();
     AMGCL_TOC("remote_rows");
+
     return B_nbr;
 }
 
+/// Distributed sparse matrix-matrix product with a reusable plan.
+/**
+ * The first call to operator() computes the product and, when the plan is
+ * reusable, stores its structure together with the communication pattern
+ * of the result. Any subsequent call assumes that the structures of A and B
+ * have not changed (e.g. in the Galerkin products of a hierarchy rebuilt for
+ * the new matrix values) and only exchanges and multiplies the values. The
+ * row and nonzero counts of A and B are checked against the stored ones.
+ *
+ * The remote rows of B are fetched in the background while the rows of the
+ * product that only depend on the local part of A are processed.
+ */
 template <class Backend>
-std::shared_ptr< distributed_matrix<Backend> >
-product(const distributed_matrix<Backend> &A, const distributed_matrix<Backend> &B) {
-    typedef typename Backend::value_type value_type;
-    typedef backend::crs<value_type>     build_matrix;
-    AMGCL_TIC("product");
+class product_plan {
+    public:
+        typedef typename Backend::value_type value_type;
+        typedef backend::crs<value_type>     build_matrix;
+        typedef distributed_matrix<Backend>  matrix;
+        typedef comm_pattern<Backend>        CommPattern;
+
+        /// A plan that is not reusable does not keep the product structure.
+        product_plan(bool reuse = true) : reuse(reuse) {}
+
+        std::shared_ptr<matrix> operator()(const matrix &A, const matrix &B) {
+            AMGCL_TIC("product");
+            std::shared_ptr<matrix> C = pattern ? numeric(A, B) : symbolic(A, B);
+            AMGCL_TOC("product");
+            return C;
+        }
 
-    const comm_pattern<Backend> &Acp = A.cpat();
+    private:
+        bool reuse;
 
-    build_matrix &A_loc = *A.local();
-    build_matrix &A_rem = *A.remote();
-    build_matrix &B_loc = *B.local();
-    build_matrix &B_rem = *B.remote();
+        detail::remote_rows_fetch<Backend> fetch;
+        detail::col_map rem_idx;
 
-    ptrdiff_t A_rows = A.loc_rows();
-    ptrdiff_t B_cols = B.loc_cols();
+        std::shared_ptr<build_matrix> B_nbr;
 
-    ptrdiff_t B_beg = B.loc_col_shift();
-    ptrdiff_t B_end = B_beg + B_cols;
+        std::vector<ptrdiff_t> irow;      // rows of A without remote columns,
+        std::vector<ptrdiff_t> brow;      // and the rest of them.
+        std::vector<int>       a_rem_row; // rows of B_nbr referenced by A_rem.
+        std::vector<int>       b_rem_col; // local numbers of B_rem columns.
+        std::vector<ptrdiff_t> b_nbr_col; // B_nbr columns: local (>= 0) or -1-remote.
 
-    auto b_nbr = remote_rows(Acp, B);
-    build_matrix &B_nbr = *b_nbr;
+        std::vector<ptrdiff_t> loc_ptr, loc_col;
+        std::vector<ptrdiff_t> rem_ptr, rem_col;
+        std::vector<int>       rem_cix;
 
-    // Build mapping from global to local column numbers in the remote part of
-    // the product matrix.
-    std::vector<ptrdiff_t> rem_cols(B_rem.nnz + B_nbr.nnz);
+        // Sizes and pattern checksums of the inputs the structure was
+        // computed for.
+        ptrdiff_t a_rows, b_cols;
+        size_t    a_loc_nnz, b_loc_nnz;
+        size_t    a_pattern, b_pattern;
 
-    std::copy(B_nbr.col, B_nbr.col + B_nbr.nnz,
-            std::copy(B_rem.col, B_rem.col + B_rem.nnz, rem_cols.begin()));
+        std::shared_ptr<CommPattern> pattern;
 
-    std::sort(rem_cols.begin(), rem_cols.end());
-    rem_cols.erase(std::unique(rem_cols.begin(), rem_cols.end()), rem_cols.end());
+        std::shared_ptr<matrix> symbolic(const matrix &A, const matrix &B) {
+            const CommPattern &Acp = A.cpat();
 
-    ptrdiff_t n_rem_cols = 0;
-    std::unordered_map<ptrdiff_t, int> rem_idx(2 * rem_cols.size());
-    for(ptrdiff_t c : rem_cols) {
-        if (c >= B_beg && c < B_end) continue;
-        rem_idx[c] = n_rem_cols++;
-    }
+            build_matrix &A_loc = *A.local();
+            build_matrix &A_rem = *A.remote();
+            build_matrix &B_loc = *B.local();
+            build_matrix &B_rem = *B.remote();
 
-    // Build the product.
-    auto c_loc = std::make_shared<build_matrix>();
-    auto c_rem = std::make_shared<build_matrix>();
+            ptrdiff_t A_rows = A.loc_rows();
+            ptrdiff_t B_cols = B.loc_cols();
 
-    build_matrix &C_loc = *c_loc;
-    build_matrix &C_rem = *c_rem;
+            ptrdiff_t B_beg = B.loc_col_shift();
+            ptrdiff_t B_end = B_beg + B_cols;
 
-    C_loc.set_size(A_rows, B_cols, false);
-    C_rem.set_size(A_rows, 0,      false);
+            fetch.start(Acp, B);
 
-    C_loc.ptr[0] = 0;
-    C_rem.ptr[0] = 0;
+            AMGCL_TIC("analyze");
+            irow.clear();
+            brow.clear();
+            for(ptrdiff_t i = 0; i < A_rows; ++i)
+                (A_rem.ptr[i+1] > A_rem.ptr[i] ? brow : irow).push_back(i);
 
-    AMGCL_TIC("analyze");
-#pragma omp parallel
-    {
-        std::vector<ptrdiff_t> loc_marker(B_end - B_beg, -1);
-        std::vector<ptrdiff_t> rem_marker(n_rem_cols,    -1);
+            a_rem_row.resize(A_rem.nnz);
+#pragma omp parallel for
+            for(ptrdiff_t j = 0; j < static_cast<ptrdiff_t>(A_rem.nnz); ++j)
+                a_rem_row[j] = Acp.local_index(A_rem.col[j]);
 
-#pragma omp for
-        for(ptrdiff_t ia = 0; ia < A_rows; ++ia) {
-            ptrdiff_t loc_cols = 0;
-            ptrdiff_t rem_cols = 0;
+            // Remote columns of the product.
+            rem_idx.clear();
+            b_rem_col.resize(B_rem.nnz);
+            for(size_t j = 0; j < B_rem.nnz; ++j)
+                b_rem_col[j] = rem_idx.insert(B_rem.col[j]);
 
-            for(ptrdiff_t ja = A_loc.ptr[ia], ea = A_loc.ptr[ia + 1]; ja < ea; ++ja) {
-                ptrdiff_t  ca = A_loc.col[ja];
+            auto c_loc = std::make_shared<build_matrix>();
+            auto c_rem = std::make_shared<build_matrix>();
 
-                for(ptrdiff_t jb = B_loc.ptr[ca], eb = B_loc.ptr[ca+1]; jb < eb; ++jb) {
-                    ptrdiff_t  cb = B_loc.col[jb];
+            build_matrix &C_loc = *c_loc;
+            build_matrix &C_rem = *c_rem;
 
-                    if (loc_marker[cb] != ia) {
-                        loc_marker[cb]  = ia;
-                        ++loc_cols;
-                    }
-                }
+            C_loc.set_size(A_rows, B_cols, false);
+            C_rem.set_size(A_rows, 0,      false);
 
-                for(ptrdiff_t jb = B_rem.ptr[ca], eb = B_rem.ptr[ca+1]; jb < eb; ++jb) {
-                    ptrdiff_t  cb = rem_idx[B_rem.col[jb]];
+            C_loc.ptr[0] = 0;
+            C_rem.ptr[0] = 0;
 
-                    if (rem_marker[cb] != ia) {
-                        rem_marker[cb]  = ia;
-                        ++rem_cols;
-                    }
-                }
-            }
-
-            for(ptrdiff_t ja = A_rem.ptr[ia], ea = A_rem.ptr[ia + 1]; ja < ea; ++ja) {
-                ptrdiff_t  ca = Acp.local_index(A_rem.col[ja]);
+            auto count = [&](ptrdiff_t ia,
+                    std::vector<ptrdiff_t> &loc_marker,
+                    std::vector<ptrdiff_t> &rem_marker)
+            {
+                ptrdiff_t loc_cols = 0;
+                ptrdiff_t rem_cols = 0;
 
-                for(ptrdiff_t jb = B_nbr.ptr[ca], eb = B_nbr.ptr[ca+1]; jb < eb; ++jb) {
-                    ptrdiff_t  cb = B_nbr.col[jb];
+                for(ptrdiff_t ja = A_loc.ptr[ia], ea = A_loc.ptr[ia + 1]; ja < ea; ++ja) {
+                    ptrdiff_t  ca = A_loc.col[ja];
 
-                    if (cb >= B_beg && cb < B_end) {
-                        cb -= B_beg;
+                    for(ptrdiff_t jb = B_loc.ptr[ca], eb = B_loc.ptr[ca+1]; jb < eb; ++jb) {
+                        ptrdiff_t  cb = B_loc.col[jb];
 
                         if (loc_marker[cb] != ia) {
                             loc_marker[cb]  = ia;
                             ++loc_cols;
                         }
-                    } else {
-                        cb = rem_idx[cb];
+                    }
+
+                    for(ptrdiff_t jb = B_rem.ptr[ca], eb = B_rem.ptr[ca+1]; jb < eb; ++jb) {
+                        ptrdiff_t  cb = b_rem_col[jb];
 
                         if (rem_marker[cb] != ia) {
                             rem_marker[cb]  = ia;
@@ -892,113 +1678,299 @@ product(const distributed_matrix<Backend> &A, const distributed_matrix<Backend>
                         }
                     }
                 }
-            }
 
-            C_loc.ptr[ia + 1] = loc_cols;
-            C_rem.ptr[ia + 1] = rem_cols;
-        }
-    }
-    AMGCL_TOC("analyze");
+                for(ptrdiff_t ja = A_rem.ptr[ia], ea = A_rem.ptr[ia + 1]; ja < ea; ++ja) {
+                    ptrdiff_t  ca = a_rem_row[ja];
 
-    C_loc.set_nonzeros(C_loc.scan_row_sizes());
-    C_rem.set_nonzeros(C_rem.scan_row_sizes());
+                    for(ptrdiff_t jb = B_nbr->ptr[ca], eb = B_nbr->ptr[ca+1]; jb < eb; ++jb) {
+                        ptrdiff_t  cb = b_nbr_col[jb];
 
-    AMGCL_TIC("compute");
-#pragma omp parallel
-    {
-        std::vector<ptrdiff_t> loc_marker(B_end - B_beg, -1);
-        std::vector<ptrdiff_t> rem_marker(n_rem_cols,    -1);
-
-#pragma omp for
-        for(ptrdiff_t ia = 0; ia < A_rows; ++ia) {
-            ptrdiff_t loc_beg = C_loc.ptr[ia];
-            ptrdiff_t rem_beg = C_rem.ptr[ia];
-            ptrdiff_t loc_end = loc_beg;
-            ptrdiff_t rem_end = rem_beg;
-
-            for(ptrdiff_t ja = A_loc.ptr[ia], ea = A_loc.ptr[ia + 1]; ja < ea; ++ja) {
-                ptrdiff_t  ca = A_loc.col[ja];
-                value_type va = A_loc.val[ja];
+                        if (cb >= 0) {
+                            if (loc_marker[cb] != ia) {
+                                loc_marker[cb]  = ia;
+                                ++loc_cols;
+                            }
+                        } else {
+                            cb = -1 - cb;
 
-                for(ptrdiff_t jb = B_loc.ptr[ca], eb = B_loc.ptr[ca+1]; jb < eb; ++jb) {
-                    ptrdiff_t  cb = B_loc.col[jb];
-                    value_type vb = B_loc.val[jb];
+                            if (rem_marker[cb] != ia) {
+                                rem_marker[cb]  = ia;
+                                ++rem_cols;
+                            }
+                        }
+                    }
+                }
 
-                    if (loc_marker[cb] < loc_beg) {
-                        loc_marker[cb] = loc_end;
+                C_loc.ptr[ia + 1] = loc_cols;
+                C_rem.ptr[ia + 1] = rem_cols;
+            };
 
-                        C_loc.col[loc_end] = cb;
-                        C_loc.val[loc_end] = va * vb;
+            // Rows without remote columns do not need the remote rows of B,
+            // so they are analyzed while the rows are in flight.
+            {
+                ptrdiff_t n = irow.size();
+                ptrdiff_t m = rem_idx.size();
+                ptrdiff_t chunk = detail::progress_chunk();
+#pragma omp parallel
+                {
+                    std::vector<ptrdiff_t> loc_marker(B_cols, -1);
+                    std::vector<ptrdiff_t> rem_marker(m,      -1);
 
-                        ++loc_end;
-                    } else {
-                        C_loc.val[loc_marker[cb]] += va * vb;
-                    }
+                    detail::progress_for(n, chunk, [this]() { fetch.progress(); },
+                            [&](ptrdiff_t k) { count(irow[k], loc_marker, rem_marker); });
                 }
+            }
 
-                for(ptrdiff_t jb = B_rem.ptr[ca], eb = B_rem.ptr[ca+1]; jb < eb; ++jb) {
-                    ptrdiff_t  gb = B_rem.col[jb];
-                    ptrdiff_t  cb = rem_idx[gb];
-                    value_type vb = B_rem.val[jb];
+            B_nbr = fetch.finish();
+            const build_matrix &Bn = *B_nbr;
 
-                    if (rem_marker[cb] < rem_beg) {
-                        rem_marker[cb] = rem_end;
+            b_nbr_col.resize(Bn.nnz);
+            for(size_t j = 0; j < Bn.nnz; ++j) {
+                ptrdiff_t c = Bn.col[j];
+                b_nbr_col[j] = (c >= B_beg && c < B_end) ? c - B_beg : -1 - rem_idx.insert(c);
+            }
 
-                        C_rem.col[rem_end] = gb;
-                        C_rem.val[rem_end] = va * vb;
+            {
+                ptrdiff_t n = brow.size();
+                ptrdiff_t m = rem_idx.size();
+#pragma omp parallel
+                {
+                    std::vector<ptrdiff_t> loc_marker(B_cols, -1);
+                    std::vector<ptrdiff_t> rem_marker(m,      -1);
 
-                        ++rem_end;
-                    } else {
-                        C_rem.val[rem_marker[cb]] += va * vb;
-                    }
+#pragma omp for
+                    for(ptrdiff_t k = 0; k < n; ++k)
+                        count(brow[k], loc_marker, rem_marker);
                 }
             }
+            AMGCL_TOC("analyze");
 
-            for(ptrdiff_t ja = A_rem.ptr[ia], ea = A_rem.ptr[ia + 1]; ja < ea; ++ja) {
-                ptrdiff_t  ca = Acp.local_index(A_rem.col[ja]);
-                value_type va = A_rem.val[ja];
+            C_loc.set_nonzeros(C_loc.scan_row_sizes());
+            C_rem.set_nonzeros(C_rem.scan_row_sizes());
 
-                for(ptrdiff_t jb = B_nbr.ptr[ca], eb = B_nbr.ptr[ca+1]; jb < eb; ++jb) {
-                    ptrdiff_t  gb = B_nbr.col[jb];
-                    value_type vb = B_nbr.val[jb];
+            if (reuse) rem_cix.resize(C_rem.nnz);
 
-                    if (gb >= B_beg && gb < B_end) {
-                        ptrdiff_t cb = gb - B_beg;
+            AMGCL_TIC("compute");
+#pragma omp parallel
+            {
+                std::vector<ptrdiff_t> loc_marker(B_cols,          -1);
+                std::vector<ptrdiff_t> rem_marker(rem_idx.size(),  -1);
 
+#pragma omp for
+                for(ptrdiff_t ia = 0; ia < A_rows; ++ia) {
+                    ptrdiff_t loc_beg = C_loc.ptr[ia];
+                    ptrdiff_t rem_beg = C_rem.ptr[ia];
+                    ptrdiff_t loc_end = loc_beg;
+                    ptrdiff_t rem_end = rem_beg;
+
+                    auto add_loc = [&](ptrdiff_t cb, value_type v) {
                         if (loc_marker[cb] < loc_beg) {
                             loc_marker[cb] = loc_end;
 
                             C_loc.col[loc_end] = cb;
-                            C_loc.val[loc_end] = va * vb;
+                            C_loc.val[loc_end] = v;
 
                             ++loc_end;
                         } else {
-                            C_loc.val[loc_marker[cb]] += va * vb;
+                            C_loc.val[loc_marker[cb]] += v;
                         }
-                    } else {
-                        ptrdiff_t cb = rem_idx[gb];
+                    };
 
+                    auto add_rem = [&](ptrdiff_t cb, ptrdiff_t gb, value_type v) {
                         if (rem_marker[cb] < rem_beg) {
                             rem_marker[cb] = rem_end;
 
                             C_rem.col[rem_end] = gb;
-                            C_rem.val[rem_end] = va * vb;
+                            C_rem.val[rem_end] = v;
+                            if (reuse) rem_cix[rem_end] = cb;
 
                             ++rem_end;
                         } else {
-                            C_rem.val[rem_marker[cb]] += va * vb;
+                            C_rem.val[rem_marker[cb]] += v;
+                        }
+                    };
+
+                    for(ptrdiff_t ja = A_loc.ptr[ia], ea = A_loc.ptr[ia + 1]; ja < ea; ++ja) {
+                        ptrdiff_t  ca = A_loc.col[ja];
+                        value_type va = A_loc.val[ja];
+
+                        for(ptrdiff_t jb = B_loc.ptr[ca], eb = B_loc.ptr[ca+1]; jb < eb; ++jb)
+                            add_loc(B_loc.col[jb], va * B_loc.val[jb]);
+
+                        for(ptrdiff_t jb = B_rem.ptr[ca], eb = B_rem.ptr[ca+1]; jb < eb; ++jb)
+                            add_rem(b_rem_col[jb], B_rem.col[jb], va * B_rem.val[jb]);
+                    }
+
+                    for(ptrdiff_t ja = A_rem.ptr[ia], ea = A_rem.ptr[ia + 1]; ja < ea; ++ja) {
+                        ptrdiff_t  ca = a_rem_row[ja];
+                        value_type va = A_rem.val[ja];
+
+                        for(ptrdiff_t jb = Bn.ptr[ca], eb = Bn.ptr[ca+1]; jb < eb; ++jb) {
+                            ptrdiff_t cb = b_nbr_col[jb];
+
+                            if (cb >= 0)
+                                add_loc(cb, va * Bn.val[jb]);
+                            else
+                                add_rem(-1 - cb, Bn.col[jb], va * Bn.val[jb]);
                         }
                     }
                 }
             }
+            AMGCL_TOC("compute");
+
+            auto C = std::make_shared<matrix>(A.comm(), c_loc, c_rem);
+
+            if (reuse) {
+                // Save the structure of the product for the subsequent calls.
+                loc_ptr.assign(C_loc.ptr, C_loc.ptr + A_rows + 1);
+                loc_col.assign(C_loc.col, C_loc.col + C_loc.nnz);
+                rem_ptr.assign(C_rem.ptr, C_rem.ptr + A_rows + 1);
+                rem_col.assign(C_rem.col, C_rem.col + C_rem.nnz);
+
+                a_rows    = A_rows;
+                b_cols    = B_cols;
+                a_loc_nnz = A_loc.nnz;
+                b_loc_nnz = B_loc.nnz;
+                a_pattern = detail::pattern_checksum(A);
+                b_pattern = detail::pattern_checksum(B);
+
+                pattern = C->cpat_ptr();
+            }
+
+            return C;
         }
-    }
-    AMGCL_TOC("compute");
-    AMGCL_TOC("product");
 
-    return std::make_shared<distributed_matrix<Backend> >(A.comm(), c_loc, c_rem);
+        std::shared_ptr<matrix> numeric(const matrix &A, const matrix &B) {
+            build_matrix &A_loc = *A.local();
+            build_matrix &A_rem = *A.remote();
+            build_matrix &B_loc = *B.local();
+            build_matrix &B_rem = *B.remote();
+
+            ptrdiff_t A_rows = A.loc_rows();
+            ptrdiff_t B_cols = B.loc_cols();
+
+            A.comm().check(
+                    A_rows == a_rows && B_cols == b_cols &&
+                    A_loc.nnz == a_loc_nnz && A_rem.nnz == a_rem_row.size() &&
+                    B_loc.nnz == b_loc_nnz && B_rem.nnz == b_rem_col.size() &&
+                    detail::pattern_checksum(A) == a_pattern &&
+                    detail::pattern_checksum(B) == b_pattern,
+                    "The structure of the product operands has changed");
+
+            fetch.start_values(A.cpat(), B);
+
+            auto c_loc = std::make_shared<build_matrix>();
+            auto c_rem = std::make_shared<build_matrix>();
+
+            build_matrix &C_loc = *c_loc;
+            build_matrix &C_rem = *c_rem;
+
+            C_loc.set_size(A_rows, B_cols, false);
+            C_rem.set_size(A_rows, 0,      false);
+
+            C_loc.set_nonzeros(loc_col.size());
+            C_rem.set_nonzeros(rem_col.size());
+
+            std::copy(loc_ptr.begin(), loc_ptr.end(), C_loc.ptr);
+            std::copy(rem_ptr.begin(), rem_ptr.end(), C_rem.ptr);
+            std::copy(loc_col.begin(), loc_col.end(), C_loc.col);
+            std::copy(rem_col.begin(), rem_col.end(), C_rem.col);
+
+            const build_matrix &Bn = *B_nbr;
+
+            auto fill = [&](ptrdiff_t ia,
+                    std::vector<ptrdiff_t> &loc_marker,
+                    std::vector<ptrdiff_t> &rem_marker)
+            {
+                for(ptrdiff_t j = C_loc.ptr[ia], e = C_loc.ptr[ia+1]; j < e; ++j) {
+                    loc_marker[C_loc.col[j]] = j;
+                    C_loc.val[j] = math::zero<value_type>();
+                }
+
+                for(ptrdiff_t j = C_rem.ptr[ia], e = C_rem.ptr[ia+1]; j < e; ++j) {
+                    rem_marker[rem_cix[j]] = j;
+                    C_rem.val[j] = math::zero<value_type>();
+                }
+
+                for(ptrdiff_t ja = A_loc.ptr[ia], ea = A_loc.ptr[ia + 1]; ja < ea; ++ja) {
+                    ptrdiff_t  ca = A_loc.col[ja];
+                    value_type va = A_loc.val[ja];
+
+                    for(ptrdiff_t jb = B_loc.ptr[ca], eb = B_loc.ptr[ca+1]; jb < eb; ++jb)
+                        C_loc.val[loc_marker[B_loc.col[jb]]] += va * B_loc.val[jb];
+
+                    for(ptrdiff_t jb = B_rem.ptr[ca], eb = B_rem.ptr[ca+1]; jb < eb; ++jb)
+                        C_rem.val[rem_marker[b_rem_col[jb]]] += va * B_rem.val[jb];
+                }
+
+                for(ptrdiff_t ja = A_rem.ptr[ia], ea = A_rem.ptr[ia + 1]; ja < ea; ++ja) {
+                    ptrdiff_t  ca = a_rem_row[ja];
+                    value_type va = A_rem.val[ja];
+
+                    for(ptrdiff_t jb = Bn.ptr[ca], eb = Bn.ptr[ca+1]; jb < eb; ++jb) {
+                        ptrdiff_t cb = b_nbr_col[jb];
+
+                        if (cb >= 0)
+                            C_loc.val[loc_marker[cb]] += va * Bn.val[jb];
+                        else
+                            C_rem.val[rem_marker[-1 - cb]] += va * Bn.val[jb];
+                    }
+                }
+            };
+
+            AMGCL_TIC("compute");
+            {
+                ptrdiff_t n = irow.size();
+                ptrdiff_t chunk = detail::progress_chunk();
+#pragma omp parallel
+                {
+                    std::vector<ptrdiff_t> loc_marker(B_cols);
+                    std::vector<ptrdiff_t> rem_marker(rem_idx.size());
+
+                    detail::progress_for(n, chunk, [this]() { fetch.progress(); },
+                            [&](ptrdiff_t k) { fill(irow[k], loc_marker, rem_marker); });
+                }
+            }
+
+            fetch.finish();
+
+            {
+                ptrdiff_t n = brow.size();
+#pragma omp parallel
+                {
+                    std::vector<ptrdiff_t> loc_marker(B_cols);
+                    std::vector<ptrdiff_t> rem_marker(rem_idx.size());
+
+#pragma omp for
+                    for(ptrdiff_t k = 0; k < n; ++k)
+                        fill(brow[k], loc_marker, rem_marker);
+                }
+            }
+            AMGCL_TOC("compute");
+
+            return std::make_shared<matrix>(A.comm(), c_loc, c_rem, pattern);
+        }
+
+};
+
+template <class Backend>
+std::shared_ptr< distributed_matrix<Backend> >
+product(const distributed_matrix<Backend> &A, const distributed_matrix<Backend> &B) {
+    return product_plan<Backend>(false)(A, B);
 }
 
+/// Galerkin operator R A P with reusable product plans.
+template <class Backend>
+struct galerkin_plan {
+    typedef distributed_matrix<Backend> matrix;
+
+    product_plan<Backend> AP, RAP;
+
+    std::shared_ptr<matrix> operator()(const matrix &A, const matrix &P, const matrix &R) {
+        return RAP(R, *AP(A, P));
+    }
+};
+
 template <class Backend, class T>
 void scale(distributed_matrix<Backend> &A, T s) {
     typedef typename Backend::value_type value_type;
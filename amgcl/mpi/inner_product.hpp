@@ -31,6 +31,9 @@ THE SOFTWARE.
  * \brief  Inner product for distributed vectors.
  */
 
+#include <vector>
+#include <memory>
+
 #include <mpi.h>
 
 #include <amgcl/backend/builtin.hpp>
@@ -60,6 +63,103 @@ struct inner_product {
 
         return sum;
     }
+
+    /// Computes several inner products with a single global reduction.
+    /** r[i] = (*x[i], *y[i]), i = [0, n). */
+    template <class Vec1, class Vec2, class Coef>
+    void operator()(size_t n, const Vec1 *const *x, const Vec2 *const *y, Coef *r) const {
+        typedef typename math::scalar_of<Coef>::type S;
+        const int elems = sizeof(Coef) / sizeof(S);
+
+        AMGCL_TIC("inner product");
+        std::vector<Coef> loc(n);
+        for(size_t i = 0; i < n; ++i)
+            loc[i] = backend::inner_product(*x[i], *y[i]);
+
+        MPI_Allreduce(loc.data(), r, n * elems, datatype<S>(), MPI_SUM, comm);
+        AMGCL_TOC("inner product");
+    }
+
+    /// Result of a non-blocking inner product.
+    /**
+     * The object owns the buffers of the reduction in flight, so it may only
+     * be moved. The destructor waits for the reduction if get() has not been
+     * called.
+     */
+    template <class T>
+    class future {
+        public:
+            future(future &&other) = default;
+
+            future& operator=(future &&other) {
+                wait();
+                d = std::move(other.d);
+                return *this;
+            }
+
+            future(const future&) = delete;
+            future& operator=(const future&) = delete;
+
+            ~future() {
+                wait();
+            }
+
+            /// Waits for the global reduction to complete.
+            T get() const {
+                wait();
+                return d->gval;
+            }
+        private:
+            struct data {
+                T lval, gval;
+                MPI_Request req;
+                bool done;
+            };
+
+            std::unique_ptr<data> d;
+
+            future(communicator comm, const T &v) : d(new data) {
+                typedef typename math::scalar_of<T>::type S;
+                const int elems = sizeof(T) / sizeof(S);
+
+                d->lval = v;
+#if MPI_VERSION >= 3
+                MPI_Iallreduce(&d->lval, &d->gval, elems, datatype<S>(), MPI_SUM, comm, &d->req);
+                d->done = false;
+#else
+                MPI_Allreduce(&d->lval, &d->gval, elems, datatype<S>(), MPI_SUM, comm);
+                d->done = true;
+#endif
+            }
+
+            void wait() const {
+                if (d && !d->done) {
+                    MPI_Wait(&d->req, MPI_STATUS_IGNORE);
+                    d->done = true;
+                }
+            }
+
+            friend struct inner_product;
+    };
+
+    /// Starts a non-blocking inner product.
+    /**
+     * The local part is computed immediately, and the global reduction is
+     * left in flight until future::get() is called, so that it may be
+     * overlapped with other work.
+     */
+    template <class Vec1, class Vec2>
+    future<
+        typename math::inner_product_impl<
+            typename backend::value_type<Vec1>::type
+            >::return_type
+        >
+    async(const Vec1 &x, const Vec2 &y) const {
+        typedef typename backend::value_type<Vec1>::type value_type;
+        typedef typename math::inner_product_impl<value_type>::return_type coef_type;
+
+        return future<coef_type>(comm, backend::inner_product(x, y));
+    }
 };
 
 } // namespace mpi
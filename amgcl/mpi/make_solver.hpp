@@ -112,6 +112,17 @@ class make_solver {
             S(backend::rows(*A), prm.solver, bprm, mpi::inner_product(comm))
         {}
 
+        /// Rebuilds the preconditioner for the new matrix values.
+        /** \sa amgcl::mpi::amg::rebuild() */
+        template <class Matrix>
+        void rebuild(
+                const Matrix &A,
+                const backend_params &bprm = backend_params()
+                )
+        {
+            P.rebuild(A, bprm);
+        }
+
         template <class Matrix, class Vec1, class Vec2>
         std::tuple<size_t, scalar_type> operator()(
                 const Matrix &A, const Vec1 &rhs, Vec2 &&x) const
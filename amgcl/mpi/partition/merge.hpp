@@ -31,6 +31,8 @@ THE SOFTWARE.
  * \brief  Dummy partitioner (merges consecutive domains together).
  */
 
+#include <vector>
+#include <map>
 #include <memory>
 
 #include <amgcl/backend/interface.hpp>
@@ -53,16 +55,27 @@ struct merge {
         ptrdiff_t min_per_proc;
         int       shrink_ratio;
 
+        /// Take the node topology into account.
+        /**
+         * When set, the domains are only merged with the domains living on
+         * the same compute node (as reported by MPI_Comm_split_type), until
+         * there is a single active domain left on each node. Only after
+         * that the domains from different nodes are merged together.
+         */
+        bool node_aware;
+
         params() :
-            enable(false), min_per_proc(10000), shrink_ratio(8)
+            enable(false), min_per_proc(10000), shrink_ratio(8),
+            node_aware(false)
         {}
 
         params(const boost::property_tree::ptree &p)
             : AMGCL_PARAMS_IMPORT_VALUE(p, enable),
               AMGCL_PARAMS_IMPORT_VALUE(p, min_per_proc),
-              AMGCL_PARAMS_IMPORT_VALUE(p, shrink_ratio)
+              AMGCL_PARAMS_IMPORT_VALUE(p, shrink_ratio),
+              AMGCL_PARAMS_IMPORT_VALUE(p, node_aware)
         {
-            check_params(p, {"enable", "min_per_proc", "shrink_ratio"});
+            check_params(p, {"enable", "min_per_proc", "shrink_ratio", "node_aware"});
         }
 
         void get(
@@ -73,6 +86,7 @@ struct merge {
             AMGCL_PARAMS_EXPORT_VALUE(p, path, enable);
             AMGCL_PARAMS_EXPORT_VALUE(p, path, min_per_proc);
             AMGCL_PARAMS_EXPORT_VALUE(p, path, shrink_ratio);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, node_aware);
         }
     } prm;
 
@@ -103,6 +117,9 @@ struct merge {
         ptrdiff_t nrows = A.loc_rows();
 
         std::vector<ptrdiff_t> row_dom = comm.exclusive_sum(nrows);
+
+        if (prm.node_aware) return merge_on_nodes(comm, row_dom);
+
         std::vector<ptrdiff_t> col_dom(comm.size + 1);
 
         for(int i = 0; i <= comm.size; ++i)
@@ -131,6 +148,81 @@ struct merge {
         return graph_perm_matrix<Backend>(comm, col_beg, col_end, perm);
     }
 
+    private:
+        std::shared_ptr<matrix> merge_on_nodes(
+                communicator comm, const std::vector<ptrdiff_t> &row_dom) const
+        {
+            // Find out where each of the processes lives.
+            // The node is identified by the lowest rank on it.
+            int node_id = comm.node().reduce(MPI_MIN, comm.rank);
+
+            std::vector<int> node(comm.size);
+            MPI_Allgather(&node_id, 1, MPI_INT, node.data(), 1, MPI_INT, comm);
+
+            // Active domains on each node:
+            std::map<int, std::vector<int>> node_dom;
+            bool shared = false;
+
+            for(int i = 0; i < comm.size; ++i) {
+                if (row_dom[i+1] > row_dom[i]) {
+                    std::vector<int> &d = node_dom[node[i]];
+                    d.push_back(i);
+                    if (d.size() > 1) shared = true;
+                }
+            }
+
+            // Each group of shrink_ratio consecutive domains is merged into
+            // the first domain of the group. The groups are formed within
+            // the nodes, unless each node only has a single active domain.
+            std::vector<int> owner(comm.size);
+            for(int i = 0; i < comm.size; ++i) owner[i] = i;
+
+            int old_domains = 0;
+            int new_domains = 0;
+
+            auto group = [&](const std::vector<int> &d) {
+                for(size_t i = 0; i < d.size(); ++i) {
+                    owner[d[i]] = d[i - i % prm.shrink_ratio];
+                    ++old_domains;
+                    if (i % prm.shrink_ratio == 0) ++new_domains;
+                }
+            };
+
+            if (shared) {
+                for(const auto &d : node_dom) group(d.second);
+            } else {
+                std::vector<int> d;
+                for(const auto &n : node_dom) d.push_back(n.second[0]);
+                group(d);
+            }
+
+            if (comm.rank == 0)
+                std::cout << "Partitioning[MERGE/NODE] " << old_domains << " -> " << new_domains << std::endl;
+
+            // The merged domains are numbered in the order of their owners,
+            // and the original domains keep their relative order inside.
+            std::vector<ptrdiff_t> col_dom(comm.size + 1, 0);
+            ptrdiff_t offset = 0;
+
+            for(int i = 0; i < comm.size; ++i) {
+                if (i == comm.rank) offset = col_dom[owner[i] + 1];
+                col_dom[owner[i] + 1] += row_dom[i+1] - row_dom[i];
+            }
+
+            std::partial_sum(col_dom.begin(), col_dom.end(), col_dom.begin());
+
+            ptrdiff_t nrows   = row_dom[comm.rank + 1] - row_dom[comm.rank];
+            ptrdiff_t col_beg = col_dom[comm.rank];
+            ptrdiff_t col_end = col_dom[comm.rank + 1];
+            ptrdiff_t row_beg = col_dom[owner[comm.rank]] + offset;
+
+            std::vector<ptrdiff_t> perm(nrows);
+            for(ptrdiff_t i = 0; i < nrows; ++i) {
+                perm[i] = i + row_beg;
+            }
+
+            return graph_perm_matrix<Backend>(comm, col_beg, col_end, perm);
+        }
 };
 
 
@@ -34,6 +34,7 @@ THE SOFTWARE.
 #include <memory>
 
 #include <amgcl/mpi/partition/merge.hpp>
+#include <amgcl/mpi/partition/sfc.hpp>
 
 #ifdef AMGCL_HAVE_SCOTCH
 #  include <amgcl/mpi/partition/ptscotch.hpp>
@@ -49,7 +50,8 @@ namespace mpi {
 namespace partition {
 
 enum type {
-    merge
+    merge,
+    sfc
 #ifdef AMGCL_HAVE_SCOTCH
   , ptscotch
 #endif
@@ -63,6 +65,8 @@ std::ostream& operator<<(std::ostream &os, type s)
     switch (s) {
         case merge:
             return os << "merge";
+        case sfc:
+            return os << "sfc";
 #ifdef AMGCL_HAVE_SCOTCH
         case ptscotch:
             return os << "ptscotch";
@@ -83,6 +87,8 @@ std::istream& operator>>(std::istream &in, type &s)
 
     if (val == "merge")
         s = merge;
+    else if (val == "sfc")
+        s = sfc;
 #ifdef AMGCL_HAVE_SCOTCH
     else if (val == "ptscotch")
         s = ptscotch;
@@ -93,7 +99,7 @@ std::istream& operator>>(std::istream &in, type &s)
 #endif
     else
         throw std::invalid_argument("Invalid partitioner value. Valid choices are: "
-                "merge"
+                "merge, sfc"
 #ifdef AMGCL_HAVE_SCOTCH
                 ", ptscotch"
 #endif
@@ -132,6 +138,12 @@ struct wrapper {
                     handle = static_cast<void*>(new R(prm));
                 }
                 break;
+            case sfc:
+                {
+                    typedef amgcl::mpi::partition::sfc<Backend> R;
+                    handle = static_cast<void*>(new R(prm));
+                }
+                break;
 #ifdef AMGCL_HAVE_SCOTCH
             case ptscotch:
                 {
@@ -161,6 +173,12 @@ struct wrapper {
                     delete static_cast<R*>(handle);
                 }
                 break;
+            case sfc:
+                {
+                    typedef amgcl::mpi::partition::sfc<Backend> R;
+                    delete static_cast<R*>(handle);
+                }
+                break;
 #ifdef AMGCL_HAVE_SCOTCH
             case ptscotch:
                 {
@@ -189,6 +207,11 @@ struct wrapper {
                     typedef amgcl::mpi::partition::merge<Backend> R;
                     return static_cast<const R*>(handle)->is_needed(A);
                 }
+            case sfc:
+                {
+                    typedef amgcl::mpi::partition::sfc<Backend> R;
+                    return static_cast<const R*>(handle)->is_needed(A);
+                }
 #ifdef AMGCL_HAVE_SCOTCH
             case ptscotch:
                 {
@@ -208,6 +231,13 @@ struct wrapper {
         }
     }
 
+    void coarsen_coords(const matrix &R) const {
+        if (t == sfc) {
+            typedef amgcl::mpi::partition::sfc<Backend> S;
+            static_cast<const S*>(handle)->coarsen_coords(R);
+        }
+    }
+
     std::shared_ptr<matrix> operator()(const matrix &A, unsigned block_size = 1) const {
         switch (t) {
             case merge:
@@ -215,6 +245,11 @@ struct wrapper {
                     typedef amgcl::mpi::partition::merge<Backend> R;
                     return static_cast<const R*>(handle)->operator()(A, block_size);
                 }
+            case sfc:
+                {
+                    typedef amgcl::mpi::partition::sfc<Backend> R;
+                    return static_cast<const R*>(handle)->operator()(A, block_size);
+                }
 #ifdef AMGCL_HAVE_SCOTCH
             case ptscotch:
                 {
@@ -0,0 +1,671 @@
+#ifndef AMGCL_MPI_PARTITION_SFC_HPP
+#define AMGCL_MPI_PARTITION_SFC_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2018 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/mpi/partition/sfc.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Space filling curve partitioner.
+ */
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <limits>
+#include <memory>
+
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/value_type/interface.hpp>
+#include <amgcl/mpi/util.hpp>
+#include <amgcl/mpi/distributed_matrix.hpp>
+#include <amgcl/mpi/partition/util.hpp>
+
+namespace amgcl {
+namespace mpi {
+namespace partition {
+
+/// Space filling curve partitioner.
+/**
+ * The unknowns are ordered along the Hilbert curve, and the curve is split
+ * into chunks of equal size. This does not need any third party libraries,
+ * and is much cheaper than a graph partitioner, while the resulting
+ * subdomains are still compact.
+ *
+ * The coordinates of the unknowns at the finest level are given with
+ * params::coords. The coordinates of the coarse unknowns are obtained as the
+ * weighted averages of the fine ones with the restriction operator, and
+ * follow the unknowns when those are redistributed. When the coordinates
+ * are not known, the distances from two peripheral vertices of the matrix
+ * graph are used as the coordinates.
+ */
+template <class Backend>
+struct sfc {
+    typedef typename Backend::value_type value_type;
+    typedef distributed_matrix<Backend>  matrix;
+
+    struct params {
+        bool      enable;
+        ptrdiff_t min_per_proc;
+        int       shrink_ratio;
+
+        /// Number of spatial dimensions (1, 2, or 3).
+        /**
+         * When set to zero, the coordinates are computed from the matrix
+         * graph.
+         */
+        int ndim;
+
+        /// Coordinates of the local unknowns at the finest level.
+        /**
+         * ndim values per local row of the system matrix. When set from a
+         * property tree, the number of local rows should be given with the
+         * "rows" parameter.
+         */
+        std::vector<double> coords;
+
+        params() :
+            enable(false), min_per_proc(10000), shrink_ratio(8), ndim(0)
+        {}
+
+        params(const boost::property_tree::ptree &p)
+            : AMGCL_PARAMS_IMPORT_VALUE(p, enable),
+              AMGCL_PARAMS_IMPORT_VALUE(p, min_per_proc),
+              AMGCL_PARAMS_IMPORT_VALUE(p, shrink_ratio),
+              AMGCL_PARAMS_IMPORT_VALUE(p, ndim)
+        {
+            double *c = 0;
+            c = p.get("coords", c);
+
+            if (c) {
+                size_t rows = 0;
+                rows = p.get("rows", rows);
+
+                precondition(ndim > 0,
+                        "Error in sfc parameters: coords is set, but ndim is not");
+
+                precondition(rows > 0,
+                        "Error in sfc parameters: coords is set, but rows is not");
+
+                coords.assign(c, c + rows * ndim);
+            }
+
+            precondition(ndim >= 0 && ndim <= 3,
+                    "Error in sfc parameters: ndim should be 0, 1, 2, or 3");
+
+            check_params(p, {"enable", "min_per_proc", "shrink_ratio", "ndim", "coords", "rows"});
+        }
+
+        void get(
+                boost::property_tree::ptree &p,
+                const std::string &path = ""
+                ) const
+        {
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, enable);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, min_per_proc);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, shrink_ratio);
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, ndim);
+        }
+    } prm;
+
+    sfc(const params &prm = params()) : prm(prm), coarse(false) {}
+
+    bool is_needed(const matrix &A) const {
+        if (!prm.enable) return false;
+
+        communicator comm = A.comm();
+        ptrdiff_t n = A.loc_rows();
+        std::vector<ptrdiff_t> row_dom = comm.exclusive_sum(n);
+
+        int non_empty = 0;
+        ptrdiff_t min_n = std::numeric_limits<ptrdiff_t>::max();
+        for(int i = 0; i < comm.size; ++i) {
+            ptrdiff_t m = row_dom[i+1] - row_dom[i];
+            if (m) {
+                min_n = std::min(min_n, m);
+                ++non_empty;
+            }
+        }
+
+        return (non_empty > 1) && (min_n <= prm.min_per_proc);
+    }
+
+    /// Moves the coordinates to the next coarser level.
+    void coarsen_coords(const matrix &R) const {
+        if (!prm.ndim) return;
+
+        typedef backend::crs<value_type> build_matrix;
+
+        AMGCL_TIC("coarsen coords");
+        const int nd = prm.ndim;
+        const comm_pattern<Backend> &C = R.cpat();
+
+        const build_matrix &R_loc = *R.local();
+        const build_matrix &R_rem = *R.remote();
+
+        ptrdiff_t n = R_loc.nrows;
+
+        const std::vector<double> &coo = coords();
+        check_coords(R.loc_cols());
+
+        std::vector<double> x_rem = exchange(C, coo, nd);
+        std::vector<double> x(n * nd);
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            double w = 0, s[3] = {0, 0, 0};
+
+            for(ptrdiff_t j = R_loc.ptr[i], e = R_loc.ptr[i+1]; j < e; ++j) {
+                double a = math::norm(R_loc.val[j]);
+                ptrdiff_t c = R_loc.col[j];
+
+                w += a;
+                for(int k = 0; k < nd; ++k) s[k] += a * coo[c * nd + k];
+            }
+
+            for(ptrdiff_t j = R_rem.ptr[i], e = R_rem.ptr[i+1]; j < e; ++j) {
+                double a = math::norm(R_rem.val[j]);
+                ptrdiff_t c = C.local_index(R_rem.col[j]);
+
+                w += a;
+                for(int k = 0; k < nd; ++k) s[k] += a * x_rem[c * nd + k];
+            }
+
+            if (w > 0) w = 1 / w;
+            for(int k = 0; k < nd; ++k) x[i * nd + k] = w * s[k];
+        }
+
+        level_coo.swap(x);
+        coarse = true;
+        AMGCL_TOC("coarsen coords");
+    }
+
+    std::shared_ptr<matrix> operator()(const matrix &A, unsigned block_size = 1) const {
+        communicator comm = A.comm();
+        ptrdiff_t n = A.loc_rows();
+        ptrdiff_t row_beg = A.loc_col_shift();
+
+        int active = (n > 0);
+        int active_ranks = comm.reduce(MPI_SUM, active);
+
+        int npart = std::max(1, active_ranks / prm.shrink_ratio);
+
+        if (comm.rank == 0)
+            std::cout << "Partitioning[SFC] " << active_ranks << " -> " << npart << std::endl;
+
+        std::vector<ptrdiff_t> perm(n);
+        ptrdiff_t col_beg, col_end;
+
+        if (prm.ndim) check_coords(n);
+
+        if (npart == 1) {
+            col_beg = (comm.rank == 0) ? 0 : A.glob_rows();
+            col_end = A.glob_rows();
+
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                perm[i] = row_beg + i;
+            }
+        } else {
+            int nd = prm.ndim ? prm.ndim : 2;
+            std::vector<double> x;
+
+            if (block_size == 1) {
+                if (!prm.ndim) graph_coords(A, x);
+
+                std::tie(col_beg, col_end) = partition(comm, npart, nd,
+                        prm.ndim ? coords() : x, perm);
+            } else {
+                typedef typename math::scalar_of<value_type>::type scalar;
+                typedef backend::builtin<scalar> sbackend;
+                ptrdiff_t np = n / block_size;
+
+                if (prm.ndim) {
+                    const std::vector<double> &coo = coords();
+
+                    x.resize(np * nd);
+                    for(ptrdiff_t ip = 0; ip < np; ++ip)
+                        for(int k = 0; k < nd; ++k)
+                            x[ip * nd + k] = coo[ip * block_size * nd + k];
+                } else {
+                    distributed_matrix<sbackend> A_pw(A.comm(),
+                            pointwise_matrix(*A.local(),  block_size),
+                            pointwise_matrix(*A.remote(), block_size)
+                            );
+
+                    graph_coords(A_pw, x);
+                }
+
+                std::vector<ptrdiff_t> perm_pw(np);
+
+                std::tie(col_beg, col_end) = partition(comm, npart, nd, x, perm_pw);
+
+                col_beg *= block_size;
+                col_end *= block_size;
+
+                for(ptrdiff_t ip = 0; ip < np; ++ip) {
+                    ptrdiff_t i = ip * block_size;
+                    ptrdiff_t j = perm_pw[ip] * block_size;
+
+                    for(unsigned k = 0; k < block_size; ++k)
+                        perm[i + k] = j + k;
+                }
+            }
+        }
+
+        if (prm.ndim) permute_coords(comm, col_beg, col_end, perm);
+
+        return graph_perm_matrix<Backend>(comm, col_beg, col_end, perm);
+    }
+
+    private:
+        static const int tag_exc_vals = 6001;
+
+        // Coordinates of the unknowns at the coarser levels. The finest
+        // level coordinates are used directly from the parameters.
+        mutable std::vector<double> level_coo;
+        mutable bool coarse;
+
+        const std::vector<double>& coords() const {
+            return coarse ? level_coo : prm.coords;
+        }
+
+        void check_coords(ptrdiff_t rows) const {
+            precondition(coords().size() == static_cast<size_t>(rows * prm.ndim),
+                    "Error in sfc parameters: "
+                    "the size of coords does not match the number of rows");
+        }
+
+        // Splits the Hilbert curve passing through the points x into npart
+        // chunks of (approximately) equal size.
+        static std::tuple<ptrdiff_t, ptrdiff_t> partition(
+                communicator comm, int npart, int nd,
+                const std::vector<double> &x, std::vector<ptrdiff_t> &perm)
+        {
+            typedef unsigned long long key_type;
+
+            AMGCL_TIC("sfc");
+            ptrdiff_t n = x.size() / nd;
+
+            // Bounding box of the points.
+            double lo[3], hi[3], glo[3], ghi[3];
+            for(int k = 0; k < nd; ++k) {
+                lo[k] =  std::numeric_limits<double>::max();
+                hi[k] = -std::numeric_limits<double>::max();
+            }
+
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                for(int k = 0; k < nd; ++k) {
+                    lo[k] = std::min(lo[k], x[i * nd + k]);
+                    hi[k] = std::max(hi[k], x[i * nd + k]);
+                }
+            }
+
+            MPI_Allreduce(lo, glo, nd, MPI_DOUBLE, MPI_MIN, comm);
+            MPI_Allreduce(hi, ghi, nd, MPI_DOUBLE, MPI_MAX, comm);
+
+            // Hilbert keys of the points.
+            const int bits = (nd == 3) ? 21 : 31;
+            const double top = static_cast<double>((1u << bits) - 1);
+
+            std::vector<key_type> key(n);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                unsigned X[3];
+
+                for(int k = 0; k < nd; ++k) {
+                    double d = ghi[k] - glo[k];
+                    X[k] = d > 0 ? static_cast<unsigned>(top * (x[i * nd + k] - glo[k]) / d) : 0;
+                }
+
+                key[i] = hilbert_key(X, nd, bits);
+            }
+
+            // Find the splitters from a (weighted) sample of the keys.
+            ptrdiff_t N = comm.reduce(MPI_SUM, n);
+            std::vector<key_type> sorted(key);
+            std::sort(sorted.begin(), sorted.end());
+
+            const ptrdiff_t oversample = 32;
+            ptrdiff_t ns = std::min(n, (oversample * npart * n + N - 1) / N);
+
+            std::vector<key_type> smp_key(ns);
+            std::vector<double>   smp_wgt(ns, static_cast<double>(n) / std::max<ptrdiff_t>(ns, 1));
+
+            for(ptrdiff_t j = 0; j < ns; ++j)
+                smp_key[j] = sorted[(2 * j + 1) * n / (2 * ns)];
+
+            std::vector<int> cnt(comm.size), dsp(comm.size + 1, 0);
+            int ins = ns;
+            MPI_Allgather(&ins, 1, MPI_INT, cnt.data(), 1, MPI_INT, comm);
+            std::partial_sum(cnt.begin(), cnt.end(), dsp.begin() + 1);
+
+            std::vector<key_type> all_key(dsp.back());
+            std::vector<double>   all_wgt(dsp.back());
+
+            MPI_Allgatherv(smp_key.data(), ns, datatype<key_type>(),
+                    all_key.data(), cnt.data(), dsp.data(), datatype<key_type>(), comm);
+            MPI_Allgatherv(smp_wgt.data(), ns, MPI_DOUBLE,
+                    all_wgt.data(), cnt.data(), dsp.data(), MPI_DOUBLE, comm);
+
+            std::vector<int> order(all_key.size());
+            for(size_t i = 0; i < order.size(); ++i) order[i] = i;
+            std::sort(order.begin(), order.end(),
+                    [&all_key](int a, int b) { return all_key[a] < all_key[b]; });
+
+            std::vector<key_type> splitter;
+            splitter.reserve(npart - 1);
+
+            double sum = 0;
+            for(int i : order) {
+                sum += all_wgt[i];
+                while(splitter.size() + 1 < static_cast<size_t>(npart) &&
+                        sum >= static_cast<double>(N) * (splitter.size() + 1) / npart)
+                    splitter.push_back(all_key[i]);
+            }
+
+            while(splitter.size() + 1 < static_cast<size_t>(npart))
+                splitter.push_back(std::numeric_limits<key_type>::max());
+
+            std::vector<int> part(n);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i)
+                part[i] = std::upper_bound(splitter.begin(), splitter.end(), key[i]) - splitter.begin();
+
+            AMGCL_TOC("sfc");
+
+            return graph_perm_index(comm, npart, part, perm);
+        }
+
+        // Position of the point X (nd coordinates, bits each) on the Hilbert
+        // curve. See J. Skilling, "Programming the Hilbert curve", AIP Conf.
+        // Proc. 707, 381 (2004).
+        static unsigned long long hilbert_key(unsigned *X, int nd, int bits) {
+            const unsigned M = 1u << (bits - 1);
+
+            // Inverse undo
+            for(unsigned Q = M; Q > 1; Q >>= 1) {
+                unsigned P = Q - 1;
+                for(int i = 0; i < nd; ++i) {
+                    if (X[i] & Q) {
+                        X[0] ^= P;
+                    } else {
+                        unsigned t = (X[0] ^ X[i]) & P;
+                        X[0] ^= t;
+                        X[i] ^= t;
+                    }
+                }
+            }
+
+            // Gray encode
+            for(int i = 1; i < nd; ++i) X[i] ^= X[i-1];
+
+            unsigned t = 0;
+            for(unsigned Q = M; Q > 1; Q >>= 1)
+                if (X[nd-1] & Q) t ^= Q - 1;
+
+            for(int i = 0; i < nd; ++i) X[i] ^= t;
+
+            // Interleave the bits of the transposed key.
+            unsigned long long key = 0;
+            for(int b = bits - 1; b >= 0; --b)
+                for(int i = 0; i < nd; ++i)
+                    key = (key << 1) | ((X[i] >> b) & 1);
+
+            return key;
+        }
+
+        // Coordinates of the graph vertices: the distances from two
+        // (approximately) peripheral vertices.
+        template <class B>
+        static void graph_coords(const distributed_matrix<B> &A, std::vector<double> &x) {
+            AMGCL_TIC("graph coords");
+            communicator comm = A.comm();
+
+            ptrdiff_t n = A.loc_rows();
+            ptrdiff_t row_beg = A.loc_col_shift();
+            ptrdiff_t row_end = row_beg + n;
+
+            std::vector<ptrdiff_t> ptr, col;
+            symm_graph(A, ptr, col);
+
+            std::vector<ptrdiff_t> rem;
+            for(ptrdiff_t c : col)
+                if (c < row_beg || c >= row_end) rem.push_back(c);
+
+            comm_pattern<B> C(comm, n, rem.size(), rem.data());
+
+            // Local neighbours are numbered from zero,
+            // remote ones are encoded as (-1 - halo index).
+            for(ptrdiff_t &c : col)
+                c = (row_beg <= c && c < row_end) ? c - row_beg : -1 - C.local_index(c);
+
+            std::vector<ptrdiff_t> d1 = distance(comm, C, ptr, col, farthest(comm, row_beg,
+                        distance(comm, C, ptr, col, 0, row_beg)), row_beg);
+            std::vector<ptrdiff_t> d2 = distance(comm, C, ptr, col, farthest(comm, row_beg,
+                        d1), row_beg);
+
+            // Unreachable vertices (disconnected graph) are put behind the
+            // farthest ones.
+            const ptrdiff_t inf = std::numeric_limits<ptrdiff_t>::max();
+            ptrdiff_t dmax = 0;
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                if (d1[i] != inf) dmax = std::max(dmax, d1[i]);
+                if (d2[i] != inf) dmax = std::max(dmax, d2[i]);
+            }
+            dmax = comm.reduce(MPI_MAX, dmax) + 1;
+
+            // The distances are integer, and lots of vertices share the
+            // same coordinates. The ties are broken with the vertex index.
+            double h = 0.5 / A.glob_rows();
+
+            x.resize(2 * n);
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                double t = h * (row_beg + i);
+                x[2 * i + 0] = std::min(d1[i], dmax) + t;
+                x[2 * i + 1] = std::min(d2[i], dmax) + t;
+            }
+            AMGCL_TOC("graph coords");
+        }
+
+        // Distances from the vertex src. Each process runs a breadth first
+        // search on its subdomain, then the distances across the subdomain
+        // boundaries are exchanged, until nothing changes.
+        template <class B>
+        static std::vector<ptrdiff_t> distance(communicator comm,
+                const comm_pattern<B> &C,
+                const std::vector<ptrdiff_t> &ptr, const std::vector<ptrdiff_t> &col,
+                ptrdiff_t src, ptrdiff_t row_beg)
+        {
+            const ptrdiff_t inf = std::numeric_limits<ptrdiff_t>::max();
+            ptrdiff_t n = ptr.size() - 1;
+
+            std::vector<ptrdiff_t> dist(n, inf);
+            std::deque<ptrdiff_t>  q;
+
+            if (row_beg <= src && src < row_beg + n) {
+                dist[src - row_beg] = 0;
+                q.push_back(src - row_beg);
+            }
+
+            for(;;) {
+                while(!q.empty()) {
+                    ptrdiff_t i = q.front(); q.pop_front();
+                    ptrdiff_t d = dist[i] + 1;
+
+                    for(ptrdiff_t j = ptr[i], e = ptr[i+1]; j < e; ++j) {
+                        ptrdiff_t c = col[j];
+                        if (c >= 0 && d < dist[c]) {
+                            dist[c] = d;
+                            q.push_back(c);
+                        }
+                    }
+                }
+
+                std::vector<ptrdiff_t> d_rem = exchange(C, dist, 1);
+
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    bool changed = false;
+
+                    for(ptrdiff_t j = ptr[i], e = ptr[i+1]; j < e; ++j) {
+                        ptrdiff_t c = col[j];
+                        if (c >= 0) continue;
+
+                        ptrdiff_t d = d_rem[-1 - c];
+                        if (d != inf && d + 1 < dist[i]) {
+                            dist[i] = d + 1;
+                            changed = true;
+                        }
+                    }
+
+                    if (changed) q.push_back(i);
+                }
+
+                int active = !q.empty();
+                if (!comm.reduce(MPI_MAX, active)) break;
+            }
+
+            return dist;
+        }
+
+        // Global index of the farthest reachable vertex.
+        static ptrdiff_t farthest(communicator comm, ptrdiff_t row_beg,
+                const std::vector<ptrdiff_t> &dist)
+        {
+            const ptrdiff_t inf = std::numeric_limits<ptrdiff_t>::max();
+
+            ptrdiff_t dmax = -1, imax = inf;
+            for(size_t i = 0; i < dist.size(); ++i) {
+                if (dist[i] != inf && dist[i] > dmax) {
+                    dmax = dist[i];
+                    imax = row_beg + i;
+                }
+            }
+
+            ptrdiff_t gmax = comm.reduce(MPI_MAX, dmax);
+            if (dmax < gmax) imax = inf;
+
+            return comm.reduce(MPI_MIN, imax);
+        }
+
+        // Values of x (m per row) at the remote columns of the pattern.
+        template <class B, class T>
+        static std::vector<T> exchange(const comm_pattern<B> &C,
+                const std::vector<T> &x, int m)
+        {
+            communicator comm = C.mpi_comm();
+
+            std::vector<T> sbuf(C.send.count() * m);
+            std::vector<T> rbuf(C.recv.count() * m);
+
+            for(size_t i = 0; i < C.send.count(); ++i)
+                for(int k = 0; k < m; ++k)
+                    sbuf[i * m + k] = x[C.send.col[i] * m + k];
+
+            std::vector<MPI_Request> req;
+            req.reserve(C.recv.nbr.size() + C.send.nbr.size());
+
+            for(size_t i = 0; i < C.recv.nbr.size(); ++i) {
+                req.push_back(MPI_REQUEST_NULL);
+                MPI_Irecv(&rbuf[C.recv.ptr[i] * m], (C.recv.ptr[i+1] - C.recv.ptr[i]) * m,
+                        datatype<T>(), C.recv.nbr[i], tag_exc_vals, comm, &req.back());
+            }
+
+            for(size_t i = 0; i < C.send.nbr.size(); ++i) {
+                req.push_back(MPI_REQUEST_NULL);
+                MPI_Isend(&sbuf[C.send.ptr[i] * m], (C.send.ptr[i+1] - C.send.ptr[i]) * m,
+                        datatype<T>(), C.send.nbr[i], tag_exc_vals, comm, &req.back());
+            }
+
+            if (!req.empty())
+                MPI_Waitall(req.size(), req.data(), MPI_STATUSES_IGNORE);
+
+            return rbuf;
+        }
+
+        // Sends the coordinates to the new owners of the unknowns.
+        void permute_coords(communicator comm, ptrdiff_t col_beg, ptrdiff_t col_end,
+                const std::vector<ptrdiff_t> &perm) const
+        {
+            const int nd = prm.ndim;
+            ptrdiff_t n = perm.size();
+
+            const std::vector<double> &coo = coords();
+
+            std::vector<ptrdiff_t> dom = comm.exclusive_sum(col_end - col_beg);
+
+            std::vector<int> dst(n);
+            std::vector<int> scnt(comm.size, 0), rcnt(comm.size);
+
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                dst[i] = std::upper_bound(dom.begin(), dom.end(), perm[i]) - dom.begin() - 1;
+                ++scnt[dst[i]];
+            }
+
+            MPI_Alltoall(scnt.data(), 1, MPI_INT, rcnt.data(), 1, MPI_INT, comm);
+
+            std::vector<int> sdsp(comm.size + 1, 0), rdsp(comm.size + 1, 0);
+            std::partial_sum(scnt.begin(), scnt.end(), sdsp.begin() + 1);
+            std::partial_sum(rcnt.begin(), rcnt.end(), rdsp.begin() + 1);
+
+            std::vector<ptrdiff_t> sidx(n), ridx(rdsp.back());
+            std::vector<double>    sval(n * nd), rval(rdsp.back() * nd);
+
+            {
+                std::vector<int> pos(sdsp.begin(), sdsp.end() - 1);
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    int j = pos[dst[i]]++;
+                    sidx[j] = perm[i];
+                    for(int k = 0; k < nd; ++k) sval[j * nd + k] = coo[i * nd + k];
+                }
+            }
+
+            MPI_Alltoallv(sidx.data(), scnt.data(), sdsp.data(), datatype<ptrdiff_t>(),
+                    ridx.data(), rcnt.data(), rdsp.data(), datatype<ptrdiff_t>(), comm);
+
+            for(int i = 0; i < comm.size; ++i) {
+                scnt[i] *= nd; sdsp[i] *= nd;
+                rcnt[i] *= nd; rdsp[i] *= nd;
+            }
+
+            MPI_Alltoallv(sval.data(), scnt.data(), sdsp.data(), MPI_DOUBLE,
+                    rval.data(), rcnt.data(), rdsp.data(), MPI_DOUBLE, comm);
+
+            std::vector<double> x((col_end - col_beg) * nd);
+            for(size_t i = 0; i < ridx.size(); ++i)
+                for(int k = 0; k < nd; ++k)
+                    x[(ridx[i] - col_beg) * nd + k] = rval[i * nd + k];
+
+            level_coo.swap(x);
+            coarse = true;
+        }
+};
+
+} // namespace partition
+} // namespace mpi
+} // namespace amgcl
+
+#endif
@@ -317,6 +317,23 @@ std::shared_ptr< distributed_matrix<Backend> > graph_perm_matrix(
     return std::make_shared< distributed_matrix<Backend> >(comm, i_loc, i_rem);
 }
 
+// Partitioners that keep track of the coordinates of the unknowns (sfc)
+// update them every time the hierarchy steps down to the next level.
+template <class Repartition, class Matrix>
+auto coarsen_coords(const Repartition &r, const Matrix &R, int)
+    -> decltype(r.coarsen_coords(R), void())
+{
+    r.coarsen_coords(R);
+}
+
+template <class Repartition, class Matrix>
+void coarsen_coords(const Repartition&, const Matrix&, long) {}
+
+template <class Repartition, class Matrix>
+void coarsen_coords(const Repartition &r, const Matrix &R) {
+    coarsen_coords(r, R, 0);
+}
+
 } // namespace partition
 } // namespace mpi
 } // namespace amgcl
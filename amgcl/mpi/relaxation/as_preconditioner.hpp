@@ -0,0 +1,122 @@
+#ifndef AMGCL_MPI_RELAXATION_AS_PRECONDITIONER_HPP
+#define AMGCL_MPI_RELAXATION_AS_PRECONDITIONER_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2018 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/mpi/relaxation/as_preconditioner.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Use a distributed smoother as standalone preconditioner.
+ */
+
+#include <memory>
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/mpi/util.hpp>
+#include <amgcl/mpi/distributed_matrix.hpp>
+
+namespace amgcl {
+namespace mpi {
+namespace relaxation {
+
+/// Allows to use a distributed smoother as standalone preconditioner.
+/**
+ * Relax is one of the smoothers from the amgcl::mpi::relaxation namespace,
+ * for example amgcl::mpi::relaxation::schwarz, or the
+ * amgcl::runtime::mpi::relaxation::wrapper.
+ */
+template <class Backend, class Relax>
+class as_preconditioner {
+    public:
+        typedef Backend backend_type;
+
+        typedef Relax                         smoother;
+        typedef distributed_matrix<Backend>   matrix;
+        typedef typename smoother::params     params;
+        typedef typename Backend::params      backend_params;
+
+        typedef typename Backend::value_type value_type;
+        typedef typename backend::builtin<value_type>::matrix build_matrix;
+
+        template <class Matrix>
+        as_preconditioner(
+                communicator comm,
+                const Matrix &Astrip,
+                const params &prm = params(),
+                const backend_params &bprm = backend_params()
+                )
+            : prm(prm)
+        {
+            init(std::make_shared<matrix>(comm, Astrip, backend::rows(Astrip)), bprm);
+        }
+
+        as_preconditioner(
+                communicator,
+                std::shared_ptr<matrix> A,
+                const params &prm = params(),
+                const backend_params &bprm = backend_params()
+                )
+            : prm(prm)
+        {
+            init(A, bprm);
+        }
+
+        template <class Vec1, class Vec2>
+        void apply(const Vec1 &rhs, Vec2 &&x) const {
+            S->apply(*A, rhs, x);
+        }
+
+        const matrix& system_matrix() const {
+            return *A;
+        }
+
+        std::shared_ptr<matrix> system_matrix_ptr() const {
+            return A;
+        }
+    private:
+        params prm;
+
+        std::shared_ptr<matrix>   A;
+        std::shared_ptr<smoother> S;
+
+        void init(std::shared_ptr<matrix> M, const backend_params &bprm) {
+            A = M;
+            S = std::make_shared<smoother>(*A, prm, bprm);
+            A->move_to_backend(bprm);
+        }
+
+        friend std::ostream& operator<<(std::ostream &os, const as_preconditioner &p) {
+            os << "Relaxation as preconditioner" << std::endl;
+            os << "  unknowns: " << p.A->glob_rows() << std::endl;
+            os << "  nonzeros: " << p.A->glob_nonzeros() << std::endl;
+
+            return os;
+        }
+};
+
+} // namespace relaxation
+} // namespace mpi
+} // namespace amgcl
+
+#endif
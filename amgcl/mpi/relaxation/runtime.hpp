@@ -36,6 +36,7 @@ THE SOFTWARE.
 #include <amgcl/value_type/interface.hpp>
 #include <amgcl/relaxation/runtime.hpp>
 #include <amgcl/mpi/relaxation/spai0.hpp>
+#include <amgcl/mpi/relaxation/schwarz.hpp>
 #include <amgcl/mpi/util.hpp>
 #include <amgcl/mpi/distributed_matrix.hpp>
 
@@ -49,13 +50,29 @@ struct wrapper {
     typedef boost::property_tree::ptree params;
     typedef typename Backend::params    backend_params;
 
+    typedef amgcl::mpi::relaxation::schwarz<Backend, runtime::relaxation::wrapper> Schwarz;
+
     runtime::relaxation::type r;
+    unsigned overlap;
     void *handle;
 
+    // When overlap is positive, the relaxation is applied to the
+    // overlapping subdomains (see amgcl::mpi::relaxation::schwarz).
     wrapper(const amgcl::mpi::distributed_matrix<Backend> &A,
             params prm, const backend_params &bprm = backend_params())
-      : r(prm.get("type", runtime::relaxation::spai0)), handle(0)
+      : r(prm.get("type", runtime::relaxation::spai0)),
+        overlap(prm.get("overlap", 0u)), handle(0)
     {
+        prm.erase("overlap");
+
+        if (overlap) {
+            typename Schwarz::params sprm;
+            sprm.overlap = overlap;
+            sprm.relax   = prm;
+            handle = static_cast<void*>(new Schwarz(A, sprm, bprm));
+            return;
+        }
+
         if (!prm.erase("type")) AMGCL_PARAM_MISSING("type");
 
         switch(r) {
@@ -94,6 +111,11 @@ struct wrapper {
     }
 
     ~wrapper() {
+        if (overlap) {
+            delete static_cast<Schwarz*>(handle);
+            return;
+        }
+
         switch(r) {
 #define AMGCL_RELAX_DISTR(type) \
             case runtime::relaxation::type: \
@@ -124,6 +146,11 @@ struct wrapper {
 
     template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
     void apply_pre(const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp) const {
+        if (overlap) {
+            static_cast<const Schwarz*>(handle)->apply_pre(A, rhs, x, tmp);
+            return;
+        }
+
         switch(r) {
 
 #define AMGCL_RELAX_DISTR(type) \
@@ -161,6 +188,11 @@ struct wrapper {
 
     template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
     void apply_post(const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp) const {
+        if (overlap) {
+            static_cast<const Schwarz*>(handle)->apply_post(A, rhs, x, tmp);
+            return;
+        }
+
         switch(r) {
 
 #define AMGCL_RELAX_DISTR(type) \
@@ -198,6 +230,11 @@ struct wrapper {
 
     template <class Matrix, class VectorRHS, class VectorX>
     void apply(const Matrix &A, const VectorRHS &rhs, VectorX &x) const {
+        if (overlap) {
+            static_cast<const Schwarz*>(handle)->apply(A, rhs, x);
+            return;
+        }
+
         switch(r) {
 
 #define AMGCL_RELAX_DISTR(type) \
@@ -0,0 +1,302 @@
+#ifndef AMGCL_MPI_RELAXATION_SCHWARZ_HPP
+#define AMGCL_MPI_RELAXATION_SCHWARZ_HPP
+
+/*
+The MIT License
+
+Copyright (c) 2012-2018 Denis Demidov <dennis.demidov@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * \file   amgcl/mpi/relaxation/schwarz.hpp
+ * \author Denis Demidov <dennis.demidov@gmail.com>
+ * \brief  Distributed memory restricted additive Schwarz relaxation.
+ */
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/backend/interface.hpp>
+#include <amgcl/value_type/interface.hpp>
+#include <amgcl/util.hpp>
+#include <amgcl/mpi/util.hpp>
+#include <amgcl/mpi/distributed_matrix.hpp>
+
+namespace amgcl {
+namespace mpi {
+namespace relaxation {
+
+/// Restricted additive Schwarz method.
+/**
+ * Each process extends its domain with the given number of layers of the
+ * rows owned by the neighbouring processes, and applies the local
+ * relaxation to the overlapping subdomain matrix. Only the part of the
+ * result belonging to the process is kept. In contrast to the local
+ * relaxations applied to the diagonal block of the matrix (which is
+ * equivalent to the non-overlapping block Jacobi), the convergence
+ * does not deteriorate as quickly with the number of processes.
+ */
+template <class Backend, template <class> class LocalRelax>
+struct schwarz {
+    typedef typename Backend::value_type               value_type;
+    typedef typename math::scalar_of<value_type>::type scalar_type;
+    typedef typename Backend::matrix                   bmatrix;
+    typedef typename Backend::vector                   vector;
+    typedef typename Backend::params                   backend_params;
+    typedef backend::crs<value_type>                   build_matrix;
+    typedef LocalRelax<Backend>                        local_relax;
+
+    struct params {
+        /// Number of layers of the neighbouring rows in the overlap.
+        unsigned overlap;
+
+        /// Parameters of the local relaxation.
+        typename local_relax::params relax;
+
+        params() : overlap(1) {}
+
+        params(const boost::property_tree::ptree &p)
+            : AMGCL_PARAMS_IMPORT_VALUE(p, overlap),
+              AMGCL_PARAMS_IMPORT_CHILD(p, relax)
+        {
+            check_params(p, {"overlap", "relax"});
+        }
+
+        void get(boost::property_tree::ptree &p, const std::string &path) const {
+            AMGCL_PARAMS_EXPORT_VALUE(p, path, overlap);
+            AMGCL_PARAMS_EXPORT_CHILD(p, path, relax);
+        }
+    } prm;
+
+    schwarz(
+            const distributed_matrix<Backend> &A,
+            const params &prm = params(),
+            const backend_params &bprm = backend_params()
+           ) : prm(prm)
+    {
+        communicator comm = A.comm();
+
+        const build_matrix &A_loc = *A.local();
+        const build_matrix &A_rem = *A.remote();
+
+        const ptrdiff_t n   = A.loc_rows();
+        const ptrdiff_t beg = A.loc_col_shift();
+        const ptrdiff_t end = beg + n;
+
+        // Find the global indices of the overlap rows, layer by layer, and
+        // fetch the rows from their owners.
+        std::vector<ptrdiff_t> ext;
+        if (prm.overlap) {
+            ext.assign(A_rem.col, A_rem.col + A_rem.nnz);
+            std::sort(ext.begin(), ext.end());
+            ext.erase(std::unique(ext.begin(), ext.end()), ext.end());
+        }
+
+        std::shared_ptr<build_matrix> a_ext;
+        for(unsigned k = 1; ; ++k) {
+            C = std::make_shared< comm_pattern<Backend> >(comm, n, ext.size(), ext.data());
+
+            bool last = (k >= prm.overlap);
+            a_ext = remote_rows(*C, A, last);
+            if (last) break;
+
+            for(size_t j = 0; j < a_ext->nnz; ++j) {
+                ptrdiff_t c = a_ext->col[j];
+                if (c < beg || c >= end) ext.push_back(c);
+            }
+
+            std::sort(ext.begin(), ext.end());
+            ext.erase(std::unique(ext.begin(), ext.end()), ext.end());
+        }
+
+        const build_matrix &A_ext = *a_ext;
+        const ptrdiff_t m = ext.size();
+
+        // Local column number in the overlapping subdomain, or -1 if the
+        // column is outside of the subdomain.
+        auto local_col = [&](ptrdiff_t c) -> ptrdiff_t {
+            if (c >= beg && c < end) return c - beg;
+            auto e = std::lower_bound(ext.begin(), ext.end(), c);
+            return (e != ext.end() && *e == c) ? n + (e - ext.begin()) : -1;
+        };
+
+        // Subdomain matrix.
+        // Connections to the outside of the subdomain are dropped.
+        auto a = std::make_shared<build_matrix>();
+        a->set_size(n + m, n + m, true);
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            ptrdiff_t w = A_loc.ptr[i+1] - A_loc.ptr[i];
+            if (m) w += A_rem.ptr[i+1] - A_rem.ptr[i];
+            a->ptr[i+1] = w;
+        }
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < m; ++i) {
+            ptrdiff_t w = 0;
+            for(ptrdiff_t j = A_ext.ptr[i], e = A_ext.ptr[i+1]; j < e; ++j)
+                if (local_col(A_ext.col[j]) >= 0) ++w;
+            a->ptr[n+i+1] = w;
+        }
+
+        a->set_nonzeros(a->scan_row_sizes());
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            ptrdiff_t head = a->ptr[i];
+
+            for(ptrdiff_t j = A_loc.ptr[i], e = A_loc.ptr[i+1]; j < e; ++j) {
+                a->col[head] = A_loc.col[j];
+                a->val[head] = A_loc.val[j];
+                ++head;
+            }
+
+            if (!m) continue;
+
+            for(ptrdiff_t j = A_rem.ptr[i], e = A_rem.ptr[i+1]; j < e; ++j) {
+                a->col[head] = local_col(A_rem.col[j]);
+                a->val[head] = A_rem.val[j];
+                ++head;
+            }
+        }
+
+#pragma omp parallel for
+        for(ptrdiff_t i = 0; i < m; ++i) {
+            ptrdiff_t head = a->ptr[n+i];
+
+            for(ptrdiff_t j = A_ext.ptr[i], e = A_ext.ptr[i+1]; j < e; ++j) {
+                ptrdiff_t c = local_col(A_ext.col[j]);
+                if (c < 0) continue;
+
+                a->col[head] = c;
+                a->val[head] = A_ext.val[j];
+                ++head;
+            }
+        }
+
+        backend::sort_rows(*a);
+
+        S  = std::make_shared<local_relax>(*a, prm.relax, bprm);
+        As = Backend::copy_matrix(a, bprm);
+
+        // Operators that scatter the local and the remote parts of a vector
+        // into the subdomain, and restrict the subdomain vector back.
+        auto pl = std::make_shared<build_matrix>();
+        auto pr = std::make_shared<build_matrix>();
+        auto r  = std::make_shared<build_matrix>();
+
+        pl->set_size(n + m, n, true);
+        pr->set_size(n + m, m, true);
+        r->set_size(n, n + m, true);
+
+        for(ptrdiff_t i = 0; i < n; ++i) pl->ptr[i+1] = 1;
+        for(ptrdiff_t i = 0; i < m; ++i) pr->ptr[n+i+1] = 1;
+        for(ptrdiff_t i = 0; i < n; ++i) r->ptr[i+1] = 1;
+
+        pl->set_nonzeros(pl->scan_row_sizes());
+        pr->set_nonzeros(pr->scan_row_sizes());
+        r->set_nonzeros(r->scan_row_sizes());
+
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            pl->col[i] = i;
+            pl->val[i] = math::identity<value_type>();
+            r->col[i]  = i;
+            r->val[i]  = math::identity<value_type>();
+        }
+
+        for(ptrdiff_t i = 0; i < m; ++i) {
+            pr->col[i] = i;
+            pr->val[i] = math::identity<value_type>();
+        }
+
+        Pl = Backend::copy_matrix(pl, bprm);
+        Pr = Backend::copy_matrix(pr, bprm);
+        R  = Backend::copy_matrix(r,  bprm);
+
+        f = Backend::create_vector(n + m, bprm);
+        u = Backend::create_vector(n + m, bprm);
+
+        C->move_to_backend(bprm);
+    }
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::apply_pre
+    template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+    void apply_pre(
+            const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp
+            ) const
+    {
+        static const scalar_type one = math::identity<scalar_type>();
+        backend::residual(rhs, A, x, tmp);
+        solve(tmp);
+        backend::spmv(one, *R, *u, one, x);
+    }
+
+    /// \copydoc amgcl::relaxation::damped_jacobi::apply_post
+    template <class Matrix, class VectorRHS, class VectorX, class VectorTMP>
+    void apply_post(
+            const Matrix &A, const VectorRHS &rhs, VectorX &x, VectorTMP &tmp
+            ) const
+    {
+        static const scalar_type one = math::identity<scalar_type>();
+        backend::residual(rhs, A, x, tmp);
+        solve(tmp);
+        backend::spmv(one, *R, *u, one, x);
+    }
+
+    template <class Matrix, class VectorRHS, class VectorX>
+    void apply(const Matrix&, const VectorRHS &rhs, VectorX &x) const
+    {
+        solve(rhs);
+        backend::spmv(math::identity<scalar_type>(), *R, *u, math::zero<scalar_type>(), x);
+    }
+
+    private:
+        std::shared_ptr< comm_pattern<Backend> > C;
+        std::shared_ptr<local_relax> S;
+        std::shared_ptr<bmatrix> As, Pl, Pr, R;
+        std::shared_ptr<vector> f, u;
+
+        // Solves the subdomain problem for the given right-hand side;
+        // the solution is left in u.
+        template <class Vector>
+        void solve(const Vector &rhs) const {
+            static const scalar_type one  = math::identity<scalar_type>();
+            static const scalar_type zero = math::zero<scalar_type>();
+
+            C->start_exchange(rhs);
+            backend::spmv(one, *Pl, rhs, zero, *f);
+            C->finish_exchange();
+
+            if (C->recv.count())
+                backend::spmv(one, *Pr, *C->x_rem, one, *f);
+
+            S->apply(*As, *f, *u);
+        }
+};
+
+} // namespace relaxation
+} // namespace mpi
+} // namespace amgcl
+
+#endif
@@ -37,11 +37,15 @@ THE SOFTWARE.
 #include <numeric>
 #include <memory>
 #include <functional>
+#include <type_traits>
+#include <cmath>
+#include <cstdint>
 
 #include <mpi.h>
 
 #include <amgcl/backend/builtin.hpp>
 #include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/solver/cg.hpp>
 #include <amgcl/mpi/util.hpp>
 #include <amgcl/mpi/direct_solver/skyline_lu.hpp>
 #include <amgcl/mpi/inner_product.hpp>
@@ -68,6 +72,272 @@ struct constant_deflation {
     }
 };
 
+/// Lowest eigenvectors of the local matrix as deflation vectors.
+/**
+ * The vectors approximate the low-energy modes of the subdomain, similar to
+ * the GenEO family of coarse spaces. The local problem is
+ * \f[A_{ii} v = \lambda D_i v,\f]
+ * where \f$A_{ii}\f$ is the diagonal block of the matrix owned by the
+ * subdomain, and \f$D_i\f$ is its diagonal. The eigenvectors corresponding
+ * to the smallest eigenvalues are found with the shift-and-invert Lanczos
+ * method with full reorthogonalization. The local matrix is only inverted
+ * approximately (see subdomain_deflation::params::lsolver), so the Ritz
+ * pairs are taken from the projection of the matrix itself onto the Lanczos
+ * basis, rather than from the Lanczos recurrence. With high-contrast
+ * coefficients, a subdomain may have several near-zero modes (one per each
+ * isolated high-permeability inclusion), which are not captured by the
+ * constant deflation.
+ *
+ * The local matrix is assumed to be symmetric positive definite. The
+ * couplings to the other subdomains are not lumped into the diagonal
+ * (which would approximate the Neumann matrix of the subdomain), because the
+ * resulting near-zero modes of the inclusions cut by the subdomain
+ * boundaries make the coarse system unstable for high contrasts.
+ *
+ * Only scalar problems are supported.
+ */
+class eigen_deflation {
+    public:
+        /// Constructor
+        /**
+         * \param A     Local part of the matrix (columns in local numbering).
+         * \param inv   Approximate inverse of A. The call inv(f, x) should
+         *              find x such that A x is close to f.
+         * \param nev   Number of eigenvectors to compute.
+         * \param iters Number of Lanczos iterations (zero means a default
+         *              value depending on nev).
+         */
+        template <class Matrix, class Inverse>
+        eigen_deflation(const Matrix &A, const Inverse &inv, unsigned nev, unsigned iters = 0)
+            : n(backend::rows(A)), nev(std::min<ptrdiff_t>(nev, n))
+        {
+            if (!this->nev) return;
+
+            ptrdiff_t m = iters ? iters : 2 * nev + 20;
+            m = std::max<ptrdiff_t>(m, this->nev);
+            m = std::min<ptrdiff_t>(m, n);
+
+            // Scaled local matrix D^{-1/2} A D^{-1/2}.
+            std::vector<double> sd(n);
+            backend::crs<double, ptrdiff_t> M;
+            M.set_size(n, n, false);
+            M.set_nonzeros(A.ptr[n]);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                double d = 0;
+
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j)
+                    if (A.col[j] == i) d += A.val[j];
+
+                sd[i] = d > 0 ? 1 / std::sqrt(d) : 1;
+            }
+
+            M.ptr[0] = 0;
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                M.ptr[i+1] = A.ptr[i+1];
+
+                for(ptrdiff_t j = A.ptr[i], e = A.ptr[i+1]; j < e; ++j) {
+                    ptrdiff_t c = A.col[j];
+                    M.col[j] = c;
+                    M.val[j] = A.val[j] * sd[i] * sd[c];
+                }
+            }
+
+            auto dot = [&](const double *x, const double *y) {
+                double s = 0;
+#pragma omp parallel for reduction(+:s)
+                for(ptrdiff_t i = 0; i < n; ++i) s += x[i] * y[i];
+                return s;
+            };
+
+            // Approximate inverse of the scaled matrix:
+            // w = D^{1/2} inv(A) D^{1/2} q.
+            std::vector<double> f(n), z(n);
+            auto solve = [&](const double *q, double *w) {
+#pragma omp parallel for
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    f[i] = q[i] / sd[i];
+                    z[i] = 0;
+                }
+
+                inv(f, z);
+
+#pragma omp parallel for
+                for(ptrdiff_t i = 0; i < n; ++i) w[i] = z[i] / sd[i];
+            };
+
+            std::vector<double> Q;
+
+            // Orthogonalizes w against the first k Lanczos vectors.
+            auto orthogonalize = [&](double *w, ptrdiff_t k) {
+                for(int pass = 0; pass < 2; ++pass) {
+                    for(ptrdiff_t j = 0; j < k; ++j) {
+                        const double *qj = &Q[j * n];
+                        double h = dot(qj, w);
+#pragma omp parallel for
+                        for(ptrdiff_t i = 0; i < n; ++i) w[i] -= h * qj[i];
+                    }
+                }
+            };
+
+            // Deterministic start vector with all the modes present.
+            auto start = [&](double *w, unsigned seed) {
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    uint64_t x = (static_cast<uint64_t>(i) + 1) * 0x9E3779B97F4A7C15ull + seed;
+                    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+                    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+                    x ^= x >> 31;
+                    w[i] = 1 + static_cast<double>(x >> 11) / 9007199254740992.0;
+                }
+            };
+
+            // Lanczos iterations for the inverse of the scaled matrix, so
+            // that the lowest eigenvalues of the matrix are the largest ones.
+            Q.resize(n * (m + 1));
+
+            start(&Q[0], 0);
+            {
+                double nrm = std::sqrt(dot(&Q[0], &Q[0]));
+                for(ptrdiff_t i = 0; i < n; ++i) Q[i] /= nrm;
+            }
+
+            ptrdiff_t k = 0;
+            for(unsigned seed = 1; k < m; ) {
+                double *qk = &Q[k * n];
+                double *w  = &Q[(k + 1) * n];
+
+                solve(qk, w);
+
+                double a = std::sqrt(dot(w, w));
+                orthogonalize(w, k + 1);
+
+                double b = std::sqrt(dot(w, w));
+                ++k;
+
+                if (k == m) break;
+
+                if (b <= 1e-10 * a) {
+                    // Invariant subspace is found, restart with a new vector.
+                    start(w, seed++);
+                    orthogonalize(w, k);
+                    b = std::sqrt(dot(w, w));
+                    if (b <= 1e-10) break;
+                }
+
+#pragma omp parallel for
+                for(ptrdiff_t i = 0; i < n; ++i) w[i] /= b;
+            }
+
+            m = k;
+            this->nev = std::min<ptrdiff_t>(this->nev, m);
+
+            // Projection of the scaled matrix onto the Lanczos basis. With
+            // the exact inverse, this would be the inverse of the Lanczos
+            // tridiagonal matrix.
+            std::vector<double> T(m * m, 0.0), V(m * m, 0.0);
+            for(ptrdiff_t j = 0; j < m; ++j) {
+                const double *qj = &Q[j * n];
+
+#pragma omp parallel for
+                for(ptrdiff_t i = 0; i < n; ++i) {
+                    double s = 0;
+                    for(ptrdiff_t l = M.ptr[i], e = M.ptr[i+1]; l < e; ++l)
+                        s += M.val[l] * qj[M.col[l]];
+                    z[i] = s;
+                }
+
+                for(ptrdiff_t i = 0; i <= j; ++i)
+                    T[i * m + j] = T[j * m + i] = dot(&Q[i * n], &z[0]);
+
+                V[j * m + j] = 1;
+            }
+
+            jacobi(m, T, V);
+
+            std::vector<ptrdiff_t> idx(m);
+            for(ptrdiff_t i = 0; i < m; ++i) idx[i] = i;
+            std::sort(idx.begin(), idx.end(), [&](ptrdiff_t a, ptrdiff_t b) {
+                    return T[a * m + a] < T[b * m + b];
+                    });
+
+            // Ritz vectors, scaled back with D^{-1/2}.
+            v.assign(n * this->nev, 0.0);
+
+#pragma omp parallel for
+            for(ptrdiff_t i = 0; i < n; ++i) {
+                for(ptrdiff_t j = 0; j < this->nev; ++j) {
+                    double s = 0;
+                    for(ptrdiff_t l = 0; l < m; ++l)
+                        s += Q[l * n + i] * V[l * m + idx[j]];
+                    v[i * this->nev + j] = s * sd[i];
+                }
+            }
+        }
+
+        int dim() const {
+            return nev;
+        }
+
+        double operator()(ptrdiff_t row, int j) const {
+            return v[row * nev + j];
+        }
+    private:
+        ptrdiff_t n, nev;
+        std::vector<double> v;
+
+        // Cyclic Jacobi method for the dense symmetric matrix.
+        // On exit, the diagonal of A holds the eigenvalues, and the
+        // columns of V hold the eigenvectors.
+        static void jacobi(ptrdiff_t m, std::vector<double> &A, std::vector<double> &V) {
+            for(int sweep = 0; sweep < 100; ++sweep) {
+                double off = 0, nrm = 0;
+                for(ptrdiff_t i = 0; i < m; ++i)
+                    for(ptrdiff_t j = 0; j < m; ++j) {
+                        double a = A[i * m + j] * A[i * m + j];
+                        nrm += a;
+                        if (i != j) off += a;
+                    }
+
+                if (off <= 1e-28 * nrm) break;
+
+                for(ptrdiff_t p = 0; p < m; ++p) {
+                    for(ptrdiff_t q = p + 1; q < m; ++q) {
+                        double apq = A[p * m + q];
+                        if (apq == 0) continue;
+
+                        double theta = (A[q * m + q] - A[p * m + p]) / (2 * apq);
+                        double t = (theta >= 0 ? 1 : -1) / (std::abs(theta) + std::sqrt(theta * theta + 1));
+                        double c = 1 / std::sqrt(t * t + 1);
+                        double s = t * c;
+
+                        for(ptrdiff_t k = 0; k < m; ++k) {
+                            double akp = A[k * m + p];
+                            double akq = A[k * m + q];
+                            A[k * m + p] = c * akp - s * akq;
+                            A[k * m + q] = s * akp + c * akq;
+                        }
+
+                        for(ptrdiff_t k = 0; k < m; ++k) {
+                            double apk = A[p * m + k];
+                            double aqk = A[q * m + k];
+                            A[p * m + k] = c * apk - s * aqk;
+                            A[q * m + k] = s * apk + c * aqk;
+                        }
+
+                        for(ptrdiff_t k = 0; k < m; ++k) {
+                            double vkp = V[k * m + p];
+                            double vkq = V[k * m + q];
+                            V[k * m + p] = c * vkp - s * vkq;
+                            V[k * m + q] = s * vkp + c * vkq;
+                        }
+                    }
+                }
+            }
+        }
+};
+
 template <class SDD, class Matrix>
 struct sdd_projected_matrix {
     typedef typename SDD::value_type value_type;
@@ -115,43 +385,65 @@ class subdomain_deflation {
         typedef typename LocalPrecond::backend_type backend_type;
         typedef typename backend_type::params backend_params;
         typedef IterativeSolver<backend_type, mpi::inner_product> ISolver;
+        typedef solver::cg<backend_type> LSolver;
 
         struct params {
             typename LocalPrecond::params local;
             typename ISolver::params      isolver;
             typename DirectSolver::params dsolver;
 
+            // Local solver applying the inverse of the local matrix on each
+            // Lanczos step for the local eigenvectors (preconditioned with
+            // the local preconditioner).
+            typename LSolver::params      lsolver;
+
             // Number of deflation vectors.
             unsigned num_def_vec;
 
             // Value of deflation vector at the given row and column.
             std::function<double(ptrdiff_t, unsigned)> def_vec;
 
-            params() {}
+            // Number of the local eigenvectors to use as deflation vectors.
+            // When non-zero, the deflation vectors are computed during the
+            // setup (see eigen_deflation), and def_vec is not used.
+            unsigned num_eig_vec;
+
+            // Number of Lanczos iterations for the local eigenvectors.
+            // Zero means a default value depending on num_eig_vec.
+            unsigned lanczos_iters;
+
+            params() : num_def_vec(0), num_eig_vec(0), lanczos_iters(0) {}
 
             params(const boost::property_tree::ptree &p)
                 : AMGCL_PARAMS_IMPORT_CHILD(p, local),
                   AMGCL_PARAMS_IMPORT_CHILD(p, isolver),
                   AMGCL_PARAMS_IMPORT_CHILD(p, dsolver),
-                  AMGCL_PARAMS_IMPORT_VALUE(p, num_def_vec)
+                  AMGCL_PARAMS_IMPORT_CHILD(p, lsolver),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, num_def_vec),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, num_eig_vec),
+                  AMGCL_PARAMS_IMPORT_VALUE(p, lanczos_iters)
             {
                 void *ptr = 0;
                 ptr = p.get("def_vec", ptr);
 
-                amgcl::precondition(ptr,
+                amgcl::precondition(ptr || num_eig_vec,
                         "Error in subdomain_deflation parameters: "
                         "def_vec is not set");
 
-                def_vec = *static_cast<std::function<double(ptrdiff_t, unsigned)>*>(ptr);
+                if (ptr)
+                    def_vec = *static_cast<std::function<double(ptrdiff_t, unsigned)>*>(ptr);
 
-                check_params(p, {"local", "isolver", "dsolver", "num_def_vec", "def_vec"});
+                check_params(p, {"local", "isolver", "dsolver", "lsolver", "num_def_vec", "def_vec", "num_eig_vec", "lanczos_iters"});
             }
 
             void get(boost::property_tree::ptree &p, const std::string &path) const {
                 AMGCL_PARAMS_EXPORT_CHILD(p, path, local);
                 AMGCL_PARAMS_EXPORT_CHILD(p, path, isolver);
                 AMGCL_PARAMS_EXPORT_CHILD(p, path, dsolver);
+                AMGCL_PARAMS_EXPORT_CHILD(p, path, lsolver);
                 AMGCL_PARAMS_EXPORT_VALUE(p, path, num_def_vec);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, num_eig_vec);
+                AMGCL_PARAMS_EXPORT_VALUE(p, path, lanczos_iters);
             }
         };
 
@@ -169,7 +461,7 @@ class subdomain_deflation {
                 const backend_params &bprm = backend_params()
                 )
         : comm(comm),
-          nrows(backend::rows(Astrip)), ndv(prm.num_def_vec),
+          nrows(backend::rows(Astrip)), ndv(num_vectors(prm, nrows)),
           dtype( datatype<value_type>() ), dv_start(comm.size + 1, 0),
           Z( ndv ), q( backend_type::create_vector(nrows, bprm) ),
           S(nrows, prm.isolver, bprm, mpi::inner_product(comm))
@@ -185,7 +477,7 @@ class subdomain_deflation {
                 const backend_params &bprm = backend_params()
                 )
         : comm(comm),
-          nrows(A->loc_rows()), ndv(prm.num_def_vec),
+          nrows(A->loc_rows()), ndv(num_vectors(prm, nrows)),
           dtype( datatype<value_type>() ), A(A), dv_start(comm.size + 1, 0),
           Z( ndv ), q( backend_type::create_vector(nrows, bprm) ),
           S(nrows, prm.isolver, bprm, mpi::inner_product(comm))
@@ -201,6 +493,30 @@ class subdomain_deflation {
             AMGCL_TIC("setup deflation");
             typedef backend::crs<value_type, ptrdiff_t>                build_matrix;
 
+            auto a_loc = A->local();
+            auto a_rem = A->remote();
+
+            std::function<double(ptrdiff_t, unsigned)> def_vec = prm.def_vec;
+            std::shared_ptr<eigen_deflation> eig;
+
+            // Create local preconditioner.
+            AMGCL_TIC("local preconditioner");
+            P = std::make_shared<LocalPrecond>( *a_loc, prm.local, bprm );
+            AMGCL_TOC("local preconditioner");
+
+            if (prm.num_eig_vec) {
+                AMGCL_TIC("local eigenvectors");
+                eig = local_eigenvectors(*a_loc, prm, bprm,
+                        std::is_arithmetic<value_type>());
+                def_vec = std::cref(*eig);
+                AMGCL_TOC("local eigenvectors");
+
+                // Lanczos may find fewer eigenvectors than requested when
+                // the Krylov subspace of the subdomain is exhausted early.
+                ndv = eig->dim();
+                Z.resize(ndv);
+            }
+
             // Lets see how many deflation vectors are there.
             std::vector<ptrdiff_t> dv_size(comm.size);
             MPI_Allgather(&ndv, 1, datatype<ptrdiff_t>(), &dv_size[0], 1, datatype<ptrdiff_t>(), comm);
@@ -215,9 +531,6 @@ class subdomain_deflation {
             auto az_loc = std::make_shared<build_matrix>();
             auto az_rem = std::make_shared<build_matrix>();
 
-            auto a_loc = A->local();
-            auto a_rem = A->remote();
-
             const comm_pattern<backend_type> &Acp = A->cpat();
 
             // Fill deflation vectors.
@@ -227,7 +540,7 @@ class subdomain_deflation {
                 for(int j = 0; j < ndv; ++j) {
 #pragma omp parallel for
                     for(ptrdiff_t i = 0; i < nrows; ++i)
-                        z[i] = prm.def_vec(i, j);
+                        z[i] = def_vec(i, j);
                     Z[j] = backend_type::copy_vector(z, bprm);
                 }
             }
@@ -258,7 +571,7 @@ class subdomain_deflation {
                         value_type v = a_loc->val[j];
 
                         for(ptrdiff_t j = 0; j < ndv; ++j)
-                            az_loc->val[az_loc_head + j] += v * prm.def_vec(c, j);
+                            az_loc->val[az_loc_head + j] += v * def_vec(c, j);
                     }
 
                     for(ptrdiff_t j = a_rem->ptr[i], e = a_rem->ptr[i+1]; j < e; ++j) {
@@ -274,11 +587,6 @@ class subdomain_deflation {
             az_rem->set_nonzeros(az_rem->scan_row_sizes());
             AMGCL_TOC("first pass");
 
-            // Create local preconditioner.
-            AMGCL_TIC("local preconditioner");
-            P = std::make_shared<LocalPrecond>( *a_loc, prm.local, bprm );
-            AMGCL_TOC("local preconditioner");
-
             A->set_local(P->system_matrix_ptr());
             A->move_to_backend(bprm);
 
@@ -313,7 +621,7 @@ class subdomain_deflation {
 
             for(size_t i = 0, k = 0; i < Acp.send.count(); ++i)
                 for(ptrdiff_t j = 0; j < ndv; ++j, ++k)
-                    zsend[k] = prm.def_vec(Acp.send.col[i], j);
+                    zsend[k] = def_vec(Acp.send.col[i], j);
 
             for(size_t i = 0; i < Acp.send.nbr.size(); ++i)
                 MPI_Isend(
@@ -404,7 +712,7 @@ class subdomain_deflation {
 #pragma omp for
                     for(ptrdiff_t i = 0; i < nrows; ++i) {
                         for(ptrdiff_t j = 0; j < ndv; ++j)
-                            z[j] = prm.def_vec(i,j);
+                            z[j] = def_vec(i,j);
 
                         for(ptrdiff_t k = az_loc->ptr[i], e = az_loc->ptr[i+1]; k < e; ++k) {
                             ptrdiff_t  c = az_loc->col[k] + dv_offset;
@@ -535,6 +843,48 @@ class subdomain_deflation {
 
         ISolver S;
 
+        static ptrdiff_t num_vectors(const params &prm, ptrdiff_t nrows) {
+            if (prm.num_eig_vec)
+                return std::min<ptrdiff_t>(prm.num_eig_vec, nrows);
+            return prm.num_def_vec;
+        }
+
+        // The inverse of the local matrix is applied approximately, with
+        // CG preconditioned by the local preconditioner.
+        template <class Matrix>
+        std::shared_ptr<eigen_deflation> local_eigenvectors(
+                const Matrix &A, const params &prm, const backend_params &bprm,
+                std::true_type) const
+        {
+            LSolver solve(nrows, prm.lsolver, bprm);
+
+            std::shared_ptr<vector> f = backend_type::create_vector(nrows, bprm);
+            std::shared_ptr<vector> x = backend_type::create_vector(nrows, bprm);
+            std::vector<value_type> buf(nrows);
+
+            auto inv = [&](const std::vector<double> &rhs, std::vector<double> &sol) {
+                std::copy(rhs.begin(), rhs.end(), buf.begin());
+                backend::copy(buf, *f);
+                backend::clear(*x);
+
+                solve(P->system_matrix(), *P, *f, *x);
+
+                backend::copy(*x, buf);
+                std::copy(buf.begin(), buf.end(), sol.begin());
+            };
+
+            return std::make_shared<eigen_deflation>(
+                    A, inv, prm.num_eig_vec, prm.lanczos_iters);
+        }
+
+        template <class Matrix>
+        std::shared_ptr<eigen_deflation> local_eigenvectors(
+                const Matrix&, const params&, const backend_params&,
+                std::false_type) const
+        {
+            throw std::logic_error("Local eigenvectors are only supported for scalar problems");
+        }
+
         void coarse_solve(std::vector<value_type> &f, std::vector<value_type> &x) const
         {
             AMGCL_TIC("coarse solve");
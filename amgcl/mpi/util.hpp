@@ -40,6 +40,10 @@ THE SOFTWARE.
 
 #include <mpi.h>
 
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
 namespace amgcl {
 namespace mpi {
 
@@ -172,7 +176,7 @@ struct communicator {
 
         if (!gc) {
             std::vector<int> c(size);
-            MPI_Gather(&lc, 1, MPI_INT, &c[0], size, MPI_INT, 0, comm);
+            MPI_Gather(&lc, 1, MPI_INT, &c[0], 1, MPI_INT, 0, comm);
             if (rank == 0) {
                 std::cerr << "Failed assumption: " << message << std::endl;
                 std::cerr << "Offending processes:";
@@ -185,6 +189,67 @@ struct communicator {
         }
     }
 
+    /// Communicator of the processes sharing the compute node.
+    /**
+     * The node communicator is split once for each communicator, and is
+     * cached as its attribute, so that it is freed together with it. The
+     * first call is collective.
+     */
+    communicator node() const {
+        static const int key = node_keyval();
+
+        MPI_Comm *node_comm;
+        int found;
+        MPI_Comm_get_attr(comm, key, &node_comm, &found);
+
+        if (!found) {
+            node_comm = new MPI_Comm;
+            MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, node_comm);
+            MPI_Comm_set_attr(comm, key, node_comm);
+        }
+
+        return communicator(*node_comm);
+    }
+
+    private:
+        static int node_keyval() {
+            int key;
+            MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, free_node, &key, 0);
+            return key;
+        }
+
+        static int free_node(MPI_Comm, int, void *val, void*) {
+            MPI_Comm *node_comm = static_cast<MPI_Comm*>(val);
+            MPI_Comm_free(node_comm);
+            delete node_comm;
+            return MPI_SUCCESS;
+        }
+};
+
+/// Changes the number of OpenMP threads for the lifetime of the object.
+/**
+ * Zero means the number of threads is left intact.
+ */
+struct scoped_threads {
+    int old;
+
+    scoped_threads(int n) : old(0) {
+#ifdef _OPENMP
+        if (n > 0) {
+            old = omp_get_max_threads();
+            omp_set_num_threads(n);
+        }
+#endif
+    }
+
+    ~scoped_threads() {
+#ifdef _OPENMP
+        if (old > 0) omp_set_num_threads(old);
+#endif
+    }
+
+    scoped_threads(const scoped_threads&) = delete;
+    scoped_threads& operator=(const scoped_threads&) = delete;
 };
 
 } // namespace mpi
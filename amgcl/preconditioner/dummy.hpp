@@ -46,7 +46,7 @@ class dummy {
         typedef typename Backend::matrix  matrix;
         typedef typename Backend::vector  vector;
         typedef typename Backend::value_type value_type;
-        typedef typename backend::builtin<value_type>::matrix build_matrix;
+        typedef typename backend::builtin_matrix<Backend>::type build_matrix;
 
         typedef amgcl::detail::empty_params params;
         typedef typename Backend::params backend_params;
@@ -52,7 +52,7 @@ class as_preconditioner {
         typedef typename Backend::params  backend_params;
 
         typedef typename Backend::value_type value_type;
-        typedef typename backend::builtin<value_type>::matrix build_matrix;
+        typedef typename backend::builtin_matrix<Backend>::type build_matrix;
 
         template <class Matrix>
         as_preconditioner(
@@ -47,7 +47,7 @@ class ilu_solve {
         typedef typename Backend::matrix matrix;
         typedef typename Backend::vector vector;
         typedef typename Backend::matrix_diagonal matrix_diagonal;
-        typedef typename backend::builtin<value_type>::matrix build_matrix;
+        typedef typename backend::builtin_matrix<Backend>::type build_matrix;
         typedef typename math::scalar_of<value_type>::type scalar_type;
 
         struct params {
@@ -113,15 +113,15 @@ class ilu_solve {
         std::shared_ptr<vector> t1, t2;
 };
 
-template <class value_type>
-class ilu_solve< backend::builtin<value_type> > {
+template <class value_type, class col_type, class ptr_type>
+class ilu_solve< backend::builtin<value_type, col_type, ptr_type> > {
     public:
-        typedef backend::builtin<value_type> Backend;
+        typedef backend::builtin<value_type, col_type, ptr_type> Backend;
         typedef typename Backend::params backend_params;
         typedef typename Backend::matrix matrix;
         typedef typename Backend::vector vector;
         typedef typename Backend::matrix_diagonal matrix_diagonal;
-        typedef typename backend::builtin<value_type>::matrix build_matrix;
+        typedef typename Backend::matrix build_matrix;
         typedef typename Backend::rhs_type rhs_type;
         typedef typename math::scalar_of<value_type>::type scalar_type;
 
@@ -181,6 +181,26 @@ class ilu_solve< backend::builtin<value_type> > {
 #endif
         }
 
+        static int team_size() {
+#ifdef _OPENMP
+            return omp_get_num_threads();
+#else
+            return 1;
+#endif
+        }
+
+        // Number of the per-thread task tables of the parallel solve. It does
+        // not depend on the team that builds the tables, so the tables may be
+        // built by a part of the cores (see amg::params::task_setup) and then
+        // used by whatever team is in effect at the solve time.
+        static int num_tasks() {
+#ifdef _OPENMP
+            return std::max(omp_get_num_procs(), omp_get_max_threads());
+#else
+            return 1;
+#endif
+        }
+
         // copies of the input matrices for the fallback (serial)
         // implementation:
         std::shared_ptr<matrix>          L;
@@ -233,7 +253,7 @@ class ilu_solve< backend::builtin<value_type> > {
                 task(ptrdiff_t beg, ptrdiff_t end) : beg(beg), end(end) {}
             };
 
-            int nthreads;
+            int ntasks;
 
             // thread-specific storage:
             std::vector< std::vector<task>       > tasks;
@@ -245,8 +265,8 @@ class ilu_solve< backend::builtin<value_type> > {
 
             template <class Matrix>
             sptr_solve(const Matrix &A, const value_type *_D = 0)
-                : nthreads(num_threads()), tasks(nthreads),
-                  ptr(nthreads), col(nthreads), val(nthreads), ord(nthreads)
+                : ntasks(num_tasks()), tasks(ntasks),
+                  ptr(ntasks), col(ntasks), val(ntasks), ord(ntasks)
             {
                 ptrdiff_t n    = A.nrows;
                 ptrdiff_t nlev = 0;
@@ -287,72 +307,74 @@ class ilu_solve< backend::builtin<value_type> > {
 
 
                 // 3. Organize matrix rows into tasks.
-                //    Each level is split into nthreads tasks.
-                std::vector<ptrdiff_t> thread_rows(nthreads, 0);
-                std::vector<ptrdiff_t> thread_cols(nthreads, 0);
+                //    Each level is split into ntasks tasks.
+                std::vector<ptrdiff_t> thread_rows(ntasks, 0);
+                std::vector<ptrdiff_t> thread_cols(ntasks, 0);
 
 #pragma omp parallel
                 {
-                    int tid = thread_id();
-                    tasks[tid].reserve(nlev);
+                    for(int tid = thread_id(); tid < ntasks; tid += team_size()) {
+                        tasks[tid].reserve(nlev);
 
-                    for(ptrdiff_t lev = 0; lev < nlev; ++lev) {
-                        // split each level into tasks.
-                        ptrdiff_t lev_size = start[lev+1] - start[lev];
-                        ptrdiff_t chunk_size = (lev_size + nthreads - 1) / nthreads;
+                        for(ptrdiff_t lev = 0; lev < nlev; ++lev) {
+                            // split each level into tasks.
+                            ptrdiff_t lev_size = start[lev+1] - start[lev];
+                            ptrdiff_t chunk_size = (lev_size + ntasks - 1) / ntasks;
 
-                        ptrdiff_t beg = std::min(tid * chunk_size, lev_size);
-                        ptrdiff_t end = std::min(beg + chunk_size, lev_size);
+                            ptrdiff_t beg = std::min(tid * chunk_size, lev_size);
+                            ptrdiff_t end = std::min(beg + chunk_size, lev_size);
 
-                        beg += start[lev];
-                        end += start[lev];
+                            beg += start[lev];
+                            end += start[lev];
 
-                        tasks[tid].push_back(task(beg, end));
+                            tasks[tid].push_back(task(beg, end));
 
-                        // count rows and nonzeros in the current task
-                        thread_rows[tid] += end - beg;
-                        for(ptrdiff_t i = beg; i < end; ++i) {
-                            ptrdiff_t j = order[i];
-                            thread_cols[tid] += A.ptr[j+1] - A.ptr[j];
+                            // count rows and nonzeros in the current task
+                            thread_rows[tid] += end - beg;
+                            for(ptrdiff_t i = beg; i < end; ++i) {
+                                ptrdiff_t j = order[i];
+                                thread_cols[tid] += A.ptr[j+1] - A.ptr[j];
+                            }
                         }
                     }
                 }
 
                 // 4. reorganize matrix data for better cache and NUMA locality.
-                if (!lower) D.resize(nthreads);
+                if (!lower) D.resize(ntasks);
 
 #pragma omp parallel
                 {
-                    int tid = thread_id();
+                    for(int tid = thread_id(); tid < ntasks; tid += team_size()) {
+
+                        col[tid].reserve(thread_cols[tid]);
+                        val[tid].reserve(thread_cols[tid]);
+                        ord[tid].reserve(thread_rows[tid]);
+                        ptr[tid].reserve(thread_rows[tid] + 1);
+                        ptr[tid].push_back(0);
 
-                    col[tid].reserve(thread_cols[tid]);
-                    val[tid].reserve(thread_cols[tid]);
-                    ord[tid].reserve(thread_rows[tid]);
-                    ptr[tid].reserve(thread_rows[tid] + 1);
-                    ptr[tid].push_back(0);
+                        if (!lower) D[tid].reserve(thread_rows[tid]);
 
-                    if (!lower) D[tid].reserve(thread_rows[tid]);
+                        for(task &t : tasks[tid]) {
+                            ptrdiff_t loc_beg = ptr[tid].size() - 1;
+                            ptrdiff_t loc_end = loc_beg;
 
-                    for(task &t : tasks[tid]) {
-                        ptrdiff_t loc_beg = ptr[tid].size() - 1;
-                        ptrdiff_t loc_end = loc_beg;
+                            for(ptrdiff_t r = t.beg; r < t.end; ++r, ++loc_end) {
+                                ptrdiff_t i = order[r];
+                                if (!lower) D[tid].push_back(_D[i]);
 
-                        for(ptrdiff_t r = t.beg; r < t.end; ++r, ++loc_end) {
-                            ptrdiff_t i = order[r];
-                            if (!lower) D[tid].push_back(_D[i]);
+                                ord[tid].push_back(i);
 
-                            ord[tid].push_back(i);
+                                for(ptrdiff_t j = A.ptr[i]; j < A.ptr[i+1]; ++j) {
+                                    col[tid].push_back(A.col[j]);
+                                    val[tid].push_back(A.val[j]);
+                                }
 
-                            for(ptrdiff_t j = A.ptr[i]; j < A.ptr[i+1]; ++j) {
-                                col[tid].push_back(A.col[j]);
-                                val[tid].push_back(A.val[j]);
+                                ptr[tid].push_back(col[tid].size());
                             }
 
-                            ptr[tid].push_back(col[tid].size());
+                            t.beg = loc_beg;
+                            t.end = loc_end;
                         }
-
-                        t.beg = loc_beg;
-                        t.end = loc_end;
                     }
                 }
             }
@@ -361,25 +383,29 @@ class ilu_solve< backend::builtin<value_type> > {
             void solve(Vector &x) const {
 #pragma omp parallel
                 {
-                    int tid = thread_id();
-
-                    for(const task &t : tasks[tid]) {
-                        for(ptrdiff_t r = t.beg; r < t.end; ++r) {
-                            ptrdiff_t i   = ord[tid][r];
-                            ptrdiff_t beg = ptr[tid][r];
-                            ptrdiff_t end = ptr[tid][r+1];
-
-                            rhs_type X = math::zero<rhs_type>();
-                            for(ptrdiff_t j = beg; j < end; ++j)
-                                X += val[tid][j] * x[col[tid][j]];
-
-                            if (lower)
-                                x[i] -= X;
-                            else
-                                x[i] = D[tid][r] * (x[i] - X);
+                    const ptrdiff_t nlev = tasks[0].size();
+                    const int       nt   = team_size();
+
+                    for(ptrdiff_t lev = 0; lev < nlev; ++lev) {
+                        for(int tid = thread_id(); tid < ntasks; tid += nt) {
+                            const task &t = tasks[tid][lev];
+                            for(ptrdiff_t r = t.beg; r < t.end; ++r) {
+                                ptrdiff_t i   = ord[tid][r];
+                                ptrdiff_t beg = ptr[tid][r];
+                                ptrdiff_t end = ptr[tid][r+1];
+
+                                rhs_type X = math::zero<rhs_type>();
+                                for(ptrdiff_t j = beg; j < end; ++j)
+                                    X += val[tid][j] * x[col[tid][j]];
+
+                                if (lower)
+                                    x[i] -= X;
+                                else
+                                    x[i] = D[tid][r] * (x[i] - X);
+                            }
                         }
 
-                        // each task corresponds to a level, so we need
+                        // each level is split between the tasks, so we need
                         // to synchronize across threads at this point:
 #pragma omp barrier
                     }
@@ -61,7 +61,7 @@ struct gauss_seidel {
         /// Use serial version of the algorithm
         bool serial;
 
-        params() : serial(false) {}
+        params() : serial(num_threads() < 4) {}
 
         params(const boost::property_tree::ptree &p)
             : AMGCL_PARAMS_IMPORT_VALUE(p, serial)
@@ -79,7 +79,7 @@ struct gauss_seidel {
     /// \copydoc amgcl::relaxation::damped_jacobi::damped_jacobi
     template <class Matrix>
     gauss_seidel( const Matrix &A, const params &prm, const typename Backend::params&)
-        : is_serial(prm.serial || num_threads() < 4)
+        : is_serial(prm.serial)
     {
         if(!is_serial) {
             forward  = std::make_shared< parallel_sweep<true>  >(A);
@@ -141,6 +141,26 @@ struct gauss_seidel {
 #endif
         }
 
+        static int team_size() {
+#ifdef _OPENMP
+            return omp_get_num_threads();
+#else
+            return 1;
+#endif
+        }
+
+        // Number of the per-thread task tables of the parallel sweep. It does
+        // not depend on the team that builds the tables, so the tables may be
+        // built by a part of the cores (see amg::params::task_setup) and then
+        // used by whatever team is in effect at the solve time.
+        static int num_tasks() {
+#ifdef _OPENMP
+            return std::max(omp_get_num_procs(), omp_get_max_threads());
+#else
+            return 1;
+#endif
+        }
+
         template <class Matrix, class VectorRHS, class VectorX>
         static void serial_sweep(
                 const Matrix &A, const VectorRHS &rhs, VectorX &x, bool forward)
@@ -182,7 +202,7 @@ struct gauss_seidel {
                 task(ptrdiff_t beg, ptrdiff_t end) : beg(beg), end(end) {}
             };
 
-            int nthreads;
+            int ntasks;
 
             // thread-specific storage:
             std::vector< std::vector<task>       > tasks;
@@ -193,8 +213,8 @@ struct gauss_seidel {
 
             template <class Matrix>
             parallel_sweep(const Matrix &A)
-                : nthreads(num_threads()), tasks(nthreads),
-                  ptr(nthreads), col(nthreads), val(nthreads), ord(nthreads)
+                : ntasks(num_tasks()), tasks(ntasks),
+                  ptr(ntasks), col(ntasks), val(ntasks), ord(ntasks)
             {
                 ptrdiff_t n    = backend::rows(A);
                 ptrdiff_t nlev = 0;
@@ -243,33 +263,34 @@ struct gauss_seidel {
 
 
                 // 3. Organize matrix rows into tasks.
-                //    Each level is split into nthreads tasks.
-                std::vector<ptrdiff_t> thread_rows(nthreads, 0);
-                std::vector<ptrdiff_t> thread_cols(nthreads, 0);
+                //    Each level is split into ntasks tasks.
+                std::vector<ptrdiff_t> thread_rows(ntasks, 0);
+                std::vector<ptrdiff_t> thread_cols(ntasks, 0);
 
 #pragma omp parallel
                 {
-                    int tid = thread_id();
-                    tasks[tid].reserve(nlev);
+                    for(int tid = thread_id(); tid < ntasks; tid += team_size()) {
+                        tasks[tid].reserve(nlev);
 
-                    for(ptrdiff_t lev = 0; lev < nlev; ++lev) {
-                        // split each level into tasks.
-                        ptrdiff_t lev_size = start[lev+1] - start[lev];
-                        ptrdiff_t chunk_size = (lev_size + nthreads - 1) / nthreads;
+                        for(ptrdiff_t lev = 0; lev < nlev; ++lev) {
+                            // split each level into tasks.
+                            ptrdiff_t lev_size = start[lev+1] - start[lev];
+                            ptrdiff_t chunk_size = (lev_size + ntasks - 1) / ntasks;
 
-                        ptrdiff_t beg = std::min(tid * chunk_size, lev_size);
-                        ptrdiff_t end = std::min(beg + chunk_size, lev_size);
+                            ptrdiff_t beg = std::min(tid * chunk_size, lev_size);
+                            ptrdiff_t end = std::min(beg + chunk_size, lev_size);
 
-                        beg += start[lev];
-                        end += start[lev];
+                            beg += start[lev];
+                            end += start[lev];
 
-                        tasks[tid].push_back(task(beg, end));
+                            tasks[tid].push_back(task(beg, end));
 
-                        // count rows and nonzeros in the current task
-                        thread_rows[tid] += end - beg;
-                        for(ptrdiff_t i = beg; i < end; ++i) {
-                            ptrdiff_t j = order[i];
-                            thread_cols[tid] += row_nonzeros(A, j);
+                            // count rows and nonzeros in the current task
+                            thread_rows[tid] += end - beg;
+                            for(ptrdiff_t i = beg; i < end; ++i) {
+                                ptrdiff_t j = order[i];
+                                thread_cols[tid] += row_nonzeros(A, j);
+                            }
                         }
                     }
                 }
@@ -277,33 +298,34 @@ struct gauss_seidel {
                 // 4. reorganize matrix data for better cache and NUMA locality.
 #pragma omp parallel
                 {
-                    int tid = thread_id();
+                    for(int tid = thread_id(); tid < ntasks; tid += team_size()) {
 
-                    col[tid].reserve(thread_cols[tid]);
-                    val[tid].reserve(thread_cols[tid]);
-                    ord[tid].reserve(thread_rows[tid]);
-                    ptr[tid].reserve(thread_rows[tid] + 1);
-                    ptr[tid].push_back(0);
+                        col[tid].reserve(thread_cols[tid]);
+                        val[tid].reserve(thread_cols[tid]);
+                        ord[tid].reserve(thread_rows[tid]);
+                        ptr[tid].reserve(thread_rows[tid] + 1);
+                        ptr[tid].push_back(0);
 
-                    for(task &t : tasks[tid]) {
-                        ptrdiff_t loc_beg = ptr[tid].size() - 1;
-                        ptrdiff_t loc_end = loc_beg;
+                        for(task &t : tasks[tid]) {
+                            ptrdiff_t loc_beg = ptr[tid].size() - 1;
+                            ptrdiff_t loc_end = loc_beg;
 
-                        for(ptrdiff_t r = t.beg; r < t.end; ++r, ++loc_end) {
-                            ptrdiff_t i = order[r];
+                            for(ptrdiff_t r = t.beg; r < t.end; ++r, ++loc_end) {
+                                ptrdiff_t i = order[r];
 
-                            ord[tid].push_back(i);
+                                ord[tid].push_back(i);
 
-                            for(auto a = row_begin(A, i); a; ++a) {
-                                col[tid].push_back(a.col());
-                                val[tid].push_back(a.value());
+                                for(auto a = row_begin(A, i); a; ++a) {
+                                    col[tid].push_back(a.col());
+                                    val[tid].push_back(a.value());
+                                }
+
+                                ptr[tid].push_back(col[tid].size());
                             }
 
-                            ptr[tid].push_back(col[tid].size());
+                            t.beg = loc_beg;
+                            t.end = loc_end;
                         }
-
-                        t.beg = loc_beg;
-                        t.end = loc_end;
                     }
                 }
             }
@@ -312,31 +334,35 @@ struct gauss_seidel {
             void sweep(const Vector1 &rhs, Vector2 &x) const {
 #pragma omp parallel
                 {
-                    int tid = thread_id();
+                    const ptrdiff_t nlev = tasks[0].size();
+                    const int       nt   = team_size();
 
-                    for(const task &t : tasks[tid]) {
-                        for(ptrdiff_t r = t.beg; r < t.end; ++r) {
-                            ptrdiff_t i   = ord[tid][r];
-                            ptrdiff_t beg = ptr[tid][r];
-                            ptrdiff_t end = ptr[tid][r+1];
-
-                            rhs_type   X = rhs[i];
-                            value_type D = math::identity<value_type>();
-
-                            for(ptrdiff_t j = beg; j < end; ++j) {
-                                ptrdiff_t  c = col[tid][j];
-                                value_type v = val[tid][j];
-
-                                if (c == i)
-                                    D = v;
-                                else
-                                    X -= v * x[c];
+                    for(ptrdiff_t lev = 0; lev < nlev; ++lev) {
+                        for(int tid = thread_id(); tid < ntasks; tid += nt) {
+                            const task &t = tasks[tid][lev];
+                            for(ptrdiff_t r = t.beg; r < t.end; ++r) {
+                                ptrdiff_t i   = ord[tid][r];
+                                ptrdiff_t beg = ptr[tid][r];
+                                ptrdiff_t end = ptr[tid][r+1];
+
+                                rhs_type   X = rhs[i];
+                                value_type D = math::identity<value_type>();
+
+                                for(ptrdiff_t j = beg; j < end; ++j) {
+                                    ptrdiff_t  c = col[tid][j];
+                                    value_type v = val[tid][j];
+
+                                    if (c == i)
+                                        D = v;
+                                    else
+                                        X -= v * x[c];
+                                }
+
+                                x[i] = math::inverse(D) * X;
                             }
-
-                            x[i] = math::inverse(D) * X;
                         }
 
-                        // each task corresponds to a level, so we need
+                        // each level is split between the tasks, so we need
                         // to synchronize across threads at this point:
 #pragma omp barrier
                     }
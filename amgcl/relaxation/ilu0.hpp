@@ -85,7 +85,7 @@ struct ilu0 {
     ilu0( const Matrix &A, const params &prm, const typename Backend::params &bprm)
       : prm(prm)
     {
-        typedef typename backend::builtin<value_type>::matrix build_matrix;
+        typedef typename backend::builtin_matrix<Backend>::type build_matrix;
         const size_t n = backend::rows(A);
 
         size_t Lnz = 0, Unz = 0;
@@ -89,7 +89,7 @@ struct iluk {
     iluk( const Matrix &A, const params &prm, const typename Backend::params &bprm)
       : prm(prm)
     {
-        typedef typename backend::builtin<value_type>::matrix build_matrix;
+        typedef typename backend::builtin_matrix<Backend>::type build_matrix;
 
         const size_t n = backend::rows(A);
 
@@ -206,7 +206,7 @@ struct ilut {
     }
 
     private:
-        typedef typename backend::builtin<value_type>::matrix build_matrix;
+        typedef typename backend::builtin_matrix<Backend>::type build_matrix;
         std::shared_ptr<ilu_solve> ilu;
 
         struct sparse_vector {
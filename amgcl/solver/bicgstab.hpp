@@ -162,12 +162,16 @@ class bicgstab {
             coef_type rho2  = zero;
             coef_type alpha = zero;
             coef_type omega = zero;
+            coef_type rho   = zero;
+
+            bool have_rho = false;
 
             size_t iter = 0;
             for(bool first = true; res > eps && iter < prm.maxiter; ++iter) {
 
                 rho2 = rho1;
-                rho1 = inner_product(*r, *rh);
+                rho1 = have_rho ? rho : inner_product(*r, *rh);
+                have_rho = false;
 
                 if (first) {
                     backend::copy(*r, *p);
@@ -182,18 +186,29 @@ class bicgstab {
 
                 alpha = rho1 / inner_product(*rh, *v);
 
+                backend::axpbypcz(one, *r, -alpha, *v, zero, *s);
+
+                // The reduction for the norm of s is overlapped with the
+                // update of the solution.
+                auto ss = solver::detail::start_inner_product(inner_product, *s, *s);
+
                 if (prm.pside == side::left) {
                     backend::axpby(alpha, *p, one, x);
                 } else {
                     backend::axpby(alpha, *T, one, x);
                 }
 
-                backend::axpbypcz(one, *r, -alpha, *v, zero, *s);
-
-                if ((res = norm(*s)) > eps) {
+                if ((res = sqrt(math::norm(ss.get()))) > eps) {
                     preconditioner::spmv(prm.pside, P, A, *s, *t, *T);
 
-                    omega = inner_product(*t, *s) / inner_product(*t, *t);
+                    {
+                        const vector *vx[] = {t.get(), t.get()};
+                        const vector *vy[] = {s.get(), t.get()};
+                        coef_type     d[2];
+
+                        solver::detail::inner_products(inner_product, 2, vx, vy, d);
+                        omega = d[0] / d[1];
+                    }
 
                     precondition(!math::is_zero(omega), "Zero omega in BiCGStab");
 
@@ -205,7 +220,19 @@ class bicgstab {
 
                     backend::axpbypcz(one, *s, -omega, *t, zero, *r);
 
-                    res = norm(*r);
+                    // Compute the residual norm together with rho for the
+                    // next iteration.
+                    {
+                        const vector *vx[] = {r.get(), r.get()};
+                        const vector *vy[] = {r.get(), rh.get()};
+                        coef_type     d[2];
+
+                        solver::detail::inner_products(inner_product, 2, vx, vy, d);
+
+                        res = sqrt(math::norm(d[0]));
+                        rho = d[1];
+                        have_rho = true;
+                    }
                 }
             }
 
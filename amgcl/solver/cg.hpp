@@ -169,10 +169,15 @@ class cg {
 
                 coef_type alpha = rho1 / inner_product(*q, *p);
 
-                backend::axpby( alpha, *p, one,  x);
                 backend::axpby(-alpha, *q, one, *r);
 
-                res_norm = norm(*r);
+                // The reduction for the residual norm is overlapped with the
+                // update of the solution.
+                auto rr = solver::detail::start_inner_product(inner_product, *r, *r);
+
+                backend::axpby( alpha, *p, one,  x);
+
+                res_norm = sqrt(math::norm(rr.get()));
             }
 
             return std::make_tuple(iter, res_norm / norm_rhs);
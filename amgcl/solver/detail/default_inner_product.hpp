@@ -49,6 +49,81 @@ struct default_inner_product {
     }
 };
 
+/// Computes several inner products at once: r[i] = (*x[i], *y[i]).
+/**
+ * Uses the batched interface of the inner product when it is available (so
+ * that e.g. the distributed inner product may reduce all of the results with
+ * a single global reduction), and falls back to one call per inner product
+ * otherwise.
+ */
+template <class InnerProduct, class Vec1, class Vec2, class Coef>
+auto inner_products(const InnerProduct &ip,
+        size_t n, const Vec1 *const *x, const Vec2 *const *y, Coef *r, int)
+    -> decltype(ip(n, x, y, r), void())
+{
+    ip(n, x, y, r);
+}
+
+template <class InnerProduct, class Vec1, class Vec2, class Coef>
+void inner_products(const InnerProduct &ip,
+        size_t n, const Vec1 *const *x, const Vec2 *const *y, Coef *r, long)
+{
+    for(size_t i = 0; i < n; ++i)
+        r[i] = ip(*x[i], *y[i]);
+}
+
+template <class InnerProduct, class Vec1, class Vec2, class Coef>
+void inner_products(const InnerProduct &ip,
+        size_t n, const Vec1 *const *x, const Vec2 *const *y, Coef *r)
+{
+    inner_products(ip, n, x, y, r, 0);
+}
+
+/// Result of an inner product that is already computed.
+template <class T>
+struct ready_inner_product {
+    T value;
+
+    T get() const { return value; }
+};
+
+/// Starts an inner product; the result is returned by get() of the result.
+/**
+ * Uses the non-blocking interface of the inner product when it is available
+ * (so that e.g. the global reduction of the distributed inner product may be
+ * overlapped with the work done before get() is called), and computes the
+ * inner product immediately otherwise.
+ */
+template <class InnerProduct, class Vec1, class Vec2>
+auto start_inner_product(const InnerProduct &ip, const Vec1 &x, const Vec2 &y, int)
+    -> decltype(ip.async(x, y))
+{
+    return ip.async(x, y);
+}
+
+template <class InnerProduct, class Vec1, class Vec2>
+ready_inner_product<
+    typename math::inner_product_impl<
+        typename backend::value_type<Vec1>::type
+        >::return_type
+    >
+start_inner_product(const InnerProduct &ip, const Vec1 &x, const Vec2 &y, long)
+{
+    typedef typename math::inner_product_impl<
+        typename backend::value_type<Vec1>::type
+        >::return_type coef_type;
+
+    ready_inner_product<coef_type> r = {ip(x, y)};
+    return r;
+}
+
+template <class InnerProduct, class Vec1, class Vec2>
+auto start_inner_product(const InnerProduct &ip, const Vec1 &x, const Vec2 &y)
+    -> decltype(start_inner_product(ip, x, y, 0))
+{
+    return start_inner_product(ip, x, y, 0);
+}
+
 } // namespace detail
 } // namespace solver
 } // namespace amgcl
@@ -169,6 +169,10 @@ class idrs {
               r_s = Backend::create_vector(n, bprm);
             }
 
+            vx.resize(prm.s);
+            vy.resize(prm.s);
+            dots.resize(prm.s);
+
             G.reserve(prm.s);
             U.reserve(prm.s);
             for(unsigned i = 0; i < prm.s; ++i) {
@@ -288,8 +292,11 @@ class idrs {
             bool trueres = false;
             while(iter < prm.maxiter && res_norm > eps) {
                 // New righ-hand size for small system:
-                for(unsigned i = 0; i < prm.s; ++i)
-                    f[i] = inner_product(*r, *P[i]);
+                for(unsigned i = 0; i < prm.s; ++i) {
+                    vx[i] = r.get();
+                    vy[i] = P[i].get();
+                }
+                solver::detail::inner_products(inner_product, prm.s, vx.data(), vy.data(), f.data());
 
                 for(unsigned k = 0; k < prm.s; ++k) {
                     // Compute new v
@@ -325,8 +332,13 @@ class idrs {
                     }
 
                     // New column of M = P'*G  (first k-1 entries are zero)
+                    for(unsigned i = k; i < prm.s; ++i) {
+                        vx[i - k] = G[k].get();
+                        vy[i - k] = P[i].get();
+                    }
+                    solver::detail::inner_products(inner_product, prm.s - k, vx.data(), vy.data(), dots.data());
                     for(unsigned i = k; i < prm.s; ++i)
-                        M(i, k) = inner_product(*G[k], *P[i]);
+                        M(i, k) = dots[i - k];
 
                     precondition(!math::is_zero(M(k, k)), "IDR(s) breakdown: zero M[k,k]");
 
@@ -343,7 +355,7 @@ class idrs {
                     // Smoothing
                     if (prm.smoothing) {
                         backend::axpbypcz(one, *r_s, -one, *r, zero, *t);
-                        coef_type gamma = inner_product(*t, *r_s) / inner_product(*t, *t);
+                        coef_type gamma = smoothing_gamma();
                         backend::axpby(-gamma, *t, one, *r_s);
                         backend::axpbypcz(-gamma, *x_s, gamma, x, one, *x_s);
                         res_norm = norm(*r_s);
@@ -384,7 +396,7 @@ class idrs {
                 // Smoothing.
                 if (prm.smoothing) {
                     backend::axpbypcz(one, *r_s, -one, *r, zero, *t);
-                    coef_type gamma = inner_product(*t, *r_s) / inner_product(*t, *t);
+                    coef_type gamma = smoothing_gamma();
                     backend::axpby(-gamma, *t, one, *r_s);
                     backend::axpbypcz(-gamma, *x_s, gamma, x, one, *x_s);
                     res_norm = norm(*r_s);
@@ -435,17 +447,34 @@ class idrs {
         std::vector< std::shared_ptr<vector> > P, G, U;
 
 
+        mutable std::vector<const vector*> vx, vy;
+        mutable std::vector<coef_type>     dots;
+
         template <class Vec>
         scalar_type norm(const Vec &x) const {
             return std::abs(sqrt(inner_product(x, x)));
         }
 
-        template <class Vector1, class Vector2>
-        coef_type omega(const Vector1 &t, const Vector2 &s) const {
-            scalar_type norm_t = norm(t);
-            scalar_type norm_s = norm(s);
+        coef_type smoothing_gamma() const {
+            const vector *x[] = {t.get(), t.get()};
+            const vector *y[] = {r_s.get(), t.get()};
+            coef_type     d[2];
+
+            solver::detail::inner_products(inner_product, 2, x, y, d);
+            return d[0] / d[1];
+        }
+
+        coef_type omega(const vector &t, const vector &s) const {
+            const vector *x[] = {&t, &s, &t};
+            const vector *y[] = {&t, &s, &s};
+            coef_type     d[3];
+
+            solver::detail::inner_products(inner_product, 3, x, y, d);
+
+            scalar_type norm_t = std::abs(sqrt(d[0]));
+            scalar_type norm_s = std::abs(sqrt(d[1]));
 
-            coef_type   ts  = inner_product(t, s);
+            coef_type   ts  = d[2];
             scalar_type rho = math::norm(ts / (norm_t * norm_s));
             coef_type   om  = ts / (norm_t * norm_t);
 
@@ -35,6 +35,7 @@ THE SOFTWARE.
 #include <iomanip>
 #include <string>
 #include <set>
+#include <array>
 #include <complex>
 #include <limits>
 #include <stdexcept>
@@ -281,6 +282,16 @@ T eps(size_t n) {
     return 2 * std::numeric_limits<T>::epsilon() * n;
 }
 
+// Bit mixer for the hash of integer values.
+inline size_t mix_hash(size_t x) {
+    x ^= x >> 31;
+    x *= static_cast<size_t>(0x7fb5d329728ea185ull);
+    x ^= x >> 27;
+    x *= static_cast<size_t>(0x81dadef4bc2dd44dull);
+    x ^= x >> 33;
+    return x;
+}
+
 } // namespace detail
 
 template <class T> struct is_complex : std::false_type {};
@@ -89,10 +89,27 @@ type
 
             destructor Destroy; override;
 
+            { Updates the solver for the new matrix values. The sparsity
+              pattern should not change, and 'precond.allow_rebuild'
+              should be set on creation. }
+            procedure update(
+                var ptr: Array of Integer;
+                var col: Array of Integer;
+                var val: Array of Double
+                );
+
+            { x holds the initial approximation on input. }
             function solve(
                 var rhs: Array of Double;
                 var x:   Array of Double
                 ) : TConvInfo;
+
+            { Solves for nrhs right-hand sides stored one after another. }
+            function solve_multi(
+                nrhs:    Integer;
+                var rhs: Array of Double;
+                var x:   Array of Double
+                ) : TConvInfo;
     end;
 
     procedure load;
@@ -140,6 +157,13 @@ Var
         val:         PDouble
         ): Pointer; stdcall;
 
+    amgcl_solver_update: procedure(
+        h:   Pointer;
+        ptr: PInteger;
+        col: PInteger;
+        val: PDouble
+        ); stdcall;
+
     amgcl_solver_solve: function(
         h:   Pointer;
         rhs: PDouble;
@@ -155,6 +179,13 @@ Var
         x:     PDouble
         ); stdcall;
 
+    amgcl_solver_solve_multi: function(
+        h:    Pointer;
+        nrhs: Integer;
+        rhs:  PDouble;
+        x:    PDouble
+        ): TConvInfo; stdcall;
+
     amgcl_solver_destroy: procedure(h: Pointer); stdcall;
 
 constructor TParams.Create;
@@ -194,6 +225,15 @@ begin
                 );
 end;
 
+procedure TSolver.update(
+    var ptr: Array of Integer;
+    var col: Array of Integer;
+    var val: Array of Double
+    );
+begin
+    amgcl_solver_update(h, @ptr[0], @col[0], @val[0]);
+end;
+
 function TSolver.solve(
     var rhs: Array of Double;
     var x:   Array of Double
@@ -202,6 +242,15 @@ begin
     solve := amgcl_solver_solve(h, @rhs[0], @x[0]);
 end;
 
+function TSolver.solve_multi(
+    nrhs:    Integer;
+    var rhs: Array of Double;
+    var x:   Array of Double
+    ): TConvInfo;
+begin
+    solve_multi := amgcl_solver_solve_multi(h, nrhs, @rhs[0], @x[0]);
+end;
+
 destructor TSolver.Destroy;
 begin
     amgcl_solver_destroy(h);
@@ -228,8 +277,10 @@ begin
         @amgcl_params_destroy   := get_function('amgcl_params_destroy');
 
         @amgcl_solver_create    := get_function('amgcl_solver_create');
+        @amgcl_solver_update    := get_function('amgcl_solver_update');
         @amgcl_solver_solve     := get_function('amgcl_solver_solve');
         @amgcl_solver_solve_mtx := get_function('amgcl_solver_solve_mtx');
+        @amgcl_solver_solve_multi := get_function('amgcl_solver_solve_multi');
         @amgcl_solver_destroy   := get_function('amgcl_solver_destroy');
     except
         on e: Exception do begin
@@ -1,9 +1,19 @@
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
 
 #include <lib/amgcl.h>
 #include "sample_problem.hpp"
 
+bool converged(const char *name, conv_info cnv, double tol) {
+    std::cout << name << ": "
+              << cnv.iterations << " iterations, error " << cnv.residual
+              << std::endl;
+    return cnv.residual <= tol;
+}
+
 int main() {
     std::vector<int>    ptr;
     std::vector<int>    col;
@@ -18,6 +28,7 @@ int main() {
     amgcl_params_sets(prm, "precond.coarsening.type", "smoothed_aggregation");
     amgcl_params_setf(prm, "precond.coarsening.aggr.eps_strong", 1e-3f);
     amgcl_params_sets(prm, "precond.relax.type", "spai0");
+    amgcl_params_seti(prm, "precond.allow_rebuild", 1);
 
     amgcl_params_sets(prm, "solver.type", "bicgstabl");
     amgcl_params_seti(prm, "solver.L", 1);
@@ -27,8 +38,6 @@ int main() {
             n, ptr.data(), col.data(), val.data(), prm
             );
 
-    amgcl_params_destroy(prm);
-
     std::vector<double> x(n, 0);
     conv_info cnv = amgcl_solver_solve(solver, rhs.data(), x.data());
 
@@ -39,8 +48,101 @@ int main() {
             rhs.data(), x.data()
             );
 
-    std::cout << "Iterations: " << cnv.iterations << std::endl
-              << "Error:      " << cnv.residual   << std::endl;
+    bool ok = converged("solve_mtx", cnv, 1e-8);
+
+    // Update the solver for the new matrix values (the sparsity pattern is
+    // the same):
+    std::vector<double> val2(val);
+    for(double &v : val2) v *= 2;
+
+    amgcl_solver_update(solver, ptr.data(), col.data(), val2.data());
+
+    std::fill(x.begin(), x.end(), 0);
+    ok = converged("update", amgcl_solver_solve(solver, rhs.data(), x.data()), 1e-8) && ok;
+
+    // Solve for several right-hand sides at once. The right-hand sides and
+    // the solutions are stored one after another:
+    const int nrhs = 3;
+    std::vector<double> F(nrhs * n), X(nrhs * n, 0.0);
+    for(int j = 0; j < nrhs; ++j)
+        for(int i = 0; i < n; ++i)
+            F[j * n + i] = (j + 1) * rhs[i];
+
+    ok = converged("solve_multi", amgcl_solver_solve_multi(solver, nrhs, F.data(), X.data()), 1e-8) && ok;
+
+    amgcl_solver_destroy(solver);
+
+    // Same with 1-based (Fortran) indices. The solution should match the one
+    // from the 0-based solver above.
+    std::vector<int> ptr_f(ptr), col_f(col);
+    for(int &p : ptr_f) ++p;
+    for(int &c : col_f) ++c;
+
+    solver = amgcl_solver_create_f(n, ptr_f.data(), col_f.data(), val.data(), prm);
+    amgcl_solver_update_f(solver, ptr_f.data(), col_f.data(), val2.data());
+
+    std::vector<double> y(n, 0);
+    ok = converged("update_f", amgcl_solver_solve(solver, rhs.data(), y.data()), 1e-8) && ok;
+
+    double diff = 0;
+    for(int i = 0; i < n; ++i)
+        diff = std::max(diff, std::abs(x[i] - y[i]));
+    std::cout << "update_f vs update: " << diff << std::endl;
+    ok = (diff < 1e-8) && ok;
 
     amgcl_solver_destroy(solver);
+
+    // Standalone preconditioner update. The preconditioner parameters are
+    // not prefixed with "precond." here:
+    amgclHandle amg_prm = amgcl_params_create();
+    amgcl_params_seti(amg_prm, "coarse_enough", 1000);
+    amgcl_params_sets(amg_prm, "relax.type", "spai0");
+    amgcl_params_seti(amg_prm, "allow_rebuild", 1);
+
+    amgclHandle amg = amgcl_precond_create(n, ptr.data(), col.data(), val.data(), amg_prm);
+    amgcl_precond_update(amg, ptr.data(), col.data(), val2.data());
+    amgcl_precond_apply(amg, rhs.data(), y.data());
+    amgcl_precond_destroy(amg);
+    amgcl_params_destroy(amg_prm);
+
+    // 64-bit indices:
+    {
+        std::vector<int64_t> ptr_l(ptr.begin(), ptr.end());
+        std::vector<int64_t> col_l(col.begin(), col.end());
+
+        amgclHandle s = amgcl_solver_create_l(n, ptr_l.data(), col_l.data(), val.data(), prm);
+        amgcl_solver_update_l(s, ptr_l.data(), col_l.data(), val2.data());
+
+        std::fill(y.begin(), y.end(), 0);
+        ok = converged("solve_l", amgcl_solver_solve_l(s, rhs.data(), y.data()), 1e-8) && ok;
+
+        std::fill(X.begin(), X.end(), 0);
+        ok = converged("solve_multi_l", amgcl_solver_solve_multi_l(s, nrhs, F.data(), X.data()), 1e-8) && ok;
+
+        amgcl_solver_destroy_l(s);
+    }
+
+    // Single precision values:
+    {
+        amgcl_params_setf(prm, "solver.tol", 1e-4f);
+
+        std::vector<float> val_s(val.begin(), val.end());
+        std::vector<float> val2_s(val2.begin(), val2.end());
+        std::vector<float> rhs_s(rhs.begin(), rhs.end());
+        std::vector<float> x_s(n, 0.0f);
+
+        amgclHandle s = amgcl_solver_create_s(n, ptr.data(), col.data(), val_s.data(), prm);
+        amgcl_solver_update_s(s, ptr.data(), col.data(), val2_s.data());
+
+        ok = converged("solve_s", amgcl_solver_solve_s(s, rhs_s.data(), x_s.data()), 1e-4) && ok;
+
+        std::vector<float> F_s(F.begin(), F.end()), X_s(nrhs * n, 0.0f);
+        ok = converged("solve_multi_s", amgcl_solver_solve_multi_s(s, nrhs, F_s.data(), X_s.data()), 1e-4) && ok;
+
+        amgcl_solver_destroy_s(s);
+    }
+
+    amgcl_params_destroy(prm);
+
+    return ok ? 0 : 1;
 }
@@ -494,12 +494,12 @@ int main(int argc, char *argv[]) {
         (
          "deflation,v",
          po::value<std::string>(&deflation_type)->default_value(deflation_type),
-         "constant, partitioned, linear, bilinear, mba, harmonic"
+         "constant, partitioned, linear, bilinear, mba, harmonic, eigen"
         )
         (
          "subparts",
          po::value<int>()->default_value(16),
-         "number of partitions for partitioned deflation"
+         "number of partitions for partitioned deflation, or number of eigenvectors for eigen deflation"
         )
         (
          "params,P",
@@ -598,6 +598,8 @@ int main(int argc, char *argv[]) {
         harmonic_deflation hd(n, chunk, lo, hi);
         ndv = hd.dim();
         dv  = hd;
+    } else if (deflation_type == "eigen") {
+        prm.put("num_eig_vec", vm["subparts"].as<int>());
     } else {
         throw std::runtime_error("Unsupported deflation type");
     }
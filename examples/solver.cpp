@@ -95,7 +95,7 @@ std::tuple<size_t, double> block_solve(
         prof.toc("reorder");
 
         prof.tic("setup");
-        Solver solve(perm(A), prm);
+        Solver solve(perm.materialize(A), prm);
         prof.toc("setup");
 
         std::cout << solve.precond() << std::endl;
@@ -178,7 +178,7 @@ std::tuple<size_t, double> block_solve(
         prof.toc("reorder");
 
         prof.tic("setup");
-        Solver solve(perm(A), prm, bprm);
+        Solver solve(perm.materialize(A), prm, bprm);
         prof.toc("setup");
 
         std::cout << solve.precond() << std::endl;
@@ -272,7 +272,7 @@ std::tuple<size_t, double> scalar_solve(
         prof.toc("reorder");
 
         prof.tic("setup");
-        Solver solve(perm(std::tie(rows, ptr, col, val)), prm, bprm);
+        Solver solve(perm.materialize(std::tie(rows, ptr, col, val)), prm, bprm);
         prof.toc("setup");
 
         std::cout << solve.precond() << std::endl;
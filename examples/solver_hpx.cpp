@@ -60,6 +60,7 @@ int hpx_main(boost::program_options::variables_map &vm) {
     prof.tic("solve");
     hpx::reset_active_counters();
     std::tie(iters, error) = solve(*f, *x);
+    x->wait();
     prof.toc("solve");
     std::cout
         << "Iters: " << iters << std::endl
@@ -3,7 +3,8 @@ module amgcl
     private
     public c_size_t, c_int, c_double, c_char, conv_info, &
         amgcl_params_create, amgcl_params_seti, amgcl_params_setf, amgcl_params_sets, amgcl_params_destroy, &
-        amgcl_solver_create, amgcl_solver_solve, amgcl_solver_report, amgcl_solver_destroy
+        amgcl_solver_create, amgcl_solver_update, amgcl_solver_solve, amgcl_solver_solve_multi, &
+        amgcl_solver_report, amgcl_solver_destroy
 
     type, bind(C) :: conv_info
         integer (c_int)    :: iterations
@@ -53,6 +54,14 @@ module amgcl
             integer (c_size_t), intent(in), value :: prm
         end function
 
+        subroutine amgcl_solver_update(solver, ptr, col, val) bind (C, name="amgcl_solver_update_f")
+            use iso_c_binding
+            integer (c_size_t), intent(in), value :: solver
+            integer (c_int),    intent(in)        :: ptr(*)
+            integer (c_int),    intent(in)        :: col(*)
+            real    (c_double), intent(in)        :: val(*)
+        end subroutine
+
         type(conv_info) &
         function amgcl_solver_solve(solver, rhs, x) bind (C, name="amgcl_solver_solve")
             use iso_c_binding
@@ -66,6 +75,20 @@ module amgcl
             end type
         end function
 
+        type(conv_info) &
+        function amgcl_solver_solve_multi(solver, nrhs, rhs, x) bind (C, name="amgcl_solver_solve_multi")
+            use iso_c_binding
+            integer (c_size_t), intent(in), value :: solver
+            integer (c_int),    intent(in), value :: nrhs
+            real    (c_double), intent(in)        :: rhs(*)
+            real    (c_double), intent(inout)     :: x(*)
+
+            type, bind(C) :: conv_info
+                integer (c_int)    :: iterations;
+                real    (c_double) :: residual
+            end type
+        end function
+
         subroutine amgcl_solver_report(solver) bind(C, name="amgcl_solver_report")
             use iso_c_binding
             integer (c_size_t), intent(in), value :: solver
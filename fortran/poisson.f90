@@ -64,6 +64,7 @@ program poisson
     params = amgcl_params_create()
     call amgcl_params_sets(params, "solver.type", "cg")
     call amgcl_params_setf(params, "solver.tol", 1e-6)
+    call amgcl_params_seti(params, "precond.allow_rebuild", 1)
 
     ! Create solver, printout its structure.
     solver = amgcl_solver_create(n2, ptr, col, val, params)
@@ -73,6 +74,14 @@ program poisson
     cnv = amgcl_solver_solve(solver, rhs, x)
     write(*,"('Iterations:', I3, ', residual: ', E13.6)") cnv%iterations, cnv%residual
 
+    ! Change the matrix values (keeping the sparsity pattern), update the
+    ! solver, and solve the new system, starting from the previous solution.
+    val = 2 * val
+    call amgcl_solver_update(solver, ptr, col, val)
+
+    cnv = amgcl_solver_solve(solver, rhs, x)
+    write(*,"('Iterations:', I3, ', residual: ', E13.6)") cnv%iterations, cnv%residual
+
     ! Destroy solver and parameter pack.
     call amgcl_solver_destroy(solver)
     call amgcl_params_destroy(params)
@@ -1,4 +1,6 @@
 #include <iostream>
+#include <algorithm>
+#include <cstdint>
 
 #include <type_traits>
 #include <boost/iterator/transform_iterator.hpp>
@@ -24,11 +26,190 @@ namespace amgcl {
 #endif
 
 //---------------------------------------------------------------------------
-typedef amgcl::backend::builtin<double>           Backend;
-typedef amgcl::amg<Backend, amgcl::runtime::coarsening::wrapper, amgcl::runtime::relaxation::wrapper> AMG;
-typedef amgcl::runtime::solver::wrapper<Backend>  ISolver;
-typedef amgcl::make_solver<AMG, ISolver>          Solver;
-typedef boost::property_tree::ptree               Params;
+//---------------------------------------------------------------------------
+// The solvers are instantiated for each of the supported combinations of the
+// value and the index types, so that the input arrays are used as they are,
+// without converting the indices.
+template <class Value, class Index>
+struct types {
+    typedef amgcl::backend::builtin<Value, Index> Backend;
+
+    typedef amgcl::amg<
+        Backend,
+        amgcl::runtime::coarsening::wrapper,
+        amgcl::runtime::relaxation::wrapper
+        > AMG;
+
+    typedef amgcl::runtime::solver::wrapper<Backend> ISolver;
+    typedef amgcl::make_solver<AMG, ISolver>         Solver;
+};
+
+typedef types<double, int>     types_d;
+typedef types<double, int64_t> types_l;
+typedef types<float,  int>     types_s;
+
+typedef boost::property_tree::ptree Params;
+
+// Converts 1-based (Fortran) indices to 0-based ones on the fly.
+struct one_based {
+    template <class T>
+    T operator()(T i) const { return i - 1; }
+};
+
+template <class B, template <class> class C, template <class> class R>
+size_t size(const amgcl::amg<B, C, R> &amg) {
+    return amgcl::backend::rows(amg.system_matrix());
+}
+
+template <class P, class S>
+size_t size(const amgcl::make_solver<P, S> &slv) {
+    return slv.size();
+}
+
+//---------------------------------------------------------------------------
+template <class Precond, class Index, class Value>
+amgclHandle create(
+        Index n, const Index *ptr, const Index *col, const Value *val,
+        amgclHandle prm, bool fortran
+        )
+{
+    Params p;
+    if (prm) p = *static_cast<Params*>(prm);
+
+    if (fortran) {
+        auto ptr_c = boost::make_transform_iterator(ptr, one_based());
+        auto col_c = boost::make_transform_iterator(col, one_based());
+
+        return static_cast<amgclHandle>(new Precond(std::make_tuple(n,
+                        boost::make_iterator_range(ptr_c, ptr_c + n + 1),
+                        boost::make_iterator_range(col_c, col_c + ptr[n]),
+                        boost::make_iterator_range(val, val + ptr[n])
+                        ), p));
+    } else {
+        return static_cast<amgclHandle>(new Precond(std::make_tuple(n,
+                        boost::make_iterator_range(ptr, ptr + n + 1),
+                        boost::make_iterator_range(col, col + ptr[n]),
+                        boost::make_iterator_range(val, val + ptr[n])
+                        ), p));
+    }
+}
+
+//---------------------------------------------------------------------------
+template <class Precond, class Index, class Value>
+void update(
+        amgclHandle handle,
+        const Index *ptr, const Index *col, const Value *val,
+        bool fortran
+        )
+{
+    Precond *P = static_cast<Precond*>(handle);
+
+    Index n = size(*P);
+
+    if (fortran) {
+        auto ptr_c = boost::make_transform_iterator(ptr, one_based());
+        auto col_c = boost::make_transform_iterator(col, one_based());
+
+        P->rebuild(std::make_tuple(n,
+                    boost::make_iterator_range(ptr_c, ptr_c + n + 1),
+                    boost::make_iterator_range(col_c, col_c + ptr[n]),
+                    boost::make_iterator_range(val, val + ptr[n])
+                    ));
+    } else {
+        P->rebuild(std::make_tuple(n,
+                    boost::make_iterator_range(ptr, ptr + n + 1),
+                    boost::make_iterator_range(col, col + ptr[n]),
+                    boost::make_iterator_range(val, val + ptr[n])
+                    ));
+    }
+}
+
+//---------------------------------------------------------------------------
+template <class AMG, class Value>
+void precond_apply(amgclHandle handle, const Value *rhs, Value *x) {
+    AMG *amg = static_cast<AMG*>(handle);
+
+    size_t n = size(*amg);
+
+    boost::iterator_range<Value*> x_range =
+        boost::make_iterator_range(x, x + n);
+
+    amg->apply(boost::make_iterator_range(rhs, rhs + n), x_range);
+}
+
+//---------------------------------------------------------------------------
+template <class Solver, class Value>
+conv_info solve(amgclHandle handle, const Value *rhs, Value *x) {
+    Solver *slv = static_cast<Solver*>(handle);
+
+    size_t n = slv->size();
+
+    conv_info cnv;
+
+    boost::iterator_range<Value*> x_range = boost::make_iterator_range(x, x + n);
+
+    std::tie(cnv.iterations, cnv.residual) = (*slv)(
+            boost::make_iterator_range(rhs, rhs + n), x_range
+            );
+
+    return cnv;
+}
+
+//---------------------------------------------------------------------------
+template <class Solver, class Index, class Value>
+conv_info solve_mtx(
+        amgclHandle handle,
+        const Index *A_ptr, const Index *A_col, const Value *A_val,
+        const Value *rhs, Value *x
+        )
+{
+    Solver *slv = static_cast<Solver*>(handle);
+
+    Index n = slv->size();
+
+    conv_info cnv;
+
+    boost::iterator_range<Value*> x_range = boost::make_iterator_range(x, x + n);
+
+    std::tie(cnv.iterations, cnv.residual) = (*slv)(
+            std::make_tuple(
+                n,
+                boost::make_iterator_range(A_ptr, A_ptr + n + 1),
+                boost::make_iterator_range(A_col, A_col + A_ptr[n]),
+                boost::make_iterator_range(A_val, A_val + A_ptr[n])
+                ),
+            boost::make_iterator_range(rhs, rhs + n), x_range
+            );
+
+    return cnv;
+}
+
+//---------------------------------------------------------------------------
+template <class Solver, class Value>
+conv_info solve_multi(amgclHandle handle, int nrhs, const Value *rhs, Value *x) {
+    Solver *slv = static_cast<Solver*>(handle);
+
+    size_t n = slv->size();
+
+    conv_info cnv = {0, 0.0};
+
+    for(int k = 0; k < nrhs; ++k) {
+        boost::iterator_range<Value*> x_range =
+            boost::make_iterator_range(x + k * n, x + (k + 1) * n);
+
+        int    iters;
+        double error;
+
+        std::tie(iters, error) = (*slv)(
+                boost::make_iterator_range(rhs + k * n, rhs + (k + 1) * n),
+                x_range);
+
+        cnv.iterations = std::max(cnv.iterations, iters);
+        cnv.residual   = std::max(cnv.residual,   error);
+    }
+
+    return cnv;
+}
 
 //---------------------------------------------------------------------------
 amgclHandle STDCALL amgcl_params_create() {
@@ -69,16 +250,7 @@ amgclHandle STDCALL amgcl_precond_create(
         amgclHandle   prm
         )
 {
-    auto A = std::make_tuple(n,
-            boost::make_iterator_range(ptr, ptr + n + 1),
-            boost::make_iterator_range(col, col + ptr[n]),
-            boost::make_iterator_range(val, val + ptr[n])
-            );
-
-    if (prm)
-        return static_cast<amgclHandle>(new AMG(A, *static_cast<Params*>(prm)));
-    else
-        return static_cast<amgclHandle>(new AMG(A));
+    return create<types_d::AMG>(n, ptr, col, val, prm, false);
 }
 
 //---------------------------------------------------------------------------
@@ -90,42 +262,44 @@ amgclHandle STDCALL amgcl_precond_create_f(
         amgclHandle   prm
         )
 {
-    auto ptr_c = boost::make_transform_iterator(ptr, [](int i){ return i - 1; });
-    auto col_c = boost::make_transform_iterator(col, [](int i){ return i - 1; });
-
-    auto A = std::make_tuple(n,
-            boost::make_iterator_range(ptr_c, ptr_c + n + 1),
-            boost::make_iterator_range(col_c, col_c + ptr[n]),
-            boost::make_iterator_range(val, val + ptr[n])
-            );
-
-    if (prm)
-        return static_cast<amgclHandle>(new AMG(A, *static_cast<Params*>(prm)));
-    else
-        return static_cast<amgclHandle>(new AMG(A));
+    return create<types_d::AMG>(n, ptr, col, val, prm, true);
 }
 
 //---------------------------------------------------------------------------
-void STDCALL amgcl_precond_apply(amgclHandle handle, const double *rhs, double *x)
+void STDCALL amgcl_precond_update(
+        amgclHandle   handle,
+        const int    *ptr,
+        const int    *col,
+        const double *val
+        )
 {
-    AMG *amg = static_cast<AMG*>(handle);
-
-    size_t n = amgcl::backend::rows(amg->system_matrix());
+    update<types_d::AMG>(handle, ptr, col, val, false);
+}
 
-    boost::iterator_range<double*> x_range =
-        boost::make_iterator_range(x, x + n);
+//---------------------------------------------------------------------------
+void STDCALL amgcl_precond_update_f(
+        amgclHandle   handle,
+        const int    *ptr,
+        const int    *col,
+        const double *val
+        )
+{
+    update<types_d::AMG>(handle, ptr, col, val, true);
+}
 
-    amg->apply(boost::make_iterator_range(rhs, rhs + n), x_range);
+//---------------------------------------------------------------------------
+void STDCALL amgcl_precond_apply(amgclHandle handle, const double *rhs, double *x) {
+    precond_apply<types_d::AMG>(handle, rhs, x);
 }
 
 //---------------------------------------------------------------------------
 void STDCALL amgcl_precond_report(amgclHandle handle) {
-    std::cout << *static_cast<AMG*>(handle) << std::endl;
+    std::cout << *static_cast<types_d::AMG*>(handle) << std::endl;
 }
 
 //---------------------------------------------------------------------------
 void STDCALL amgcl_precond_destroy(amgclHandle handle) {
-    delete static_cast<AMG*>(handle);
+    delete static_cast<types_d::AMG*>(handle);
 }
 
 //---------------------------------------------------------------------------
@@ -137,16 +311,7 @@ amgclHandle STDCALL amgcl_solver_create(
         amgclHandle   prm
         )
 {
-    auto A = std::make_tuple(n,
-            boost::make_iterator_range(ptr, ptr + n + 1),
-            boost::make_iterator_range(col, col + ptr[n]),
-            boost::make_iterator_range(val, val + ptr[n])
-            );
-
-    if (prm)
-        return static_cast<amgclHandle>(new Solver(A, *static_cast<Params*>(prm)));
-    else
-        return static_cast<amgclHandle>(new Solver(A));
+    return create<types_d::Solver>(n, ptr, col, val, prm, false);
 }
 
 //---------------------------------------------------------------------------
@@ -158,80 +323,373 @@ amgclHandle STDCALL amgcl_solver_create_f(
         amgclHandle   prm
         )
 {
-    auto ptr_c = boost::make_transform_iterator(ptr, [](int i){ return i - 1; });
-    auto col_c = boost::make_transform_iterator(col, [](int i){ return i - 1; });
+    return create<types_d::Solver>(n, ptr, col, val, prm, true);
+}
 
-    auto A = std::make_tuple(n,
-            boost::make_iterator_range(ptr_c, ptr_c + n + 1),
-            boost::make_iterator_range(col_c, col_c + ptr[n]),
-            boost::make_iterator_range(val, val + ptr[n])
-            );
+//---------------------------------------------------------------------------
+void STDCALL amgcl_solver_update(
+        amgclHandle   handle,
+        const int    *ptr,
+        const int    *col,
+        const double *val
+        )
+{
+    update<types_d::Solver>(handle, ptr, col, val, false);
+}
+
+//---------------------------------------------------------------------------
+void STDCALL amgcl_solver_update_f(
+        amgclHandle   handle,
+        const int    *ptr,
+        const int    *col,
+        const double *val
+        )
+{
+    update<types_d::Solver>(handle, ptr, col, val, true);
+}
+
+//---------------------------------------------------------------------------
+conv_info STDCALL amgcl_solver_solve(
+        amgclHandle   handle,
+        const double *rhs,
+        double       *x
+        )
+{
+    return solve<types_d::Solver>(handle, rhs, x);
+}
+
+//---------------------------------------------------------------------------
+conv_info STDCALL amgcl_solver_solve_mtx(
+        amgclHandle   handle,
+        const int    *A_ptr,
+        const int    *A_col,
+        const double *A_val,
+        const double *rhs,
+        double       *x
+        )
+{
+    return solve_mtx<types_d::Solver>(handle, A_ptr, A_col, A_val, rhs, x);
+}
 
-    if (prm)
-        return static_cast<amgclHandle>(new Solver(A, *static_cast<Params*>(prm)));
-    else
-        return static_cast<amgclHandle>(new Solver(A));
+//---------------------------------------------------------------------------
+conv_info STDCALL amgcl_solver_solve_multi(
+        amgclHandle   handle,
+        int           nrhs,
+        const double *rhs,
+        double       *x
+        )
+{
+    return solve_multi<types_d::Solver>(handle, nrhs, rhs, x);
 }
 
 //---------------------------------------------------------------------------
 void STDCALL amgcl_solver_report(amgclHandle handle) {
-    std::cout << static_cast<Solver*>(handle)->precond() << std::endl;
+    std::cout << static_cast<types_d::Solver*>(handle)->precond() << std::endl;
 }
 
 //---------------------------------------------------------------------------
 void STDCALL amgcl_solver_destroy(amgclHandle handle) {
-    delete static_cast<Solver*>(handle);
+    delete static_cast<types_d::Solver*>(handle);
 }
 
 //---------------------------------------------------------------------------
-conv_info STDCALL amgcl_solver_solve(
-        amgclHandle handle,
-        const double *rhs,
-        double *x
+amgclHandle STDCALL amgcl_precond_create_l(
+        int64_t        n,
+        const int64_t *ptr,
+        const int64_t *col,
+        const double  *val,
+        amgclHandle    prm
         )
 {
-    Solver *slv = static_cast<Solver*>(handle);
+    return create<types_l::AMG>(n, ptr, col, val, prm, false);
+}
 
-    size_t n = slv->size();
+//---------------------------------------------------------------------------
+amgclHandle STDCALL amgcl_precond_create_l_f(
+        int64_t        n,
+        const int64_t *ptr,
+        const int64_t *col,
+        const double  *val,
+        amgclHandle    prm
+        )
+{
+    return create<types_l::AMG>(n, ptr, col, val, prm, true);
+}
 
-    conv_info cnv;
+//---------------------------------------------------------------------------
+void STDCALL amgcl_precond_update_l(
+        amgclHandle    handle,
+        const int64_t *ptr,
+        const int64_t *col,
+        const double  *val
+        )
+{
+    update<types_l::AMG>(handle, ptr, col, val, false);
+}
 
-    boost::iterator_range<double*> x_range = boost::make_iterator_range(x, x + n);
+//---------------------------------------------------------------------------
+void STDCALL amgcl_precond_update_l_f(
+        amgclHandle    handle,
+        const int64_t *ptr,
+        const int64_t *col,
+        const double  *val
+        )
+{
+    update<types_l::AMG>(handle, ptr, col, val, true);
+}
 
-    std::tie(cnv.iterations, cnv.residual) = (*slv)(
-            boost::make_iterator_range(rhs, rhs + n), x_range
-            );
+//---------------------------------------------------------------------------
+void STDCALL amgcl_precond_apply_l(amgclHandle handle, const double *rhs, double *x) {
+    precond_apply<types_l::AMG>(handle, rhs, x);
+}
 
-    return cnv;
+//---------------------------------------------------------------------------
+void STDCALL amgcl_precond_report_l(amgclHandle handle) {
+    std::cout << *static_cast<types_l::AMG*>(handle) << std::endl;
 }
 
 //---------------------------------------------------------------------------
-conv_info STDCALL amgcl_solver_solve_mtx(
-        amgclHandle handle,
-        int    const * A_ptr,
-        int    const * A_col,
-        double const * A_val,
-        const double *rhs,
-        double *x
+void STDCALL amgcl_precond_destroy_l(amgclHandle handle) {
+    delete static_cast<types_l::AMG*>(handle);
+}
+
+//---------------------------------------------------------------------------
+amgclHandle STDCALL amgcl_solver_create_l(
+        int64_t        n,
+        const int64_t *ptr,
+        const int64_t *col,
+        const double  *val,
+        amgclHandle    prm
         )
 {
-    Solver *slv = static_cast<Solver*>(handle);
+    return create<types_l::Solver>(n, ptr, col, val, prm, false);
+}
 
-    size_t n = slv->size();
+//---------------------------------------------------------------------------
+amgclHandle STDCALL amgcl_solver_create_l_f(
+        int64_t        n,
+        const int64_t *ptr,
+        const int64_t *col,
+        const double  *val,
+        amgclHandle    prm
+        )
+{
+    return create<types_l::Solver>(n, ptr, col, val, prm, true);
+}
 
-    conv_info cnv;
+//---------------------------------------------------------------------------
+void STDCALL amgcl_solver_update_l(
+        amgclHandle    handle,
+        const int64_t *ptr,
+        const int64_t *col,
+        const double  *val
+        )
+{
+    update<types_l::Solver>(handle, ptr, col, val, false);
+}
 
-    boost::iterator_range<double*> x_range = boost::make_iterator_range(x, x + n);
+//---------------------------------------------------------------------------
+void STDCALL amgcl_solver_update_l_f(
+        amgclHandle    handle,
+        const int64_t *ptr,
+        const int64_t *col,
+        const double  *val
+        )
+{
+    update<types_l::Solver>(handle, ptr, col, val, true);
+}
 
-    std::tie(cnv.iterations, cnv.residual) = (*slv)(
-            std::make_tuple(
-                n,
-                boost::make_iterator_range(A_ptr, A_ptr + n),
-                boost::make_iterator_range(A_col, A_col + A_ptr[n]),
-                boost::make_iterator_range(A_val, A_val + A_ptr[n])
-                ),
-            boost::make_iterator_range(rhs, rhs + n), x_range
-            );
+//---------------------------------------------------------------------------
+conv_info STDCALL amgcl_solver_solve_l(
+        amgclHandle    handle,
+        const double  *rhs,
+        double        *x
+        )
+{
+    return solve<types_l::Solver>(handle, rhs, x);
+}
 
-    return cnv;
+//---------------------------------------------------------------------------
+conv_info STDCALL amgcl_solver_solve_mtx_l(
+        amgclHandle    handle,
+        const int64_t *A_ptr,
+        const int64_t *A_col,
+        const double  *A_val,
+        const double  *rhs,
+        double        *x
+        )
+{
+    return solve_mtx<types_l::Solver>(handle, A_ptr, A_col, A_val, rhs, x);
+}
+
+//---------------------------------------------------------------------------
+conv_info STDCALL amgcl_solver_solve_multi_l(
+        amgclHandle    handle,
+        int            nrhs,
+        const double  *rhs,
+        double        *x
+        )
+{
+    return solve_multi<types_l::Solver>(handle, nrhs, rhs, x);
+}
+
+//---------------------------------------------------------------------------
+void STDCALL amgcl_solver_report_l(amgclHandle handle) {
+    std::cout << static_cast<types_l::Solver*>(handle)->precond() << std::endl;
+}
+
+//---------------------------------------------------------------------------
+void STDCALL amgcl_solver_destroy_l(amgclHandle handle) {
+    delete static_cast<types_l::Solver*>(handle);
+}
+
+//---------------------------------------------------------------------------
+amgclHandle STDCALL amgcl_precond_create_s(
+        int          n,
+        const int   *ptr,
+        const int   *col,
+        const float *val,
+        amgclHandle  prm
+        )
+{
+    return create<types_s::AMG>(n, ptr, col, val, prm, false);
+}
+
+//---------------------------------------------------------------------------
+amgclHandle STDCALL amgcl_precond_create_s_f(
+        int          n,
+        const int   *ptr,
+        const int   *col,
+        const float *val,
+        amgclHandle  prm
+        )
+{
+    return create<types_s::AMG>(n, ptr, col, val, prm, true);
+}
+
+//---------------------------------------------------------------------------
+void STDCALL amgcl_precond_update_s(
+        amgclHandle  handle,
+        const int   *ptr,
+        const int   *col,
+        const float *val
+        )
+{
+    update<types_s::AMG>(handle, ptr, col, val, false);
+}
+
+//---------------------------------------------------------------------------
+void STDCALL amgcl_precond_update_s_f(
+        amgclHandle  handle,
+        const int   *ptr,
+        const int   *col,
+        const float *val
+        )
+{
+    update<types_s::AMG>(handle, ptr, col, val, true);
+}
+
+//---------------------------------------------------------------------------
+void STDCALL amgcl_precond_apply_s(amgclHandle handle, const float *rhs, float *x) {
+    precond_apply<types_s::AMG>(handle, rhs, x);
+}
+
+//---------------------------------------------------------------------------
+void STDCALL amgcl_precond_report_s(amgclHandle handle) {
+    std::cout << *static_cast<types_s::AMG*>(handle) << std::endl;
+}
+
+//---------------------------------------------------------------------------
+void STDCALL amgcl_precond_destroy_s(amgclHandle handle) {
+    delete static_cast<types_s::AMG*>(handle);
+}
+
+//---------------------------------------------------------------------------
+amgclHandle STDCALL amgcl_solver_create_s(
+        int          n,
+        const int   *ptr,
+        const int   *col,
+        const float *val,
+        amgclHandle  prm
+        )
+{
+    return create<types_s::Solver>(n, ptr, col, val, prm, false);
+}
+
+//---------------------------------------------------------------------------
+amgclHandle STDCALL amgcl_solver_create_s_f(
+        int          n,
+        const int   *ptr,
+        const int   *col,
+        const float *val,
+        amgclHandle  prm
+        )
+{
+    return create<types_s::Solver>(n, ptr, col, val, prm, true);
+}
+
+//---------------------------------------------------------------------------
+void STDCALL amgcl_solver_update_s(
+        amgclHandle  handle,
+        const int   *ptr,
+        const int   *col,
+        const float *val
+        )
+{
+    update<types_s::Solver>(handle, ptr, col, val, false);
+}
+
+//---------------------------------------------------------------------------
+void STDCALL amgcl_solver_update_s_f(
+        amgclHandle  handle,
+        const int   *ptr,
+        const int   *col,
+        const float *val
+        )
+{
+    update<types_s::Solver>(handle, ptr, col, val, true);
+}
+
+//---------------------------------------------------------------------------
+conv_info STDCALL amgcl_solver_solve_s(
+        amgclHandle  handle,
+        const float *rhs,
+        float       *x
+        )
+{
+    return solve<types_s::Solver>(handle, rhs, x);
+}
+
+//---------------------------------------------------------------------------
+conv_info STDCALL amgcl_solver_solve_mtx_s(
+        amgclHandle  handle,
+        const int   *A_ptr,
+        const int   *A_col,
+        const float *A_val,
+        const float *rhs,
+        float       *x
+        )
+{
+    return solve_mtx<types_s::Solver>(handle, A_ptr, A_col, A_val, rhs, x);
+}
+
+//---------------------------------------------------------------------------
+conv_info STDCALL amgcl_solver_solve_multi_s(
+        amgclHandle  handle,
+        int          nrhs,
+        const float *rhs,
+        float       *x
+        )
+{
+    return solve_multi<types_s::Solver>(handle, nrhs, rhs, x);
+}
+
+//---------------------------------------------------------------------------
+void STDCALL amgcl_solver_report_s(amgclHandle handle) {
+    std::cout << static_cast<types_s::Solver*>(handle)->precond() << std::endl;
+}
+
+//---------------------------------------------------------------------------
+void STDCALL amgcl_solver_destroy_s(amgclHandle handle) {
+    delete static_cast<types_s::Solver*>(handle);
 }
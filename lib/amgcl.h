@@ -31,6 +31,8 @@ THE SOFTWARE.
  * \brief  C wrapper interface to amgcl.
  */
 
+#include <stdint.h>
+
 #ifdef WIN32
 #  define STDCALL __stdcall
 #else
@@ -80,6 +82,27 @@ amgclHandle STDCALL amgcl_precond_create_f(
         amgclHandle   parameters
         );
 
+// Update AMG preconditioner for the new matrix values.
+// The sparsity pattern of the matrix should not change. The transfer
+// operators are reused, so that only the coarse operators, the smoothers and
+// the coarse solver are recomputed. Requires "allow_rebuild" parameter to be
+// set on creation.
+void STDCALL amgcl_precond_update(
+        amgclHandle   amg,
+        const int    *ptr,
+        const int    *col,
+        const double *val
+        );
+
+// Update AMG preconditioner for the new matrix values.
+// ptr and col arrays are 1-based (as in Fortran).
+void STDCALL amgcl_precond_update_f(
+        amgclHandle   amg,
+        const int    *ptr,
+        const int    *col,
+        const double *val
+        );
+
 // Apply AMG preconditioner (x = M^(-1) * rhs).
 void STDCALL amgcl_precond_apply(amgclHandle amg, const double *rhs, double *x);
 
@@ -114,7 +137,28 @@ struct conv_info {
     double residual;
 };
 
+// Update the solver for the new matrix values.
+// The sparsity pattern of the matrix should not change. Requires
+// "precond.allow_rebuild" parameter to be set on creation.
+void STDCALL amgcl_solver_update(
+        amgclHandle   solver,
+        const int    *ptr,
+        const int    *col,
+        const double *val
+        );
+
+// Update the solver for the new matrix values.
+// ptr and col arrays are 1-based (as in Fortran).
+void STDCALL amgcl_solver_update_f(
+        amgclHandle   solver,
+        const int    *ptr,
+        const int    *col,
+        const double *val
+        );
+
 // Solve the problem for the given right-hand side.
+// x holds the initial approximation on input (fill it with zeros when no
+// better guess is available), and the solution on output.
 conv_info STDCALL amgcl_solver_solve(
         amgclHandle    solver,
         double const * rhs,
@@ -122,6 +166,7 @@ conv_info STDCALL amgcl_solver_solve(
         );
 
 // Solve the problem for the given matrix and the right-hand side.
+// x holds the initial approximation on input and the solution on output.
 conv_info STDCALL amgcl_solver_solve_mtx(
         amgclHandle    solver,
         int    const * A_ptr,
@@ -131,12 +176,217 @@ conv_info STDCALL amgcl_solver_solve_mtx(
         double       * x
         );
 
+// Solve the problem for several right-hand sides.
+// The right-hand sides and the solutions are stored one after another in rhs
+// and x (that is, as n-by-nrhs column-major arrays). x holds the initial
+// approximations on input and the solutions on output. Returns the maximum
+// number of iterations and the maximum residual over all right-hand sides.
+conv_info STDCALL amgcl_solver_solve_multi(
+        amgclHandle    solver,
+        int            nrhs,
+        double const * rhs,
+        double       * x
+        );
+
 // Printout solver structure
 void STDCALL amgcl_solver_report(amgclHandle solver);
 
 // Destroy iterative solver.
 void STDCALL amgcl_solver_destroy(amgclHandle solver);
 
+/*
+ * Variants of the functions above for other index and value types. The
+ * suffix _l stands for 64-bit indices, and the suffix _s stands for single
+ * precision values. The semantics are the same as above. A handle may only be
+ * passed to the functions of the variant that created it.
+ */
+
+// 64-bit indices (int64_t), double precision values.
+amgclHandle STDCALL amgcl_precond_create_l(
+        int64_t        n,
+        const int64_t *ptr,
+        const int64_t *col,
+        const double  *val,
+        amgclHandle    parameters
+        );
+
+amgclHandle STDCALL amgcl_precond_create_l_f(
+        int64_t        n,
+        const int64_t *ptr,
+        const int64_t *col,
+        const double  *val,
+        amgclHandle    parameters
+        );
+
+void STDCALL amgcl_precond_update_l(
+        amgclHandle    amg,
+        const int64_t *ptr,
+        const int64_t *col,
+        const double  *val
+        );
+
+void STDCALL amgcl_precond_update_l_f(
+        amgclHandle    amg,
+        const int64_t *ptr,
+        const int64_t *col,
+        const double  *val
+        );
+
+void STDCALL amgcl_precond_apply_l(amgclHandle amg, const double *rhs, double *x);
+
+void STDCALL amgcl_precond_report_l(amgclHandle amg);
+
+void STDCALL amgcl_precond_destroy_l(amgclHandle amg);
+
+amgclHandle STDCALL amgcl_solver_create_l(
+        int64_t        n,
+        const int64_t *ptr,
+        const int64_t *col,
+        const double  *val,
+        amgclHandle    parameters
+        );
+
+amgclHandle STDCALL amgcl_solver_create_l_f(
+        int64_t        n,
+        const int64_t *ptr,
+        const int64_t *col,
+        const double  *val,
+        amgclHandle    parameters
+        );
+
+void STDCALL amgcl_solver_update_l(
+        amgclHandle    solver,
+        const int64_t *ptr,
+        const int64_t *col,
+        const double  *val
+        );
+
+void STDCALL amgcl_solver_update_l_f(
+        amgclHandle    solver,
+        const int64_t *ptr,
+        const int64_t *col,
+        const double  *val
+        );
+
+conv_info STDCALL amgcl_solver_solve_l(
+        amgclHandle    solver,
+        const double  *rhs,
+        double        *x
+        );
+
+conv_info STDCALL amgcl_solver_solve_mtx_l(
+        amgclHandle    solver,
+        const int64_t *A_ptr,
+        const int64_t *A_col,
+        const double  *A_val,
+        const double  *rhs,
+        double        *x
+        );
+
+conv_info STDCALL amgcl_solver_solve_multi_l(
+        amgclHandle    solver,
+        int            nrhs,
+        const double  *rhs,
+        double        *x
+        );
+
+void STDCALL amgcl_solver_report_l(amgclHandle solver);
+
+void STDCALL amgcl_solver_destroy_l(amgclHandle solver);
+
+// 32-bit indices (int), single precision values.
+amgclHandle STDCALL amgcl_precond_create_s(
+        int          n,
+        const int   *ptr,
+        const int   *col,
+        const float *val,
+        amgclHandle  parameters
+        );
+
+amgclHandle STDCALL amgcl_precond_create_s_f(
+        int          n,
+        const int   *ptr,
+        const int   *col,
+        const float *val,
+        amgclHandle  parameters
+        );
+
+void STDCALL amgcl_precond_update_s(
+        amgclHandle  amg,
+        const int   *ptr,
+        const int   *col,
+        const float *val
+        );
+
+void STDCALL amgcl_precond_update_s_f(
+        amgclHandle  amg,
+        const int   *ptr,
+        const int   *col,
+        const float *val
+        );
+
+void STDCALL amgcl_precond_apply_s(amgclHandle amg, const float *rhs, float *x);
+
+void STDCALL amgcl_precond_report_s(amgclHandle amg);
+
+void STDCALL amgcl_precond_destroy_s(amgclHandle amg);
+
+amgclHandle STDCALL amgcl_solver_create_s(
+        int          n,
+        const int   *ptr,
+        const int   *col,
+        const float *val,
+        amgclHandle  parameters
+        );
+
+amgclHandle STDCALL amgcl_solver_create_s_f(
+        int          n,
+        const int   *ptr,
+        const int   *col,
+        const float *val,
+        amgclHandle  parameters
+        );
+
+void STDCALL amgcl_solver_update_s(
+        amgclHandle  solver,
+        const int   *ptr,
+        const int   *col,
+        const float *val
+        );
+
+void STDCALL amgcl_solver_update_s_f(
+        amgclHandle  solver,
+        const int   *ptr,
+        const int   *col,
+        const float *val
+        );
+
+conv_info STDCALL amgcl_solver_solve_s(
+        amgclHandle  solver,
+        const float *rhs,
+        float       *x
+        );
+
+conv_info STDCALL amgcl_solver_solve_mtx_s(
+        amgclHandle  solver,
+        const int   *A_ptr,
+        const int   *A_col,
+        const float *A_val,
+        const float *rhs,
+        float       *x
+        );
+
+conv_info STDCALL amgcl_solver_solve_multi_s(
+        amgclHandle  solver,
+        int          nrhs,
+        const float *rhs,
+        float       *x
+        );
+
+void STDCALL amgcl_solver_report_s(amgclHandle solver);
+
+void STDCALL amgcl_solver_destroy_s(amgclHandle solver);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
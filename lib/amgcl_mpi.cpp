@@ -16,15 +16,21 @@
 #include "amgcl_mpi.h"
 
 //---------------------------------------------------------------------------
-typedef amgcl::backend::builtin<double>                   Backend;
-typedef boost::property_tree::ptree                       Params;
+// The solver is instantiated for double and single precision values. The
+// indices are ptrdiff_t in both cases, as accepted by the builtin backend.
+template <class Value>
+struct types {
+    typedef amgcl::backend::builtin<Value> Backend;
+
+    typedef
+        amgcl::mpi::subdomain_deflation<
+            amgcl::amg<Backend, amgcl::runtime::coarsening::wrapper, amgcl::runtime::relaxation::wrapper>,
+            amgcl::runtime::solver::wrapper,
+            amgcl::runtime::mpi::direct::solver<Value>
+        > Solver;
+};
 
-typedef
-    amgcl::mpi::subdomain_deflation<
-        amgcl::amg<Backend, amgcl::runtime::coarsening::wrapper, amgcl::runtime::relaxation::wrapper>,
-        amgcl::runtime::solver::wrapper,
-        amgcl::runtime::mpi::direct::solver<double>
-    > Solver;
+typedef boost::property_tree::ptree Params;
 
 //---------------------------------------------------------------------------
 struct deflation_vectors {
@@ -44,12 +50,13 @@ struct deflation_vectors {
 };
 
 //---------------------------------------------------------------------------
-amgclHandle STDCALL amgcl_mpi_create(
+template <class Solver, class Value>
+amgclHandle create(
         MPI_Comm             comm,
         ptrdiff_t            n,
         const ptrdiff_t     *ptr,
         const ptrdiff_t     *col,
-        const double        *val,
+        const Value         *val,
         int                  n_def_vec,
         amgclDefVecFunction  def_vec_func,
         void                *def_vec_data,
@@ -76,17 +83,18 @@ amgclHandle STDCALL amgcl_mpi_create(
 }
 
 //---------------------------------------------------------------------------
-conv_info STDCALL amgcl_mpi_solve(
-        amgclHandle   handle,
-        double const *rhs,
-        double       *x
+template <class Solver, class Value>
+conv_info solve(
+        amgclHandle  handle,
+        Value const *rhs,
+        Value       *x
         )
 {
     Solver *solver = static_cast<Solver*>(handle);
 
     size_t n = solver->size();
 
-    boost::iterator_range<double*> x_range =
+    boost::iterator_range<Value*> x_range =
         boost::make_iterator_range(x, x + n);
 
     conv_info cnv;
@@ -98,7 +106,66 @@ conv_info STDCALL amgcl_mpi_solve(
     return cnv;
 }
 
+//---------------------------------------------------------------------------
+amgclHandle STDCALL amgcl_mpi_create(
+        MPI_Comm             comm,
+        ptrdiff_t            n,
+        const ptrdiff_t     *ptr,
+        const ptrdiff_t     *col,
+        const double        *val,
+        int                  n_def_vec,
+        amgclDefVecFunction  def_vec_func,
+        void                *def_vec_data,
+        amgclHandle          params
+        )
+{
+    return create<types<double>::Solver>(comm, n, ptr, col, val,
+            n_def_vec, def_vec_func, def_vec_data, params);
+}
+
+//---------------------------------------------------------------------------
+conv_info STDCALL amgcl_mpi_solve(
+        amgclHandle   handle,
+        double const *rhs,
+        double       *x
+        )
+{
+    return solve<types<double>::Solver>(handle, rhs, x);
+}
+
 //---------------------------------------------------------------------------
 void STDCALL amgcl_mpi_destroy(amgclHandle handle) {
-    delete static_cast<Solver*>(handle);
+    delete static_cast<types<double>::Solver*>(handle);
+}
+
+//---------------------------------------------------------------------------
+amgclHandle STDCALL amgcl_mpi_create_s(
+        MPI_Comm             comm,
+        ptrdiff_t            n,
+        const ptrdiff_t     *ptr,
+        const ptrdiff_t     *col,
+        const float         *val,
+        int                  n_def_vec,
+        amgclDefVecFunction  def_vec_func,
+        void                *def_vec_data,
+        amgclHandle          params
+        )
+{
+    return create<types<float>::Solver>(comm, n, ptr, col, val,
+            n_def_vec, def_vec_func, def_vec_data, params);
+}
+
+//---------------------------------------------------------------------------
+conv_info STDCALL amgcl_mpi_solve_s(
+        amgclHandle  handle,
+        float const *rhs,
+        float       *x
+        )
+{
+    return solve<types<float>::Solver>(handle, rhs, x);
+}
+
+//---------------------------------------------------------------------------
+void STDCALL amgcl_mpi_destroy_s(amgclHandle handle) {
+    delete static_cast<types<float>::Solver*>(handle);
 }
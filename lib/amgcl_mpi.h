@@ -63,6 +63,29 @@ conv_info STDCALL amgcl_mpi_solve(
 // Destroy the distributed solver.
 void STDCALL amgcl_mpi_destroy(amgclHandle solver);
 
+// Single precision variants of the functions above. The indices are ptrdiff_t
+// (64-bit on 64-bit platforms) for both precisions. A handle may only be
+// passed to the functions of the variant that created it.
+amgclHandle STDCALL amgcl_mpi_create_s(
+        MPI_Comm             comm,
+        ptrdiff_t            n,
+        const ptrdiff_t     *ptr,
+        const ptrdiff_t     *col,
+        const float         *val,
+        int                  n_def_vec,
+        amgclDefVecFunction  def_vec_func,
+        void                *def_vec_data,
+        amgclHandle          params
+        );
+
+conv_info STDCALL amgcl_mpi_solve_s(
+        amgclHandle  solver,
+        float const *rhs,
+        float       *x
+        );
+
+void STDCALL amgcl_mpi_destroy_s(amgclHandle solver);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -30,10 +30,22 @@ class solver(pyamgcl_ext.solver):
         approximate the system matrix.  This saves time needed for rebuilding
         the preconditioner.
 
+        The right-hand side may be a vector, or a matrix with a right-hand side
+        in each column. In the latter case the solution has the same shape, and
+        the iters and error properties report the worst values over the
+        columns.
+
+        The Python global interpreter lock is released during the solution, so
+        that independent solvers may be used from several Python threads at
+        once. Several solvers may share a preconditioner, but the
+        preconditioner applications (one per iteration) are then serialized
+        with a lock, since the multigrid hierarchy keeps the work vectors of
+        the V-cycle. Create a preconditioner per thread when that matters.
+
         Parameters
         ----------
         A : the new system matrix (optional)
-        rhs : the right-hand side
+        rhs : the right-hand side (vector or matrix)
         """
         if len(args) == 1:
             return pyamgcl_ext.solver.__call__(self, args[0])
@@ -51,6 +63,15 @@ class amgcl(pyamgcl_ext.amgcl):
         """
         Creates algebraic multigrid hierarchy to be used as preconditioner.
 
+        The CRS arrays of the matrix are used in place when the indices are
+        int32 or int64 and the values are float32 or float64, which covers the
+        scipy.sparse matrices. The global interpreter lock is released during
+        the setup.
+
+        The preconditioner may be used from several threads at once, but its
+        applications are serialized with a lock, because the hierarchy keeps
+        the work vectors of the V-cycle.
+
         Parameters
         ----------
         A     The system matrix in scipy.sparse format
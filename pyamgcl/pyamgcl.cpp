@@ -2,6 +2,9 @@
 #include <string>
 #include <sstream>
 #include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <mutex>
 
 #include <boost/range/iterator_range.hpp>
 #include <boost/property_tree/ptree.hpp>
@@ -43,8 +46,8 @@ py::array_t<T> make_array(size_t n, T *ptr = nullptr) {
 }
 
 //---------------------------------------------------------------------------
-template <typename T>
-boost::iterator_range<T*> make_range(py::array_t<T> a) {
+template <typename T, int Flags>
+boost::iterator_range<T*> make_range(py::array_t<T, Flags> a) {
     py::buffer_info i = a.request();
 
     amgcl::precondition(i.ndim == 1,
@@ -55,6 +58,45 @@ boost::iterator_range<T*> make_range(py::array_t<T> a) {
             );
 }
 
+//---------------------------------------------------------------------------
+// Views a contiguous array of the given type in place. Arrays of other types
+// or with other layouts are converted.
+template <typename T>
+py::array_t<T, py::array::c_style | py::array::forcecast> as_array(py::array a) {
+    auto r = py::array_t<T, py::array::c_style | py::array::forcecast>::ensure(a);
+    amgcl::precondition(r, "Unsupported array type");
+    return r;
+}
+
+template <class Ptr, class Val, class Func>
+void call_crs(py::array ptr, py::array col, py::array val, const Func &f) {
+    auto p = as_array<Ptr>(ptr);
+    auto c = as_array<Ptr>(col);
+    auto v = as_array<Val>(val);
+
+    f(make_range(p), make_range(c), make_range(v));
+}
+
+//---------------------------------------------------------------------------
+// Calls f(ptr, col, val) with the CRS arrays viewed in place, when the
+// indices are int32 or int64 (the same type for ptr and col), and the values
+// are float32 or float64. This covers the arrays of scipy.sparse matrices
+// without a conversion.
+template <class Func>
+void dispatch_crs(py::array ptr, py::array col, py::array val, const Func &f) {
+    bool i32 = py::isinstance<py::array_t<int32_t>>(ptr)
+            && py::isinstance<py::array_t<int32_t>>(col);
+    bool f32 = py::isinstance<py::array_t<float>>(val);
+
+    if (i32) {
+        if (f32) call_crs<int32_t, float >(ptr, col, val, f);
+        else     call_crs<int32_t, double>(ptr, col, val, f);
+    } else {
+        if (f32) call_crs<int64_t, float >(ptr, col, val, f);
+        else     call_crs<int64_t, double>(ptr, col, val, f);
+    }
+}
+
 //---------------------------------------------------------------------------
 struct precond {
     typedef amgcl::backend::builtin<double> backend_type;
@@ -71,7 +113,10 @@ struct precond {
     py::array_t<double> call(py::array_t<double> rhs) const {
         vector x(rhs.size(), true);
         vector f(rhs.data(), rhs.data() + rhs.size());
-        this->apply(f, x);
+        {
+            py::gil_scoped_release release;
+            this->apply(f, x);
+        }
         return make_array(x.size(), x.data());
     }
 };
@@ -85,35 +130,20 @@ class solver
             : S(amgcl::backend::rows(P.system_matrix()), make_ptree(prm)), P(P)
         {}
 
-        py::array_t<double> solve(
-                py::array_t<int>    _ptr,
-                py::array_t<int>    _col,
-                py::array_t<double> _val,
-                py::array_t<double> _rhs
+        py::array solve(
+                py::array ptr,
+                py::array col,
+                py::array val,
+                py::array rhs
                 ) const
         {
-            auto ptr = make_range(_ptr);
-            auto col = make_range(_col);
-            auto val = make_range(_val);
-            auto rhs = make_range(_rhs);
-
-            size_t n = boost::size(rhs);
-            std::vector<double> x(n, 0.0);
-
-            std::tie(iters, error) = (*this)(
-                    std::make_tuple(n, ptr, col, val), P,
-                    std::vector<double>(boost::begin(rhs), boost::end(rhs)), x
-                    );
-
-            return make_array(x.size(), x.data());
+            py::array x;
+            dispatch_crs(ptr, col, val, solve_with_matrix(*this, rhs, x));
+            return x;
         }
 
-        py::array_t<double> solve(py::array_t<double> _rhs) const {
-            auto rhs = make_range(_rhs);
-            std::vector<double> x(boost::size(rhs), 0.0);
-            std::tie(iters, error) = (*this)(
-                    P, std::vector<double>(boost::begin(rhs), boost::end(rhs)), x);
-            return make_array(x.size(), x.data());
+        py::array solve(py::array rhs) const {
+            return solve(P.system_matrix(), rhs);
         }
 
         int iterations() const {
@@ -129,8 +159,70 @@ class solver
 
         const precond &P;
 
+        mutable std::mutex mx;
         mutable int    iters;
         mutable double error;
+
+        struct solve_with_matrix {
+            const solver &s;
+            py::array    rhs;
+            py::array    &x;
+
+            solve_with_matrix(const solver &s, py::array rhs, py::array &x)
+                : s(s), rhs(rhs), x(x) {}
+
+            template <class Ptr, class Col, class Val>
+            void operator()(Ptr ptr, Col col, Val val) const {
+                x = s.solve(std::make_tuple(boost::size(ptr) - 1, ptr, col, val), rhs);
+            }
+        };
+
+        // Solves for a vector, or for each column of a matrix of the
+        // right-hand sides. The GIL is released for the duration of the
+        // solution; concurrent calls to the same solver are serialized.
+        template <class Matrix>
+        py::array solve(const Matrix &A, py::array rhs) const {
+            auto f = py::array_t<double, py::array::f_style | py::array::forcecast>::ensure(rhs);
+            amgcl::precondition(f && (f.ndim() == 1 || f.ndim() == 2),
+                    "The right-hand side should be a vector or a matrix");
+
+            size_t n = f.shape(0);
+            size_t m = f.ndim() == 2 ? f.shape(1) : 1;
+
+            amgcl::precondition(n == amgcl::backend::rows(A),
+                    "The right-hand side has wrong size");
+
+            std::vector<size_t> shape(f.shape(), f.shape() + f.ndim());
+            py::array_t<double, py::array::f_style> x(shape);
+
+            const double *fp = f.data();
+            double       *xp = x.mutable_data();
+
+            std::fill(xp, xp + n * m, 0.0);
+
+            {
+                py::gil_scoped_release release;
+                std::lock_guard<std::mutex> lock(mx);
+
+                iters = 0;
+                error = 0;
+
+                for(size_t j = 0; j < m; ++j) {
+                    auto fr = boost::make_iterator_range(fp + j * n, fp + (j + 1) * n);
+                    auto xr = boost::make_iterator_range(xp + j * n, xp + (j + 1) * n);
+
+                    size_t it;
+                    double e;
+
+                    std::tie(it, e) = (*this)(A, P, fr, xr);
+
+                    iters = std::max<int>(iters, it);
+                    error = std::max(error, e);
+                }
+            }
+
+            return x;
+        }
 };
 
 //---------------------------------------------------------------------------
@@ -139,23 +231,17 @@ class amg_precond: public precond
 {
     public:
         amg_precond(
-            py::array_t<int>    _ptr,
-            py::array_t<int>    _col,
-            py::array_t<double> _val,
+            py::array ptr,
+            py::array col,
+            py::array val,
             py::dict prm
            )
         {
-            auto ptr = make_range(_ptr);
-            auto col = make_range(_col);
-            auto val = make_range(_val);
-
-            P = std::make_shared<Precond>(
-                    std::make_tuple(boost::size(ptr) - 1, ptr, col, val),
-                    make_ptree(prm)
-                    );
+            dispatch_crs(ptr, col, val, build(P, make_ptree(prm)));
         }
 
         void apply(const precond::vector& rhs, precond::vector &x) const {
+            std::lock_guard<std::mutex> lock(mx);
             P->apply(rhs, x);
         }
 
@@ -171,6 +257,25 @@ class amg_precond: public precond
 
     private:
         std::shared_ptr<Precond> P;
+
+        // The hierarchy keeps temporary vectors that are used during
+        // application, so concurrent applications are serialized.
+        mutable std::mutex mx;
+
+        struct build {
+            std::shared_ptr<Precond>    &P;
+            boost::property_tree::ptree prm;
+
+            build(std::shared_ptr<Precond> &P, const boost::property_tree::ptree &prm)
+                : P(P), prm(prm) {}
+
+            template <class Ptr, class Col, class Val>
+            void operator()(Ptr ptr, Col col, Val val) const {
+                py::gil_scoped_release release;
+                P = std::make_shared<Precond>(
+                        std::make_tuple(boost::size(ptr) - 1, ptr, col, val), prm);
+            }
+        };
 };
 
 //---------------------------------------------------------------------------
@@ -186,7 +291,7 @@ PYBIND11_MODULE(pyamgcl_ext, m) {
 
     typedef amg_precond<amgcl::runtime::preconditioner<Backend>> AMG;
     py::class_<AMG>(m, "amgcl", Precond)
-        .def(py::init<py::array_t<int>, py::array_t<int>, py::array_t<double>, py::dict>());
+        .def(py::init<py::array, py::array, py::array, py::dict>());
 
     py::class_<solver>(m, "solver")
         .def(py::init<
@@ -194,9 +299,9 @@ PYBIND11_MODULE(pyamgcl_ext, m) {
                 py::dict
                 >()
             )
-        .def("__call__", (py::array_t<double> (solver::*)(py::array_t<double>) const) &solver::solve)
-        .def("__call__", (py::array_t<double> (solver::*)(
-                        py::array_t<int>, py::array_t<int>, py::array_t<double>, py::array_t<double>) const
+        .def("__call__", (py::array (solver::*)(py::array) const) &solver::solve)
+        .def("__call__", (py::array (solver::*)(
+                        py::array, py::array, py::array, py::array) const
                     ) &solver::solve)
         .def_property_readonly("iters", &solver::iterations)
         .def_property_readonly("error", &solver::residual)
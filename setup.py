@@ -110,6 +110,6 @@ setup(
                 language='c++'
                 )
             ],
-        install_requires=['pybind11>=1.7'],
+        install_requires=['pybind11>=2.2'],
         cmdclass={'build_ext': BuildExt},
 )
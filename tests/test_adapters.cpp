@@ -0,0 +1,275 @@
+#define BOOST_TEST_MODULE TestAdapters
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <map>
+#include <utility>
+#include <cstdint>
+#include <cmath>
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/adapter/element_assembler.hpp>
+#include <amgcl/adapter/coo.hpp>
+#include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/make_solver.hpp>
+#include <amgcl/make_reordered_solver.hpp>
+#include <amgcl/amg.hpp>
+#include <amgcl/coarsening/smoothed_aggregation.hpp>
+#include <amgcl/relaxation/spai0.hpp>
+#include <amgcl/solver/cg.hpp>
+
+#include "sample_problem.hpp"
+
+typedef std::map<std::pair<ptrdiff_t, ptrdiff_t>, double> dok_matrix;
+
+// Deterministic pseudo-random value in [-1, 1).
+double pseudo_random(uint64_t i) {
+    uint64_t x = (i + 1) * 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return 2.0 * static_cast<double>(x >> 11) / 9007199254740992.0 - 1.0;
+}
+
+// Checks that the CRS matrix is the same as the reference one.
+template <class Matrix>
+void check_matrix(const Matrix &A, const dok_matrix &ref) {
+    BOOST_REQUIRE_EQUAL(A.nnz, ref.size());
+
+    auto r = ref.begin();
+    for(size_t i = 0; i < A.nrows; ++i) {
+        for(ptrdiff_t j = A.ptr[i]; j < A.ptr[i+1]; ++j, ++r) {
+            BOOST_REQUIRE_EQUAL(static_cast<ptrdiff_t>(i), r->first.first);
+            BOOST_REQUIRE_EQUAL(A.col[j], r->first.second);
+            BOOST_CHECK_CLOSE(A.val[j], r->second, 1e-10);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( test_adapters )
+
+BOOST_AUTO_TEST_CASE(element_assembler)
+{
+    // Mesh of a rectangle with n x n nodes. The odd cells are split into two
+    // triangles, and the even cells are quadrilaterals, so that the elements
+    // have different sizes.
+    const ptrdiff_t n = 17;
+
+    std::vector<ptrdiff_t> eptr(1, 0);
+    std::vector<ptrdiff_t> enodes;
+
+    for(ptrdiff_t j = 0; j + 1 < n; ++j) {
+        for(ptrdiff_t i = 0; i + 1 < n; ++i) {
+            ptrdiff_t a = j * n + i, b = a + 1, c = a + n + 1, d = a + n;
+
+            if ((i + j) % 2) {
+                enodes.push_back(a); enodes.push_back(b); enodes.push_back(c);
+                eptr.push_back(enodes.size());
+
+                enodes.push_back(c); enodes.push_back(d); enodes.push_back(a);
+                eptr.push_back(enodes.size());
+            } else {
+                enodes.push_back(a); enodes.push_back(b);
+                enodes.push_back(c); enodes.push_back(d);
+                eptr.push_back(enodes.size());
+            }
+        }
+    }
+
+    const size_t nnodes = n * n;
+    const size_t nelems = eptr.size() - 1;
+
+    amgcl::adapter::element_assembler<double> assemble(
+            nnodes, nelems, eptr.data(), enodes.data());
+
+    for(int pass = 0; pass < 2; ++pass) {
+        // Element matrices and the reference assembly.
+        std::vector<double> Ke;
+        dok_matrix ref;
+
+        for(size_t e = 0; e < nelems; ++e) {
+            for(ptrdiff_t i = eptr[e]; i < eptr[e+1]; ++i) {
+                for(ptrdiff_t j = eptr[e]; j < eptr[e+1]; ++j) {
+                    double v = pseudo_random(pass * 1000003 + Ke.size());
+                    Ke.push_back(v);
+                    ref[std::make_pair(enodes[i], enodes[j])] += v;
+                }
+            }
+        }
+
+        BOOST_REQUIRE_EQUAL(assemble.size(), Ke.size());
+
+        // The second pass reassembles the values into the kept matrix.
+        auto A = assemble(Ke);
+
+        BOOST_CHECK_EQUAL(A->nrows, nnodes);
+        BOOST_CHECK_EQUAL(A->ncols, nnodes);
+
+        check_matrix(*A, ref);
+    }
+
+    // The same mesh with the fixed element size.
+    std::vector<ptrdiff_t> tri;
+    for(ptrdiff_t j = 0; j + 1 < n; ++j) {
+        for(ptrdiff_t i = 0; i + 1 < n; ++i) {
+            ptrdiff_t a = j * n + i, b = a + 1, c = a + n + 1, d = a + n;
+            tri.push_back(a); tri.push_back(b); tri.push_back(c);
+            tri.push_back(c); tri.push_back(d); tri.push_back(a);
+        }
+    }
+
+    const size_t ntri = tri.size() / 3;
+
+    amgcl::adapter::element_assembler<double> assemble_tri(
+            nnodes, ntri, 3, tri.data());
+
+    std::vector<double> Ke;
+    dok_matrix ref;
+
+    for(size_t e = 0; e < ntri; ++e) {
+        for(int i = 0; i < 3; ++i) {
+            for(int j = 0; j < 3; ++j) {
+                double v = pseudo_random(Ke.size());
+                Ke.push_back(v);
+                ref[std::make_pair(tri[3 * e + i], tri[3 * e + j])] += v;
+            }
+        }
+    }
+
+    check_matrix(*assemble_tri(Ke), ref);
+}
+
+BOOST_AUTO_TEST_CASE(coo_to_crs)
+{
+    // Random triplets with many duplicates, in no particular order. The
+    // matrix is rectangular, and most of its rows are empty.
+    const size_t nrows = 300;
+    const size_t ncols = 400;
+    const size_t nnz   = 20000;
+
+    std::vector<ptrdiff_t> row(nnz), col(nnz);
+    std::vector<double>    val(nnz);
+
+    for(size_t k = 0; k < nnz; ++k) {
+        row[k] = static_cast<ptrdiff_t>((pseudo_random(3 * k) + 1) / 2 * nrows) % 100 * 3;
+        col[k] = static_cast<ptrdiff_t>((pseudo_random(3 * k + 1) + 1) / 2 * ncols) % 50 * 8;
+        val[k] = pseudo_random(3 * k + 2);
+    }
+
+    dok_matrix ref;
+    for(size_t k = 0; k < nnz; ++k)
+        ref[std::make_pair(row[k], col[k])] += val[k];
+
+    // Most of the triplets should be duplicates.
+    BOOST_REQUIRE_LT(ref.size(), nnz / 2);
+
+    auto A = amgcl::adapter::coo(nrows, ncols, nnz, row.data(), col.data(), val.data());
+
+    BOOST_CHECK_EQUAL(A->nrows, nrows);
+    BOOST_CHECK_EQUAL(A->ncols, ncols);
+
+    check_matrix(*A, ref);
+
+    // New values for the same triplets.
+    amgcl::adapter::coo_to_crs<double> convert(nrows, ncols, nnz, row.data(), col.data());
+
+    BOOST_REQUIRE_EQUAL(convert.size(), nnz);
+
+    for(size_t k = 0; k < nnz; ++k) val[k] = pseudo_random(nnz + k);
+
+    ref.clear();
+    for(size_t k = 0; k < nnz; ++k)
+        ref[std::make_pair(row[k], col[k])] += val[k];
+
+    check_matrix(*convert(val), ref);
+}
+
+BOOST_AUTO_TEST_CASE(coo_to_crs_large_rows)
+{
+    // With 32-bit indices and more than 2^24 rows the radix sort needs all
+    // four bytes of the row keys, and must not shift past the key width.
+    const int nrows = (1 << 24) + 10;
+    const int ncols = 100;
+    const int nnz   = 1000;
+
+    std::vector<int>    row(nnz), col(nnz);
+    std::vector<double> val(nnz);
+
+    for(int k = 0; k < nnz; ++k) {
+        row[k] = (k % 2) ? nrows - 1 - k % 17 : static_cast<int>(
+                (pseudo_random(3 * k) + 1) / 2 * nrows) % nrows;
+        col[k] = static_cast<int>((pseudo_random(3 * k + 1) + 1) / 2 * ncols) % ncols;
+        val[k] = pseudo_random(3 * k + 2);
+    }
+
+    dok_matrix ref;
+    for(int k = 0; k < nnz; ++k)
+        ref[std::make_pair(row[k], col[k])] += val[k];
+
+    amgcl::adapter::coo_to_crs<double, int> convert(nrows, ncols, nnz, row.data(), col.data());
+
+    auto A = convert(val);
+
+    BOOST_CHECK_EQUAL(A->nrows, static_cast<size_t>(nrows));
+    check_matrix(*A, ref);
+}
+
+BOOST_AUTO_TEST_CASE(reordered_solver)
+{
+    typedef amgcl::backend::builtin<double> Backend;
+
+    typedef amgcl::amg<
+        Backend,
+        amgcl::coarsening::smoothed_aggregation,
+        amgcl::relaxation::spai0
+        > Precond;
+
+    typedef amgcl::solver::cg<Backend> Solver;
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    size_t n = sample_problem(24, val, col, ptr, rhs);
+
+    // Non-uniform right-hand side, so that the permutations of the vectors
+    // matter.
+    for(size_t i = 0; i < n; ++i) rhs[i] = pseudo_random(i);
+
+    auto A = std::tie(n, ptr, col, val);
+
+    amgcl::make_solver<Precond, Solver>::params prm;
+    prm.solver.tol = 1e-10;
+
+    amgcl::make_solver<Precond, Solver>           solve(A, prm);
+    amgcl::make_reordered_solver<Precond, Solver> solve_reordered(A, prm);
+
+    std::vector<double> x0(n, 0.0), x1(n, 0.0);
+
+    size_t iters[2];
+    double resid[2];
+
+    std::tie(iters[0], resid[0]) = solve(rhs, x0);
+    std::tie(iters[1], resid[1]) = solve_reordered(rhs, x1);
+
+    BOOST_CHECK_SMALL(resid[0], 1e-10);
+    BOOST_CHECK_SMALL(resid[1], 1e-10);
+
+    // The solution is returned in the original numbering.
+    double d = 0, s = 0;
+    for(size_t i = 0; i < n; ++i) {
+        d += (x0[i] - x1[i]) * (x0[i] - x1[i]);
+        s += x0[i] * x0[i];
+    }
+
+    BOOST_CHECK_SMALL(std::sqrt(d / s), 1e-8);
+
+    std::vector<double> r(n);
+    amgcl::backend::residual(rhs, A, x1, r);
+    BOOST_CHECK_SMALL(
+            std::sqrt(amgcl::backend::inner_product(r, r) / amgcl::backend::inner_product(rhs, rhs)),
+            1e-9);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -6,6 +6,7 @@ import pyamgcl as amg
 from numpy.linalg import norm
 from scipy.sparse import csr_matrix
 from scipy.sparse.linalg import bicgstab, LinearOperator
+from concurrent.futures import ThreadPoolExecutor
 
 def make_problem(n):
     h   = 1.0 / (n - 1)
@@ -55,6 +56,71 @@ class TestPyAMGCL(unittest.TestCase):
                 # Solve
                 x = solve(rhs)
 
+    def test_dtypes(self):
+        A, rhs = make_problem(100)
+
+        for itype in (np.int32, np.int64):
+            for vtype in (np.float32, np.float64):
+                B = csr_matrix((A.data.astype(vtype), A.indices, A.indptr), shape=A.shape)
+
+                # scipy may downcast the indices on construction:
+                B.indices = B.indices.astype(itype)
+                B.indptr  = B.indptr.astype(itype)
+
+                P = amg.amgcl(B)
+                solve = amg.solver(P, prm=dict(type='bicgstab', tol=1e-3, maxiter=1000))
+                x = solve(rhs)
+
+                self.assertTrue(norm(rhs - A * x) / norm(rhs) < 1e-3)
+
+    def test_batched_rhs(self):
+        A, rhs = make_problem(100)
+
+        P = amg.amgcl(A)
+        solve = amg.solver(P, prm=dict(type='bicgstab', tol=1e-3, maxiter=1000))
+
+        F = np.column_stack((rhs, 2 * rhs, np.random.rand(rhs.size)))
+        X = solve(F)
+
+        self.assertTrue(X.shape == F.shape)
+        for j in range(F.shape[1]):
+            self.assertTrue(norm(F[:,j] - A * X[:,j]) / norm(F[:,j]) < 1e-3)
+
+    def test_threads(self):
+        A, rhs = make_problem(100)
+
+        def run(k):
+            P = amg.amgcl(A)
+            solve = amg.solver(P, prm=dict(type='bicgstab', tol=1e-3, maxiter=1000))
+            x = solve(k * rhs)
+            return norm(k * rhs - A * x) / norm(k * rhs)
+
+        with ThreadPoolExecutor(4) as pool:
+            for e in pool.map(run, range(1, 5)):
+                self.assertTrue(e < 1e-3)
+
+    def test_shared_preconditioner(self):
+        A, rhs = make_problem(100)
+        P = amg.amgcl(A)
+
+        def run(k):
+            solve = amg.solver(P, prm=dict(type='bicgstab', tol=1e-3, maxiter=1000))
+            x = solve(k * rhs)
+            return norm(k * rhs - A * x) / norm(k * rhs)
+
+        with ThreadPoolExecutor(4) as pool:
+            for e in pool.map(run, range(1, 9)):
+                self.assertTrue(e < 1e-3)
+
+        # The preconditioner applied directly from several threads should
+        # give the same results as the serial application.
+        F = [np.random.rand(rhs.size) for k in range(8)]
+        X = [P(f) for f in F]
+
+        with ThreadPoolExecutor(4) as pool:
+            for x, y in zip(X, pool.map(P, F)):
+                self.assertTrue(norm(x - y) <= 1e-12 * norm(x))
+
     def test_preconditioner(self):
         A, rhs = make_problem(100)
 
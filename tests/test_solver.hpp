@@ -92,11 +92,11 @@ void test_rap(
     BOOST_CHECK_SMALL(resid, 1e-4);
 }
 
-template <class Backend, class value_type, class rhs_type>
+template <class Backend, class value_type, class rhs_type, class index_type>
 void test_problem(
         size_t n,
-        std::vector<ptrdiff_t>  ptr,
-        std::vector<ptrdiff_t>  col,
+        std::vector<index_type> ptr,
+        std::vector<index_type> col,
         std::vector<value_type> val,
         std::vector<rhs_type>   rhs
         )
@@ -178,15 +178,15 @@ void test_problem(
         } catch(const std::logic_error&) {}
     }
 }
-template <class Backend>
+template <class Backend, class index_type = ptrdiff_t>
 void test_backend() {
     typedef typename Backend::value_type value_type;
     typedef typename amgcl::math::rhs_of<value_type>::type rhs_type;
 
     // Poisson 3D
     {
-        std::vector<ptrdiff_t>  ptr;
-        std::vector<ptrdiff_t>  col;
+        std::vector<index_type> ptr;
+        std::vector<index_type> col;
         std::vector<value_type> val;
         std::vector<rhs_type>   rhs;
 
@@ -198,8 +198,8 @@ void test_backend() {
     // Trivial problem
 #if !defined(SOLVER_BACKEND_VIENNACL)
     {
-        std::vector<ptrdiff_t>  ptr;
-        std::vector<ptrdiff_t>  col;
+        std::vector<index_type> ptr;
+        std::vector<index_type> col;
         std::vector<value_type> val;
         std::vector<rhs_type>   rhs;
 
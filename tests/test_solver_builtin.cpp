@@ -1,6 +1,11 @@
 #define BOOST_TEST_MODULE TestSolvers
 #include <boost/test/unit_test.hpp>
 #include <amgcl/backend/builtin.hpp>
+#include <amgcl/adapter/crs_tuple.hpp>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
 
 #include "test_solver.hpp"
 
@@ -11,4 +16,173 @@ BOOST_AUTO_TEST_CASE(test_builtin_backend)
     test_backend< amgcl::backend::builtin<double> >();
 }
 
+BOOST_AUTO_TEST_CASE(test_builtin_backend_int32)
+{
+    test_backend< amgcl::backend::builtin<double, int>, int >();
+}
+
+BOOST_AUTO_TEST_CASE(test_builtin_rebuild)
+{
+    typedef amgcl::backend::builtin<double> Backend;
+    typedef amgcl::make_solver<
+        amgcl::amg<Backend, amgcl::runtime::coarsening::wrapper, amgcl::runtime::relaxation::wrapper>,
+        amgcl::runtime::solver::wrapper<Backend>
+        > Solver;
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    size_t n = sample_problem(32, val, col, ptr, rhs);
+
+    amgcl::runtime::coarsening::type coarsening[] = {
+        amgcl::runtime::coarsening::ruge_stuben,
+        amgcl::runtime::coarsening::aggregation,
+        amgcl::runtime::coarsening::smoothed_aggregation,
+        amgcl::runtime::coarsening::smoothed_aggr_emin
+    };
+
+    for(amgcl::runtime::coarsening::type c : coarsening) {
+        std::cout << "Rebuild with " << c << std::endl;
+
+        boost::property_tree::ptree prm;
+        prm.put("precond.coarse_enough",   500);
+        prm.put("precond.coarsening.type", c);
+        prm.put("precond.allow_rebuild",   true);
+
+        std::vector<double> v = val;
+        Solver solve(std::tie(n, ptr, col, v), prm);
+
+        // Scale the matrix so that the values change but the pattern does
+        // not. The scaling is exact, so the transfer operators constructed
+        // for the new matrix from scratch are the same as the kept ones.
+        for(double &a : v) a *= 2;
+
+        solve.rebuild(std::tie(n, ptr, col, v));
+
+        // The rebuilt preconditioner should act the same as the one
+        // constructed from scratch for the new matrix.
+        prm.put("precond.allow_rebuild", false);
+        Solver fresh(std::tie(n, ptr, col, v), prm);
+
+        size_t iters[2];
+        double resid[2];
+
+        std::vector<double> x(n, 0.0);
+        std::tie(iters[0], resid[0]) = solve(std::tie(n, ptr, col, v), rhs, x);
+
+        std::fill(x.begin(), x.end(), 0.0);
+        std::tie(iters[1], resid[1]) = fresh(std::tie(n, ptr, col, v), rhs, x);
+
+        std::cout << "Iterations: " << iters[0] << " / " << iters[1] << std::endl
+                  << "Error:      " << resid[0] << " / " << resid[1] << std::endl
+                  << std::endl;
+
+        BOOST_CHECK_EQUAL(iters[0], iters[1]);
+        BOOST_CHECK_CLOSE(resid[0], resid[1], 1e-3);
+        BOOST_CHECK_SMALL(resid[0], 1e-4);
+
+        // The iterations are invariant to the scaling of the preconditioner,
+        // so compare the preconditioners directly.
+        std::vector<double> y0(n), y1(n);
+        solve.precond().apply(rhs, y0);
+        fresh.precond().apply(rhs, y1);
+
+        double d = 0, s = 0;
+        for(size_t i = 0; i < n; ++i) {
+            d += (y0[i] - y1[i]) * (y0[i] - y1[i]);
+            s += y1[i] * y1[i];
+        }
+
+        BOOST_CHECK_SMALL(std::sqrt(d / s), 1e-8);
+
+        // A different pattern with the same number of nonzeros is rejected.
+        std::vector<ptrdiff_t> c2 = col;
+        ++c2[ptr[n / 2 + 1] - 1];
+
+        BOOST_CHECK_THROW(solve.rebuild(std::tie(n, ptr, c2, v)), std::runtime_error);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_builtin_task_setup)
+{
+    typedef amgcl::backend::builtin<double> Backend;
+    typedef amgcl::make_solver<
+        amgcl::amg<Backend, amgcl::runtime::coarsening::wrapper, amgcl::runtime::relaxation::wrapper>,
+        amgcl::runtime::solver::wrapper<Backend>
+        > Solver;
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    size_t n = sample_problem(32, val, col, ptr, rhs);
+
+    amgcl::runtime::coarsening::type coarsening[] = {
+        amgcl::runtime::coarsening::ruge_stuben,
+        amgcl::runtime::coarsening::smoothed_aggregation
+    };
+
+    amgcl::runtime::relaxation::type relaxation[] = {
+        amgcl::runtime::relaxation::spai0,
+        amgcl::runtime::relaxation::ilu0,
+        amgcl::runtime::relaxation::gauss_seidel
+    };
+
+#ifdef _OPENMP
+    // The parallel versions of ilu0 and gauss_seidel are only used with
+    // 4 threads or more, and the task setup is only used with 2 threads or
+    // more, so make sure both paths are covered regardless of the machine.
+    const int old_threads = omp_get_max_threads();
+    omp_set_num_threads(8);
+#endif
+
+    for(amgcl::runtime::coarsening::type c : coarsening) {
+        for(amgcl::runtime::relaxation::type r : relaxation) {
+            std::cout << "Task setup with " << c << " and " << r << std::endl;
+
+            size_t iters[2];
+            double resid[2];
+
+            for(int t = 0; t < 2; ++t) {
+                boost::property_tree::ptree prm;
+                prm.put("precond.coarsening.type", c);
+                prm.put("precond.relax.type",      r);
+                prm.put("precond.task_setup",      t == 1);
+
+                Solver solve(std::tie(n, ptr, col, val), prm);
+
+                std::vector<double> x(n, 0.0);
+                std::tie(iters[t], resid[t]) = solve(rhs, x);
+
+#ifdef _OPENMP
+                // The relaxations follow the number of threads in effect at
+                // the solve time, which may differ from the setup one.
+                size_t it;
+                double rs;
+
+                omp_set_num_threads(5);
+                std::fill(x.begin(), x.end(), 0.0);
+                std::tie(it, rs) = solve(rhs, x);
+                omp_set_num_threads(8);
+
+                BOOST_CHECK_EQUAL(it, iters[t]);
+                BOOST_CHECK_CLOSE(rs, resid[t], 1e-3);
+#endif
+            }
+
+            // The overlapped setup should build the same hierarchy.
+            BOOST_CHECK_EQUAL(iters[0], iters[1]);
+            BOOST_CHECK_CLOSE(resid[0], resid[1], 1e-3);
+            BOOST_CHECK_SMALL(resid[1], 1e-4);
+        }
+    }
+
+#ifdef _OPENMP
+    omp_set_num_threads(old_threads);
+#endif
+}
+
 BOOST_AUTO_TEST_SUITE_END()
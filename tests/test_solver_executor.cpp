@@ -0,0 +1,114 @@
+#define BOOST_TEST_MODULE TestSolvers
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+#include <amgcl/backend/executor.hpp>
+#include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/make_solver.hpp>
+#include <amgcl/amg.hpp>
+#include <amgcl/coarsening/smoothed_aggregation.hpp>
+#include <amgcl/relaxation/spai0.hpp>
+#include <amgcl/solver/bicgstab.hpp>
+
+#include "test_solver.hpp"
+
+BOOST_AUTO_TEST_SUITE( test_solvers )
+
+BOOST_AUTO_TEST_CASE(test_executor_backend)
+{
+    test_backend< amgcl::backend::executor_backend<double> >();
+}
+
+BOOST_AUTO_TEST_CASE(test_thread_pool)
+{
+    typedef amgcl::backend::executor_backend<double> Backend;
+
+    typedef amgcl::make_solver<
+        amgcl::amg<
+            Backend,
+            amgcl::coarsening::smoothed_aggregation,
+            amgcl::relaxation::spai0
+            >,
+        amgcl::solver::bicgstab<Backend>
+        > Solver;
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    size_t n = sample_problem(32, val, col, ptr, rhs);
+
+    amgcl::backend::thread_pool pool(3);
+
+    Backend::params bprm(&pool);
+    bprm.grain_size = 1024;
+
+    auto f = Backend::copy_vector(rhs, bprm);
+
+    // Independent solvers may share the pool.
+    std::vector<size_t> iters(4);
+    std::vector<double> error(4);
+    std::vector<std::thread> threads;
+
+    for(int i = 0; i < 4; ++i) {
+        threads.emplace_back([&, i]() {
+                Solver solve(std::tie(n, ptr, col, val), Solver::params(), bprm);
+                auto x = Backend::create_vector(n, bprm);
+                std::tie(iters[i], error[i]) = solve(*f, *x);
+                });
+    }
+
+    for(auto &t : threads) t.join();
+
+    for(int i = 0; i < 4; ++i) {
+        BOOST_CHECK_EQUAL(iters[i], iters[0]);
+        BOOST_CHECK_EQUAL(error[i], error[0]);
+        BOOST_CHECK_SMALL(error[i], 1e-8);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_thread_pool_exception)
+{
+    amgcl::backend::thread_pool pool(3);
+
+    const std::thread::id caller = std::this_thread::get_id();
+
+    std::atomic<bool> thrown(false), returned(false);
+    std::atomic<int>  late(0);
+
+    // The tasks picked up by the workers are blocked until the calling
+    // thread gets one of the tasks and throws. No task should be running
+    // after run() has returned.
+    auto task = [&](int) {
+        if (std::this_thread::get_id() == caller) {
+            thrown = true;
+            throw std::runtime_error("task failed");
+        }
+
+        while(!thrown) std::this_thread::yield();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (returned) ++late;
+    };
+
+    try {
+        pool.run(16, task);
+        BOOST_ERROR("exception expected");
+    } catch(const std::runtime_error&) {
+        returned = true;
+    }
+
+    // The pool is still usable.
+    std::atomic<int> count(0);
+    pool.run(100, [&](int) { ++count; });
+    BOOST_CHECK_EQUAL(count.load(), 100);
+
+    BOOST_CHECK_EQUAL(late.load(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,1235 @@
+#define BOOST_TEST_MODULE TestSolverMPI
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <map>
+#include <cmath>
+#include <tuple>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+#include <amgcl/backend/builtin.hpp>
+#include <amgcl/adapter/crs_tuple.hpp>
+#include <amgcl/mpi/util.hpp>
+#include <amgcl/mpi/inner_product.hpp>
+#include <amgcl/mpi/make_solver.hpp>
+#include <amgcl/mpi/amg.hpp>
+#include <amgcl/mpi/coarsening/runtime.hpp>
+#include <amgcl/mpi/relaxation/runtime.hpp>
+#include <amgcl/mpi/direct_solver/runtime.hpp>
+#include <amgcl/mpi/direct_solver/skyline_lu.hpp>
+#include <amgcl/mpi/partition/runtime.hpp>
+#include <amgcl/mpi/partition/sfc.hpp>
+#include <amgcl/mpi/subdomain_deflation.hpp>
+#include <amgcl/mpi/assembler.hpp>
+#include <amgcl/mpi/relaxation/schwarz.hpp>
+#include <amgcl/mpi/relaxation/as_preconditioner.hpp>
+#include <amgcl/relaxation/as_preconditioner.hpp>
+#include <amgcl/amg.hpp>
+#include <amgcl/coarsening/smoothed_aggregation.hpp>
+#include <amgcl/relaxation/spai0.hpp>
+#include <amgcl/relaxation/ilut.hpp>
+#include <amgcl/solver/cg.hpp>
+#include <amgcl/solver/bicgstab.hpp>
+#include <amgcl/solver/runtime.hpp>
+
+struct mpi_init {
+    mpi_init() {
+        int provided;
+        MPI_Init_thread(
+                &boost::unit_test::framework::master_test_suite().argc,
+                &boost::unit_test::framework::master_test_suite().argv,
+                MPI_THREAD_FUNNELED, &provided);
+    }
+
+    ~mpi_init() {
+        MPI_Finalize();
+    }
+};
+
+BOOST_GLOBAL_FIXTURE(mpi_init);
+
+// Generates the local strip of the poisson problem in a unit cube.
+// The column numbers are global.
+ptrdiff_t poisson3d(amgcl::mpi::communicator comm, ptrdiff_t n,
+        std::vector<ptrdiff_t> &ptr,
+        std::vector<ptrdiff_t> &col,
+        std::vector<double>    &val,
+        std::vector<double>    &rhs)
+{
+    ptrdiff_t n3 = n * n * n;
+
+    ptrdiff_t row_beg = n3 * comm.rank / comm.size;
+    ptrdiff_t row_end = n3 * (comm.rank + 1) / comm.size;
+    ptrdiff_t chunk   = row_end - row_beg;
+
+    ptr.clear(); ptr.reserve(chunk + 1); ptr.push_back(0);
+    col.clear(); col.reserve(chunk * 7);
+    val.clear(); val.reserve(chunk * 7);
+
+    rhs.assign(chunk, 1.0);
+
+    for(ptrdiff_t idx = row_beg; idx < row_end; ++idx) {
+        ptrdiff_t k = idx / (n * n);
+        ptrdiff_t j = (idx / n) % n;
+        ptrdiff_t i = idx % n;
+
+        if (k > 0)     { col.push_back(idx - n * n); val.push_back(-1); }
+        if (j > 0)     { col.push_back(idx - n);     val.push_back(-1); }
+        if (i > 0)     { col.push_back(idx - 1);     val.push_back(-1); }
+
+        col.push_back(idx);
+        val.push_back(6);
+
+        if (i + 1 < n) { col.push_back(idx + 1);     val.push_back(-1); }
+        if (j + 1 < n) { col.push_back(idx + n);     val.push_back(-1); }
+        if (k + 1 < n) { col.push_back(idx + n * n); val.push_back(-1); }
+
+        ptr.push_back(col.size());
+    }
+
+    return chunk;
+}
+
+// Coordinates of the local unknowns of the poisson problem.
+std::vector<double> poisson3d_coords(amgcl::mpi::communicator comm, ptrdiff_t n) {
+    ptrdiff_t n3 = n * n * n;
+
+    ptrdiff_t row_beg = n3 * comm.rank / comm.size;
+    ptrdiff_t row_end = n3 * (comm.rank + 1) / comm.size;
+
+    std::vector<double> x;
+    x.reserve(3 * (row_end - row_beg));
+
+    for(ptrdiff_t idx = row_beg; idx < row_end; ++idx) {
+        x.push_back(idx % n);
+        x.push_back((idx / n) % n);
+        x.push_back(idx / (n * n));
+    }
+
+    return x;
+}
+
+typedef amgcl::backend::builtin<double> Backend;
+
+typedef amgcl::mpi::make_solver<
+    amgcl::mpi::amg<
+        Backend,
+        amgcl::runtime::mpi::coarsening::wrapper<Backend>,
+        amgcl::runtime::mpi::relaxation::wrapper<Backend>,
+        amgcl::runtime::mpi::direct::solver<double>,
+        amgcl::runtime::mpi::partition::wrapper<Backend>
+        >,
+    amgcl::runtime::solver::wrapper
+    > Solver;
+
+BOOST_AUTO_TEST_SUITE( test_solver_mpi )
+
+BOOST_AUTO_TEST_CASE(test_mpi_rebuild)
+{
+    amgcl::mpi::communicator comm(MPI_COMM_WORLD);
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    ptrdiff_t n = poisson3d(comm, 24, ptr, col, val, rhs);
+    ptrdiff_t row_beg = comm.exclusive_sum(n)[comm.rank];
+
+    amgcl::runtime::mpi::coarsening::type coarsening[] = {
+        amgcl::runtime::mpi::coarsening::aggregation,
+        amgcl::runtime::mpi::coarsening::smoothed_aggregation
+    };
+
+    // Iterations and residuals for each of the coarsening types.
+    std::vector< std::tuple<size_t, double> > stats;
+
+    for(amgcl::runtime::mpi::coarsening::type c : coarsening) {
+        if (comm.rank == 0)
+            std::cout << "Rebuild with " << c << std::endl;
+
+        boost::property_tree::ptree prm;
+        prm.put("precond.coarse_enough",   500);
+        prm.put("precond.coarsening.type", c);
+        prm.put("precond.allow_rebuild",   true);
+
+        BOOST_REQUIRE_EQUAL(prm.get<amgcl::runtime::mpi::coarsening::type>(
+                    "precond.coarsening.type"), c);
+
+        std::vector<double> v = val;
+        Solver solve(comm, std::tie(n, ptr, col, v), prm);
+
+        // Scale the matrix so that the values change but the pattern does
+        // not. The scaling is exact, so the transfer operators constructed
+        // for the new matrix from scratch are the same as the kept ones.
+        for(double &a : v) a *= 2;
+
+        solve.rebuild(std::tie(n, ptr, col, v));
+
+        // The rebuilt preconditioner should act the same as the one
+        // constructed from scratch for the new matrix.
+        prm.put("precond.allow_rebuild", false);
+        Solver fresh(comm, std::tie(n, ptr, col, v), prm);
+
+        size_t iters[2];
+        double resid[2];
+
+        std::vector<double> x(n, 0.0);
+        std::tie(iters[0], resid[0]) = solve(rhs, x);
+
+        std::fill(x.begin(), x.end(), 0.0);
+        std::tie(iters[1], resid[1]) = fresh(rhs, x);
+
+        if (comm.rank == 0)
+            std::cout << "Iterations: " << iters[0] << " / " << iters[1] << std::endl
+                      << "Error:      " << resid[0] << " / " << resid[1] << std::endl
+                      << std::endl;
+
+        BOOST_CHECK_EQUAL(iters[0], iters[1]);
+        BOOST_CHECK_CLOSE(resid[0], resid[1], 1e-3);
+        BOOST_CHECK_SMALL(resid[0], 1e-4);
+
+        // The iterations are invariant to the scaling of the preconditioner,
+        // so compare the preconditioners directly.
+        std::vector<double> y0(n), y1(n);
+        solve.precond().apply(rhs, y0);
+        fresh.precond().apply(rhs, y1);
+
+        double d = 0, s = 0;
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            d += (y0[i] - y1[i]) * (y0[i] - y1[i]);
+            s += y1[i] * y1[i];
+        }
+        d = comm.reduce(MPI_SUM, d);
+        s = comm.reduce(MPI_SUM, s);
+
+        BOOST_CHECK_SMALL(std::sqrt(d / s), 1e-8);
+
+        stats.push_back(std::make_tuple(iters[0], resid[0]));
+
+        // A different pattern with the same number of nonzeros is rejected.
+        std::vector<ptrdiff_t> c2 = col;
+        for(ptrdiff_t j = ptr[0]; j < ptr[1]; ++j) {
+            if (c2[j] == row_beg + 1) {
+                c2[j] = row_beg + 2;
+                break;
+            }
+        }
+
+        BOOST_CHECK_THROW(solve.rebuild(std::tie(n, ptr, c2, v)), std::runtime_error);
+    }
+
+    // Smoothed aggregation should take its own path, and not repeat the
+    // plain aggregation run.
+    BOOST_CHECK(stats[0] != stats[1]);
+}
+
+BOOST_AUTO_TEST_CASE(test_mpi_product_plan)
+{
+    amgcl::mpi::communicator comm(MPI_COMM_WORLD);
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    ptrdiff_t n = poisson3d(comm, 16, ptr, col, val, rhs);
+    ptrdiff_t row_beg = comm.exclusive_sum(n)[comm.rank];
+
+    typedef amgcl::mpi::distributed_matrix<Backend> matrix;
+
+    auto A = std::make_shared<matrix>(comm, std::tie(n, ptr, col, val), n);
+
+    amgcl::mpi::product_plan<Backend> plan;
+    auto C1 = plan(*A, *A);
+
+    // The reused plan only recomputes the values.
+    std::vector<double> v = val;
+    for(double &a : v) a *= 2;
+
+    auto B  = std::make_shared<matrix>(comm, std::tie(n, ptr, col, v), n);
+    auto C2 = plan(*B, *B);
+
+    BOOST_REQUIRE_EQUAL(C1->local()->nnz,  C2->local()->nnz);
+    BOOST_REQUIRE_EQUAL(C1->remote()->nnz, C2->remote()->nnz);
+
+    for(size_t j = 0; j < C1->local()->nnz; ++j) {
+        BOOST_CHECK_EQUAL(C1->local()->col[j], C2->local()->col[j]);
+        BOOST_CHECK_CLOSE(4 * C1->local()->val[j], C2->local()->val[j], 1e-10);
+    }
+
+    for(size_t j = 0; j < C1->remote()->nnz; ++j) {
+        BOOST_CHECK_EQUAL(C1->remote()->col[j], C2->remote()->col[j]);
+        BOOST_CHECK_CLOSE(4 * C1->remote()->val[j], C2->remote()->val[j], 1e-10);
+    }
+
+    // A different pattern with the same number of nonzeros on one of the
+    // processes is rejected on all of them.
+    std::vector<ptrdiff_t> c2 = col;
+    if (comm.rank == 0) {
+        for(ptrdiff_t j = ptr[0]; j < ptr[1]; ++j) {
+            if (c2[j] == row_beg + 1) {
+                c2[j] = row_beg + 2;
+                break;
+            }
+        }
+    }
+
+    auto D = std::make_shared<matrix>(comm, std::tie(n, ptr, c2, v), n);
+    BOOST_CHECK_THROW(plan(*D, *B), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_mpi_ruge_stuben)
+{
+    amgcl::mpi::communicator comm(MPI_COMM_WORLD);
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    ptrdiff_t n = poisson3d(comm, 24, ptr, col, val, rhs);
+
+    // HMIS, PMIS, and aggressive coarsening with HMIS.
+    const bool     hmis[]       = {true, false, true};
+    const unsigned aggressive[] = {0,    0,     1};
+
+    for(int k = 0; k < 3; ++k) {
+        boost::property_tree::ptree prm;
+        prm.put("precond.coarse_enough",   500);
+        prm.put("precond.coarsening.type", "ruge_stuben");
+        prm.put("precond.coarsening.hmis", hmis[k]);
+        prm.put("precond.coarsening.aggressive_levels", aggressive[k]);
+
+        Solver solve(comm, std::tie(n, ptr, col, val), prm);
+
+        std::vector<double> x(n, 0.0);
+
+        size_t iters;
+        double resid;
+
+        std::tie(iters, resid) = solve(rhs, x);
+
+        if (comm.rank == 0)
+            std::cout << "Ruge-Stuben (hmis=" << hmis[k]
+                      << ", aggressive_levels=" << aggressive[k] << ")" << std::endl
+                      << "Iterations: " << iters << std::endl
+                      << "Error:      " << resid << std::endl
+                      << std::endl;
+
+        BOOST_CHECK_SMALL(resid, 1e-4);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_mpi_partition_sfc)
+{
+    typedef amgcl::mpi::distributed_matrix<Backend> Matrix;
+    typedef amgcl::mpi::partition::sfc<Backend>     Partition;
+
+    amgcl::mpi::communicator comm(MPI_COMM_WORLD);
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    ptrdiff_t n = poisson3d(comm, 16, ptr, col, val, rhs);
+
+    Matrix A(comm, std::tie(n, ptr, col, val));
+
+    for(int ndim = 0; ndim <= 3; ndim += 3) {
+        Partition::params prm;
+        prm.enable       = true;
+        prm.shrink_ratio = 2;
+        prm.ndim         = ndim;
+
+        if (ndim) prm.coords = poisson3d_coords(comm, 16);
+
+        Partition part(prm);
+        auto I = part(A);
+
+        // I should be a permutation matrix that moves the rows to
+        // comm.size / 2 of the processes.
+        BOOST_CHECK_EQUAL(I->glob_rows(),     A.glob_rows());
+        BOOST_CHECK_EQUAL(I->glob_cols(),     A.glob_rows());
+        BOOST_CHECK_EQUAL(I->glob_nonzeros(), A.glob_rows());
+
+        const Matrix::build_matrix &I_loc = *I->local();
+        const Matrix::build_matrix &I_rem = *I->remote();
+
+        for(ptrdiff_t i = 0; i < n; ++i) {
+            BOOST_CHECK_EQUAL(
+                    (I_loc.ptr[i+1] - I_loc.ptr[i]) + (I_rem.ptr[i+1] - I_rem.ptr[i]),
+                    1);
+        }
+
+        int active = comm.reduce(MPI_SUM, static_cast<int>(I->loc_cols() > 0));
+        BOOST_CHECK_EQUAL(active, std::max(1, comm.size / 2));
+    }
+
+    // The coordinates should match the number of local rows.
+    Partition::params prm;
+    prm.enable       = true;
+    prm.shrink_ratio = 2;
+    prm.ndim         = 3;
+    prm.coords.resize(3 * n - 1);
+
+    Partition part(prm);
+    BOOST_CHECK_THROW(part(A), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_mpi_solver_sfc)
+{
+    amgcl::mpi::communicator comm(MPI_COMM_WORLD);
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    ptrdiff_t n = poisson3d(comm, 24, ptr, col, val, rhs);
+    std::vector<double> coo = poisson3d_coords(comm, 24);
+
+    boost::property_tree::ptree prm;
+    prm.put("precond.coarse_enough",      500);
+    prm.put("precond.repart.type",        "sfc");
+    prm.put("precond.repart.enable",      true);
+    prm.put("precond.repart.min_per_proc", 5000);
+    prm.put("precond.repart.shrink_ratio", 2);
+    prm.put("precond.repart.ndim",        3);
+    prm.put("precond.repart.rows",        n);
+    prm.put("precond.repart.coords",      coo.data());
+
+    Solver solve(comm, std::tie(n, ptr, col, val), prm);
+
+    std::vector<double> x(n, 0.0);
+
+    size_t iters;
+    double resid;
+
+    std::tie(iters, resid) = solve(rhs, x);
+
+    if (comm.rank == 0)
+        std::cout << "SFC repartitioning" << std::endl
+                  << "Iterations: " << iters << std::endl
+                  << "Error:      " << resid << std::endl
+                  << std::endl;
+
+    BOOST_CHECK_SMALL(resid, 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(test_mpi_sdd_eigen_tiny)
+{
+    typedef amgcl::mpi::subdomain_deflation<
+        amgcl::relaxation::as_preconditioner<Backend, amgcl::relaxation::spai0>,
+        amgcl::solver::cg
+        > SDD;
+
+    amgcl::mpi::communicator comm(MPI_COMM_WORLD);
+
+    // 1D poisson problem with tiny subdomains. The grid points are dealt
+    // to the processes round-robin, so that the local blocks of the matrix
+    // are diagonal. The Lanczos process in eigen_deflation hits an
+    // invariant subspace on each step, and the subdomains are smaller than
+    // the requested number of eigenvectors.
+    const ptrdiff_t n  = 3;
+    const ptrdiff_t np = n * comm.size;
+
+    auto gid = [&](ptrdiff_t p) {
+        return (p % comm.size) * n + p / comm.size;
+    };
+
+    std::vector<ptrdiff_t> ptr, col;
+    std::vector<double>    val;
+    std::vector<double>    rhs(n, 1.0);
+
+    ptr.push_back(0);
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        ptrdiff_t p = i * comm.size + comm.rank;
+
+        if (p > 0)      { col.push_back(gid(p - 1)); val.push_back(-1); }
+        col.push_back(gid(p)); val.push_back(2);
+        if (p + 1 < np) { col.push_back(gid(p + 1)); val.push_back(-1); }
+
+        ptr.push_back(col.size());
+    }
+
+    SDD::params prm;
+    prm.num_eig_vec = 8;
+    prm.isolver.tol = 1e-8;
+
+    SDD solve(comm, std::tie(n, ptr, col, val), prm);
+
+    std::vector<double> x(n, 0.0);
+
+    size_t iters;
+    double resid;
+
+    std::tie(iters, resid) = solve(rhs, x);
+
+    if (comm.rank == 0)
+        std::cout << "Eigen deflation, tiny subdomains" << std::endl
+                  << "Iterations: " << iters << std::endl
+                  << "Error:      " << resid << std::endl
+                  << std::endl;
+
+    BOOST_CHECK_SMALL(resid, 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(test_mpi_sdd_eigen_contrast)
+{
+    typedef amgcl::mpi::subdomain_deflation<
+        amgcl::relaxation::as_preconditioner<Backend, amgcl::relaxation::spai0>,
+        amgcl::solver::cg
+        > SDD;
+
+    amgcl::mpi::communicator comm(MPI_COMM_WORLD);
+
+    // 2D diffusion on a (nx x ny * nproc) grid with the Dirichlet
+    // boundary, split into horizontal strips of ny rows. Each strip has
+    // several floating high-conductivity channels, each of which adds a
+    // near-zero mode that the constant deflation vector misses.
+    const ptrdiff_t nx = 64;
+    const ptrdiff_t ny = 16;
+    const ptrdiff_t n  = nx * ny;
+
+    auto k = [&](ptrdiff_t i, ptrdiff_t j) {
+        ptrdiff_t jl = j % ny;
+        return (jl % 4 == 2 && i >= 8 && i < nx - 8) ? 1e6 : 1.0;
+    };
+
+    auto kf = [](double a, double b) { return 2 * a * b / (a + b); };
+
+    const ptrdiff_t glob_ny = ny * comm.size;
+
+    std::vector<ptrdiff_t> ptr, col;
+    std::vector<double>    val;
+    std::vector<double>    rhs(n, 1.0);
+
+    ptr.reserve(n + 1);
+    col.reserve(5 * n);
+    val.reserve(5 * n);
+
+    ptr.push_back(0);
+    for(ptrdiff_t jl = 0; jl < ny; ++jl) {
+        ptrdiff_t j = comm.rank * ny + jl;
+        for(ptrdiff_t i = 0; i < nx; ++i) {
+            // The neighbours in the order of increasing global index, with
+            // the point itself in the middle.
+            const ptrdiff_t ni[] = {i, i - 1, i, i + 1, i};
+            const ptrdiff_t nj[] = {j - 1, j, j, j, j + 1};
+
+            double kc = k(i, j), a[5], d = 0;
+
+            for(int q = 0; q < 5; ++q) {
+                if (q == 2) continue;
+
+                bool inside = ni[q] >= 0 && ni[q] < nx && nj[q] >= 0 && nj[q] < glob_ny;
+
+                a[q] = inside ? kf(kc, k(ni[q], nj[q])) : 0.0;
+                d += inside ? a[q] : kc;
+            }
+
+            for(int q = 0; q < 5; ++q) {
+                if (q == 2) {
+                    col.push_back(j * nx + i);
+                    val.push_back(d);
+                } else if (a[q] != 0) {
+                    col.push_back(nj[q] * nx + ni[q]);
+                    val.push_back(-a[q]);
+                }
+            }
+
+            ptr.push_back(col.size());
+        }
+    }
+
+    size_t iters[2];
+    double resid[2];
+
+    for(int e = 0; e < 2; ++e) {
+        SDD::params prm;
+        prm.isolver.tol     = 1e-8;
+        prm.isolver.maxiter = 1000;
+
+        if (e) {
+            prm.num_eig_vec = 4;
+
+            // The local preconditioner is weak, and the channel modes need
+            // accurate local solves.
+            prm.lsolver.maxiter = 1000;
+        } else {
+            prm.num_def_vec = 1;
+            prm.def_vec     = amgcl::mpi::constant_deflation(1);
+        }
+
+        SDD solve(comm, std::tie(n, ptr, col, val), prm);
+
+        std::vector<double> x(n, 0.0);
+        std::tie(iters[e], resid[e]) = solve(rhs, x);
+    }
+
+    if (comm.rank == 0)
+        std::cout << "High contrast, constant / eigen deflation" << std::endl
+                  << "Iterations: " << iters[0] << " / " << iters[1] << std::endl
+                  << "Error:      " << resid[0] << " / " << resid[1] << std::endl
+                  << std::endl;
+
+    BOOST_CHECK_SMALL(resid[0], 1e-6);
+    BOOST_CHECK_SMALL(resid[1], 1e-6);
+
+    // The eigenvectors capture the channel modes, so the eigen deflation
+    // needs several times fewer iterations.
+    BOOST_CHECK_LT(2 * iters[1], iters[0]);
+}
+
+BOOST_AUTO_TEST_CASE(test_mpi_sdd_eigen_setup)
+{
+    typedef amgcl::mpi::subdomain_deflation<
+        amgcl::amg<Backend, amgcl::coarsening::smoothed_aggregation, amgcl::relaxation::spai0>,
+        amgcl::solver::cg
+        > SDD;
+
+    amgcl::mpi::communicator comm(MPI_COMM_WORLD);
+
+    // 3D poisson problem with at least 50k rows per subdomain. The local
+    // matrices are only inverted approximately with the local
+    // preconditioner, so the eigenvectors should not cost much more than
+    // the rest of the setup.
+    const ptrdiff_t m = std::ceil(std::cbrt(50000.0 * comm.size));
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    ptrdiff_t n = poisson3d(comm, m, ptr, col, val, rhs);
+    BOOST_REQUIRE_GE(n, 50000);
+
+    size_t iters[2];
+    double resid[2];
+    double setup[2];
+
+    for(int e = 0; e < 2; ++e) {
+        SDD::params prm;
+        prm.isolver.tol = 1e-8;
+
+        if (e) {
+            prm.num_eig_vec = 4;
+        } else {
+            prm.num_def_vec = 1;
+            prm.def_vec     = amgcl::mpi::constant_deflation(1);
+        }
+
+        MPI_Barrier(comm);
+        double tic = MPI_Wtime();
+
+        SDD solve(comm, std::tie(n, ptr, col, val), prm);
+
+        setup[e] = comm.reduce(MPI_MAX, MPI_Wtime() - tic);
+
+        std::vector<double> x(n, 0.0);
+        std::tie(iters[e], resid[e]) = solve(rhs, x);
+    }
+
+    if (comm.rank == 0)
+        std::cout << "Large subdomains, constant / eigen deflation" << std::endl
+                  << "Setup:      " << setup[0] << " / " << setup[1] << std::endl
+                  << "Iterations: " << iters[0] << " / " << iters[1] << std::endl
+                  << "Error:      " << resid[0] << " / " << resid[1] << std::endl
+                  << std::endl;
+
+    BOOST_CHECK_SMALL(resid[0], 1e-6);
+    BOOST_CHECK_SMALL(resid[1], 1e-6);
+
+    BOOST_CHECK_LE(iters[1], iters[0]);
+
+    // With the skyline LU factorization of the local matrices the eigen
+    // deflation setup was several hundred times slower.
+    BOOST_CHECK_LT(setup[1], 50 * setup[0]);
+}
+
+// Checks the local part of the distributed matrix (with the global column
+// numbers of the remote part, before it is moved to the backend) against
+// the reference.
+void check_assembled(
+        const amgcl::mpi::distributed_matrix<Backend> &A,
+        const std::map<std::pair<ptrdiff_t, ptrdiff_t>, double> &ref,
+        ptrdiff_t row_beg)
+{
+    auto a_loc = A.local();
+    auto a_rem = A.remote();
+
+    BOOST_REQUIRE_EQUAL(a_loc->nnz + a_rem->nnz, ref.size());
+
+    for(size_t i = 0; i < a_loc->nrows; ++i) {
+        ptrdiff_t r = row_beg + i;
+
+        for(ptrdiff_t j = a_loc->ptr[i]; j < a_loc->ptr[i+1]; ++j) {
+            auto v = ref.find(std::make_pair(r, row_beg + a_loc->col[j]));
+            BOOST_REQUIRE(v != ref.end());
+            BOOST_CHECK_CLOSE(a_loc->val[j], v->second, 1e-10);
+        }
+
+        for(ptrdiff_t j = a_rem->ptr[i]; j < a_rem->ptr[i+1]; ++j) {
+            auto v = ref.find(std::make_pair(r, a_rem->col[j]));
+            BOOST_REQUIRE(v != ref.end());
+            BOOST_CHECK_CLOSE(a_rem->val[j], v->second, 1e-10);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_mpi_assembler)
+{
+    amgcl::mpi::communicator comm(MPI_COMM_WORLD);
+
+    // The 3D grid laplacian with a mass term is assembled from the edge
+    // and the node contributions. The contributions are dealt to the
+    // processes independently of the row ownership, so most of them go to
+    // the rows owned by other processes, and each nonzero gets several
+    // contributions from different processes. The node contributions are
+    // additionally split in two on the same process.
+    const ptrdiff_t m  = 12;
+    const ptrdiff_t m3 = m * m * m;
+
+    const ptrdiff_t row_beg = m3 * comm.rank / comm.size;
+    const ptrdiff_t row_end = m3 * (comm.rank + 1) / comm.size;
+    const ptrdiff_t n       = row_end - row_beg;
+
+    typedef std::map<std::pair<ptrdiff_t, ptrdiff_t>, double> dok_matrix;
+
+    amgcl::mpi::assembler<Backend> assemble(comm, n);
+
+    std::vector<double> v;
+    dok_matrix ref;
+
+    auto add = [&](int owner, ptrdiff_t i, ptrdiff_t j, double a) {
+        if (owner == comm.rank) {
+            assemble.insert(i, j, a);
+            v.push_back(a);
+        }
+
+        if (i >= row_beg && i < row_end)
+            ref[std::make_pair(i, j)] += a;
+    };
+
+    ptrdiff_t e = 0;
+    for(ptrdiff_t idx = 0; idx < m3; ++idx) {
+        ptrdiff_t k = idx / (m * m);
+        ptrdiff_t j = (idx / m) % m;
+        ptrdiff_t i = idx % m;
+
+        int owner = (idx * 5 + 1) % comm.size;
+        add(owner, idx, idx, 0.25);
+        add(owner, idx, idx, 0.25);
+
+        const ptrdiff_t nbr[] = {
+            i + 1 < m ? idx + 1     : -1,
+            j + 1 < m ? idx + m     : -1,
+            k + 1 < m ? idx + m * m : -1
+        };
+
+        for(ptrdiff_t b : nbr) {
+            if (b < 0) continue;
+
+            int    o = (e * 7 + 3) % comm.size;
+            double w = 1 + (e % 7) / 7.0;
+
+            add(o, idx, idx,  w);
+            add(o, b,   b,    w);
+            add(o, idx, b,   -w);
+            add(o, b,   idx, -w);
+
+            ++e;
+        }
+    }
+
+    auto A = assemble();
+
+    BOOST_CHECK_EQUAL(A->loc_rows(), n);
+    BOOST_CHECK_EQUAL(A->glob_rows(), m3);
+    check_assembled(*A, ref, row_beg);
+
+    boost::property_tree::ptree prm;
+    prm.put("precond.coarse_enough", 200);
+    prm.put("precond.allow_rebuild", true);
+
+    Solver solve(comm, A, prm);
+
+    // Value-only reassembly. The scaling is exact, so the preconditioner
+    // rebuilt with the kept transfer operators should be the same as the
+    // one constructed from scratch for the new matrix.
+    for(double &a : v) a *= 2;
+    for(auto &a : ref) a.second *= 2;
+
+    auto B = assemble.reassemble(v);
+    check_assembled(*B, ref, row_beg);
+
+    solve.rebuild(B);
+
+    std::vector<ptrdiff_t> ptr(1, 0), col;
+    std::vector<double>    val;
+
+    for(const auto &a : ref) {
+        while(static_cast<ptrdiff_t>(ptr.size()) <= a.first.first - row_beg)
+            ptr.push_back(col.size());
+        col.push_back(a.first.second);
+        val.push_back(a.second);
+    }
+    ptr.push_back(col.size());
+
+    BOOST_REQUIRE_EQUAL(static_cast<ptrdiff_t>(ptr.size()), n + 1);
+
+    prm.put("precond.allow_rebuild", false);
+    Solver fresh(comm, std::tie(n, ptr, col, val), prm);
+
+    std::vector<double> rhs(n, 1.0);
+
+    size_t iters[2];
+    double resid[2];
+
+    std::vector<double> x(n, 0.0);
+    std::tie(iters[0], resid[0]) = solve(rhs, x);
+
+    std::fill(x.begin(), x.end(), 0.0);
+    std::tie(iters[1], resid[1]) = fresh(rhs, x);
+
+    if (comm.rank == 0)
+        std::cout << "Assembled matrix" << std::endl
+                  << "Iterations: " << iters[0] << " / " << iters[1] << std::endl
+                  << "Error:      " << resid[0] << " / " << resid[1] << std::endl
+                  << std::endl;
+
+    BOOST_CHECK_EQUAL(iters[0], iters[1]);
+    BOOST_CHECK_CLOSE(resid[0], resid[1], 1e-3);
+    BOOST_CHECK_SMALL(resid[0], 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(test_mpi_schwarz)
+{
+    amgcl::mpi::communicator comm(MPI_COMM_WORLD);
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    ptrdiff_t n = poisson3d(comm, 24, ptr, col, val, rhs);
+
+    // Restricted additive Schwarz as the smoother of the AMG hierarchy.
+    {
+        boost::property_tree::ptree prm;
+        prm.put("precond.coarse_enough", 500);
+        prm.put("precond.relax.type",    "ilu0");
+        prm.put("precond.relax.overlap", 1);
+
+        Solver solve(comm, std::tie(n, ptr, col, val), prm);
+
+        std::vector<double> x(n, 0.0);
+
+        size_t iters;
+        double resid;
+
+        std::tie(iters, resid) = solve(rhs, x);
+
+        if (comm.rank == 0)
+            std::cout << "AMG with RAS(ilu0) smoother" << std::endl
+                      << "Iterations: " << iters << std::endl
+                      << "Error:      " << resid << std::endl
+                      << std::endl;
+
+        BOOST_CHECK_SMALL(resid, 1e-4);
+    }
+
+    // Restricted additive Schwarz as a standalone preconditioner. The
+    // overlap should improve the convergence over the block Jacobi
+    // (overlap = 0) method. The local solver has to be accurate enough for
+    // that (with ilu0 the local approximation error dominates).
+    typedef amgcl::mpi::make_solver<
+        amgcl::mpi::relaxation::as_preconditioner<
+            Backend,
+            amgcl::mpi::relaxation::schwarz<Backend, amgcl::relaxation::ilut>
+            >,
+        amgcl::solver::bicgstab
+        > RAS;
+
+    size_t iters[3];
+
+    for(unsigned overlap = 0; overlap < 3; ++overlap) {
+        RAS::params prm;
+        prm.precond.overlap   = overlap;
+        prm.precond.relax.p   = 10;
+        prm.precond.relax.tau = 1e-5;
+        prm.solver.tol        = 1e-6;
+        prm.solver.maxiter    = 500;
+
+        RAS solve(comm, std::tie(n, ptr, col, val), prm);
+
+        std::vector<double> x(n, 0.0);
+        double resid;
+
+        std::tie(iters[overlap], resid) = solve(rhs, x);
+
+        if (comm.rank == 0)
+            std::cout << "RAS(ilut), overlap=" << overlap << std::endl
+                      << "Iterations: " << iters[overlap] << std::endl
+                      << "Error:      " << resid << std::endl
+                      << std::endl;
+
+        BOOST_CHECK_SMALL(resid, 1e-6);
+    }
+
+    if (comm.size > 1) {
+        BOOST_CHECK_LT(iters[1], iters[0]);
+        BOOST_CHECK_LE(iters[2], iters[1]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_mpi_mis2)
+{
+    amgcl::mpi::communicator world(MPI_COMM_WORLD);
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    {
+        ptrdiff_t n = poisson3d(world, 24, ptr, col, val, rhs);
+
+        amgcl::runtime::mpi::coarsening::type coarsening[] = {
+            amgcl::runtime::mpi::coarsening::aggregation,
+            amgcl::runtime::mpi::coarsening::smoothed_aggregation
+        };
+
+        std::vector< std::tuple<size_t, double> > stats;
+
+        for(amgcl::runtime::mpi::coarsening::type c : coarsening) {
+            boost::property_tree::ptree prm;
+            prm.put("precond.coarse_enough",        500);
+            prm.put("precond.coarsening.type",      c);
+            prm.put("precond.coarsening.aggr.mis2", true);
+
+            BOOST_REQUIRE_EQUAL(prm.get<amgcl::runtime::mpi::coarsening::type>(
+                        "precond.coarsening.type"), c);
+
+            Solver solve(world, std::tie(n, ptr, col, val), prm);
+
+            std::vector<double> x(n, 0.0);
+
+            size_t iters;
+            double resid;
+
+            std::tie(iters, resid) = solve(rhs, x);
+
+            if (world.rank == 0)
+                std::cout << "MIS-2 " << c << std::endl
+                          << "Iterations: " << iters << std::endl
+                          << "Error:      " << resid << std::endl
+                          << std::endl;
+
+            BOOST_CHECK_SMALL(resid, 1e-4);
+
+            stats.push_back(std::make_tuple(iters, resid));
+        }
+
+        // MIS-2 aggregates with and without the prolongation smoothing
+        // should give different solvers.
+        BOOST_CHECK(stats[0] != stats[1]);
+    }
+
+    // The MIS-2 aggregates only depend on the global numbering of the
+    // unknowns, so the coarse size should not depend on the number of
+    // processes.
+    ptrdiff_t naggr_ref = 0;
+
+    for(int size = 1; size <= world.size; size *= 2) {
+        MPI_Comm sub;
+        MPI_Comm_split(world, world.rank < size ? 0 : MPI_UNDEFINED, world.rank, &sub);
+
+        ptrdiff_t naggr = 0;
+
+        if (sub != MPI_COMM_NULL) {
+            amgcl::mpi::communicator comm(sub);
+
+            ptrdiff_t n = poisson3d(comm, 16, ptr, col, val, rhs);
+            auto A = std::make_shared< amgcl::mpi::distributed_matrix<Backend> >(
+                    comm, std::tie(n, ptr, col, val), n);
+
+            amgcl::mpi::coarsening::aggregation<Backend>::params prm;
+            prm.aggr.mis2 = true;
+
+            amgcl::mpi::coarsening::aggregation<Backend> C(prm);
+            naggr = std::get<0>(C.transfer_operators(*A))->glob_cols();
+
+            MPI_Comm_free(&sub);
+        }
+
+        naggr = world.reduce(MPI_MAX, naggr);
+
+        if (world.rank == 0)
+            std::cout << "MIS-2 aggregates on " << size << " processes: " << naggr << std::endl;
+
+        if (size == 1) {
+            naggr_ref = naggr;
+            BOOST_CHECK_GT(naggr, 0);
+            BOOST_CHECK_LT(naggr, 16 * 16 * 16 / 8);
+        } else {
+            BOOST_CHECK_EQUAL(naggr, naggr_ref);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_mpi_replicate_direct)
+{
+    amgcl::mpi::communicator comm(MPI_COMM_WORLD);
+
+    // 1D poisson problem, where the second process (if there are more
+    // than two) owns no rows.
+    const ptrdiff_t N = 200;
+
+    auto bound = [&](int r) -> ptrdiff_t {
+        if (r == 1 && comm.size > 2) r = 2;
+        return N * r / comm.size;
+    };
+
+    const ptrdiff_t row_beg = bound(comm.rank);
+    const ptrdiff_t n       = bound(comm.rank + 1) - row_beg;
+
+    std::vector<ptrdiff_t> ptr(1, 0), col;
+    std::vector<double>    val, rhs;
+
+    for(ptrdiff_t i = row_beg; i < row_beg + n; ++i) {
+        if (i > 0)     { col.push_back(i - 1); val.push_back(-1); }
+        col.push_back(i); val.push_back(2.5);
+        if (i + 1 < N) { col.push_back(i + 1); val.push_back(-1); }
+
+        ptr.push_back(col.size());
+        rhs.push_back(std::sin(0.1 * i));
+    }
+
+    // The replicated solver should give the same solution as the default
+    // one, which gathers the problem to a single process.
+    typedef amgcl::mpi::direct::skyline_lu<double> Direct;
+
+    std::vector<double> x[2];
+
+    for(int k = 0; k < 2; ++k) {
+        Direct::params prm;
+        prm.replicate = (k == 1);
+
+        Direct solve(comm, std::tie(n, ptr, col, val), prm);
+
+        x[k].resize(n);
+        solve(rhs, x[k]);
+    }
+
+    double d = 0, s = 0;
+    for(ptrdiff_t i = 0; i < n; ++i) {
+        d += (x[0][i] - x[1][i]) * (x[0][i] - x[1][i]);
+        s += x[0][i] * x[0][i];
+    }
+    d = comm.reduce(MPI_SUM, d);
+    s = comm.reduce(MPI_SUM, s);
+
+    BOOST_CHECK_GT(s, 0);
+    BOOST_CHECK_SMALL(std::sqrt(d / s), 1e-12);
+
+    // The same for the coarse level solver in the AMG hierarchy.
+    {
+        ptrdiff_t m = poisson3d(comm, 24, ptr, col, val, rhs);
+
+        size_t iters[2];
+        double resid[2];
+
+        for(int k = 0; k < 2; ++k) {
+            boost::property_tree::ptree prm;
+            prm.put("precond.coarse_enough",    500);
+            prm.put("precond.direct.type",      "skyline_lu");
+            prm.put("precond.direct.replicate", k == 1);
+
+            Solver solve(comm, std::tie(m, ptr, col, val), prm);
+
+            std::vector<double> x(m, 0.0);
+            std::tie(iters[k], resid[k]) = solve(rhs, x);
+        }
+
+        if (comm.rank == 0)
+            std::cout << "Replicated coarse solver" << std::endl
+                      << "Iterations: " << iters[0] << " / " << iters[1] << std::endl
+                      << "Error:      " << resid[0] << " / " << resid[1] << std::endl
+                      << std::endl;
+
+        BOOST_CHECK_EQUAL(iters[0], iters[1]);
+        BOOST_CHECK_CLOSE(resid[0], resid[1], 1e-3);
+        BOOST_CHECK_SMALL(resid[1], 1e-4);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_mpi_node_aware)
+{
+    amgcl::mpi::communicator comm(MPI_COMM_WORLD);
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    ptrdiff_t n = poisson3d(comm, 24, ptr, col, val, rhs);
+
+    // The node aware merge with the thread expansion on the coarse levels,
+    // and the plain merge. All processes of the test live on the same node,
+    // so both should result in the same hierarchy.
+    size_t iters[2];
+    double resid[2];
+
+    for(int k = 0; k < 2; ++k) {
+        boost::property_tree::ptree prm;
+        prm.put("precond.coarse_enough",       500);
+        prm.put("precond.repart.type",         "merge");
+        prm.put("precond.repart.enable",       true);
+        prm.put("precond.repart.min_per_proc", 5000);
+        prm.put("precond.repart.shrink_ratio", 2);
+        prm.put("precond.repart.node_aware",   k == 0);
+        prm.put("precond.expand_threads",      k == 0);
+
+#ifdef _OPENMP
+        const int nt = omp_get_max_threads();
+#endif
+
+        Solver solve(comm, std::tie(n, ptr, col, val), prm);
+
+        std::vector<double> x(n, 0.0);
+        std::tie(iters[k], resid[k]) = solve(rhs, x);
+
+#ifdef _OPENMP
+        // The number of threads is restored after each level.
+        BOOST_CHECK_EQUAL(omp_get_max_threads(), nt);
+#endif
+    }
+
+    if (comm.rank == 0)
+        std::cout << "Node aware merge" << std::endl
+                  << "Iterations: " << iters[0] << " / " << iters[1] << std::endl
+                  << "Error:      " << resid[0] << " / " << resid[1] << std::endl
+                  << std::endl;
+
+    BOOST_CHECK_EQUAL(iters[0], iters[1]);
+    BOOST_CHECK_CLOSE(resid[0], resid[1], 1e-3);
+    BOOST_CHECK_SMALL(resid[0], 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(test_mpi_shared_memory)
+{
+    amgcl::mpi::communicator comm(MPI_COMM_WORLD);
+
+    std::vector<ptrdiff_t> ptr;
+    std::vector<ptrdiff_t> col;
+    std::vector<double>    val;
+    std::vector<double>    rhs;
+
+    ptrdiff_t n = poisson3d(comm, 24, ptr, col, val, rhs);
+
+    // The halo exchange through the shared memory on the node, and through
+    // the point-to-point messages only. The exchanged values are the same,
+    // so should be the solutions.
+    size_t iters[2];
+    double resid[2];
+    std::vector<double> x[2];
+
+    for(int k = 0; k < 2; ++k) {
+        amgcl::mpi::shared_memory_exchange() = (k == 0);
+
+        boost::property_tree::ptree prm;
+        prm.put("precond.coarse_enough", 500);
+
+        Solver solve(comm, std::tie(n, ptr, col, val), prm);
+
+#ifdef AMGCL_MPI_SHARED_MEMORY
+        BOOST_CHECK_EQUAL(solve.system_matrix().cpat().shared_memory(),
+                k == 0 && comm.node().size > 1);
+#endif
+
+        x[k].assign(n, 0.0);
+        std::tie(iters[k], resid[k]) = solve(rhs, x[k]);
+    }
+
+    amgcl::mpi::shared_memory_exchange() = true;
+
+    if (comm.rank == 0)
+        std::cout << "Shared memory exchange on / off" << std::endl
+                  << "Iterations: " << iters[0] << " / " << iters[1] << std::endl
+                  << "Error:      " << resid[0] << " / " << resid[1] << std::endl
+                  << std::endl;
+
+    BOOST_CHECK_EQUAL(iters[0], iters[1]);
+    BOOST_CHECK_CLOSE(resid[0], resid[1], 1e-8);
+    BOOST_CHECK_SMALL(resid[0], 1e-4);
+
+    for(ptrdiff_t i = 0; i < n; ++i)
+        BOOST_CHECK_CLOSE(x[0][i], x[1][i], 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(test_mpi_inner_product)
+{
+    amgcl::mpi::communicator comm(MPI_COMM_WORLD);
+    amgcl::mpi::inner_product dot(comm);
+
+    // The local sizes differ between the processes.
+    const size_t n = 100 + 10 * comm.rank;
+
+    std::vector<double> x(n), y(n), z(n);
+    for(size_t i = 0; i < n; ++i) {
+        double t = comm.rank + static_cast<double>(i) / n;
+        x[i] = std::sin(t);
+        y[i] = std::cos(t);
+        z[i] = t;
+    }
+
+    const double xy = dot(x, y);
+    const double yz = dot(y, z);
+    const double zz = dot(z, z);
+
+    // Batched products, with a single reduction.
+    {
+        const std::vector<double> *a[] = {&x, &y, &z};
+        const std::vector<double> *b[] = {&y, &z, &z};
+        double r[3];
+
+        dot(3, a, b, r);
+
+        BOOST_CHECK_CLOSE(r[0], xy, 1e-10);
+        BOOST_CHECK_CLOSE(r[1], yz, 1e-10);
+        BOOST_CHECK_CLOSE(r[2], zz, 1e-10);
+    }
+
+    // Non-blocking products, several in flight at once.
+    {
+        auto f0 = dot.async(x, y);
+        auto f1 = dot.async(y, z);
+        auto f2 = std::move(f1);
+
+        BOOST_CHECK_CLOSE(f2.get(), yz, 1e-10);
+        BOOST_CHECK_CLOSE(f0.get(), xy, 1e-10);
+
+        // Repeated get() returns the same value.
+        BOOST_CHECK_CLOSE(f0.get(), xy, 1e-10);
+
+        // Assigning over a future completes its reduction first.
+        f0 = dot.async(z, z);
+        BOOST_CHECK_CLOSE(f0.get(), zz, 1e-10);
+    }
+
+    // A future dropped without get() completes its reduction on
+    // destruction, and does not disturb the reductions that follow.
+    {
+        auto f = dot.async(x, y);
+    }
+
+    BOOST_CHECK_CLOSE(dot(z, z), zz, 1e-10);
+}
+
+BOOST_AUTO_TEST_SUITE_END()